@@ -711,7 +711,6 @@ C_BaseAnimating::C_BaseAnimating() :
 	m_iMostRecentModelBoneCounter = 0xFFFFFFFF;
 	m_iMostRecentBoneSetupRequest = g_iPreviousBoneCounter - 1;
 	m_flLastBoneSetupTime = -FLT_MAX;
-	m_pNextForThreadedBoneSetup = NULL;
 
 	m_vecPreRagdollMins = vec3_origin;
 	m_vecPreRagdollMaxs = vec3_origin;
@@ -2573,15 +2572,7 @@ CThreadLocalInt<> *pCount;
 
 void C_BaseAnimating::SetupBonesOnBaseAnimating( C_BaseAnimating *&pBaseAnimating )
 {
-	C_BaseAnimating *pCurrent = pBaseAnimating;
-	C_BaseAnimating *pNext;
-	while ( pCurrent )
-	{
-		pNext = pCurrent->m_pNextForThreadedBoneSetup;
-		pCurrent->m_pNextForThreadedBoneSetup = NULL;
-		pCurrent->SetupBones( NULL, -1, -1, gpGlobals->curtime );
-		pCurrent = pNext;
-	}
+	pBaseAnimating->SetupBones( NULL, -1, -1, gpGlobals->curtime );
 
 #ifdef DEBUG_BONE_SETUP_THREADING
 	(*pCount)++;
@@ -2646,6 +2637,30 @@ void C_BaseAnimating::MarkForThreadedBoneSetup()
 	}
 }
 
+static ConVar cl_threaded_bone_setup_batch_bones( "cl_threaded_bone_setup_batch_bones", "128", 0, "Bones a worker takes at once in the threaded bone setup, small models are processed in batches" );
+
+struct ThreadedBoneSetup_t
+{
+	C_BaseAnimating *pAnimating;
+	int nDepth;
+	int nBones;
+};
+
+static int __cdecl ThreadedBoneSetupSortFunc( const ThreadedBoneSetup_t *a, const ThreadedBoneSetup_t *b )
+{
+	// parents always come before their children
+	if ( a->nDepth != b->nDepth )
+		return a->nDepth - b->nDepth;
+
+	// the heavy ones first, so they don't end up alone at the end of the level
+	return b->nBones - a->nBones;
+}
+
+static C_BaseAnimating *GetBoneSetupParent( C_BaseAnimating *pAnimating )
+{
+	return pAnimating->GetMoveParent() ? pAnimating->GetMoveParent()->GetBaseAnimating() : NULL;
+}
+
 void C_BaseAnimating::ThreadedBoneSetup()
 {
 	g_bDoThreadedBoneSetup = ( g_pBoneSetupThreadPool && g_pBoneSetupThreadPool->NumThreads() && cl_threaded_bone_setup.GetInt() );
@@ -2660,58 +2675,77 @@ void C_BaseAnimating::ThreadedBoneSetup()
 			Msg( "{\n" );
 #endif
 			// This loop is here rather than the mark function so we don't have to worry about the list being threadsafe, or worry about entity destruction
-#ifdef _DEBUG
-			CUtlVector<C_BaseAnimating *> test;
-			test.AddVectorToTail( g_PreviousBoneSetups );
-#endif
-			for ( int i = g_PreviousBoneSetups.Count() - 1; i >= 0; i-- )
+			// The bones of the parents are needed by the children (attachments), add the ones that weren't requested
+			for ( int i = 0; i < g_PreviousBoneSetups.Count(); i++ )
 			{
-				C_BaseAnimating *pAnimating = g_PreviousBoneSetups[i];
-				C_BaseAnimating *pParent;
-				if ( pAnimating->GetMoveParent() && ( pParent = pAnimating->GetMoveParent()->GetBaseAnimating() ) != NULL )
+				C_BaseAnimating *pParent = GetBoneSetupParent( g_PreviousBoneSetups[i] );
+				if ( pParent && pParent->m_iMostRecentBoneSetupRequest != g_iPreviousBoneCounter )
 				{
-					Assert( pAnimating->m_pNextForThreadedBoneSetup == NULL );
-					C_BaseAnimating *pNextParent;
-					while ( pParent->GetMoveParent() && ( pNextParent = pParent->GetMoveParent()->GetBaseAnimating() ) != NULL )
-					{
-						pParent = pNextParent;
-					}
-					
-					pAnimating->m_pNextForThreadedBoneSetup = pParent->m_pNextForThreadedBoneSetup;
-					pParent->m_pNextForThreadedBoneSetup = pAnimating;
-					g_PreviousBoneSetups.FastRemove( i );
-					if ( pParent->m_iMostRecentBoneSetupRequest != g_iPreviousBoneCounter )
-					{
-						Assert( g_PreviousBoneSetups.Find( pParent ) == -1 );
-						pParent->m_iMostRecentBoneSetupRequest = g_iPreviousBoneCounter;
-						g_PreviousBoneSetups.AddToTail( pParent );
-					}
+					Assert( g_PreviousBoneSetups.Find( pParent ) == -1 );
+					pParent->m_iMostRecentBoneSetupRequest = g_iPreviousBoneCounter;
+					g_PreviousBoneSetups.AddToTail( pParent );
 				}
 			}
 			nCount = g_PreviousBoneSetups.Count();
 
-			g_bInThreadedBoneSetup = true;
-			if ( cl_threaded_bone_setup.GetInt() == 1 )
-			{
-				CParallelProcessor<C_BaseAnimating *, CFuncJobItemProcessor<C_BaseAnimating *>, 2 > processor;
-				processor.m_ItemProcessor.Init( &SetupBonesOnBaseAnimating, &PreThreadedBoneSetup, &PostThreadedBoneSetup );
-				processor.Run( g_PreviousBoneSetups.Base(), nCount, 1, INT_MAX, g_pBoneSetupThreadPool );
-			}
-			else
+			// Order them by depth in the hierarchy, every level only depends on the previous ones
+			CUtlVector<ThreadedBoneSetup_t> setups;
+			setups.SetCount( nCount );
+			for ( int i = 0; i < nCount; i++ )
 			{
-				for ( int i = 0; i < nCount; i++ )
+				ThreadedBoneSetup_t &setup = setups[i];
+				setup.pAnimating = g_PreviousBoneSetups[i];
+				setup.nDepth = 0;
+				for ( C_BaseAnimating *pParent = GetBoneSetupParent( setup.pAnimating ); pParent; pParent = GetBoneSetupParent( pParent ) )
 				{
-					SetupBonesOnBaseAnimating( g_PreviousBoneSetups[i] );
+					setup.nDepth++;
 				}
+
+				CStudioHdr *pStudioHdr = setup.pAnimating->GetModelPtr();
+				setup.nBones = ( pStudioHdr ) ? MAX( pStudioHdr->numbones(), 1 ) : 1;
 			}
-			g_bInThreadedBoneSetup = false;
+			setups.Sort( ThreadedBoneSetupSortFunc );
 
-#ifdef _DEBUG
-			for ( int i = test.Count() - 1; i > 0; i-- )
+			for ( int i = 0; i < nCount; i++ )
 			{
-				Assert( test[i]->m_pNextForThreadedBoneSetup == NULL );
+				g_PreviousBoneSetups[i] = setups[i].pAnimating;
 			}
-#endif
+
+			g_bInThreadedBoneSetup = true;
+			int nFirst = 0;
+			while ( nFirst < nCount )
+			{
+				int nLast = nFirst;
+				int nBones = 0;
+				while ( nLast < nCount && setups[nLast].nDepth == setups[nFirst].nDepth )
+				{
+					nBones += setups[nLast].nBones;
+					nLast++;
+				}
+
+				int nItems = nLast - nFirst;
+				if ( cl_threaded_bone_setup.GetInt() == 1 && nItems > 1 )
+				{
+					// Batch the small models, but leave enough batches to keep every thread busy
+					int nThreads = g_pBoneSetupThreadPool->NumThreads() + 1;
+					int nChunkSize = ( cl_threaded_bone_setup_batch_bones.GetInt() * nItems ) / nBones;
+					nChunkSize = clamp( nChunkSize, 1, MAX( nItems / nThreads, 1 ) );
+
+					CParallelProcessor<C_BaseAnimating *, CFuncJobItemProcessor<C_BaseAnimating *>, 2 > processor;
+					processor.m_ItemProcessor.Init( &SetupBonesOnBaseAnimating, &PreThreadedBoneSetup, &PostThreadedBoneSetup );
+					processor.Run( g_PreviousBoneSetups.Base() + nFirst, nItems, nChunkSize, INT_MAX, g_pBoneSetupThreadPool );
+				}
+				else
+				{
+					for ( int i = nFirst; i < nLast; i++ )
+					{
+						SetupBonesOnBaseAnimating( g_PreviousBoneSetups[i] );
+					}
+				}
+
+				nFirst = nLast;
+			}
+			g_bInThreadedBoneSetup = false;
 
 #ifdef DEBUG_BONE_SETUP_THREADING
 			Msg( "} \n" );
@@ -5300,7 +5334,7 @@ int C_BaseAnimating::LookupAttachment( const char *pAttachmentName )
 	// NOTE: Currently, the network uses 0 to mean "no attachment" 
 	// thus the client must add one to the index of the attachment
 	// UNDONE: Make the server do this too to be consistent.
-	return Studio_FindAttachment( hdr, pAttachmentName ) + 1;
+	return ::LookupAttachment( hdr, pAttachmentName ) + 1;
 }
 
 //-----------------------------------------------------------------------------
@@ -6229,16 +6263,7 @@ int C_BaseAnimating::LookupPoseParameter( CStudioHdr *pstudiohdr, const char *sz
 	if ( !pstudiohdr )
 		return -1;	
 
-	for (int i = 0; i < pstudiohdr->GetNumPoseParameters(); i++)
-	{
-		if (stricmp( pstudiohdr->pPoseParameter( i ).pszName(), szName ) == 0)
-		{
-			return i;
-		}
-	}
-
-	// AssertMsg( 0, UTIL_VarArgs( "poseparameter %s couldn't be mapped!!!\n", szName ) );
-	return -1; // Error
+	return ::LookupPoseParameter( pstudiohdr, szName );
 }
 
 //=========================================================
@@ -932,15 +932,22 @@ void C_Player::UpdateFlashlight()
         }
 
         // El servidor no quiere luces dinmicas para las linternas de otros jugadores.
-        if ( !sv_flashlight_realistic.GetBool() ) {
+        FlashlightQuality maxQuality = ( sv_flashlight_realistic.GetBool() ) ? FLASHLIGHT_QUALITY_SHADOWED : FLASHLIGHT_QUALITY_SPRITE;
+
+        // Solo las linternas mas importantes para nosotros usan texturas proyectadas
+        Vector vecEnd;
+        FlashlightQuality quality = TheFlashlightBudget->Request( index, m_vecFlashlightOrigin, m_vecFlashlightForward, pPlayer->GetFlashlightFarZ(), pPlayer->GetFlashlightFOV(), maxQuality, &vecEnd );
+
+        if ( quality <= FLASHLIGHT_QUALITY_SPRITE ) {
             GetFlashlight( NORMAL )->TurnOff();
 
-            trace_t tr;
-            UTIL_TraceLine( m_vecFlashlightOrigin, m_vecFlashlightOrigin + (m_vecFlashlightForward * pPlayer->GetFlashlightFarZ()), MASK_SOLID, this, COLLISION_GROUP_NONE, &tr );
+            // No se ve
+            if ( quality == FLASHLIGHT_QUALITY_NONE )
+                return;
 
             // Usamos una linterna barata en recursos
             dlight_t *el = effects->CL_AllocDlight( index );
-            el->origin = tr.endpos;
+            el->origin = vecEnd;
             el->radius = pPlayer->GetFlashlightFOV() + 35.0f;
             el->decay = el->radius / 0.05f;
             el->die = gpGlobals->curtime + 0.001f;
@@ -952,7 +959,7 @@ void C_Player::UpdateFlashlight()
         }
 
         // Las linternas de otros jugadores son de baja calidad
-        GetFlashlight( NORMAL )->SetShadows( true, false, 0, 2.5f );
+        GetFlashlight( NORMAL )->SetShadows( (quality == FLASHLIGHT_QUALITY_SHADOWED), false, 0, 2.5f );
     }
 
     GetFlashlight( NORMAL )->SetFOV( pPlayer->GetFlashlightFOV() );
@@ -34,6 +34,14 @@ DECLARE_CHEAT_CMD( r_projectedtexture_nearoffsetscale, "1.0", "" )
 DECLARE_CHEAT_CMD( r_projectedtexture_tracedistcutoff, "128", "" )
 DECLARE_CHEAT_CMD( r_projectedtexture_backtraceoffset, "0.4", "" )
 
+DECLARE_CMD( r_flashlight_budget_shadowed, "2", "Numero de linternas de otros jugadores que pueden proyectar sombras", FCVAR_ARCHIVE )
+DECLARE_CMD( r_flashlight_budget_unshadowed, "4", "Numero de linternas de otros jugadores que pueden usar una textura proyectada sin sombras", FCVAR_ARCHIVE )
+
+DECLARE_CHEAT_CMD( r_flashlight_budget_maxdist, "3000", "" )
+DECLARE_CHEAT_CMD( r_flashlight_budget_occlusion, "0.2", "" )
+DECLARE_CHEAT_CMD( r_flashlight_budget_hysteresis, "0.25", "" )
+DECLARE_CHEAT_CMD( r_flashlight_budget_traceinterval, "0.15", "" )
+
 //================================================================================
 // Constructor
 //================================================================================
@@ -698,3 +706,311 @@ int CProjectedLight::GetEntIndex() const
 {
     return m_Lights.Element( 0 )->GetEntIndex();
 }
+
+//================================================================================
+// Presupuesto de linternas
+//================================================================================
+
+static CFlashlightBudget g_FlashlightBudget;
+CFlashlightBudget *TheFlashlightBudget = &g_FlashlightBudget;
+
+//================================================================================
+// Devuelve la fraccion (aproximada) de la pantalla que ocupa la esfera
+//================================================================================
+float FlashlightBudget_Coverage( const FlashlightBudgetView_t &view, const Vector &vecCenter, float flRadius )
+{
+    Vector vecDelta = vecCenter - view.origin;
+    float flDistance = vecDelta.Length();
+
+    // Estamos dentro
+    if ( flDistance <= flRadius )
+        return 1.0f;
+
+    float flHalfFOV = DEG2RAD( clamp( view.fov, 1.0f, 170.0f ) * 0.5f );
+    float flAngularRadius = asin( flRadius / flDistance );
+    float flAngle = acos( clamp( DotProduct( vecDelta / flDistance, view.forward ), -1.0f, 1.0f ) );
+
+    // Fuera de la pantalla
+    if ( flAngle - flAngularRadius > flHalfFOV )
+        return 0.0f;
+
+    float flSize = tan( MIN( flAngularRadius, DEG2RAD( 89.0f ) ) ) / tan( flHalfFOV );
+    return clamp( flSize * flSize, 0.0f, 1.0f );
+}
+
+//================================================================================
+// Devuelve la importancia de la linterna para esta vista
+//================================================================================
+float FlashlightBudget_Score( const FlashlightBudgetView_t &view, const FlashlightBudgetLight_t &light, float flMaxDistance, float flOcclusionScale )
+{
+    // Esfera que envuelve el cono de luz hasta donde choca
+    float flLength = light.origin.DistTo( light.end );
+    float flConeRadius = flLength * tan( DEG2RAD( clamp( light.fov, 1.0f, 170.0f ) * 0.5f ) );
+    float flRadius = FastSqrt( 0.25f * flLength * flLength + flConeRadius * flConeRadius );
+
+    Vector vecCenter = (light.origin + light.end) * 0.5f;
+    float flDistance = MAX( view.origin.DistTo( vecCenter ) - flRadius, 0.0f );
+
+    if ( flMaxDistance <= 0.0f || flDistance >= flMaxDistance )
+        return 0.0f;
+
+    float flScore = FlashlightBudget_Coverage( view, vecCenter, flRadius );
+
+    // Las luces lejanas pierden importancia aunque ocupen mucho
+    flScore *= 1.0f - (flDistance / flMaxDistance);
+
+    if ( light.occluded )
+        flScore *= flOcclusionScale;
+
+    return flScore;
+}
+
+//================================================================================
+//================================================================================
+static int __cdecl FlashlightBudgetLightCompare( const FlashlightBudgetLight_t *a, const FlashlightBudgetLight_t *b )
+{
+    if ( a->priority != b->priority )
+        return ( a->priority > b->priority ) ? -1 : 1;
+
+    return a->index - b->index;
+}
+
+//================================================================================
+// Ordena las linternas por importancia y les asigna la calidad
+//================================================================================
+void FlashlightBudget_Select( CUtlVector<FlashlightBudgetLight_t> &lights, int nShadowed, int nUnshadowed, float flHysteresis )
+{
+    // Preferimos las que ya tenian una textura proyectada, asi no parpadean
+    FOR_EACH_VEC( lights, it )
+    {
+        FlashlightBudgetLight_t &light = lights[it];
+        light.priority = light.score;
+
+        if ( light.lastQuality >= FLASHLIGHT_QUALITY_UNSHADOWED )
+            light.priority *= 1.0f + flHysteresis;
+    }
+
+    lights.Sort( FlashlightBudgetLightCompare );
+
+    FOR_EACH_VEC( lights, it )
+    {
+        FlashlightBudgetLight_t &light = lights[it];
+        light.quality = FLASHLIGHT_QUALITY_NONE;
+
+        if ( light.score <= 0.0f )
+            continue;
+
+        if ( light.maxQuality >= FLASHLIGHT_QUALITY_SHADOWED && nShadowed > 0 ) {
+            light.quality = FLASHLIGHT_QUALITY_SHADOWED;
+            --nShadowed;
+        }
+        else if ( light.maxQuality >= FLASHLIGHT_QUALITY_UNSHADOWED && nUnshadowed > 0 ) {
+            light.quality = FLASHLIGHT_QUALITY_UNSHADOWED;
+            --nUnshadowed;
+        }
+        else {
+            light.quality = (FlashlightQuality)MIN( light.maxQuality, FLASHLIGHT_QUALITY_SPRITE );
+        }
+    }
+}
+
+//================================================================================
+// Constructor
+//================================================================================
+CFlashlightBudget::CFlashlightBudget()
+{
+    m_iFrame = -1;
+
+    for ( int it = 0; it <= MAX_PLAYERS; ++it ) {
+        m_Info[it].quality = FLASHLIGHT_QUALITY_SPRITE;
+        m_Info[it].frame = -1;
+        m_Info[it].nextTrace = 0.0f;
+        m_Info[it].fraction = 1.0f;
+        m_Info[it].endTraced = false;
+        m_Info[it].occluded = false;
+    }
+}
+
+//================================================================================
+// Pide una textura proyectada para la linterna del jugador, devuelve la
+// calidad que le toca (calculada con las linternas del frame anterior)
+//================================================================================
+FlashlightQuality CFlashlightBudget::Request( int index, const Vector &vecOrigin, const Vector &vecForward, float flFarZ, float flFOV, FlashlightQuality maxQuality, Vector *pEndPosition )
+{
+    VPROF_BUDGET( __FUNCTION__, VPROF_BUDGETGROUP_SHADOW_DEPTH_TEXTURING );
+
+    Assert( index > 0 && index <= MAX_PLAYERS );
+
+    if ( index <= 0 || index > MAX_PLAYERS ) {
+        if ( pEndPosition )
+            *pEndPosition = vecOrigin + vecForward * flFarZ;
+
+        return maxQuality;
+    }
+
+    // Nuevo frame: repartimos con las linternas del anterior
+    if ( m_iFrame != gpGlobals->framecount ) {
+        Select();
+
+        m_Selected.Swap( m_Lights );
+        m_Lights.RemoveAll();
+        m_iFrame = gpGlobals->framecount;
+    }
+
+    LightInfo_t &info = m_Info[index];
+
+    // No se pidio en el frame anterior, empezamos de nuevo
+    if ( info.frame != gpGlobals->framecount && info.frame != gpGlobals->framecount - 1 ) {
+        info.quality = FLASHLIGHT_QUALITY_SPRITE;
+        info.nextTrace = 0.0f;
+    }
+
+    // Donde choca la luz solo hace falta para la luz dinamica que la reemplaza,
+    // las texturas proyectadas no la usan
+    bool bNeedEnd = ( MIN( info.quality, maxQuality ) <= FLASHLIGHT_QUALITY_SPRITE );
+
+    // Las trazas son caras, todas las linternas las hacen cada cierto tiempo
+    // (o en cuanto necesitamos saber donde choca y no lo sabemos)
+    if ( gpGlobals->curtime >= info.nextTrace || (bNeedEnd && !info.endTraced) ) {
+        UpdateTraces( index, info, vecOrigin, vecForward, flFarZ, bNeedEnd );
+        info.nextTrace = gpGlobals->curtime + r_flashlight_budget_traceinterval.GetFloat();
+    }
+
+    Vector vecEnd = vecOrigin + vecForward * (flFarZ * info.fraction);
+
+    if ( pEndPosition )
+        *pEndPosition = vecEnd;
+
+    // Ya la tenemos en este frame
+    if ( info.frame != gpGlobals->framecount ) {
+        info.frame = gpGlobals->framecount;
+
+        FlashlightBudgetLight_t &light = m_Lights[m_Lights.AddToTail()];
+        light.index = index;
+        light.origin = vecOrigin;
+        light.end = vecEnd;
+        light.fov = flFOV;
+        light.occluded = info.occluded;
+        light.maxQuality = maxQuality;
+        light.lastQuality = info.quality;
+        light.score = 0.0f;
+        light.priority = 0.0f;
+        light.quality = info.quality;
+    }
+
+    return (FlashlightQuality)MIN( info.quality, maxQuality );
+}
+
+//================================================================================
+// Calcula la importancia de las linternas pedidas en el frame anterior
+//================================================================================
+void CFlashlightBudget::Select()
+{
+    VPROF_BUDGET( __FUNCTION__, VPROF_BUDGETGROUP_SHADOW_DEPTH_TEXTURING );
+
+    if ( m_Lights.Count() == 0 )
+        return;
+
+    FlashlightBudgetView_t views[MAX_SPLITSCREEN_PLAYERS];
+    int nViews = 0;
+
+    FOR_EACH_VALID_SPLITSCREEN_PLAYER( hh )
+    {
+        const CViewSetup *pSetup = view->GetPlayerViewSetup( hh );
+
+        views[nViews].origin = MainViewOrigin( hh );
+        views[nViews].forward = MainViewForward( hh );
+        views[nViews].fov = (pSetup) ? pSetup->fov : 90.0f;
+        ++nViews;
+    }
+
+    FOR_EACH_VEC( m_Lights, it )
+    {
+        FlashlightBudgetLight_t &light = m_Lights[it];
+
+        for ( int hh = 0; hh < nViews; ++hh ) {
+            light.score = MAX( light.score, FlashlightBudget_Score( views[hh], light, r_flashlight_budget_maxdist.GetFloat(), r_flashlight_budget_occlusion.GetFloat() ) );
+        }
+    }
+
+    FlashlightBudget_Select( m_Lights, r_flashlight_budget_shadowed.GetInt(), r_flashlight_budget_unshadowed.GetInt(), r_flashlight_budget_hysteresis.GetFloat() );
+
+    FOR_EACH_VEC( m_Lights, it )
+    {
+        m_Info[m_Lights[it].index].quality = m_Lights[it].quality;
+    }
+}
+
+//================================================================================
+// Actualiza donde choca la luz y si alguna vista puede verla
+//================================================================================
+void CFlashlightBudget::UpdateTraces( int index, LightInfo_t &info, const Vector &vecOrigin, const Vector &vecForward, float flFarZ, bool bTraceEnd )
+{
+    C_BasePlayer *pPlayer = UTIL_PlayerByIndex( index );
+
+    trace_t tr;
+    Vector vecEnd;
+
+    // Si no la necesitamos usamos la fraccion de la ultima vez
+    if ( bTraceEnd ) {
+        UTIL_TraceLine( vecOrigin, vecOrigin + (vecForward * flFarZ), MASK_SOLID, pPlayer, COLLISION_GROUP_NONE, &tr );
+        info.fraction = tr.fraction;
+
+        // Un poco antes de la pared
+        vecEnd = tr.endpos;
+
+        if ( tr.DidHit() )
+            vecEnd += tr.plane.normal * 4.0f;
+    }
+    else {
+        vecEnd = vecOrigin + vecForward * (flFarZ * info.fraction);
+    }
+
+    info.endTraced = bTraceEnd;
+    info.occluded = true;
+
+    FOR_EACH_VALID_SPLITSCREEN_PLAYER( hh )
+    {
+        CTraceFilterSkipTwoEntities filter( pPlayer, C_BasePlayer::GetLocalPlayer( hh ), COLLISION_GROUP_NONE );
+        const Vector &vecView = MainViewOrigin( hh );
+
+        UTIL_TraceLine( vecView, vecOrigin, MASK_OPAQUE, &filter, &tr );
+
+        if ( tr.fraction == 1.0f ) {
+            info.occluded = false;
+            return;
+        }
+
+        UTIL_TraceLine( vecView, vecEnd, MASK_OPAQUE, &filter, &tr );
+
+        if ( tr.fraction == 1.0f ) {
+            info.occluded = false;
+            return;
+        }
+    }
+}
+
+//================================================================================
+//================================================================================
+void CFlashlightBudget::Print()
+{
+    static const char *pQualityNames[LAST_FLASHLIGHT_QUALITY] = {
+        "None",
+        "Sprite",
+        "Unshadowed",
+        "Shadowed"
+    };
+
+    Msg( "%i flashlights (%i shadowed, %i unshadowed):\n", m_Selected.Count(), r_flashlight_budget_shadowed.GetInt(), r_flashlight_budget_unshadowed.GetInt() );
+
+    FOR_EACH_VEC( m_Selected, it )
+    {
+        const FlashlightBudgetLight_t &light = m_Selected[it];
+        Msg( "  #%i - %s (score: %.4f, priority: %.4f%s)\n", light.index, pQualityNames[light.quality], light.score, light.priority, (light.occluded) ? ", occluded" : "" );
+    }
+}
+
+CON_COMMAND_F( r_flashlight_budget_print, "Muestra la calidad de las linternas de los demas jugadores", FCVAR_CHEAT )
+{
+    TheFlashlightBudget->Print();
+}
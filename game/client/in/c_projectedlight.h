@@ -206,4 +206,89 @@ protected:
     CUtlVector<CInternalLight *> m_Lights;
 };
 
+//================================================================================
+// Calidad con la que se dibuja la linterna de otro jugador
+//================================================================================
+enum FlashlightQuality
+{
+    FLASHLIGHT_QUALITY_NONE = 0,        // No se dibuja
+    FLASHLIGHT_QUALITY_SPRITE,          // Luz dinamica barata donde choca la luz
+    FLASHLIGHT_QUALITY_UNSHADOWED,      // Textura proyectada sin sombras
+    FLASHLIGHT_QUALITY_SHADOWED,        // Textura proyectada con sombras
+
+    LAST_FLASHLIGHT_QUALITY
+};
+
+//================================================================================
+// Vista desde la que se calcula la importancia de las linternas
+//================================================================================
+struct FlashlightBudgetView_t
+{
+    Vector origin;
+    Vector forward;
+    float fov;
+};
+
+//================================================================================
+// Linterna que pide una textura proyectada en este frame
+//================================================================================
+struct FlashlightBudgetLight_t
+{
+    int index;
+    Vector origin;
+    Vector end;         // Donde choca la luz
+    float fov;
+    bool occluded;      // Ninguna vista puede ver la linterna ni donde choca la luz
+
+    FlashlightQuality maxQuality;
+    FlashlightQuality lastQuality;
+
+    float score;
+    float priority;
+    FlashlightQuality quality;
+};
+
+// No dependen del render, solo de la vista y de las linternas
+extern float FlashlightBudget_Coverage( const FlashlightBudgetView_t &view, const Vector &vecCenter, float flRadius );
+extern float FlashlightBudget_Score( const FlashlightBudgetView_t &view, const FlashlightBudgetLight_t &light, float flMaxDistance, float flOcclusionScale );
+extern void FlashlightBudget_Select( CUtlVector<FlashlightBudgetLight_t> &lights, int nShadowed, int nUnshadowed, float flHysteresis );
+
+//================================================================================
+// Reparte las texturas proyectadas con sombras entre las linternas de los
+// demas jugadores (y bots), las menos importantes usan aproximaciones baratas
+//================================================================================
+class CFlashlightBudget
+{
+public:
+    DECLARE_CLASS_NOBASE( CFlashlightBudget );
+
+    CFlashlightBudget();
+
+    virtual FlashlightQuality Request( int index, const Vector &vecOrigin, const Vector &vecForward, float flFarZ, float flFOV, FlashlightQuality maxQuality = FLASHLIGHT_QUALITY_SHADOWED, Vector *pEndPosition = NULL );
+    virtual void Print();
+
+protected:
+    struct LightInfo_t
+    {
+        FlashlightQuality quality;
+        int frame;
+        float nextTrace;
+        float fraction;
+        bool endTraced;
+        bool occluded;
+    };
+
+    virtual void Select();
+    virtual void UpdateTraces( int index, LightInfo_t &info, const Vector &vecOrigin, const Vector &vecForward, float flFarZ, bool bTraceEnd );
+
+protected:
+    int m_iFrame;
+    LightInfo_t m_Info[MAX_PLAYERS + 1];
+
+    CUtlVector<FlashlightBudgetLight_t> m_Lights;
+    CUtlVector<FlashlightBudgetLight_t> m_Selected;
+};
+
+extern CFlashlightBudget *TheFlashlightBudget;
+
 #endif
\ No newline at end of file
@@ -1048,13 +1048,17 @@ void CParticleMgr::LevelInit()
 
 Particle *CParticleMgr::AllocParticle( int size )
 {
-	// Enforce max particle limit.
-	if ( m_nCurrentParticlesAllocated >= MAX_TOTAL_PARTICLES )
+	// Enforce max particle limit. Effects can allocate from several threads at once,
+	// so take the slot first and give it back if we went over.
+	if ( ++m_nCurrentParticlesAllocated > MAX_TOTAL_PARTICLES )
+	{
+		--m_nCurrentParticlesAllocated;
 		return NULL;
+	}
 		
 	Particle *pRet = (Particle *)malloc( size );
-	if ( pRet )
-		++m_nCurrentParticlesAllocated;
+	if ( !pRet )
+		--m_nCurrentParticlesAllocated;
 
 	return pRet;
 }
@@ -1496,6 +1500,16 @@ static void ProcessNonDrawingSystem( CParticleCollection *&pNonDrawingEffect )
 }
 
 
+static ConVar r_threaded_legacy_particles( "r_threaded_legacy_particles", "1", 0, "Simulate the particles of the old effects (CParticleEffectBinding) that allow it in the thread pool" );
+
+static float s_flThreadedEffectTimeStep;
+
+static void ProcessEffectBinding( CParticleEffectBinding *&pEffect )
+{
+	pEffect->SimulateParticles( s_flThreadedEffectTimeStep );
+}
+
+
 
 int CParticleMgr::ComputeParticleDefScreenArea( int nInfoCount, RetireInfo_t *pInfo, float *pTotalArea, CParticleSystemDefinition* pDef, 
 	const CViewSetup& view, const VMatrix &worldToPixels, float flFocalDist )
@@ -1869,6 +1883,8 @@ void CParticleMgr::UpdateAllEffects( float flTimeDelta )
 	if( flTimeDelta > 0.1f )
 		flTimeDelta = 0.1f;
 
+	// first, run the non-reentrant part
+	CUtlVectorFixedGrowable< CParticleEffectBinding *, 128 > effectsToSimulate;
 	FOR_EACH_LL( m_Effects, iEffect )
 	{
 		CParticleEffectBinding *pEffect = m_Effects[iEffect];
@@ -1893,15 +1909,42 @@ void CParticleMgr::UpdateAllEffects( float flTimeDelta )
 		// This flag will get set to true if the effect is drawn through the leaf system.
 		pEffect->SetDrawn( false );
 
-		// Update the effect.
+		// Update the effect, this one can call into random entity code which may not be thread-safe
 		pEffect->m_pSim->Update( flTimeDelta );
 
 		if ( pEffect->GetFirstFrameFlag() )
 			pEffect->SetFirstFrameFlag( false );
+		else if ( pEffect->GetThreadedSimulation() )
+			effectsToSimulate.AddToTail( pEffect );
 		else
 			pEffect->SimulateParticles( flTimeDelta );
+	}
+
+	// only the effects that said their simulation is self-contained run in parallel
+	if ( effectsToSimulate.Count() )
+	{
+		s_flThreadedEffectTimeStep = flTimeDelta;
+
+		if ( !r_threaded_particles.GetBool() || !r_threaded_legacy_particles.GetBool() )
+		{
+			for ( int i = 0; i < effectsToSimulate.Count(); i++ )
+			{
+				ProcessEffectBinding( effectsToSimulate[i] );
+			}
+		}
+		else
+		{
+			ParallelProcess( effectsToSimulate.Base(), effectsToSimulate.Count(), ProcessEffectBinding, PreProcessPSystem, PostProcessPSystem );
+		}
+	}
+
+	// now, update the position in the leaf system of the ones whose bbox changed
+	FOR_EACH_LL( m_Effects, iEffect )
+	{
+		CParticleEffectBinding *pEffect = m_Effects[iEffect];
+		if ( pEffect->GetRemoveFlag() )
+			continue;
 
-		// Update its position in the leaf system if its bbox changed.
 		pEffect->DetectChanges();
 	}
 
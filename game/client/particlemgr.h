@@ -117,6 +117,7 @@ entities. Each one is useful under different conditions.
 #include "iclientrenderable.h"
 #include "clientleafsystem.h"
 #include "tier0/fasttimer.h"
+#include "tier0/threadtools.h"
 #include "utllinkedlist.h"
 #include "UtlDict.h"
 #ifdef WIN32
@@ -403,6 +404,12 @@ public:
 	void			SetAlwaysSimulate( int bAlwaysSimulate )		{ SetFlag( FLAGS_ALWAYSSIMULATE, bAlwaysSimulate ); }
 
 	void			SetIsNewParticleSystem( void )		{ SetFlag( FLAGS_NEW_PARTICLE_SYSTEM, 1 ); }
+
+	// Set by effects whose SimulateParticles only touches their own particles (no entities,
+	// traces or other effects), so they can be simulated in the thread pool.
+	// This flag is OFF by default.
+	int				GetThreadedSimulation()							{ return GetFlag( FLAGS_THREADED_SIMULATION ); }
+	void			SetThreadedSimulation( int bThreaded )			{ SetFlag( FLAGS_THREADED_SIMULATION, bThreaded ); }
 	// Set if the effect was drawn the previous frame.
 	// This can be used by particle effect classes
 	// to decide whether or not they want to spawn
@@ -543,7 +550,8 @@ private:
 		FLAGS_DRAW_BEFORE_VIEW_MODEL=(1<<9),// Draw before the view model? If this is set, it assumes FLAGS_DRAW_THRU_LEAF_SYSTEM goes off.
 		FLAGS_AUTOAPPLYLOCALTRANSFORM=(1<<10), // Automatically apply the local transform to CParticleMgr::GetModelView()'s matrix.
 		FLAGS_FIRST_FRAME =         (1<<11),	// Cleared after the first frame that this system exists (so it can simulate after rendering once).
-		FLAGS_NEW_PARTICLE_SYSTEM=  (1<<12) // uses new particle system
+		FLAGS_NEW_PARTICLE_SYSTEM=  (1<<12), // uses new particle system
+		FLAGS_THREADED_SIMULATION=  (1<<13)	// See SetThreadedSimulation.
 	};
 
 
@@ -755,7 +763,7 @@ private:
 
 private:
 
-	int m_nCurrentParticlesAllocated;
+	CInterlockedInt m_nCurrentParticlesAllocated;	// threaded effects can add or remove particles while simulating in parallel
 
 	// Directional lighting info.
 	CParticleLightInfo m_DirectionalLight;
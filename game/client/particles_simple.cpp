@@ -237,6 +237,9 @@ CSmartPtr<CSimpleEmitter> CSimpleEmitter::Create( const char *pDebugName )
 {
 	CSimpleEmitter *pRet = new CSimpleEmitter( pDebugName );
 	pRet->SetDynamicallyAllocated( true );
+
+	// Derived emitters may override the Update* functions, only the plain one is known to be self-contained
+	pRet->GetBinding().SetThreadedSimulation( true );
 	return pRet;
 }
 
@@ -4,6 +4,7 @@
 #include "filesystem.h"
 #include "asw_system.h"
 #include "convar.h"
+#include "utlbuffer.h"
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include <tier0/memdbgon.h>
@@ -17,6 +18,12 @@ static FileFindHandle_t	g_hthemefind = FILESYSTEM_INVALID_FIND_HANDLE;
 
 ConVar asw_tilegen_theme( "asw_tilegen_theme", "Rydberg", FCVAR_ARCHIVE, "Default theme selected in TileGen" );
 
+ConVar tilegen_source_cache( "tilegen_source_cache", "1", FCVAR_NONE, "Load level themes and room templates from a binary cache, rebuilt whenever one of their files changes" );
+
+#define TILESOURCE_CACHE_FILE		"tilegen/tilesource.cache"
+#define TILESOURCE_CACHE_ID			MAKEID( 'T', 'S', 'R', 'C' )
+#define TILESOURCE_CACHE_VERSION	1
+
 // Loads in all level themes found in tilegen/themes/
 void CLevelTheme::LoadLevelThemes()
 {
@@ -27,6 +34,41 @@ void CLevelTheme::LoadLevelThemes()
 	s_LevelThemes.PurgeAndDeleteElements();
 	s_bLoadedThemes = true;
 
+	double flStartTime = Plat_FloatTime();
+
+	CUtlVector<SourceFile_t> sourceFiles;
+	GatherSourceFiles( sourceFiles );
+
+	bool bFromCache = tilegen_source_cache.GetBool() && LoadLevelThemesFromCache( s_LevelThemes, sourceFiles );
+	if ( !bFromCache )
+	{
+		LoadLevelThemesFromText( s_LevelThemes );
+		if ( tilegen_source_cache.GetBool() )
+		{
+			SaveLevelThemesToCache( s_LevelThemes, sourceFiles );
+		}
+	}
+
+	int nRoomTemplates = 0;
+	for ( int i = 0; i < s_LevelThemes.Count(); i++ )
+	{
+		CLevelTheme *pTheme = s_LevelThemes[i];
+		nRoomTemplates += pTheme->m_RoomTemplates.Count();
+		if (!Q_stricmp(pTheme->m_szName, asw_tilegen_theme.GetString()))	// default to the Rydberg theme
+			SetCurrentTheme(pTheme);
+	}
+
+	if ( s_pCurrentTheme == NULL && s_LevelThemes.Count() > 0 )
+	{
+		SetCurrentTheme( s_LevelThemes[0] );
+	}
+
+	DevMsg( "Loaded %d level themes, %d room templates from %s in %.2f ms\n", s_LevelThemes.Count(), nRoomTemplates,
+		bFromCache ? TILESOURCE_CACHE_FILE : "text files", ( Plat_FloatTime() - flStartTime ) * 1000.0f );
+}
+
+void CLevelTheme::LoadLevelThemesFromText( CUtlVector<CLevelTheme*> &themes )
+{
 	// Search the directory structure.
 	char mapwild[MAX_PATH];
 	Q_strncpy(mapwild,"tilegen/themes/*.theme", sizeof( mapwild ) );
@@ -54,9 +96,7 @@ void CLevelTheme::LoadLevelThemes()
 				pTheme->m_vecAmbientLight.z = 1;
 			}
 			pTheme->LoadRoomTemplates();
-			s_LevelThemes.AddToTail(pTheme);
-			if (!Q_stricmp(pTheme->m_szName, asw_tilegen_theme.GetString()))	// default to the Rydberg theme
-				SetCurrentTheme(pTheme);
+			themes.AddToTail(pTheme);
 		}
 		else
 		{
@@ -65,13 +105,167 @@ void CLevelTheme::LoadLevelThemes()
 		pThemeKeyValues->deleteThis();
 		filename = Sys_FindNext(g_hthemefind, NULL, 0);
 	}
+		
+	Sys_FindClose(g_hthemefind);
+}
 
-	if ( s_pCurrentTheme == NULL && s_LevelThemes.Count() > 0 )
+void CLevelTheme::GatherSourceFiles( CUtlVector<SourceFile_t> &sourceFiles )
+{
+	sourceFiles.RemoveAll();
+	GatherSourceFilesInFolder( "tilegen/themes", "theme", false, sourceFiles );
+	GatherSourceFilesInFolder( "tilegen/tags", "txt", false, sourceFiles );		// room template tags are checked against these
+	GatherSourceFilesInFolder( "tilegen/roomtemplates", "roomtemplate", true, sourceFiles );
+}
+
+void CLevelTheme::GatherSourceFilesInFolder( const char *szPath, const char *szExtension, bool bRecursive, CUtlVector<SourceFile_t> &sourceFiles )
+{
+	char mapwild[MAX_PATH];
+	Q_snprintf( mapwild, sizeof( mapwild ), "%s/*", szPath );
+	char const *filename;
+	FileFindHandle_t	hFind = FILESYSTEM_INVALID_FIND_HANDLE;
+	filename = Sys_FindFirst( hFind, mapwild, NULL, 0 );
+	while ( filename )
 	{
-		SetCurrentTheme( s_LevelThemes[0] );
+		if ( g_pFullFileSystem->FindIsDirectory( hFind ) )
+		{
+			if ( bRecursive && Q_strcmp( filename, "." ) && Q_strcmp( filename, ".." ) )
+			{
+				char subfolder[MAX_PATH];
+				Q_snprintf( subfolder, sizeof( subfolder ), "%s/%s", szPath, filename );
+				GatherSourceFilesInFolder( subfolder, szExtension, bRecursive, sourceFiles );
+			}
+		}
+		else
+		{
+			const char *pExt = Q_GetFileExtension( filename );
+			if ( pExt && !Q_stricmp( pExt, szExtension ) )
+			{
+				SourceFile_t &sourceFile = sourceFiles[ sourceFiles.AddToTail() ];
+				Q_snprintf( sourceFile.m_szFileName, sizeof( sourceFile.m_szFileName ), "%s/%s", szPath, filename );
+				sourceFile.m_nFileTime = g_pFullFileSystem->GetFileTime( sourceFile.m_szFileName, "GAME" );
+			}
+		}
+		filename = Sys_FindNext( hFind, NULL, 0 );
 	}
-		
-	Sys_FindClose(g_hthemefind);
+
+	Sys_FindClose( hFind );
+}
+
+bool CLevelTheme::LoadLevelThemesFromCache( CUtlVector<CLevelTheme*> &themes, const CUtlVector<SourceFile_t> &sourceFiles )
+{
+	// the whole cache is read in one go, then parsed from memory
+	CUtlBuffer buf;
+	if ( !g_pFullFileSystem->ReadFile( TILESOURCE_CACHE_FILE, "GAME", buf ) )
+		return false;
+
+	if ( buf.GetInt() != TILESOURCE_CACHE_ID || buf.GetInt() != TILESOURCE_CACHE_VERSION )
+		return false;
+
+	// stale if any file was added, removed or changed since the cache was written
+	if ( buf.GetInt() != sourceFiles.Count() )
+		return false;
+
+	char szFileName[MAX_PATH];
+	for ( int i = 0; i < sourceFiles.Count(); i++ )
+	{
+		buf.GetString( szFileName, sizeof( szFileName ) );
+		long nFileTime = buf.GetInt();
+		if ( !buf.IsValid() || Q_stricmp( szFileName, sourceFiles[i].m_szFileName ) || nFileTime != sourceFiles[i].m_nFileTime )
+			return false;
+	}
+
+	int nFirstTheme = themes.Count();
+	int nThemes = buf.GetInt();
+	for ( int i = 0; i < nThemes && buf.IsValid(); i++ )
+	{
+		CLevelTheme *pTheme = new CLevelTheme( NULL, NULL, false );
+		themes.AddToTail( pTheme );
+		if ( !pTheme->LoadFromBuffer( buf ) )
+			break;
+	}
+
+	if ( !buf.IsValid() || themes.Count() - nFirstTheme != nThemes )
+	{
+		Warning( "Failed to read %s, rebuilding it\n", TILESOURCE_CACHE_FILE );
+		while ( themes.Count() > nFirstTheme )
+		{
+			delete themes.Tail();
+			themes.RemoveMultipleFromTail( 1 );
+		}
+		return false;
+	}
+
+	return true;
+}
+
+bool CLevelTheme::SaveLevelThemesToCache( const CUtlVector<CLevelTheme*> &themes, const CUtlVector<SourceFile_t> &sourceFiles )
+{
+	CUtlBuffer buf;
+	buf.PutInt( TILESOURCE_CACHE_ID );
+	buf.PutInt( TILESOURCE_CACHE_VERSION );
+
+	buf.PutInt( sourceFiles.Count() );
+	for ( int i = 0; i < sourceFiles.Count(); i++ )
+	{
+		buf.PutString( sourceFiles[i].m_szFileName );
+		buf.PutInt( sourceFiles[i].m_nFileTime );
+	}
+
+	buf.PutInt( themes.Count() );
+	for ( int i = 0; i < themes.Count(); i++ )
+	{
+		themes[i]->SaveToBuffer( buf );
+	}
+
+	if ( !g_pFullFileSystem->WriteFile( TILESOURCE_CACHE_FILE, "GAME", buf ) )
+	{
+		Msg( "Error: Failed to save %s\n", TILESOURCE_CACHE_FILE );
+		return false;
+	}
+	return true;
+}
+
+void CLevelTheme::SaveToBuffer( CUtlBuffer &buf ) const
+{
+	buf.PutString( m_szName );
+	buf.PutString( m_szDescription );
+	buf.PutChar( m_bRequiresVMFTweak ? 1 : 0 );
+	buf.PutChar( m_bSkipErrorCheck ? 1 : 0 );
+	buf.PutFloat( m_vecAmbientLight.x );
+	buf.PutFloat( m_vecAmbientLight.y );
+	buf.PutFloat( m_vecAmbientLight.z );
+
+	buf.PutInt( m_RoomTemplates.Count() );
+	for ( int i = 0; i < m_RoomTemplates.Count(); i++ )
+	{
+		m_RoomTemplates[i]->SaveToBuffer( buf );
+	}
+}
+
+bool CLevelTheme::LoadFromBuffer( CUtlBuffer &buf )
+{
+	buf.GetString( m_szName, sizeof( m_szName ) );
+	buf.GetString( m_szDescription, sizeof( m_szDescription ) );
+	m_bRequiresVMFTweak = ( buf.GetChar() != 0 );
+	m_bSkipErrorCheck = ( buf.GetChar() != 0 );
+	m_vecAmbientLight.x = buf.GetFloat();
+	m_vecAmbientLight.y = buf.GetFloat();
+	m_vecAmbientLight.z = buf.GetFloat();
+
+	m_RoomTemplates.PurgeAndDeleteElements();
+	int nRoomTemplates = buf.GetInt();
+	for ( int i = 0; i < nRoomTemplates && buf.IsValid(); i++ )
+	{
+		CRoomTemplate *pRoomTemplate = new CRoomTemplate( this );
+		if ( !pRoomTemplate->LoadFromBuffer( buf ) )
+		{
+			delete pRoomTemplate;
+			return false;
+		}
+		m_RoomTemplates.Insert( pRoomTemplate );
+	}
+
+	return buf.IsValid();
 }
 
 void CLevelTheme::SetCurrentTheme(CLevelTheme* pTheme)
@@ -257,4 +451,61 @@ bool CLevelTheme::SplitThemeAndRoom( const char *pszFullName, char *szThemeOut,
 
 	Q_strncpy( szRoomOut, pszFirstForwardSlash + 1, nRoomOutSize );
 	return true;
-}
\ No newline at end of file
+}
+
+// times loading every level theme and room template from the text files (cold) and from the binary cache (warm)
+void CC_TileGen_Source_Cache_Benchmark( const CCommand &args )
+{
+	int nIterations = ( args.ArgC() > 1 ) ? MAX( atoi( args[1] ), 1 ) : 5;
+
+	CUtlVector<CLevelTheme::SourceFile_t> sourceFiles;
+	CUtlVector<CLevelTheme*> themes;
+
+	double flStartTime = Plat_FloatTime();
+	CLevelTheme::GatherSourceFiles( sourceFiles );
+	double flGatherTime = Plat_FloatTime() - flStartTime;
+
+	flStartTime = Plat_FloatTime();
+	for ( int i = 0; i < nIterations; i++ )
+	{
+		CLevelTheme::LoadLevelThemesFromText( themes );
+		if ( i < nIterations - 1 )
+		{
+			themes.PurgeAndDeleteElements();
+		}
+	}
+	double flColdTime = ( Plat_FloatTime() - flStartTime ) / nIterations;
+
+	int nThemes = themes.Count();
+	int nRoomTemplates = 0;
+	for ( int i = 0; i < themes.Count(); i++ )
+	{
+		nRoomTemplates += themes[i]->m_RoomTemplates.Count();
+	}
+
+	flStartTime = Plat_FloatTime();
+	bool bSaved = CLevelTheme::SaveLevelThemesToCache( themes, sourceFiles );
+	double flSaveTime = Plat_FloatTime() - flStartTime;
+	themes.PurgeAndDeleteElements();
+
+	if ( !bSaved )
+		return;
+
+	flStartTime = Plat_FloatTime();
+	for ( int i = 0; i < nIterations; i++ )
+	{
+		if ( !CLevelTheme::LoadLevelThemesFromCache( themes, sourceFiles ) )
+		{
+			Warning( "Failed to load %s\n", TILESOURCE_CACHE_FILE );
+			return;
+		}
+		themes.PurgeAndDeleteElements();
+	}
+	double flWarmTime = ( Plat_FloatTime() - flStartTime ) / nIterations;
+
+	Msg( "%d level themes, %d room templates, %d source files (%.2f ms to check)\n", nThemes, nRoomTemplates, sourceFiles.Count(), flGatherTime * 1000.0f );
+	Msg( "  cold (text files): %.2f ms\n", flColdTime * 1000.0f );
+	Msg( "  warm (cache):      %.2f ms\n", flWarmTime * 1000.0f );
+	Msg( "  cache rebuild:     %.2f ms\n", flSaveTime * 1000.0f );
+}
+static ConCommand tilegen_source_cache_benchmark( "tilegen_source_cache_benchmark", CC_TileGen_Source_Cache_Benchmark, "Times loading the level themes and room templates from their text files and from the binary cache. Usage: tilegen_source_cache_benchmark [iterations]", FCVAR_CHEAT );
@@ -8,6 +8,7 @@
 #include "tier1/UtlSortVector.h"
 
 class CRoomTemplate;
+class CUtlBuffer;
 
 // alphabetical sorting of room templates by name
 class CRoomTemplateLessFunc
@@ -34,6 +35,10 @@ public:
 	bool SaveTheme(const char *pszThemeName);		// pass just the theme name like "GreyCorridor" (no extension/path)
 
 	void LoadRoomTemplates();	// makes this theme load in all its room templates
+
+	// binary form of the theme and all its room templates, used by the tilegen source cache
+	void SaveToBuffer( CUtlBuffer &buf ) const;
+	bool LoadFromBuffer( CUtlBuffer &buf );
 	CRoomTemplate* FindRoom( const char *szRoomTemplate );
 
 	CUtlSortVector<CRoomTemplate*, CRoomTemplateLessFunc> m_RoomTemplates;		// all the room templates that belong to this theme
@@ -51,8 +56,26 @@ public:
 
 	static bool SplitThemeAndRoom( const char *szFullName, char *szThemeOut, int nThemeOutSize, char *szRoomOut, int nRoomOutSize );
 
+	// a source file of the cache and the time it was last modified
+	struct SourceFile_t
+	{
+		char m_szFileName[MAX_PATH];
+		long m_nFileTime;
+	};
+
+	// fills the list with every theme, room template and tag file under tilegen/
+	static void GatherSourceFiles( CUtlVector<SourceFile_t> &sourceFiles );
+
+	// parse the .theme and .roomtemplate files
+	static void LoadLevelThemesFromText( CUtlVector<CLevelTheme*> &themes );
+
+	// the cache is only used if it was built from exactly the same source files
+	static bool LoadLevelThemesFromCache( CUtlVector<CLevelTheme*> &themes, const CUtlVector<SourceFile_t> &sourceFiles );
+	static bool SaveLevelThemesToCache( const CUtlVector<CLevelTheme*> &themes, const CUtlVector<SourceFile_t> &sourceFiles );
+
 private:
 	void LoadRoomTemplatesInFolder( const char *szPath );
+	static void GatherSourceFilesInFolder( const char *szPath, const char *szExtension, bool bRecursive, CUtlVector<SourceFile_t> &sourceFiles );
 };
 
 #endif TILEGEN_LEVELTHEME_H
\ No newline at end of file
@@ -118,6 +118,7 @@ m_pGenerationOptions( pGenerationOptions )
 			m_pRoomGrid[x][y] = NULL;
 		}
 	}
+	ClearBitboards();
 }
 
 CMapLayout::~CMapLayout()
@@ -152,6 +153,7 @@ void CMapLayout::Clear()
 			m_pRoomGrid[x][y] = NULL;
 		}
 	}
+	ClearBitboards();
 
 	m_iPlayerStartTileX = MAP_LAYOUT_TILES_WIDE * 0.5f;
 	m_iPlayerStartTileY = MAP_LAYOUT_TILES_WIDE * 0.5f;
@@ -423,31 +425,152 @@ bool CMapLayout::RoomsOverlap( int x, int y, int w, int h,
 
 bool CMapLayout::TemplateFits( const CRoomTemplate *pTemplate, int x, int y, bool bAllowNoExits ) const
 {
+	int iRoomWide = pTemplate->GetTilesX();
+	int iRoomTall = pTemplate->GetTilesY();
+
 	// check it's not out of bounds
-	if ( x < 0 || y < 0 || x + pTemplate->GetTilesX() > MAP_LAYOUT_TILES_WIDE || y + pTemplate->GetTilesY() > MAP_LAYOUT_TILES_WIDE )
+	if ( x < 0 || y < 0 || x + iRoomWide > MAP_LAYOUT_TILES_WIDE || y + iRoomTall > MAP_LAYOUT_TILES_WIDE )
 		return false;
 
+	// each side of the template has to fit in a single word to use the bitboards
+	bool bUseBitboards = ( iRoomWide > 0 && iRoomWide <= 64 && iRoomTall > 0 && iRoomTall <= 64 );
+
 	// check for overlapping any existing rooms
-	for (int j = 0 ; j < pTemplate->GetTilesX() ; j++)
+	if ( bUseBitboards )
 	{
-		for (int k = 0 ; k < pTemplate->GetTilesY() ; k++)
+		for ( int j = 0 ; j < iRoomWide ; j++ )
 		{
-			if (m_pRoomGrid[x+j][y+k])
+			if ( m_OccupiedColumns[x + j].Extract( y, iRoomTall ) != 0 )
 				return false;
 		}
 	}
+	else
+	{
+		for (int j = 0 ; j < iRoomWide ; j++)
+		{
+			for (int k = 0 ; k < iRoomTall ; k++)
+			{
+				if (m_pRoomGrid[x+j][y+k])
+					return false;
+			}
+		}
+	}
 
 	// if a template has no exits, assume it's a solid block used for capping and therefore fits anywhere
 	if ( bAllowNoExits && pTemplate->m_Exits.Count() == 0 )
 		return true;
 
 	// check for matching exits
-	if ( !CheckExits( pTemplate, x, y ) )
+	if ( bUseBitboards ? !CheckExitsBitboard( pTemplate, x, y ) : !CheckExits( pTemplate, x, y ) )
 		return false;
 
 	return true;
 }
 
+// Same result as CheckExits (minus the list of matching exits), but each side of the template is
+// tested in a few word ops: every occupied neighbour square must have an exit facing us exactly
+// where we have one facing it.  Exit tags are then only compared on the squares that connect.
+bool CMapLayout::CheckExitsBitboard( const CRoomTemplate *pTemplate, int x, int y ) const
+{
+	int iRoomWide = pTemplate->GetTilesX();
+	int iRoomTall = pTemplate->GetTilesY();
+
+	// our exits along each side, bit 0 is the left/bottom square of that side
+	uint64 ourExits[EXITDIR_END] = { 0, 0, 0, 0 };
+	for ( int i = 0; i < pTemplate->m_Exits.Count(); i++ )
+	{
+		const CRoomTemplateExit *pExit = pTemplate->m_Exits[i];
+		if ( pExit->m_bChokepointGrowSource )		// never connect into a chokepoint grow source
+			continue;
+		if ( pExit->m_iXPos < 0 || pExit->m_iXPos >= iRoomWide || pExit->m_iYPos < 0 || pExit->m_iYPos >= iRoomTall )
+			continue;
+
+		// template exits count Y down from the top
+		switch ( pExit->m_ExitDirection )
+		{
+		case EXITDIR_NORTH:
+			if ( pExit->m_iYPos == 0 )
+				ourExits[EXITDIR_NORTH] |= ( uint64 )1 << pExit->m_iXPos;
+			break;
+		case EXITDIR_SOUTH:
+			if ( pExit->m_iYPos == iRoomTall - 1 )
+				ourExits[EXITDIR_SOUTH] |= ( uint64 )1 << pExit->m_iXPos;
+			break;
+		case EXITDIR_WEST:
+			if ( pExit->m_iXPos == 0 )
+				ourExits[EXITDIR_WEST] |= ( uint64 )1 << ( ( iRoomTall - 1 ) - pExit->m_iYPos );
+			break;
+		case EXITDIR_EAST:
+			if ( pExit->m_iXPos == iRoomWide - 1 )
+				ourExits[EXITDIR_EAST] |= ( uint64 )1 << ( ( iRoomTall - 1 ) - pExit->m_iYPos );
+			break;
+		}
+	}
+
+	uint64 occupied, connected;
+
+	// check bottom
+	if ( y > 0 )
+	{
+		occupied = m_OccupiedRows[y - 1].Extract( x, iRoomWide );
+		if ( ( ourExits[EXITDIR_SOUTH] ^ m_ExitBoards[EXITDIR_NORTH][y - 1].Extract( x, iRoomWide ) ) & occupied )
+			return false;
+
+		connected = ourExits[EXITDIR_SOUTH] & occupied;
+		for ( int k = 0; connected != 0; k++, connected >>= 1 )
+		{
+			if ( ( connected & 1 ) && !CheckExitsOnSquares( pTemplate, k, iRoomTall - 1, EXITDIR_SOUTH, x + k, y - 1 ) )
+				return false;
+		}
+	}
+
+	// check top
+	if ( ( y + iRoomTall ) < MAP_LAYOUT_TILES_WIDE )
+	{
+		occupied = m_OccupiedRows[y + iRoomTall].Extract( x, iRoomWide );
+		if ( ( ourExits[EXITDIR_NORTH] ^ m_ExitBoards[EXITDIR_SOUTH][y + iRoomTall].Extract( x, iRoomWide ) ) & occupied )
+			return false;
+
+		connected = ourExits[EXITDIR_NORTH] & occupied;
+		for ( int k = 0; connected != 0; k++, connected >>= 1 )
+		{
+			if ( ( connected & 1 ) && !CheckExitsOnSquares( pTemplate, k, 0, EXITDIR_NORTH, x + k, y + iRoomTall ) )
+				return false;
+		}
+	}
+
+	// check left
+	if ( x > 0 )
+	{
+		occupied = m_OccupiedColumns[x - 1].Extract( y, iRoomTall );
+		if ( ( ourExits[EXITDIR_WEST] ^ m_ExitBoards[EXITDIR_EAST][x - 1].Extract( y, iRoomTall ) ) & occupied )
+			return false;
+
+		connected = ourExits[EXITDIR_WEST] & occupied;
+		for ( int j = 0; connected != 0; j++, connected >>= 1 )
+		{
+			if ( ( connected & 1 ) && !CheckExitsOnSquares( pTemplate, 0, (iRoomTall - 1) - j, EXITDIR_WEST, x - 1, y + j ) )
+				return false;
+		}
+	}
+
+	// check right
+	if ( ( x + iRoomWide ) < MAP_LAYOUT_TILES_WIDE )
+	{
+		occupied = m_OccupiedColumns[x + iRoomWide].Extract( y, iRoomTall );
+		if ( ( ourExits[EXITDIR_EAST] ^ m_ExitBoards[EXITDIR_WEST][x + iRoomWide].Extract( y, iRoomTall ) ) & occupied )
+			return false;
+
+		connected = ourExits[EXITDIR_EAST] & occupied;
+		for ( int j = 0; connected != 0; j++, connected >>= 1 )
+		{
+			if ( ( connected & 1 ) && !CheckExitsOnSquares( pTemplate, iRoomWide - 1, (iRoomTall - 1) - j, EXITDIR_EAST, x + iRoomWide, y + j ) )
+				return false;
+		}
+	}
+	return true;
+}
+
 bool CMapLayout::CheckExits( const CRoomTemplate *pTemplate, int x, int y, CUtlVector< CRoomTemplateExit * > *pMatchingExits ) const
 {
 	int iRoomWide = pTemplate->GetTilesX();
@@ -561,6 +684,7 @@ void CMapLayout::PlaceRoom( CRoom *pRoom )
 			m_pRoomGrid[x][y] = pRoom;
 		}
 	}
+	UpdateBitboards( pRoom, true );
 }
 
 void CMapLayout::RemoveRoom( CRoom *pRoom )
@@ -581,6 +705,67 @@ void CMapLayout::RemoveRoom( CRoom *pRoom )
 			m_pRoomGrid[x][y] = NULL;
 		}
 	}
+	UpdateBitboards( pRoom, false );
+}
+
+void CMapLayout::ClearBitboards()
+{
+	for ( int i = 0; i < MAP_LAYOUT_TILES_WIDE; i++ )
+	{
+		m_OccupiedColumns[i].ClearAll();
+		m_OccupiedRows[i].ClearAll();
+		for ( int dir = EXITDIR_BEGIN; dir < EXITDIR_END; dir++ )
+		{
+			m_ExitBoards[dir][i].ClearAll();
+		}
+	}
+}
+
+// sets or clears the squares and exits of a room in the bitboards used by TemplateFits
+void CMapLayout::UpdateBitboards( const CRoom *pRoom, bool bPlaced )
+{
+	const CRoomTemplate *pTemplate = pRoom->m_pRoomTemplate;
+	int iRoomWide = pTemplate->GetTilesX();
+	int iRoomTall = pTemplate->GetTilesY();
+
+	for ( int x = pRoom->m_iPosX ; x < pRoom->m_iPosX + iRoomWide ; x++ )
+	{
+		for ( int y = pRoom->m_iPosY ; y < pRoom->m_iPosY + iRoomTall ; y++ )
+		{
+			if ( bPlaced )
+			{
+				m_OccupiedColumns[x].Set( y );
+				m_OccupiedRows[y].Set( x );
+			}
+			else
+			{
+				m_OccupiedColumns[x].Clear( y );
+				m_OccupiedRows[y].Clear( x );
+			}
+		}
+	}
+
+	for ( int i = 0; i < pTemplate->m_Exits.Count(); i++ )
+	{
+		const CRoomTemplateExit *pExit = pTemplate->m_Exits[i];
+		ExitDirection_t dir = pExit->m_ExitDirection;
+		if ( dir < EXITDIR_BEGIN || dir >= EXITDIR_END )
+			continue;
+
+		// exits outside of the room's own squares can never be matched, so they're left out
+		if ( pExit->m_iXPos < 0 || pExit->m_iXPos >= iRoomWide || pExit->m_iYPos < 0 || pExit->m_iYPos >= iRoomTall )
+			continue;
+
+		int iExitX = pRoom->m_iPosX + pExit->m_iXPos;
+		int iExitY = pRoom->m_iPosY + ( iRoomTall - 1 ) - pExit->m_iYPos;
+		bool bRow = ( dir == EXITDIR_NORTH || dir == EXITDIR_SOUTH );
+
+		CMapLayoutBitRow &board = m_ExitBoards[dir][ bRow ? iExitY : iExitX ];
+		if ( bPlaced )
+			board.Set( bRow ? iExitX : iExitY );
+		else
+			board.Clear( bRow ? iExitX : iExitY );
+	}
 }
 
 void CMapLayout::AddLogicalRoom( CRoomTemplate *pRoomTemplate )
@@ -19,6 +19,38 @@ class CASW_Spawn_Definition;
 
 #define ASW_TILE_SIZE 256.0f
 
+#define MAP_LAYOUT_BITROW_WORDS ( ( MAP_LAYOUT_TILES_WIDE + 63 ) / 64 )
+
+//-----------------------------------------------------------------------------
+// One bit per tile along a full row (or column) of the layout grid.
+// Lets TemplateFits test a whole template edge with a few word ops
+// instead of walking the room grid tile by tile.
+//-----------------------------------------------------------------------------
+class CMapLayoutBitRow
+{
+public:
+	void ClearAll() { memset( m_Words, 0, sizeof( m_Words ) ); }
+	void Set( int i ) { m_Words[i >> 6] |= ( uint64 )1 << ( i & 63 ); }
+	void Clear( int i ) { m_Words[i >> 6] &= ~( ( uint64 )1 << ( i & 63 ) ); }
+
+	// Returns nCount (1 to 64) bits starting at nStart, packed into the low bits.
+	uint64 Extract( int nStart, int nCount ) const
+	{
+		Assert( nStart >= 0 && nCount > 0 && nCount <= 64 && nStart + nCount <= MAP_LAYOUT_TILES_WIDE );
+		int nWord = nStart >> 6;
+		int nBit = nStart & 63;
+		uint64 bits = m_Words[nWord] >> nBit;
+		if ( nBit != 0 && nWord + 1 < MAP_LAYOUT_BITROW_WORDS )
+		{
+			bits |= m_Words[nWord + 1] << ( 64 - nBit );
+		}
+		return ( nCount == 64 ) ? bits : ( bits & ( ( ( uint64 )1 << nCount ) - 1 ) );
+	}
+
+private:
+	uint64 m_Words[MAP_LAYOUT_BITROW_WORDS];
+};
+
 class CExit
 {
 public:
@@ -197,6 +229,7 @@ public:
 	bool RoomsOverlap( int x, int y, int w, int h, int x2, int y2, int w2, int h2 ) const;
 	bool CheckExits( const CRoomTemplate *pTemplate, int x, int y, CUtlVector<CRoomTemplateExit*> *pMatchingExits = NULL ) const;
 	bool CheckExitsOnSquares( const CRoomTemplate *pTemplate1, int offset_x, int offset_y, ExitDirection_t Direction, int x2, int y2, bool bRequireConnection = false, CUtlVector<CRoomTemplateExit*> *pMatchingExits = NULL ) const;
+	bool CheckExitsBitboard( const CRoomTemplate *pTemplate, int x, int y ) const;
 
 	// coords of the player starts (todo: support multiple tile player starts? deal better with players putting them in geometry, etc?)
 	int m_iPlayerStartTileX;
@@ -216,7 +249,17 @@ public:
 	CUtlVector<CASW_Encounter*> m_Encounters;
 
 private:
+	void ClearBitboards();
+	void UpdateBitboards( const CRoom *pRoom, bool bPlaced );
+
 	KeyValues* m_pGenerationOptions;		// keyvalues for the mission we used to generate this layout
+
+	// occupancy of m_pRoomGrid, both as columns (bits over y) and as rows (bits over x)
+	CMapLayoutBitRow m_OccupiedColumns[MAP_LAYOUT_TILES_WIDE];
+	CMapLayoutBitRow m_OccupiedRows[MAP_LAYOUT_TILES_WIDE];
+	// tiles of placed rooms with an exit facing each direction.
+	// north/south exits are stored as rows (bits over x), east/west exits as columns (bits over y).
+	CMapLayoutBitRow m_ExitBoards[EXITDIR_END][MAP_LAYOUT_TILES_WIDE];
 };
 
 #endif TILEGEN_MAPLAYOUT_H
\ No newline at end of file
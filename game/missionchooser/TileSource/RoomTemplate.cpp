@@ -3,6 +3,7 @@
 #include "RoomTemplate.h"
 #include "filesystem.h"
 #include "TagList.h"
+#include "utlbuffer.h"
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include <tier0/memdbgon.h>
@@ -159,6 +160,78 @@ bool CRoomTemplate::SaveRoomTemplate()
 	return true;
 }
 
+void CRoomTemplate::SaveToBuffer( CUtlBuffer &buf ) const
+{
+	buf.PutString( m_FullName );
+	buf.PutString( m_Description );
+	buf.PutString( m_Soundscape );
+	buf.PutInt( m_nTilesX );
+	buf.PutInt( m_nTilesY );
+	buf.PutInt( m_nSpawnWeight );
+	buf.PutInt( m_nTileType );
+
+	buf.PutInt( m_Tags.Count() );
+	for ( int i=0;i<m_Tags.Count();i++ )
+	{
+		buf.PutString( m_Tags[i] );
+	}
+
+	buf.PutInt( m_Exits.Count() );
+	for ( int i=0;i<m_Exits.Count();i++ )
+	{
+		const CRoomTemplateExit *pExit = m_Exits[i];
+		buf.PutInt( pExit->m_iXPos );
+		buf.PutInt( pExit->m_iYPos );
+		buf.PutInt( (int) pExit->m_ExitDirection );
+		buf.PutInt( pExit->m_iZChange );
+		buf.PutString( pExit->m_szExitTag );
+		buf.PutChar( pExit->m_bChokepointGrowSource ? 1 : 0 );
+	}
+}
+
+// returns false if the buffer is truncated or holds bad values
+bool CRoomTemplate::LoadFromBuffer( CUtlBuffer &buf )
+{
+	char szBuffer[MAX_PATH];
+	buf.GetString( szBuffer, sizeof( szBuffer ) );
+	SetFullName( szBuffer );
+	buf.GetString( m_Description, m_nMaxDescriptionLength );
+	buf.GetString( m_Soundscape, m_nMaxSoundscapeLength );
+	m_nTilesX = buf.GetInt();
+	m_nTilesY = buf.GetInt();
+	SetSpawnWeight( buf.GetInt() );
+
+	int nTileType = buf.GetInt();
+	if ( !buf.IsValid() || nTileType < ASW_TILETYPE_UNKNOWN || nTileType >= ASW_TILETYPE_COUNT )
+		return false;
+	SetTileType( nTileType );
+
+	// tags are looked up again, so we point at the tag list's strings
+	m_Tags.RemoveAll();
+	int nTags = buf.GetInt();
+	for ( int i=0;i<nTags && buf.IsValid();i++ )
+	{
+		buf.GetString( szBuffer, sizeof( szBuffer ) );
+		AddTag( szBuffer );
+	}
+
+	m_Exits.PurgeAndDeleteElements();
+	int nExits = buf.GetInt();
+	for ( int i=0;i<nExits && buf.IsValid();i++ )
+	{
+		CRoomTemplateExit *pExit = new CRoomTemplateExit();
+		pExit->m_iXPos = buf.GetInt();
+		pExit->m_iYPos = buf.GetInt();
+		pExit->m_ExitDirection = (ExitDirection_t) buf.GetInt();
+		pExit->m_iZChange = buf.GetInt();
+		buf.GetString( pExit->m_szExitTag, sizeof( pExit->m_szExitTag ) );
+		pExit->m_bChokepointGrowSource = ( buf.GetChar() != 0 );
+		m_Exits.AddToTail( pExit );
+	}
+
+	return buf.IsValid();
+}
+
 void CRoomTemplate::SetFullName( const char *pFullName )
 {
 	Q_strncpy( m_FullName, pFullName, MAX_PATH );
@@ -8,6 +8,7 @@
 
 class CLevelTheme;
 class KeyValues;
+class CUtlBuffer;
 
 enum ExitDirection_t 
 {
@@ -63,6 +64,10 @@ public:
 	void LoadFromKeyValues( const char *pRoomName, KeyValues *pKeyValues );
 	bool SaveRoomTemplate();
 
+	// binary form of the template, used by the tilegen source cache (see CLevelTheme::LoadLevelThemes)
+	void SaveToBuffer( CUtlBuffer &buf ) const;
+	bool LoadFromBuffer( CUtlBuffer &buf );
+
 	const char *GetFullName() const { return m_FullName; }
 	const char *GetFolderName() const { return m_SubFolder; }
 	const char *GetDescription() const { return m_Description; }
@@ -12,12 +12,16 @@
 
 ConVar tilegen_use_instancing( "tilegen_use_instancing", "0", FCVAR_REPLICATED );
 
-// TODO: Read room templates into keyvalues and output them after the whole room template has been loaded
-//       This way we can modify state based on the complete picture of that room, rather than just making changes on a key by key basis
-
-VMFExporter::VMFExporter()
+VMFExporter::VMFExporter() :
+	m_OutputBuffer( 0, 0, CUtlBuffer::TEXT_BUFFER )		// text mode, so PutString doesn't write terminators
 {
 	m_pMapLayout = NULL;
+	m_RoomTemplateVMFs.SetLessFunc( DefLessFunc( const CRoomTemplate* ) );
+	m_hOutputFile = FILESYSTEM_INVALID_HANDLE;
+	m_iOutputIndent = 0;
+	m_iBytesWritten = 0;
+	m_nStartMemoryUsed = 0;
+	m_nPeakMemoryUsed = 0;
 
 	Init();
 }
@@ -25,6 +29,7 @@ VMFExporter::VMFExporter()
 VMFExporter::~VMFExporter()
 {
 	ClearExportErrors();
+	PurgeRoomTemplateVMFs();
 }
 
 void VMFExporter::Init()
@@ -36,9 +41,9 @@ void VMFExporter::Init()
 	m_bWritingLevelContainer = false;
 	m_iEntityCount = 1;	// 1 already, from the worldspawn
 	m_iSideCount = 0;
-	m_pTemplateKeys = NULL;
 	
 	m_iNextNodeID = 0;
+	m_iNextWrittenNodeID = 0;
 	m_pRoom = NULL;
 	m_iCurrentRoom = 0;
 
@@ -46,7 +51,6 @@ void VMFExporter::Init()
 	m_iMapExtents_YMin = 0;
 	m_iMapExtents_XMax = 0;
 	m_iMapExtents_YMax = 0;
-	m_pExportKeys = NULL;
 	m_vecStartRoomOrigin = vec3_origin;
 	ClearExportErrors();
 }
@@ -81,6 +85,7 @@ bool VMFExporter::ShowExportErrors()
 	return true;
 }
 
+
 bool VMFExporter::ExportVMF( CMapLayout* pLayout, const char *mapname, bool bPopupWarnings )
 {
 	m_bPopupWarnings = bPopupWarnings;
@@ -95,6 +100,11 @@ bool VMFExporter::ExportVMF( CMapLayout* pLayout, const char *mapname, bool bPop
 		return false;
 	}
 
+	double flStartTime = Plat_FloatTime();
+	size_t nFreeMemory;
+	g_pMemAlloc->GlobalMemoryStatus( &m_nStartMemoryUsed, &nFreeMemory );
+	m_nPeakMemoryUsed = m_nStartMemoryUsed;
+
 	// see if we have a start room
 	bool bHasStartRoom = false;
 	for ( int i = 0 ; i < pLayout->m_PlacedRooms.Count() ; i++ )
@@ -111,130 +121,141 @@ bool VMFExporter::ExportVMF( CMapLayout* pLayout, const char *mapname, bool bPop
 	LoadUniqueKeyList();
 
 	m_iNextNodeID = 0;
-		
-	m_pExportKeys = new KeyValues( "ExportKeys" );
-
-	m_pExportKeys->AddSubKey( GetVersionInfo() );
-	m_pExportKeys->AddSubKey( GetDefaultVisGroups() );
-	m_pExportKeys->AddSubKey( GetViewSettings() );
-	m_pExportWorldKeys = GetDefaultWorldChunk();
-	if ( !m_pExportWorldKeys )
+
+	char filename[512];
+	Q_snprintf( filename, sizeof(filename), "maps\\%s", mapname );
+	Q_SetExtension( filename, "vmf", sizeof( filename ) );
+	if ( !OpenOutput( filename ) )
 	{
-		Q_snprintf( m_szLastExporterError, sizeof(m_szLastExporterError), "Failed to save world chunk start\n");
+		Q_snprintf( m_szLastExporterError, sizeof(m_szLastExporterError), "Failed to open %s for writing\n", filename );
 		return false;
 	}
-	m_pExportKeys->AddSubKey( m_pExportWorldKeys );
 
-	
-	// save out the big cube the whole level sits in	
-	if ( !AddLevelContainer() )
+	bool bSuccess = true;
+
+	WriteChunk( GetVersionInfo() );
+	WriteChunk( GetDefaultVisGroups() );
+	WriteChunk( GetViewSettings() );
+
+	// the world section has to be complete before any entity is written
+	KeyValues *pWorldKeys = GetDefaultWorldChunk();
+	BeginBlock( pWorldKeys->GetName() );
+	for ( KeyValues *pKeys = pWorldKeys->GetFirstSubKey(); pKeys; pKeys = pKeys->GetNextKey() )
 	{
-		Q_snprintf( m_szLastExporterError, sizeof(m_szLastExporterError), "Failed to save level container\n");
-		return false;
+		WriteKeysUnchanged( pKeys );
 	}
+	pWorldKeys->deleteThis();
 
-	if ( tilegen_use_instancing.GetBool() )
+	// save out the big cube the whole level sits in
+	if ( !AddLevelContainer() )
 	{
-		int nLogicalRooms = m_pMapLayout->m_LogicalRooms.Count();
-		int nPlacedRooms = m_pMapLayout->m_PlacedRooms.Count();
+		Q_snprintf( m_szLastExporterError, sizeof(m_szLastExporterError), "Failed to save level container\n");
+		bSuccess = false;
+	}
 
-		m_pRoom = NULL;
-		for ( int i = 0; i < nLogicalRooms; ++ i )
-		{
-			AddRoomInstance( m_pMapLayout->m_LogicalRooms[i] );
-		}
+	int iLogicalRooms = m_pMapLayout->m_LogicalRooms.Count();
+	int iRooms = m_pMapLayout->m_PlacedRooms.Count();
+	bool bInstancing = tilegen_use_instancing.GetBool();
 
-		for ( int i = 0; i < nPlacedRooms; ++ i )
-		{
-			m_pRoom = m_pMapLayout->m_PlacedRooms[i];
-			AddRoomInstance( m_pRoom->m_pRoomTemplate, i );
-		}
-	}
-	else
+	// the displacement brushes of each room stay in the world
+	for ( int i = 0 ; bSuccess && !bInstancing && i < iLogicalRooms + iRooms ; i++ )
 	{
-		// write out logical room solids
-		int iLogicalRooms = m_pMapLayout->m_LogicalRooms.Count();
-		m_pRoom = NULL;
-		for ( int i = 0 ; i < iLogicalRooms ; i++ )
+		const CRoomTemplate *pRoomTemplate = NULL;
+		if ( i < iLogicalRooms )
 		{
 			// start logical room IDs at 5000 (assumes we'll never place 5000 real rooms)
 			m_iCurrentRoom = 5000 + i;
-			CRoomTemplate *pRoomTemplate = m_pMapLayout->m_LogicalRooms[i];
-			if ( !pRoomTemplate )
-				continue;
-
-			if ( !AddRoomTemplateSolids( pRoomTemplate ) )
-				return false;
+			m_pRoom = NULL;
+			pRoomTemplate = m_pMapLayout->m_LogicalRooms[i];
 		}
-
-		// go through each CRoom and write out its world solids
-		int iRooms = m_pMapLayout->m_PlacedRooms.Count();
-		for ( m_iCurrentRoom = 0 ; m_iCurrentRoom<iRooms ; m_iCurrentRoom++)
+		else
 		{
+			m_iCurrentRoom = i - iLogicalRooms;
 			m_pRoom = m_pMapLayout->m_PlacedRooms[m_iCurrentRoom];
-			if (!m_pRoom)
-				continue;
-			const CRoomTemplate *pRoomTemplate = m_pRoom->m_pRoomTemplate;
-			if (!pRoomTemplate)
-				continue;
-
-			if ( !AddRoomTemplateSolids( pRoomTemplate ) )
-				return false;
+			pRoomTemplate = m_pRoom ? m_pRoom->m_pRoomTemplate : NULL;
 		}
+		if ( !pRoomTemplate )
+			continue;
+
+		bSuccess = AddRoomTemplateWorldSolids( pRoomTemplate );
+	}
 
-		// write out logical room entities
+	EndBlock();
+
+	if ( bSuccess && bInstancing )
+	{
 		m_pRoom = NULL;
-		for ( int i = 0 ; i < iLogicalRooms ; i++ )
+		for ( int i = 0; i < iLogicalRooms; ++ i )
 		{
-			// start logical room IDs at 5000 (assumes we'll never place 5000 real rooms)
-			m_iCurrentRoom = 5000 + i;
-			CRoomTemplate *pRoomTemplate = m_pMapLayout->m_LogicalRooms[i];
-			if ( !pRoomTemplate )
-				continue;
-
-			if ( !AddRoomTemplateEntities( pRoomTemplate ) )
-				return false;
+			AddRoomInstance( m_pMapLayout->m_LogicalRooms[i] );
 		}
 
-		// go through each CRoom and add its entities
-		for ( m_iCurrentRoom = 0 ; m_iCurrentRoom<iRooms ; m_iCurrentRoom++)
+		for ( int i = 0; i < iRooms; ++ i )
 		{
-			m_pRoom = m_pMapLayout->m_PlacedRooms[m_iCurrentRoom];
-			if (!m_pRoom)
-				continue;
-			const CRoomTemplate *pRoomTemplate = m_pRoom->m_pRoomTemplate;
-			if (!pRoomTemplate)
-				continue;
+			m_pRoom = m_pMapLayout->m_PlacedRooms[i];
+			AddRoomInstance( m_pRoom->m_pRoomTemplate, i );
+		}
+	}
+	else if ( bSuccess )
+	{
+		// write out room solids as func_detail, then room entities
+		for ( int nPass = 0 ; bSuccess && nPass < 2 ; nPass++ )
+		{
+			for ( int i = 0 ; bSuccess && i < iLogicalRooms + iRooms ; i++ )
+			{
+				const CRoomTemplate *pRoomTemplate = NULL;
+				if ( i < iLogicalRooms )
+				{
+					m_iCurrentRoom = 5000 + i;
+					m_pRoom = NULL;
+					pRoomTemplate = m_pMapLayout->m_LogicalRooms[i];
+				}
+				else
+				{
+					m_iCurrentRoom = i - iLogicalRooms;
+					m_pRoom = m_pMapLayout->m_PlacedRooms[m_iCurrentRoom];
+					pRoomTemplate = m_pRoom ? m_pRoom->m_pRoomTemplate : NULL;
+				}
+				if ( !pRoomTemplate )
+					continue;
 
-			if ( !AddRoomTemplateEntities( pRoomTemplate ) )
-				return false;
+				bSuccess = ( nPass == 0 ) ? AddRoomTemplateDetailSolids( pRoomTemplate ) : AddRoomTemplateEntities( pRoomTemplate );
+			}
 		}
 	}
 
-	// add some player starts to the map in the tile the user selected
-	if ( !bHasStartRoom )
+	if ( bSuccess )
 	{
-		m_pExportKeys->AddSubKey( GetPlayerStarts() );
+		// add some player starts to the map in the tile the user selected
+		if ( !bHasStartRoom )
+		{
+			WriteChunk( GetPlayerStarts() );
+		}
+
+		WriteChunk( GetGameRulesProxy() );
+		WriteChunk( GetDefaultCamera() );
 	}
 
-	m_pExportKeys->AddSubKey( GetGameRulesProxy() );
-	m_pExportKeys->AddSubKey( GetDefaultCamera() );
+	int iTemplates = m_RoomTemplateVMFs.Count();
+	PurgeRoomTemplateVMFs();
 
-	// save out the export keys
-	char filename[512];
-	Q_snprintf( filename, sizeof(filename), "maps\\%s", mapname );
-	Q_SetExtension( filename, "vmf", sizeof( filename ) );
-	CUtlBuffer buf( 0, 0, CUtlBuffer::TEXT_BUFFER );
-	for ( KeyValues *pKey = m_pExportKeys->GetFirstSubKey(); pKey; pKey = pKey->GetNextKey() )
+	if ( !CloseOutput() )
 	{
-		pKey->RecursiveSaveToFile( buf, 0 );			
+		Msg( "Failed to SaveToFile %s\n", filename );
+		bSuccess = false;
 	}
-	if ( !g_pFullFileSystem->WriteFile( filename, "GAME", buf ) )
+
+	if ( !bSuccess )
 	{
-		Msg( "Failed to SaveToFile %s\n", filename );
+		// don't leave half a map lying around for the compile tools to pick up
+		g_pFullFileSystem->RemoveFile( filename, "GAME" );
 		return false;
 	}
-	
+
+	Msg( "Exported %s: %d rooms from %d room templates, %.1f KB in %.1f ms, peak memory use %.1f MB over start\n",
+		filename, iRooms + iLogicalRooms, iTemplates, m_iBytesWritten / 1024.0f, ( Plat_FloatTime() - flStartTime ) * 1000.0f,
+		( m_nPeakMemoryUsed - m_nStartMemoryUsed ) / ( 1024.0f * 1024.0f ) );
+
 	// save the map layout there (so the game can get information about rooms during play)
 	Q_snprintf( filename, sizeof( filename ), "maps\\%s", mapname );
 	Q_SetExtension( filename, "layout", sizeof( filename ) );
@@ -247,50 +268,38 @@ bool VMFExporter::ExportVMF( CMapLayout* pLayout, const char *mapname, bool bPop
 	return true;
 }
 
-bool VMFExporter::AddRoomTemplateSolids( const CRoomTemplate *pRoomTemplate )
+bool VMFExporter::AddRoomTemplateWorldSolids( const CRoomTemplate *pRoomTemplate )
 {
-	// open its vmf file
-	char roomvmfname[MAX_PATH];
-	Q_snprintf(roomvmfname, sizeof(roomvmfname), "tilegen/roomtemplates/%s/%s.vmf", 
-		pRoomTemplate->m_pLevelTheme->m_szName,
-		pRoomTemplate->GetFullName() );
-	m_pTemplateKeys = new KeyValues( "RoomTemplateVMF" );
-	m_pTemplateKeys->LoadFromFile( g_pFullFileSystem, roomvmfname, "GAME" );
+	RoomTemplateVMF_t *pVMF = GetRoomTemplateVMF( pRoomTemplate );
 
-	// look for world key
-	for ( KeyValues *pKeys = m_pTemplateKeys; pKeys; pKeys = pKeys->GetNextKey() )
+	for ( int i = 0; i < pVMF->m_WorldSolids.Count(); i++ )
 	{
-		if ( !Q_stricmp( pKeys->GetName(), "world" ) )		// find the world key in our room template
+		if ( !WriteSolid( pVMF->m_WorldSolids[i] ) )					// fix up solid positions
 		{
-			if ( !ProcessWorld( pKeys ) )					// fix up solid positions
-			{
-				Q_snprintf( m_szLastExporterError, sizeof(m_szLastExporterError), "Failed to copy world from room %s\n", pRoomTemplate->GetFullName() );
-				return false;
-			}
-			for ( KeyValues *pSubKey = pKeys->GetFirstSubKey(); pSubKey; pSubKey = pSubKey->GetNextKey() )		// convert each solid to a func_detail entity
-			{
-				if ( !Q_stricmp( pSubKey->GetName(), "solid" ) )
-				{
-					if ( IsDisplacementBrush( pSubKey ) )
-					{
-						// add to world section
-						m_pExportWorldKeys->AddSubKey( pSubKey->MakeCopy() );
-					}
-					else
-					{
-						// put into entity section as a func_detail
-						KeyValues *pFuncDetail = new KeyValues( "entity" );
-						pFuncDetail->SetInt( "id", ++m_iEntityCount );
-						pFuncDetail->SetString( "classname", "func_detail" );
-						pFuncDetail->AddSubKey( pSubKey->MakeCopy() );
-						m_pExportKeys->AddSubKey( pFuncDetail );
-					}
-				}
-			}			
+			Q_snprintf( m_szLastExporterError, sizeof(m_szLastExporterError), "Failed to copy world from room %s\n", pRoomTemplate->GetFullName() );
+			return false;
 		}
 	}
-	m_pTemplateKeys->deleteThis();
-	m_pTemplateKeys = NULL;
+	return true;
+}
+
+bool VMFExporter::AddRoomTemplateDetailSolids( const CRoomTemplate *pRoomTemplate )
+{
+	RoomTemplateVMF_t *pVMF = GetRoomTemplateVMF( pRoomTemplate );
+
+	for ( int i = 0; i < pVMF->m_DetailSolids.Count(); i++ )
+	{
+		// put into entity section as a func_detail
+		BeginBlock( "entity" );
+		WriteKeyInt( "id", ++m_iEntityCount );
+		WriteKey( "classname", "func_detail" );
+		if ( !WriteSolid( pVMF->m_DetailSolids[i] ) )
+		{
+			Q_snprintf( m_szLastExporterError, sizeof(m_szLastExporterError), "Failed to copy world from room %s\n", pRoomTemplate->GetFullName() );
+			return false;
+		}
+		EndBlock();
+	}
 	return true;
 }
 
@@ -299,38 +308,22 @@ bool VMFExporter::AddRoomTemplateEntities( const CRoomTemplate *pRoomTemplate )
 	m_SideTranslations.PurgeAndDeleteElements();
 	m_NodeTranslations.PurgeAndDeleteElements();
 
-	// reopen the source vmf
-	char roomvmfname[MAX_PATH];
-	Q_snprintf( roomvmfname, sizeof(roomvmfname), "tilegen/roomtemplates/%s/%s.vmf", 
-		pRoomTemplate->m_pLevelTheme->m_szName,
-		pRoomTemplate->GetFullName() );
-	m_pTemplateKeys = new KeyValues( "RoomTemplateVMF" );
-	m_pTemplateKeys->LoadFromFile( g_pFullFileSystem, roomvmfname, "GAME" );
+	RoomTemplateVMF_t *pVMF = GetRoomTemplateVMF( pRoomTemplate );
 
 	// make all node IDs unique
-	MakeNodeIDsUnique();		
+	m_iNextWrittenNodeID = m_iNextNodeID;
+	MakeNodeIDsUnique( pVMF->m_pKeys );
 
-	// sets priority of objective entities based on the generation options
-	ReorderObjectives( pRoomTemplate, m_pTemplateKeys );
-
-	// look for entity keys
-	for ( KeyValues *pKeys = m_pTemplateKeys; pKeys; pKeys = pKeys->GetNextKey() )
+	for ( int i = 0; i < pVMF->m_Entities.Count(); i++ )
 	{
-		if ( !Q_stricmp( pKeys->GetName(), "entity" ) )
+		if ( !WriteEntity( pRoomTemplate, pVMF->m_Entities[i] ) )
 		{
-			if ( !ProcessEntity( pKeys ) )
-			{
-				Q_snprintf( m_szLastExporterError, sizeof(m_szLastExporterError), "Failed to copy entity from room %s\n", pRoomTemplate->GetFullName());
-				return false;
-			}
-			m_pExportKeys->AddSubKey( pKeys->MakeCopy() );
+			Q_snprintf( m_szLastExporterError, sizeof(m_szLastExporterError), "Failed to copy entity from room %s\n", pRoomTemplate->GetFullName());
+			return false;
 		}
 	}
-	
-	m_pTemplateKeys->deleteThis();
-	m_pTemplateKeys = NULL;
 	return true;
-};
+}
 
 bool VMFExporter::IsDisplacementBrush( KeyValues *pSolidKeys )
 {
@@ -345,68 +338,85 @@ bool VMFExporter::IsDisplacementBrush( KeyValues *pSolidKeys )
 	return false;
 }
 
-bool VMFExporter::ProcessWorld( KeyValues *pWorldKeys )
+bool VMFExporter::WriteSolid( KeyValues *pSolidKey )
 {
-	// look for solid keys
-	KeyValues *pSolidKeys = pWorldKeys->GetFirstSubKey();
-	while ( pSolidKeys )
+	BeginBlock( pSolidKey->GetName() );
+
+	bool bWroteID = false;
+	for ( KeyValues *pKeys = pSolidKey->GetFirstSubKey(); pKeys; pKeys = pKeys->GetNextKey() )
 	{
-		if ( !Q_stricmp( pSolidKeys->GetName(), "solid" ) )
+		if ( !bWroteID && !pKeys->GetFirstSubKey() && !Q_stricmp( pKeys->GetName(), "id" ) )
 		{
-			if ( !ProcessSolid( pSolidKeys ) )
-				return false;
+			WriteKeyInt( "id", ++m_iEntityCount );
+			bWroteID = true;
 		}
-		pSolidKeys = pSolidKeys->GetNextKey();
-	}
-
-	return true;
-}
-
-bool VMFExporter::ProcessSolid( KeyValues *pSolidKey )
-{
-	pSolidKey->SetInt( "id", ++m_iEntityCount );
-	
-	// now process each side
-	KeyValues *pKeys = pSolidKey->GetFirstSubKey();
-	while ( pKeys )
-	{
-		if ( !Q_stricmp( pKeys->GetName(), "side" ) )
+		else if ( !Q_stricmp( pKeys->GetName(), "side" ) )
 		{
-			if ( !ProcessSide( pKeys ) )
+			if ( !WriteSide( pKeys ) )
 				return false;
 		}
 		else
 		{
-			if ( !ProcessGenericRecursive( pKeys ) )
+			if ( !WriteGenericRecursive( pKeys ) )
 				return false;
 		}
-		pKeys = pKeys->GetNextKey();
 	}
 
+	if ( !bWroteID )
+	{
+		WriteKeyInt( "id", ++m_iEntityCount );
+	}
+
+	EndBlock();
 	return true;
 }
 
-bool VMFExporter::ProcessSide( KeyValues *pSideKey )
-{		
+bool VMFExporter::WriteSide( KeyValues *pSideKey )
+{
+	BeginBlock( pSideKey->GetName() );
+
 	for ( KeyValues *pKeys = pSideKey->GetFirstSubKey(); pKeys; pKeys = pKeys->GetNextKey() )
 	{
 		if ( !Q_stricmp( pKeys->GetName(), "dispinfo" ) )
 		{
-			if ( !ProcessGenericRecursive( pKeys ) )
+			if ( !WriteGenericRecursive( pKeys ) )
 				return false;
 		}
-		else
+		else if ( pKeys->GetFirstSubKey() )
 		{
-			if ( !ProcessSideKey( pKeys ) )
+			WriteKeysUnchanged( pKeys );
+		}
+		else if ( pKeys->GetDataType() != KeyValues::TYPE_NONE )
+		{
+			char buffer[256];
+			const char *szValue = ProcessSideKey( pKeys->GetName(), pKeys->GetString(), buffer, sizeof( buffer ) );
+			if ( !szValue )
 				return false;
+			WriteKey( pKeys->GetName(), szValue );
 		}
 	}
 
+	EndBlock();
 	return true;
 }
 
-bool VMFExporter::ProcessGenericRecursive( KeyValues *pKey )
+bool VMFExporter::WriteGenericRecursive( KeyValues *pKey )
 {
+	if ( pKey->GetDataType() == KeyValues::TYPE_NONE )		// if this keyvalues entry has subkeys, then process them
+	{
+		if ( !pKey->GetFirstSubKey() )
+			return true;
+
+		BeginBlock( pKey->GetName() );
+		for ( KeyValues *pKeys = pKey->GetFirstSubKey(); pKeys; pKeys = pKeys->GetNextKey() )
+		{
+			if ( !WriteGenericRecursive( pKeys ) )
+				return false;
+		}
+		EndBlock();
+		return true;
+	}
+
 	const char *szKey = pKey->GetName();
 	const char *szValue = pKey->GetString();
 
@@ -415,7 +425,7 @@ bool VMFExporter::ProcessGenericRecursive( KeyValues *pKey )
 		Vector Origin;
 		int nRead = sscanf(szValue, "[%f %f %f]", &Origin[0], &Origin[1], &Origin[2]);
 
-		if (nRead != 3)		
+		if (nRead != 3)
 			return false;
 
 		// move the points to where our room is
@@ -424,26 +434,16 @@ bool VMFExporter::ProcessGenericRecursive( KeyValues *pKey )
 		char buffer[256];
 		Q_snprintf(buffer, sizeof(buffer), "[%f %f %f]", Origin[0], Origin[1], Origin[2]);
 
-		pKey->SetStringValue( buffer );
-	}
-
-	if ( pKey->GetFirstSubKey() )		// if this keyvalues entry has subkeys, then process them
-	{
-		for ( KeyValues *pKeys = pKey->GetFirstSubKey(); pKeys; pKeys = pKeys->GetNextKey() )
-		{
-			if ( !ProcessGenericRecursive( pKeys ) )
-				return false;
-		}
+		WriteKey( szKey, buffer );
+		return true;
 	}
 
+	WriteKey( szKey, szValue );
 	return true;
 }
 
-bool VMFExporter::ProcessSideKey( KeyValues *pKey )
+const char *VMFExporter::ProcessSideKey( const char *szKey, const char *szValue, char *pBuffer, int nBufferSize )
 {
-	const char *szKey = pKey->GetName();
-	const char *szValue = pKey->GetString();
-
 	if (!stricmp(szKey, "id"))
 	{
 		// store the side
@@ -451,25 +451,23 @@ bool VMFExporter::ProcessSideKey( KeyValues *pKey )
 		pSideTranslation->m_iOriginalSide = atoi( szValue );
 
 		// give this side a unique ID
-		char buffer[32];
-		Q_snprintf(buffer, sizeof(buffer), "%d", ++m_iSideCount );
-		pKey->SetStringValue( buffer );
+		Q_snprintf(pBuffer, nBufferSize, "%d", ++m_iSideCount );
 
 		pSideTranslation->m_iNewSide = m_iSideCount;
 		m_SideTranslations.AddToTail( pSideTranslation );
 
-		return true;
+		return pBuffer;
 	}
 	else if (!stricmp(szKey, "plane"))
 	{
 		Vector planepts[3];
-		int nRead = sscanf(szValue, "(%f %f %f) (%f %f %f) (%f %f %f)", 
+		int nRead = sscanf(szValue, "(%f %f %f) (%f %f %f) (%f %f %f)",
 			&planepts[0][0], &planepts[0][1], &planepts[0][2],
 			&planepts[1][0], &planepts[1][1], &planepts[1][2],
 			&planepts[2][0], &planepts[2][1], &planepts[2][2]);
 
-		if (nRead != 9)		
-			return false;
+		if (nRead != 9)
+			return NULL;
 
 		if (m_bWritingLevelContainer)
 		{
@@ -501,14 +499,12 @@ bool VMFExporter::ProcessSideKey( KeyValues *pKey )
 			m_vecLastPlaneOffset = GetCurrentRoomOffset();
 		}
 
-		char buffer[256];
-		Q_snprintf(buffer, sizeof(buffer), "(%f %f %f) (%f %f %f) (%f %f %f)",
+		Q_snprintf(pBuffer, nBufferSize, "(%f %f %f) (%f %f %f) (%f %f %f)",
 			planepts[0][0], planepts[0][1], planepts[0][2],
 			planepts[1][0], planepts[1][1], planepts[1][2],
 			planepts[2][0], planepts[2][1], planepts[2][2]);
 
-		pKey->SetStringValue( buffer );
-		return true;
+		return pBuffer;
 	}
 	else if ( !stricmp(szKey, "uaxis") || !stricmp(szKey, "vaxis") )		// fix texture alignment (similar to moving a brush with texture lock turned on in hammer)
 	{
@@ -521,12 +517,10 @@ bool VMFExporter::ProcessSideKey( KeyValues *pKey )
 		{
 			offset -= m_vecLastPlaneOffset.Dot( axis ) / scale;
 
-			char buffer[256];
-			Q_snprintf( buffer, sizeof(buffer), "[%f %f %f %f] %f",
+			Q_snprintf( pBuffer, nBufferSize, "[%f %f %f %f] %f",
 				axis.x, axis.y, axis.z, offset, scale );
 
-			pKey->SetStringValue( buffer );
-			return true;
+			return pBuffer;
 		}
 		else
 		{
@@ -534,75 +528,98 @@ bool VMFExporter::ProcessSideKey( KeyValues *pKey )
 		}
 	}
 
-	return true;
+	return szValue;
 }
 
-bool VMFExporter::ProcessEntity( KeyValues *pEntityKeys )
-{		
-	for ( KeyValues *pKeys = pEntityKeys->GetFirstSubKey(); pKeys; )
+bool VMFExporter::WriteEntity( const CRoomTemplate *pTemplate, KeyValues *pEntityKeys )
+{
+	// sets priority of objective entities based on the generation options
+	float flPriority = GetObjectivePriority( pTemplate, pEntityKeys );
+	bool bWrotePriority = ( flPriority == 0 );
+
+	BeginBlock( pEntityKeys->GetName() );
+
+	for ( KeyValues *pKeys = pEntityKeys->GetFirstSubKey(); pKeys; pKeys = pKeys->GetNextKey() )
 	{
 		if ( pKeys->GetFirstSubKey() )
 		{
 			if ( !Q_stricmp( pKeys->GetName(), "solid" ) )
 			{
-				if ( !ProcessSolid( pKeys ) )
+				if ( !WriteSolid( pKeys ) )
 					return false;
 			}
 			else if ( !Q_stricmp( pKeys->GetName(), "connections" ) )
 			{
-				if ( !ProcessConnections( pKeys ) )
+				if ( !WriteConnections( pKeys ) )
 					return false;
 			}
-			else if ( !Q_stricmp( pKeys->GetName(), "editor" ) )	// remove editor keys
+			else if ( Q_stricmp( pKeys->GetName(), "editor" ) )	// remove editor keys
 			{
-				KeyValues *pRemoveKey = pKeys;
-				pKeys = pKeys->GetNextKey();
-				pEntityKeys->RemoveSubKey( pRemoveKey );
-				pRemoveKey->deleteThis();
-				continue;
+				WriteKeysUnchanged( pKeys );
 			}
 		}
-		else
+		else if ( pKeys->GetDataType() != KeyValues::TYPE_NONE )
 		{
-			if ( !ProcessEntityKey( pKeys ) )
+			const char *szKey = pKeys->GetName();
+			const char *szValue = pKeys->GetString();
+
+			char nodeBuffer[16];
+			if ( !stricmp( szKey, "nodeid" ) )
+			{
+				// matches the translation stored by MakeNodeIDsUnique
+				Q_snprintf( nodeBuffer, sizeof( nodeBuffer ), "%d", m_iNextWrittenNodeID++ );
+				szValue = nodeBuffer;
+			}
+
+			char priorityBuffer[32];
+			if ( !bWrotePriority && !Q_stricmp( szKey, "Priority" ) )
+			{
+				Q_snprintf( priorityBuffer, sizeof( priorityBuffer ), "%f", flPriority );
+				szValue = priorityBuffer;
+				bWrotePriority = true;
+			}
+
+			char buffer[256];
+			szValue = ProcessEntityKey( szKey, szValue, buffer, sizeof( buffer ) );
+			if ( !szValue )
 				return false;
+			WriteKey( szKey, szValue );
 		}
-		pKeys = pKeys->GetNextKey();
 	}
 
+	if ( !bWrotePriority )
+	{
+		char priorityBuffer[32];
+		Q_snprintf( priorityBuffer, sizeof( priorityBuffer ), "%f", flPriority );
+		char buffer[256];
+		WriteKey( "Priority", ProcessEntityKey( "Priority", priorityBuffer, buffer, sizeof( buffer ) ) );
+	}
+
+	EndBlock();
 	return true;
 }
 
-bool VMFExporter::ProcessEntityKey( KeyValues *pKey )
+const char *VMFExporter::ProcessEntityKey( const char *szKey, const char *szValue, char *pBuffer, int nBufferSize )
 {
-	const char *szKey = pKey->GetName();
-	const char *szValue = pKey->GetString();
-
 	if (!stricmp(szKey, "id"))
 	{
 		// give this entity a unique ID
-		char buffer[32];
-		Q_snprintf(buffer, sizeof(buffer), "%d", ++m_iEntityCount );
-		pKey->SetStringValue( buffer );
-
-		return true;
+		Q_snprintf(pBuffer, nBufferSize, "%d", ++m_iEntityCount );
+		return pBuffer;
 	}
 	else if (!stricmp(szKey, "origin"))
 	{
 		Vector Origin;
 		int nRead = sscanf(szValue, "%f %f %f", &Origin[0], &Origin[1], &Origin[2]);
 
-		if (nRead != 3)		
-			return false;
+		if (nRead != 3)
+			return NULL;
 
 		// move the points to where our room is
 		Origin += GetCurrentRoomOffset();
 
-		char buffer[256];
-		Q_snprintf(buffer, sizeof(buffer), "%f %f %f", Origin[0], Origin[1], Origin[2]);
-		pKey->SetStringValue( buffer );
-
-		return true;
+		Q_snprintf(pBuffer, nBufferSize, "%f %f %f", Origin[0], Origin[1], Origin[2]);
+		return pBuffer;
 	}
 	// check for overlay values
 	if (!stricmp(szKey, "sides"))
@@ -615,10 +632,8 @@ bool VMFExporter::ProcessEntityKey( KeyValues *pKey )
 			SideTranslation_t *pSideTranslation = m_SideTranslations[i];
 			if ( pSideTranslation->m_iOriginalSide == iSide )
 			{
-				char buffer[32];
-				Q_snprintf(buffer, sizeof(buffer), "%d", pSideTranslation->m_iNewSide );
-				pKey->SetStringValue( buffer );
-				return true;
+				Q_snprintf(pBuffer, nBufferSize, "%d", pSideTranslation->m_iNewSide );
+				return pBuffer;
 			}
 		}
 	}
@@ -627,17 +642,14 @@ bool VMFExporter::ProcessEntityKey( KeyValues *pKey )
 		Vector Origin;
 		int nRead = sscanf(szValue, "%f %f %f", &Origin[0], &Origin[1], &Origin[2]);
 
-		if (nRead != 3)		
-			return false;
+		if (nRead != 3)
+			return NULL;
 
 		// move the points to where our room is
 		Origin += GetCurrentRoomOffset();
 
-		char buffer[256];
-		Q_snprintf(buffer, sizeof(buffer), "%f %f %f", Origin[0], Origin[1], Origin[2]);
-
-		pKey->SetStringValue( buffer );
-		return true;
+		Q_snprintf(pBuffer, nBufferSize, "%f %f %f", Origin[0], Origin[1], Origin[2]);
+		return pBuffer;
 	}
 
 	// check for unique string keys (targetname, etc.)
@@ -648,11 +660,8 @@ bool VMFExporter::ProcessEntityKey( KeyValues *pKey )
 		if ( !stricmp(szKey, pUnique) && szValue && szValue[0] != '@' )		// don't make names unique if they start with special character
 		{
 			// prepend room id to make this unique
-			char buffer[256];
-			Q_snprintf( buffer, sizeof(buffer), "Room%d_%s", m_iCurrentRoom, szValue );
-
-			pKey->SetStringValue( buffer );
-			return true;
+			Q_snprintf( pBuffer, nBufferSize, "Room%d_%s", m_iCurrentRoom, szValue );
+			return pBuffer;
 		}
 	}
 
@@ -669,82 +678,72 @@ bool VMFExporter::ProcessEntityKey( KeyValues *pKey )
 				NodeTranslation_t *pTranslation = m_NodeTranslations[i];
 				if ( pTranslation->m_iOriginalNodeID == iNodeID )
 				{
-
-					char buffer[32];
-					Q_snprintf(buffer, sizeof(buffer), "%d", pTranslation->m_iNewNodeID );
-					pKey->SetStringValue( buffer );
-					return true;
+					Q_snprintf(pBuffer, nBufferSize, "%d", pTranslation->m_iNewNodeID );
+					return pBuffer;
 				}
 			}
 		}
 	}
 
-	return true;
+	return szValue;
 }
 
-bool VMFExporter::ProcessConnections( KeyValues *pConnections )
-{	
+bool VMFExporter::WriteConnections( KeyValues *pConnections )
+{
+	BeginBlock( pConnections->GetName() );
+
 	for ( KeyValues *pKeys = pConnections->GetFirstSubKey(); pKeys; pKeys = pKeys->GetNextKey() )
 	{
-		if ( !ProcessConnectionsKey( pKeys ) )
-			return false;		
+		char buffer[256];
+		const char *szValue = ProcessConnectionsKey( pKeys->GetString(), buffer, sizeof( buffer ) );
+		if ( !szValue )
+			return false;
+		WriteKey( pKeys->GetName(), szValue );
 	}
 
+	EndBlock();
 	return true;
 }
 
-bool VMFExporter::ProcessConnectionsKey( KeyValues *pKey )
+const char *VMFExporter::ProcessConnectionsKey( const char *szValue, char *pBuffer, int nBufferSize )
 {
-	const char *szValue = pKey->GetString();
-
-	char buffer[256];
 	// prepend room id to targetname
 	if ( szValue && szValue[0] != '@' )		// don't make names unique if they start with special character
 	{
-		Q_snprintf( buffer, sizeof( buffer ), "Room%d_%s", m_iCurrentRoom, szValue );		
-	}
-	else
-	{
-		Q_snprintf( buffer, sizeof( buffer ), "%s", szValue );
+		Q_snprintf( pBuffer, nBufferSize, "Room%d_%s", m_iCurrentRoom, szValue );
+		return pBuffer;
 	}
 
-	pKey->SetStringValue( buffer );
-	return true;
+	return szValue;
 }
 
-// sets priority of objective entities based on the order the rooms were listed in the mission/objective txt
-void VMFExporter::ReorderObjectives( const CRoomTemplate *pTemplate, KeyValues *pTemplateKeys )
-{	
-	KeyValues *pKeys = m_pTemplateKeys;
-	while ( pKeys )
-	{
-		if ( !Q_stricmp( pKeys->GetName(), "entity" ) && !Q_strnicmp( pKeys->GetString( "classname" ), "asw_objective", 13 ) )
-		{
-			if ( pKeys->GetFloat( "Priority" ) != 0 )	// if level designer has already set priority, then don't override it
-			{
-				pKeys = pKeys->GetNextKey();
-				continue;
-			}
-
-			int iPriority = 100;
-			// We no longer have a requested rooms array, so this code is not valid.  Need to replace it with something else to ensure priorities are set correctly.
-// 			for ( int i = 0; i < m_pMapLayout->m_pRequestedRooms.Count(); i++ )
-// 			{
-// 				if ( m_pMapLayout->m_pRequestedRooms[i]->m_pRoomTemplate == pTemplate )
-// 				{
-// 					iPriority = m_pMapLayout->m_pRequestedRooms[i]->m_iMissionTextOrder;
-// 				}
-// 			}
-			pKeys->SetFloat( "Priority", iPriority );
-		}
-		pKeys = pKeys->GetNextKey();
-	}
+// returns the priority to give an objective entity, based on the order the rooms were listed in the mission/objective txt.
+// returns 0 if the entity's priority should be left alone.
+float VMFExporter::GetObjectivePriority( const CRoomTemplate *pTemplate, KeyValues *pEntityKeys )
+{
+	if ( Q_strnicmp( pEntityKeys->GetString( "classname" ), "asw_objective", 13 ) )
+		return 0;
+
+	if ( pEntityKeys->GetFloat( "Priority" ) != 0 )	// if level designer has already set priority, then don't override it
+		return 0;
+
+	int iPriority = 100;
+	// We no longer have a requested rooms array, so this code is not valid.  Need to replace it with something else to ensure priorities are set correctly.
+// 	for ( int i = 0; i < m_pMapLayout->m_pRequestedRooms.Count(); i++ )
+// 	{
+// 		if ( m_pMapLayout->m_pRequestedRooms[i]->m_pRoomTemplate == pTemplate )
+// 		{
+// 			iPriority = m_pMapLayout->m_pRequestedRooms[i]->m_iMissionTextOrder;
+// 		}
+// 	}
+	return iPriority;
 }
 
-int VMFExporter::MakeNodeIDsUnique()
+// stores a translation for every AI node in the room template, WriteEntity gives them their new IDs as it writes them out
+int VMFExporter::MakeNodeIDsUnique( KeyValues *pTemplateKeys )
 {
 	int iNodes = 0;
-	KeyValues *pKeys = m_pTemplateKeys;
+	KeyValues *pKeys = pTemplateKeys;
 	while ( pKeys )
 	{
 		if ( !Q_stricmp( pKeys->GetName(), "entity" ) )		// go through all entities in this room
@@ -752,7 +751,7 @@ int VMFExporter::MakeNodeIDsUnique()
 			KeyValues *pFieldKey = pKeys->GetFirstSubKey();
 			while ( pFieldKey )								// go through all properties of this entity
 			{
-				if ( !pFieldKey->GetFirstSubKey() )			// leaf
+				if ( !pFieldKey->GetFirstSubKey() && pFieldKey->GetDataType() != KeyValues::TYPE_NONE )			// leaf
 				{
 					if ( !stricmp(pFieldKey->GetName(), "nodeid" ) )
 					{
@@ -760,13 +759,10 @@ int VMFExporter::MakeNodeIDsUnique()
 						pNodeTranslation->m_iOriginalNodeID = atoi( pFieldKey->GetString() );
 						pNodeTranslation->m_iNewNodeID = m_iNextNodeID;
 						m_NodeTranslations.AddToTail( pNodeTranslation );
-						char buffer[16];
-						Q_snprintf( buffer, sizeof( buffer ), "%d", m_iNextNodeID);
-						pFieldKey->SetStringValue( buffer );
 						m_iNextNodeID++;
 						iNodes++;
 					}
-				}		
+				}
 				pFieldKey = pFieldKey->GetNextKey();
 			}
 		}
@@ -775,6 +771,7 @@ int VMFExporter::MakeNodeIDsUnique()
 	return iNodes;
 }
 
+
 const Vector& VMFExporter::GetCurrentRoomOffset()
 {
 	static Vector s_vecCurrentRoomOffset = vec3_origin;	
@@ -830,6 +827,7 @@ void VMFExporter::LoadUniqueKeyList()
 	manifest->deleteThis();
 }
 
+
 void VMFExporter::AddRoomInstance( const CRoomTemplate *pRoomTemplate, int nPlacedRoomIndex )
 {
 	KeyValues *pFuncInstance = new KeyValues( "entity" );
@@ -858,7 +856,7 @@ void VMFExporter::AddRoomInstance( const CRoomTemplate *pRoomTemplate, int nPlac
 	char buf[128];
 	Q_snprintf( buf, 128, "%f %f %f", vOrigin.x, vOrigin.y, vOrigin.z );
 	pFuncInstance->SetString( "origin", buf );
-	m_pExportKeys->AddSubKey( pFuncInstance );
+	WriteChunk( pFuncInstance );
 }
 
 //-----------------------------------------------------------------------------
@@ -966,11 +964,15 @@ KeyValues* VMFExporter::GetDefaultWorldChunk()
 	return pKeys;
 }
 
+
 bool VMFExporter::AddLevelContainer()
 {
 	KeyValues *pLevelContainerKeys = new KeyValues( "LevelContainer" );
 	if ( !pLevelContainerKeys->LoadFromFile( g_pFullFileSystem, "tilegen/roomtemplates/levelcontainer.vmf.no_func_detail", "GAME" ) )
+	{
+		pLevelContainerKeys->deleteThis();
 		return false;
+	}
 
 	m_bWritingLevelContainer = true;
 
@@ -1002,7 +1004,18 @@ bool VMFExporter::AddLevelContainer()
 			break;
 		}
 	}
-	if ( !pWorldKeys || !ProcessWorld( pWorldKeys ) )
+
+	bool bSuccess = ( pWorldKeys != NULL );
+	for ( KeyValues *pKeys = pWorldKeys ? pWorldKeys->GetFirstSubKey() : NULL; bSuccess && pKeys; pKeys = pKeys->GetNextKey() )
+	{
+		if ( !Q_stricmp( pKeys->GetName(), "solid" ) )
+		{
+			bSuccess = WriteSolid( pKeys );
+		}
+	}
+	pLevelContainerKeys->deleteThis();
+
+	if ( !bSuccess )
 	{
 		Q_snprintf( m_szLastExporterError, sizeof(m_szLastExporterError), "Failed to copy level container\n" );
 		return false;
@@ -1010,18 +1023,197 @@ bool VMFExporter::AddLevelContainer()
 
 	m_bWritingLevelContainer = false;
 
-	for ( KeyValues *pKeys = pWorldKeys->GetFirstSubKey(); pKeys; pKeys = pKeys->GetNextKey() )
+	return true;
+}
+
+// parses the room template's vmf the first time it's used in this export
+VMFExporter::RoomTemplateVMF_t* VMFExporter::GetRoomTemplateVMF( const CRoomTemplate *pRoomTemplate )
+{
+	unsigned short i = m_RoomTemplateVMFs.Find( pRoomTemplate );
+	if ( i != m_RoomTemplateVMFs.InvalidIndex() )
+		return m_RoomTemplateVMFs[i];
+
+	char roomvmfname[MAX_PATH];
+	Q_snprintf(roomvmfname, sizeof(roomvmfname), "tilegen/roomtemplates/%s/%s.vmf", 
+		pRoomTemplate->m_pLevelTheme->m_szName,
+		pRoomTemplate->GetFullName() );
+
+	RoomTemplateVMF_t *pVMF = new RoomTemplateVMF_t;
+	pVMF->m_pKeys = new KeyValues( "RoomTemplateVMF" );
+	pVMF->m_pKeys->LoadFromFile( g_pFullFileSystem, roomvmfname, "GAME" );
+
+	for ( KeyValues *pKeys = pVMF->m_pKeys; pKeys; pKeys = pKeys->GetNextKey() )
 	{
-		const char *szName = pKeys->GetName();
-		if ( !Q_stricmp( szName, "solid" ) )
+		if ( !Q_stricmp( pKeys->GetName(), "world" ) )		// find the world key in our room template
 		{
-			m_pExportWorldKeys->AddSubKey( pKeys->MakeCopy() );
+			for ( KeyValues *pSubKey = pKeys->GetFirstSubKey(); pSubKey; pSubKey = pSubKey->GetNextKey() )
+			{
+				if ( !Q_stricmp( pSubKey->GetName(), "solid" ) )
+				{
+					if ( IsDisplacementBrush( pSubKey ) )
+					{
+						pVMF->m_WorldSolids.AddToTail( pSubKey );
+					}
+					else
+					{
+						pVMF->m_DetailSolids.AddToTail( pSubKey );
+					}
+				}
+			}
+		}
+		else if ( !Q_stricmp( pKeys->GetName(), "entity" ) )
+		{
+			pVMF->m_Entities.AddToTail( pKeys );
 		}
 	}
-	pLevelContainerKeys->deleteThis();
 
-	m_pTemplateKeys->deleteThis();
-	m_pTemplateKeys = NULL;
+	m_RoomTemplateVMFs.Insert( pRoomTemplate, pVMF );
+	UpdatePeakMemory();
+	return pVMF;
+}
 
+void VMFExporter::PurgeRoomTemplateVMFs()
+{
+	FOR_EACH_MAP_FAST( m_RoomTemplateVMFs, i )
+	{
+		m_RoomTemplateVMFs[i]->m_pKeys->deleteThis();
+		delete m_RoomTemplateVMFs[i];
+	}
+	m_RoomTemplateVMFs.RemoveAll();
+}
+
+//-----------------------------------------------------------------------------
+// Output
+//-----------------------------------------------------------------------------
+
+#define VMF_OUTPUT_FLUSH_SIZE	( 64 * 1024 )
+
+bool VMFExporter::OpenOutput( const char *filename )
+{
+	m_hOutputFile = g_pFullFileSystem->Open( filename, "wb", "GAME" );
+	if ( m_hOutputFile == FILESYSTEM_INVALID_HANDLE )
+		return false;
+
+	m_OutputBuffer.Clear();
+	m_OutputBuffer.EnsureCapacity( VMF_OUTPUT_FLUSH_SIZE + 1024 );
+	m_iOutputIndent = 0;
+	m_iBytesWritten = 0;
 	return true;
 }
+
+bool VMFExporter::CloseOutput()
+{
+	if ( m_hOutputFile == FILESYSTEM_INVALID_HANDLE )
+		return false;
+
+	FlushOutput( true );
+	bool bOk = g_pFullFileSystem->IsOk( m_hOutputFile );
+	g_pFullFileSystem->Close( m_hOutputFile );
+	m_hOutputFile = FILESYSTEM_INVALID_HANDLE;
+	m_OutputBuffer.Purge();
+	return bOk;
+}
+
+void VMFExporter::FlushOutput( bool bForce )
+{
+	int nSize = m_OutputBuffer.TellPut();
+	if ( nSize <= 0 || ( !bForce && nSize < VMF_OUTPUT_FLUSH_SIZE ) )
+		return;
+
+	g_pFullFileSystem->Write( m_OutputBuffer.Base(), nSize, m_hOutputFile );
+	m_iBytesWritten += nSize;
+	m_OutputBuffer.Clear();
+}
+
+void VMFExporter::WriteIndents()
+{
+	for ( int i = 0; i < m_iOutputIndent; i++ )
+	{
+		m_OutputBuffer.PutChar( '\t' );
+	}
+}
+
+// same escaping as KeyValues, so the vmf reads back the same
+void VMFExporter::WriteQuotedString( const char *pString )
+{
+	m_OutputBuffer.PutChar( '"' );
+	for ( const char *p = pString; *p; p++ )
+	{
+		if ( *p == '"' )
+		{
+			m_OutputBuffer.PutChar( '\\' );
+		}
+		m_OutputBuffer.PutChar( *p );
+	}
+	m_OutputBuffer.PutChar( '"' );
+}
+
+void VMFExporter::BeginBlock( const char *pName )
+{
+	WriteIndents();
+	WriteQuotedString( pName );
+	m_OutputBuffer.PutChar( '\n' );
+	WriteIndents();
+	m_OutputBuffer.PutString( "{\n" );
+	m_iOutputIndent++;
+}
+
+void VMFExporter::EndBlock()
+{
+	Assert( m_iOutputIndent > 0 );
+	m_iOutputIndent--;
+	WriteIndents();
+	m_OutputBuffer.PutString( "}\n" );
+
+	// only flush between blocks, so we never write out a partial line
+	FlushOutput( false );
+}
+
+void VMFExporter::WriteKey( const char *pName, const char *pValue )
+{
+	WriteIndents();
+	WriteQuotedString( pName );
+	m_OutputBuffer.PutString( "\t\t" );
+	WriteQuotedString( pValue ? pValue : "" );
+	m_OutputBuffer.PutChar( '\n' );
+}
+
+void VMFExporter::WriteKeyInt( const char *pName, int nValue )
+{
+	char buffer[32];
+	Q_snprintf( buffer, sizeof( buffer ), "%d", nValue );
+	WriteKey( pName, buffer );
+}
+
+void VMFExporter::WriteKeysUnchanged( KeyValues *pKey )
+{
+	if ( !pKey->GetFirstSubKey() && pKey->GetDataType() != KeyValues::TYPE_NONE )
+	{
+		WriteKey( pKey->GetName(), pKey->GetString() );
+		return;
+	}
+
+	BeginBlock( pKey->GetName() );
+	for ( KeyValues *pSubKey = pKey->GetFirstSubKey(); pSubKey; pSubKey = pSubKey->GetNextKey() )
+	{
+		// empty sub blocks aren't saved by KeyValues either
+		if ( pSubKey->GetFirstSubKey() || pSubKey->GetDataType() != KeyValues::TYPE_NONE )
+		{
+			WriteKeysUnchanged( pSubKey );
+		}
+	}
+	EndBlock();
+}
+
+void VMFExporter::WriteChunk( KeyValues *pKeys )
+{
+	WriteKeysUnchanged( pKeys );
+	pKeys->deleteThis();
+}
+
+void VMFExporter::UpdatePeakMemory()
+{
+	size_t nUsed, nFree;
+	g_pMemAlloc->GlobalMemoryStatus( &nUsed, &nFree );
+	m_nPeakMemoryUsed = MAX( m_nPeakMemoryUsed, nUsed );
+}
@@ -7,12 +7,17 @@
 #include "ChunkFile.h"
 #include "utlvector.h"
 #include "utlstring.h"
+#include "utlbuffer.h"
+#include "utlmap.h"
+#include "filesystem.h"
 
 class CRoom;
 class CMapLayout;
 class CRoomTemplate;
 
-// this class uses the placed rooms and room templates to build up a vmf file of the put together map
+// this class uses the placed rooms and room templates to build up a vmf file of the put together map.
+// the vmf is streamed straight to disk: each room template's vmf is parsed once per export and its
+// solids and entities are written out for every room using it, with offsets and IDs fixed up as they're written.
 
 class VMFExporter
 {
@@ -35,24 +40,63 @@ public:
 	//-----------------------------------------------------------------------------
 	// Functionality for old manual instancing (tilegen_use_instancing = 0)
 	//-----------------------------------------------------------------------------
-	bool AddRoomTemplateSolids( const CRoomTemplate *pRoomTemplate );
+	// displacement solids go in the world section, everything else is written later as func_detail entities
+	bool AddRoomTemplateWorldSolids( const CRoomTemplate *pRoomTemplate );
+	bool AddRoomTemplateDetailSolids( const CRoomTemplate *pRoomTemplate );
 	bool AddRoomTemplateEntities( const CRoomTemplate *pRoomTemplate );
 	bool IsDisplacementBrush( KeyValues *pSolidKeys );
-	// these functions go through the keys and alter any needed values (shifting origin, bumping IDs, etc.)
-	bool ProcessWorld( KeyValues *pWorldKey );
-	bool ProcessSolid( KeyValues *pSolidKey );
-	bool ProcessSide( KeyValues *pSideKey );
-	bool ProcessSideKey( KeyValues *pKey );
-	bool ProcessGenericRecursive( KeyValues *pParentKey );
-	bool ProcessEntity( KeyValues *pSideKey );
-	bool ProcessEntityKey( KeyValues *pEntityKey );
-	bool ProcessConnections( KeyValues *pSideKey );
-	bool ProcessConnectionsKey( KeyValues *pEntityKey );
-	void ReorderObjectives( const CRoomTemplate *pTemplate, KeyValues *pTemplateKeys );
-	int MakeNodeIDsUnique();
+	// these functions write out the keys, altering any needed values (shifting origin, bumping IDs, etc.) on the way.
+	// the Process*Key functions return the value to write (either the original value or pBuffer), or NULL on error.
+	bool WriteSolid( KeyValues *pSolidKey );
+	bool WriteSide( KeyValues *pSideKey );
+	bool WriteGenericRecursive( KeyValues *pKey );
+	bool WriteEntity( const CRoomTemplate *pTemplate, KeyValues *pEntityKey );
+	bool WriteConnections( KeyValues *pConnectionsKey );
+	const char *ProcessSideKey( const char *szKey, const char *szValue, char *pBuffer, int nBufferSize );
+	const char *ProcessEntityKey( const char *szKey, const char *szValue, char *pBuffer, int nBufferSize );
+	const char *ProcessConnectionsKey( const char *szValue, char *pBuffer, int nBufferSize );
+	float GetObjectivePriority( const CRoomTemplate *pTemplate, KeyValues *pEntityKeys );
+	int MakeNodeIDsUnique( KeyValues *pTemplateKeys );
 	const Vector& GetCurrentRoomOffset();
 	void LoadUniqueKeyList();
 
+	//-----------------------------------------------------------------------------
+	// Room template vmfs, parsed once per export and shared by every room using the template
+	//-----------------------------------------------------------------------------
+	struct RoomTemplateVMF_t
+	{
+		KeyValues *m_pKeys;
+		CUtlVector<KeyValues*> m_WorldSolids;		// displacement brushes
+		CUtlVector<KeyValues*> m_DetailSolids;		// everything else
+		CUtlVector<KeyValues*> m_Entities;
+	};
+	RoomTemplateVMF_t* GetRoomTemplateVMF( const CRoomTemplate *pRoomTemplate );
+	void PurgeRoomTemplateVMFs();
+	CUtlMap<const CRoomTemplate*, RoomTemplateVMF_t*> m_RoomTemplateVMFs;
+
+	//-----------------------------------------------------------------------------
+	// Buffered output, in the same format as KeyValues::RecursiveSaveToFile
+	//-----------------------------------------------------------------------------
+	bool OpenOutput( const char *filename );
+	bool CloseOutput();
+	void FlushOutput( bool bForce );
+	void WriteIndents();
+	void WriteQuotedString( const char *pString );
+	void BeginBlock( const char *pName );
+	void EndBlock();
+	void WriteKey( const char *pName, const char *pValue );
+	void WriteKeyInt( const char *pName, int nValue );
+	void WriteKeysUnchanged( KeyValues *pKey );
+	void WriteChunk( KeyValues *pKeys );	// writes out and deletes a generated top level chunk
+	void UpdatePeakMemory();
+
+	FileHandle_t m_hOutputFile;
+	CUtlBuffer m_OutputBuffer;
+	int m_iOutputIndent;
+	int m_iBytesWritten;
+	size_t m_nStartMemoryUsed;
+	size_t m_nPeakMemoryUsed;
+
 	//-----------------------------------------------------------------------------
 	// Functionality for new instancing support (tilegen_use_instancing = 1)
 	//-----------------------------------------------------------------------------
@@ -64,10 +108,7 @@ public:
 	int m_iEntityCount;
 	int m_iSideCount;
 	int m_iNextNodeID;	// ID to give the next AI node we export
-
-	KeyValues *m_pTemplateKeys;			// keys for the template we're currently reading in
-	KeyValues *m_pExportKeys;			// the keys we're going to export as a vmf file
-	KeyValues *m_pExportWorldKeys;		// world section of m_pExportKeys
+	int m_iNextWrittenNodeID;	// ID of the next AI node we write out in the current room
 
 	CUtlVector<CUtlString> m_UniqueKeys, m_NodeIDKeys;
 
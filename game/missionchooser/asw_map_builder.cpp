@@ -33,6 +33,7 @@
 
 static ConVar asw_vbsp2( "asw_vbsp2", "0", FCVAR_REPLICATED ); // 0 = Use default map builder (VBSP.EXE), 1 = Use new, experimental level builder (VBSP2LIB.LIB)
 static ConVar tilegen_retry_count( "tilegen_retry_count", "20", FCVAR_CHEAT, "The number of level generation retries to attempt after which tilegen will give up." );
+static ConVar tilegen_parallel_seeds( "tilegen_parallel_seeds", "4", FCVAR_CHEAT, "Number of random seeds a randomly generated layout is attempted with in parallel (the first valid layout wins). Set to 1 to generate one seed at a time." );
 ConVar asw_regular_floor_texture( "asw_regular_floor_texture", "REGULAR_FLOOR", FCVAR_NONE, "Regular floor texture to replace" );
 ConVar asw_alien_floor_texture( "asw_alien_floor_texture", "ALIEN_FLOOR", FCVAR_NONE, "Alien floor texture used for replacement" );
 
@@ -200,6 +201,7 @@ m_flProgress( 0.0f ),
 m_pGeneratedMapLayout( NULL ),
 m_pBuildingMapLayout( NULL ),
 m_pLayoutSystem( NULL ),
+m_pSpeculativeGenerator( NULL ),
 m_nLevelGenerationRetryCount( 0 ),
 m_pMissionSettings( NULL ),
 m_pMissionDefinition( NULL ),
@@ -226,6 +228,7 @@ CASW_Map_Builder::~CASW_Map_Builder()
 	delete m_pGeneratedMapLayout;
 	delete m_pBuildingMapLayout;
 	delete m_pLayoutSystem;
+	delete m_pSpeculativeGenerator;
 
 	// Tell the worker thread to shutdown and block until finished
 	m_pWorkerThread->CallWorker( MBC_SHUTDOWN );
@@ -267,9 +270,62 @@ void CASW_Map_Builder::Update( float flEngineTime )
 					m_iBuildStage = STAGE_NONE;
 					return;
 				}
+
+				int nSeeds = tilegen_parallel_seeds.GetInt();
+				if ( nSeeds > 1 && m_pLayoutSystem->IsRandomlyGenerated() )
+				{
+					// Generate the whole layout from several seeds at once on the job threads, polled below.
+					if ( !m_pSpeculativeGenerator )
+					{
+						m_pSpeculativeGenerator = new CSpeculativeLayoutGenerator();
+					}
+
+					if ( !m_pSpeculativeGenerator->Begin( m_pMissionDefinition, m_pMissionSettings, nSeeds ) )
+					{
+						m_iBuildStage = STAGE_NONE;
+						return;
+					}
+
+					m_bStartedGeneration = true;
+					return;
+				}
+
 				m_pLayoutSystem->BeginGeneration( m_pGeneratedMapLayout );
 				m_bStartedGeneration = true;
 			}
+			else if ( m_pSpeculativeGenerator && m_pSpeculativeGenerator->IsRunning() )
+			{
+				// Keep the frames going until every seed is done
+				if ( !m_pSpeculativeGenerator->IsFinished() )
+					return;
+
+				// The finished layout gets saved next update.
+				int nSeeds = m_pSpeculativeGenerator->GetSeedCount();
+				CLayoutSystem *pLayoutSystem;
+				CMapLayout *pMapLayout;
+				if ( m_pSpeculativeGenerator->Finish( &pLayoutSystem, &pMapLayout ) )
+				{
+					delete m_pGeneratedMapLayout;
+					delete m_pLayoutSystem;
+					m_pGeneratedMapLayout = pMapLayout;
+					m_pLayoutSystem = pLayoutSystem;
+				}
+				else
+				{
+					m_nLevelGenerationRetryCount += nSeeds;
+					if ( m_nLevelGenerationRetryCount < tilegen_retry_count.GetInt() )
+					{
+						// Start another batch of seeds next update.
+						Log_Msg( LOG_TilegenGeneral, "Retrying layout generation...\n" );
+						m_bStartedGeneration = false;
+					}
+					else
+					{
+						Log_Warning( LOG_TilegenGeneral, "Failed to generate valid map layout after %d tries...\n", m_nLevelGenerationRetryCount );
+						m_iBuildStage = STAGE_NONE;
+					}
+				}
+			}
 			else
 			{
 				if ( m_pLayoutSystem->IsGenerating() )
@@ -9,6 +9,7 @@
 class KeyValues;
 class CMapLayout;
 class CLayoutSystem;
+class CSpeculativeLayoutGenerator;
 class CMapBuilderWorkerThread;
 
 enum MapBuildStage
@@ -100,6 +101,7 @@ private:
 	CMapLayout *m_pBuildingMapLayout;
 	// Layout system object used to generate map layout.
 	CLayoutSystem *m_pLayoutSystem;
+	CSpeculativeLayoutGenerator *m_pSpeculativeGenerator;
 	int m_nLevelGenerationRetryCount;
 	
 	// Auxiliary settings/metadata that affect runtime behavior for a mission.
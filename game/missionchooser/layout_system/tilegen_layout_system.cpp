@@ -12,6 +12,9 @@
 #include "tilegen_ranges.h"
 #include "tilegen_layout_system.h"
 #include "asw_npcs.h"
+#include "asw_key_values_database.h"
+#include "LevelTheme.h"
+#include "vstdlib/jobthread.h"
 
 ConVar tilegen_break_on_iteration( "tilegen_break_on_iteration", "-1", FCVAR_CHEAT, "If set to a non-negative value, tilegen will break at the start of iteration #N if a debugger is attached." );
 DEFINE_LOGGING_CHANNEL_NO_TAGS( LOG_TilegenLayoutSystem, "TilegenLayoutSystem", 0, LS_MESSAGE, Color( 192, 255, 192, 255 ) );
@@ -22,6 +25,164 @@ void AddListeners( CLayoutSystem *pLayoutSystem )
 	pLayoutSystem->AddListener( new CTilegenListener_NumTilesPlaced() );
 }
 
+// Set as the winner to make every seed give up.
+static const int SPECULATIVE_LAYOUT_ABORTED = INT_MAX;
+
+static void GenerateSpeculativeLayout( SpeculativeLayout_t *pLayout )
+{
+	CLayoutSystem *pLayoutSystem = pLayout->m_pLayoutSystem;
+	pLayoutSystem->BeginGeneration( pLayout->m_pMapLayout, pLayout->m_nSeed );
+
+	// Give up as soon as another seed has produced a valid layout.
+	while ( pLayoutSystem->IsGenerating() && *pLayout->m_pWinner < 0 )
+	{
+		pLayoutSystem->ExecuteIteration();
+	}
+
+	if ( !pLayoutSystem->IsGenerating() && !pLayoutSystem->GenerationErrorOccurred() )
+	{
+		pLayout->m_pWinner->AssignIf( -1, pLayout->m_nIndex );
+	}
+}
+
+bool GenerateLayoutSpeculative( KeyValues *pMissionDefinition, KeyValues *pMissionSettings, int nSeeds, CLayoutSystem **ppLayoutSystem, CMapLayout **ppMapLayout )
+{
+	CSpeculativeLayoutGenerator generator;
+	if ( !generator.Begin( pMissionDefinition, pMissionSettings, nSeeds ) )
+	{
+		*ppLayoutSystem = NULL;
+		*ppMapLayout = NULL;
+		return false;
+	}
+
+	return generator.Finish( ppLayoutSystem, ppMapLayout );
+}
+
+CSpeculativeLayoutGenerator::CSpeculativeLayoutGenerator() :
+	m_nWinner( -1 )
+{
+}
+
+CSpeculativeLayoutGenerator::~CSpeculativeLayoutGenerator()
+{
+	Abort();
+}
+
+bool CSpeculativeLayoutGenerator::Begin( KeyValues *pMissionDefinition, KeyValues *pMissionSettings, int nSeeds )
+{
+	Abort();
+
+	// Anything touching global state (themes, class factories, the global random stream) 
+	// has to happen here, before the seeds go wide.
+	CLevelTheme::LoadLevelThemes();
+
+	m_nWinner = -1;
+	m_Layouts.EnsureCapacity( nSeeds );
+	for ( int i = 0; i < nSeeds; ++ i )
+	{
+		CLayoutSystem *pLayoutSystem = new CLayoutSystem();
+		AddListeners( pLayoutSystem );
+		if ( !pLayoutSystem->LoadFromKeyValues( pMissionDefinition ) )
+		{
+			Log_Warning( LOG_TilegenLayoutSystem, "Failed to load mission from key values definition.\n" );
+			delete pLayoutSystem;
+			Abort();
+			return false;
+		}
+		pLayoutSystem->SetDeferFixedSpawns( true );
+
+		SpeculativeLayout_t &layout = m_Layouts[m_Layouts.AddToTail()];
+		layout.m_pLayoutSystem = pLayoutSystem;
+		layout.m_pMapLayout = new CMapLayout( pMissionSettings ? pMissionSettings->MakeCopy() : NULL );
+		layout.m_nSeed = RandomInt( 1, 1000000000 );
+		layout.m_nIndex = i;
+		layout.m_pWinner = &m_nWinner;
+		layout.m_pJob = NULL;
+	}
+
+	// Only queued once every seed is set up, so the jobs never see the vector reallocate.
+	for ( int i = 0; i < m_Layouts.Count(); ++ i )
+	{
+		m_Layouts[i].m_pJob = g_pThreadPool->QueueCall( GenerateSpeculativeLayout, &m_Layouts[i] );
+	}
+
+	return true;
+}
+
+bool CSpeculativeLayoutGenerator::IsFinished() const
+{
+	for ( int i = 0; i < m_Layouts.Count(); ++ i )
+	{
+		if ( m_Layouts[i].m_pJob && !m_Layouts[i].m_pJob->IsFinished() )
+			return false;
+	}
+
+	return true;
+}
+
+void CSpeculativeLayoutGenerator::WaitForJobs()
+{
+	for ( int i = 0; i < m_Layouts.Count(); ++ i )
+	{
+		if ( m_Layouts[i].m_pJob )
+		{
+			m_Layouts[i].m_pJob->WaitForFinishAndRelease();
+			m_Layouts[i].m_pJob = NULL;
+		}
+	}
+}
+
+bool CSpeculativeLayoutGenerator::Finish( CLayoutSystem **ppLayoutSystem, CMapLayout **ppMapLayout )
+{
+	*ppLayoutSystem = NULL;
+	*ppMapLayout = NULL;
+
+	WaitForJobs();
+
+	int nWinner = m_nWinner;
+	int nSeed = 0;
+	int nSeeds = m_Layouts.Count();
+	for ( int i = 0; i < m_Layouts.Count(); ++ i )
+	{
+		if ( i == nWinner )
+		{
+			*ppLayoutSystem = m_Layouts[i].m_pLayoutSystem;
+			*ppMapLayout = m_Layouts[i].m_pMapLayout;
+			nSeed = m_Layouts[i].m_nSeed;
+		}
+		else
+		{
+			delete m_Layouts[i].m_pMapLayout;
+			delete m_Layouts[i].m_pLayoutSystem;
+		}
+	}
+	m_Layouts.RemoveAll();
+
+	if ( *ppLayoutSystem == NULL )
+		return false;
+
+	Log_Msg( LOG_TilegenLayoutSystem, "Speculative generation picked random seed " );
+	Log_Msg( LOG_TilegenLayoutSystem, Color( 255, 255, 0, 255 ), "%d", nSeed );
+	Log_Msg( LOG_TilegenLayoutSystem, " out of %d.\n", nSeeds );
+
+	( *ppLayoutSystem )->SetDeferFixedSpawns( false );
+	( *ppLayoutSystem )->PlaceFixedSpawns();
+	return true;
+}
+
+void CSpeculativeLayoutGenerator::Abort()
+{
+	m_nWinner = SPECULATIVE_LAYOUT_ABORTED;
+	WaitForJobs();
+
+	for ( int i = 0; i < m_Layouts.Count(); ++ i )
+	{
+		delete m_Layouts[i].m_pMapLayout;
+		delete m_Layouts[i].m_pLayoutSystem;
+	}
+	m_Layouts.RemoveAll();
+}
+
 CTilegenState *CTilegenStateList::FindState( const char *pStateName )
 {
 	for ( int i = 0; i < m_States.Count(); ++ i )
@@ -242,6 +403,7 @@ CLayoutSystem::CLayoutSystem() :
 	m_ActionData( DefLessFunc( ITilegenAction *) ),
 	m_bLayoutError( false ),
 	m_bGenerating( false ),
+	m_bDeferFixedSpawns( false ),
 	m_nIterations( 0 )
 {
 	m_States.SetLayoutSystem( this );
@@ -373,6 +535,14 @@ void CLayoutSystem::OnFinished()
 	m_CurrentIterationState.m_bStopIteration = true;
 	Log_Msg( LOG_TilegenLayoutSystem, "CLayoutSystem: finished layout generation.\n" );
 
+	if ( !m_bDeferFixedSpawns )
+	{
+		PlaceFixedSpawns();
+	}
+}
+
+void CLayoutSystem::PlaceFixedSpawns()
+{
 	// Temp hack to setup fixed alien spawns
 	// TODO: Move this into a required rule
 	CASWMissionChooserNPCs::InitFixedSpawns( this, m_pMapLayout );
@@ -439,7 +609,7 @@ void CLayoutSystem::OnStateChanged( const CTilegenState *pOldState )
 	m_pCurrentState->OnStateChanged( this );
 }
 
-void CLayoutSystem::BeginGeneration( CMapLayout *pMapLayout ) 
+void CLayoutSystem::BeginGeneration( CMapLayout *pMapLayout, int nRandomSeed ) 
 { 
 	if ( m_States.GetStateCount() == 0 )
 	{
@@ -451,7 +621,11 @@ void CLayoutSystem::BeginGeneration( CMapLayout *pMapLayout )
 	// Reset random generator
 	int nSeed;
 	m_Random = CUniformRandomStream();
-	if ( m_nRandomSeed != 0 )
+	if ( nRandomSeed != 0 )
+	{
+		nSeed = nRandomSeed;
+	}
+	else if ( m_nRandomSeed != 0 )
 	{
 		nSeed = m_nRandomSeed;
 	}
@@ -582,3 +756,107 @@ void CLayoutSystem::AddOpenExit( CRoom *pSourceRoom, int nX, int nY, ExitDirecti
 
 	m_OpenExits.AddToTail( CExit( nX, nY, exitDirection, pExitTag, pSourceRoom, bChokepointGrowSource ) );
 }
+
+//-----------------------------------------------------------------------------
+// Times layout generation for every shipped mission definition, one seed
+// at a time (retrying failures like the map builder does) versus
+// speculatively with several seeds in parallel.
+//-----------------------------------------------------------------------------
+void CC_Tilegen_Benchmark( const CCommand &args )
+{
+	int nGenerations = ( args.ArgC() >= 2 ) ? MAX( atoi( args[1] ), 1 ) : 10;
+	int nSeeds = ( args.ArgC() >= 3 ) ? MAX( atoi( args[2] ), 1 ) : 4;
+	const int nMaxTries = 20;
+
+	CASW_KeyValuesDatabase missionDatabase;
+	missionDatabase.LoadFiles( "tilegen/new_missions/" );
+	CASW_KeyValuesDatabase rulesDatabase;
+	rulesDatabase.LoadFiles( "tilegen/rules/" );
+
+	CTilegenMissionPreprocessor preprocessor;
+	for ( int i = 0; i < rulesDatabase.GetFileCount(); ++ i )
+	{
+		preprocessor.ParseAndStripRules( rulesDatabase.GetFile( i ) );
+	}
+
+	// Per-iteration logging would dominate the timings.
+	LoggingSystem_SetChannelSpewLevel( LOG_TilegenLayoutSystem, LS_WARNING );
+
+	Msg( "%d layouts per mission, %d parallel seeds.\n", nGenerations, nSeeds );
+	Msg( "%-40s %10s %6s %6s %10s %6s %6s\n", "mission", "serial ms", "tries", "fails", "spec ms", "tries", "fails" );
+
+	for ( int i = 0; i < missionDatabase.GetFileCount(); ++ i )
+	{
+		KeyValues *pMission = missionDatabase.GetFile( i );
+		if ( !preprocessor.SubstituteRules( pMission ) )
+		{
+			Warning( "Error pre-processing mission '%s'.\n", missionDatabase.GetFilename( i ) );
+			continue;
+		}
+		KeyValues *pSettings = pMission->FindKey( "mission_settings" );
+
+		int nSerialTries = 0, nSerialFailures = 0;
+		double flSerialStart = Plat_FloatTime();
+		for ( int nGeneration = 0; nGeneration < nGenerations; ++ nGeneration )
+		{
+			CLayoutSystem *pLayoutSystem = new CLayoutSystem();
+			AddListeners( pLayoutSystem );
+			CMapLayout *pMapLayout = new CMapLayout( pSettings ? pSettings->MakeCopy() : NULL );
+
+			bool bSucceeded = false;
+			if ( pLayoutSystem->LoadFromKeyValues( pMission ) )
+			{
+				for ( int nTry = 0; nTry < nMaxTries && !bSucceeded; ++ nTry )
+				{
+					pMapLayout->Clear();
+					pLayoutSystem->BeginGeneration( pMapLayout, RandomInt( 1, 1000000000 ) );
+					while ( pLayoutSystem->IsGenerating() )
+					{
+						pLayoutSystem->ExecuteIteration();
+					}
+					bSucceeded = !pLayoutSystem->GenerationErrorOccurred();
+					++ nSerialTries;
+				}
+			}
+			nSerialFailures += bSucceeded ? 0 : 1;
+
+			delete pMapLayout;
+			delete pLayoutSystem;
+		}
+		double flSerialTime = Plat_FloatTime() - flSerialStart;
+
+		int nSpeculativeTries = 0, nSpeculativeFailures = 0;
+		double flSpeculativeStart = Plat_FloatTime();
+		for ( int nGeneration = 0; nGeneration < nGenerations; ++ nGeneration )
+		{
+			bool bSucceeded = false;
+			for ( int nTry = 0; nTry < nMaxTries && !bSucceeded; nTry += nSeeds )
+			{
+				CLayoutSystem *pLayoutSystem;
+				CMapLayout *pMapLayout;
+				bSucceeded = GenerateLayoutSpeculative( pMission, pSettings, nSeeds, &pLayoutSystem, &pMapLayout );
+				delete pMapLayout;
+				delete pLayoutSystem;
+				nSpeculativeTries += nSeeds;
+			}
+			nSpeculativeFailures += bSucceeded ? 0 : 1;
+		}
+		double flSpeculativeTime = Plat_FloatTime() - flSpeculativeStart;
+
+		Msg( "%-40s %10.2f %6d %6d %10.2f %6d %6d\n", missionDatabase.GetFilename( i ),
+			flSerialTime * 1000.0 / nGenerations, nSerialTries, nSerialFailures,
+			flSpeculativeTime * 1000.0 / nGenerations, nSpeculativeTries, nSpeculativeFailures );
+	}
+
+	LoggingSystem_SetChannelSpewLevel( LOG_TilegenLayoutSystem, LS_MESSAGE );
+
+	for ( int i = 0; i < missionDatabase.GetFileCount(); ++ i )
+	{
+		missionDatabase.GetFile( i )->deleteThis();
+	}
+	for ( int i = 0; i < rulesDatabase.GetFileCount(); ++ i )
+	{
+		rulesDatabase.GetFile( i )->deleteThis();
+	}
+}
+static ConCommand tilegen_benchmark( "tilegen_benchmark", CC_Tilegen_Benchmark, "Times layout generation of every mission in tilegen/new_missions. Usage: tilegen_benchmark [layouts per mission] [parallel seeds]", FCVAR_CHEAT );
@@ -12,6 +12,7 @@
 #endif
 
 #include "utlvector.h"
+#include "tier0/threadtools.h"
 #include "vstdlib/random.h"
 #include "tilegen_class_interfaces.h"
 #include "tilegen_expressions.h"
@@ -20,12 +21,84 @@
 class CMapLayout;
 class CTilegenState;
 class CLayoutSystem;
+class CJob;
 
 //-----------------------------------------------------------------------------
 // Adds all known tilegen listeners to the given layout system.
 //-----------------------------------------------------------------------------
 void AddListeners( CLayoutSystem *pLayoutSystem );
 
+//-----------------------------------------------------------------------------
+// Generates a layout for the mission from nSeeds random seeds in parallel,
+// each seed in its own layout system and map layout.  The first seed to
+// finish without errors wins and the others are abandoned.
+//
+// Returns true on success, in which case the winning layout system and
+// map layout are handed to the caller (who owns them).
+//
+// Blocks until done, see CSpeculativeLayoutGenerator to poll instead.
+//-----------------------------------------------------------------------------
+bool GenerateLayoutSpeculative( KeyValues *pMissionDefinition, KeyValues *pMissionSettings, int nSeeds, CLayoutSystem **ppLayoutSystem, CMapLayout **ppMapLayout );
+
+//-----------------------------------------------------------------------------
+// One seed of a speculative generation.
+//-----------------------------------------------------------------------------
+struct SpeculativeLayout_t
+{
+	CLayoutSystem *m_pLayoutSystem;
+	CMapLayout *m_pMapLayout;
+	int m_nSeed;
+	int m_nIndex;
+	CInterlockedInt *m_pWinner;
+	CJob *m_pJob;
+};
+
+//-----------------------------------------------------------------------------
+// Speculative layout generation running as jobs on the thread pool, so the
+// caller can keep ticking frames and poll IsFinished().
+//-----------------------------------------------------------------------------
+class CSpeculativeLayoutGenerator
+{
+public:
+	CSpeculativeLayoutGenerator();
+	~CSpeculativeLayoutGenerator();
+
+	//-----------------------------------------------------------------------------
+	// Loads the mission into nSeeds layout systems and queues one job per seed.
+	// Any generation still in progress is aborted first.
+	//-----------------------------------------------------------------------------
+	bool Begin( KeyValues *pMissionDefinition, KeyValues *pMissionSettings, int nSeeds );
+
+	//-----------------------------------------------------------------------------
+	// True between Begin() and Finish()/Abort().
+	//-----------------------------------------------------------------------------
+	bool IsRunning() const { return m_Layouts.Count() > 0; }
+	int GetSeedCount() const { return m_Layouts.Count(); }
+
+	//-----------------------------------------------------------------------------
+	// True once every seed has stopped (finished, failed or given up because 
+	// another seed won).
+	//-----------------------------------------------------------------------------
+	bool IsFinished() const;
+
+	//-----------------------------------------------------------------------------
+	// Waits for the jobs if needed and picks the winner, see
+	// GenerateLayoutSpeculative for the return value.
+	//-----------------------------------------------------------------------------
+	bool Finish( CLayoutSystem **ppLayoutSystem, CMapLayout **ppMapLayout );
+
+	//-----------------------------------------------------------------------------
+	// Stops every seed at its next iteration and discards the layouts.
+	//-----------------------------------------------------------------------------
+	void Abort();
+
+private:
+	void WaitForJobs();
+
+	CUtlVector< SpeculativeLayout_t > m_Layouts;
+	CInterlockedInt m_nWinner;
+};
+
 //-----------------------------------------------------------------------------
 // A list of states in a state layout system state machine.
 // Each state may contain a nested state list.
@@ -264,6 +337,14 @@ public:
 	//-----------------------------------------------------------------------------
 	void OnFinished();
 
+	//-----------------------------------------------------------------------------
+	// Places the fixed alien spawns of the finished layout.  Normally done by
+	// OnFinished, but that touches global state, so layouts generated on a
+	// worker thread defer it until the calling thread picks them.
+	//-----------------------------------------------------------------------------
+	void PlaceFixedSpawns();
+	void SetDeferFixedSpawns( bool bDefer ) { m_bDeferFixedSpawns = bDefer; }
+
 	//-----------------------------------------------------------------------------
 	// Executes the specified action with a given condition.  
 	// If pCondition is NULL, the action is always executed.
@@ -274,8 +355,9 @@ public:
 	// Resets the layout system and begins generating a new map.
 	// Once this is called, the system must be ticked by calling ExecuteIteration
 	// until IsGeneration() returns false.
+	// A non-zero nRandomSeed overrides the seed of the mission.
 	//-----------------------------------------------------------------------------
-	void BeginGeneration( CMapLayout *pMapLayout );
+	void BeginGeneration( CMapLayout *pMapLayout, int nRandomSeed = 0 );
 
 	//-----------------------------------------------------------------------------
 	// Executes a single pass through the actions in the global & current state.
@@ -328,6 +410,7 @@ private:
 
 	bool m_bLayoutError;
 	bool m_bGenerating;
+	bool m_bDeferFixedSpawns;
 
 	// Number of iterations since beginning level generation.
 	int m_nIterations;
@@ -3324,16 +3324,17 @@ void CAI_BaseNPC::UpdateEfficiency( bool bInPVS )
 	
 	if ( GetSoundInterests() & SOUND_DANGER )
 	{
-		int	iSound = CSoundEnt::ActiveList();
-		
-		while ( iSound != SOUNDLIST_EMPTY )
-		{
-			CSound *pCurrentSound = CSoundEnt::SoundPointerForIndex( iSound );
+		float hearingSensitivity = HearingSensitivity();
+		Vector vEarPosition = EarPosition();
 
-			float hearingSensitivity = HearingSensitivity();
-			Vector vEarPosition = EarPosition();
+		CUtlVector<int> sounds;
+		CSoundEnt::GetSoundsInRange( vEarPosition, hearingSensitivity, SOUND_DANGER, sounds );
+
+		for ( int i = 0; i < sounds.Count(); i++ )
+		{
+			CSound *pCurrentSound = CSoundEnt::SoundPointerForIndex( sounds[i] );
 
-			if ( pCurrentSound && (SOUND_DANGER & pCurrentSound->SoundType()) )
+			if ( pCurrentSound )
 			{
 				float flHearDistanceSq = pCurrentSound->Volume() * hearingSensitivity;
 				flHearDistanceSq *= flHearDistanceSq;
@@ -3343,8 +3344,6 @@ void CAI_BaseNPC::UpdateEfficiency( bool bInPVS )
 					break;
 				}
 			}
-			
-			iSound = pCurrentSound->NextSound();
 		}
 	}
 
@@ -3516,22 +3515,20 @@ void CAI_BaseNPC::UpdateSleepState( bool bInPVS )
 				// Should check for visible danger sounds
 				if ( (GetSoundInterests() & SOUND_DANGER) && !(HasSpawnFlags(SF_NPC_WAIT_TILL_SEEN)) )
 				{
-					int	iSound = CSoundEnt::ActiveList();
-					
-					while ( iSound != SOUNDLIST_EMPTY )
+					CUtlVector<int> sounds;
+					CSoundEnt::GetSoundsInRange( EarPosition(), HearingSensitivity(), SOUND_DANGER, sounds );
+
+					for ( int i = 0; i < sounds.Count(); i++ )
 					{
-						CSound *pCurrentSound = CSoundEnt::SoundPointerForIndex( iSound );
+						CSound *pCurrentSound = CSoundEnt::SoundPointerForIndex( sounds[i] );
 						Assert( pCurrentSound );
 
-						if ( (pCurrentSound->SoundType() & SOUND_DANGER) && 
-							 GetSenses()->CanHearSound( pCurrentSound ) &&
+						if ( GetSenses()->CanHearSound( pCurrentSound ) &&
 							 SoundIsVisible( pCurrentSound ))
 						{
 							Wake();
 							break;
 						}
-
-						iSound = pCurrentSound->NextSound();
 					}
 				}
 			}
@@ -14201,7 +14198,7 @@ void CAI_BaseNPC::ModifyOrAppendCriteria( AI_CriteriaSet& set )
 	// Append time since seen player
 	if ( m_flLastSawPlayerTime )
 	{
-		set.AppendCriteria( "timesinceseenplayer", UTIL_VarArgs( "%f", gpGlobals->curtime - m_flLastSawPlayerTime ) );
+		set.AppendCriteria( "timesinceseenplayer", gpGlobals->curtime - m_flLastSawPlayerTime );
 	}
 	else
 	{
@@ -14211,7 +14208,7 @@ void CAI_BaseNPC::ModifyOrAppendCriteria( AI_CriteriaSet& set )
 	// Append distance to my enemy
 	if ( GetEnemy() )
 	{
-		set.AppendCriteria( "distancetoenemy", UTIL_VarArgs( "%f", EnemyDistance(GetEnemy()) ) );
+		set.AppendCriteria( "distancetoenemy", EnemyDistance(GetEnemy()) );
 	}
 	else
 	{
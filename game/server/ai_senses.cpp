@@ -121,20 +121,21 @@ void CAI_Senses::Listen( void )
 	
 	if ( iSoundMask != SOUND_NONE && !(GetCharacter()->HasSpawnFlags(SF_NPC_WAIT_TILL_SEEN)) )
 	{
-		int	iSound = CSoundEnt::ActiveList();
-		
-		while ( iSound != SOUNDLIST_EMPTY )
+		// only the sounds that may reach our ears, not the whole active list
+		CUtlVector<int> sounds;
+		CSoundEnt::GetSoundsInRange( GetCharacter()->EarPosition(), GetCharacter()->HearingSensitivity(), iSoundMask, sounds );
+
+		for ( int i = 0; i < sounds.Count(); i++ )
 		{
+			int iSound = sounds[i];
 			CSound *pCurrentSound = CSoundEnt::SoundPointerForIndex( iSound );
 
-			if ( pCurrentSound	&& (iSoundMask & pCurrentSound->SoundType()) && CanHearSound( pCurrentSound ) )
+			if ( pCurrentSound && CanHearSound( pCurrentSound ) )
 			{
 	 			// the npc cares about this sound, and it's close enough to hear.
 				pCurrentSound->m_iNextAudible = m_iAudibleList;
 				m_iAudibleList = iSound;
 			}
-
-			iSound = pCurrentSound->NextSound();
 		}
 	}
 	
@@ -1283,7 +1283,7 @@ void CAI_ExpresserHost_NPC_DoModifyOrAppendCriteria( CAI_BaseNPC *pSpeaker, AI_C
 		if ( pSpeaker->GetLastEnemyTime() == 0.0 )
 			set.AppendCriteria( "timesincecombat", "999999.0" );
 		else
-			set.AppendCriteria( "timesincecombat", UTIL_VarArgs( "%f", gpGlobals->curtime - pSpeaker->GetLastEnemyTime() ) );
+			set.AppendCriteria( "timesincecombat", gpGlobals->curtime - pSpeaker->GetLastEnemyTime() );
 	}
 
 	set.AppendCriteria( "speed", UTIL_VarArgs( "%.3f", pSpeaker->GetSmoothedVelocity().Length() ) );
@@ -1303,12 +1303,12 @@ void CAI_ExpresserHost_NPC_DoModifyOrAppendCriteria( CAI_BaseNPC *pSpeaker, AI_C
 	{
 		Vector distance = pPlayer->GetAbsOrigin() - pSpeaker->GetAbsOrigin();
 
-		set.AppendCriteria( "distancetoplayer", UTIL_VarArgs( "%f", distance.Length() ) );
+		set.AppendCriteria( "distancetoplayer", distance.Length() );
 
 	}
 	else
 	{
-		set.AppendCriteria( "distancetoplayer", UTIL_VarArgs( "%i", MAX_COORD_RANGE ) );
+		set.AppendCriteriaInt( "distancetoplayer", MAX_COORD_RANGE );
 	}
 
 	if ( pSpeaker->HasCondition( COND_SEE_PLAYER ) )
@@ -14,6 +14,7 @@
 #include "nav.h"
 #include "nav_area.h"
 #include "nav_mesh.h"
+#include "nav_resources.h"
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
@@ -108,30 +109,60 @@ void CSearchResourcesSchedule::GetWander()
 	}
 }
 
+//================================================================================
+// Returns if the bot can go for the resources of this area
+//================================================================================
+static bool IsSafeResourceArea( CNavArea *pArea, CNavArea *pCurrent )
+{
+	if ( !pArea || pArea == pCurrent )
+		return false;
+
+	if ( pArea->IsUnderwater() )
+		return false;
+
+	if ( pArea->GetDanger(TEAM_ANY) > 10.0f )
+		return false;
+
+	return true;
+}
+
 //================================================================================
 // 
 //================================================================================
 void CSearchResourcesSchedule::GetResources() 
 {
-	int count = TheNavMesh->GetNavAreaCount();
-
-	if ( count == 0 )
+	// The index has not been built yet
+	if ( !TheNavResources->IsBuilt() )
 		return;
 
-    FOR_EACH_VEC( TheNavAreas, it )
-    {
-        CNavArea *pArea = TheNavAreas[it];
+	CNavArea *pCurrent = GetHost()->GetLastKnownArea();
 
-		if ( !pArea )
-			continue;
+	// The nearest (by travel distance) resource of each type
+	for ( int type = 0; type < LAST_NAV_RESOURCE; ++type )
+	{
+		CNavArea *pNearest = TheNavResources->GetNearest( pCurrent, (NavResourceType)type );
 
-		if ( pArea->IsUnderwater() )
+		if ( !IsSafeResourceArea(pNearest, pCurrent) )
 			continue;
 
-		if ( pArea->GetDanger(TEAM_ANY) > 10.0f )
+		if ( m_CandidateAreas.HasElement(pNearest) )
 			continue;
 
-		if ( !pArea->HasAttributes(NAV_MESH_RESOURCES) )
+		m_CandidateAreas.AddToTail( pNearest );
+	}
+
+	if ( m_CandidateAreas.Count() > 0 )
+		return;
+
+	// We are already in the nearest ones (or they are not safe),
+	// we choose randomly among the rest
+	const CUtlVector<CNavArea *> &areas = TheNavResources->GetAreas( NAV_RESOURCE_ANY );
+
+    FOR_EACH_VEC( areas, it )
+    {
+        CNavArea *pArea = areas[it];
+
+		if ( !IsSafeResourceArea(pArea, pCurrent) )
 			continue;
     
 		if ( m_CandidateAreas.HasElement(pArea) )
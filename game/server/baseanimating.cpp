@@ -1339,16 +1339,7 @@ int CBaseAnimating::LookupPoseParameter( CStudioHdr *pStudioHdr, const char *szN
 		return 0;
 	}
 
-	for (int i = 0; i < pStudioHdr->GetNumPoseParameters(); i++)
-	{
-		if (Q_stricmp( pStudioHdr->pPoseParameter( i ).pszName(), szName ) == 0)
-		{
-			return i;
-		}
-	}
-
-	// AssertMsg( 0, UTIL_VarArgs( "poseparameter %s couldn't be mapped!!!\n", szName ) );
-	return -1; // Error
+	return ::LookupPoseParameter( pStudioHdr, szName );
 }
 
 //=========================================================
@@ -1955,7 +1946,7 @@ int CBaseAnimating::LookupAttachment( const char *szName )
 	}
 
 	// The +1 is to make attachment indices be 1-based (namely 0 == invalid or unused attachment)
-	const int studioAttachmentNum = Studio_FindAttachment( pStudioHdr, szName );
+	const int studioAttachmentNum = ::LookupAttachment( pStudioHdr, szName );
 	AssertMsg3( studioAttachmentNum >= 0, "Couldn't find attachment %s on skeleton %s for object %s\n",
 		szName, pStudioHdr->pszName(), GetDebugName() );
 	return studioAttachmentNum + 1;
@@ -748,6 +748,11 @@ CBaseEntity::CBaseEntity( bool bServerOnly )
 #endif
 	m_pPrevByClass = m_pNextByClass = NULL;
 	m_ListByClass = (UtlHashHandle_t)~0;
+	m_iListSerial = 0;
+	m_iIndexedName = NULL_STRING;
+	m_iGridCell = -1;
+	m_pPrevInCell = m_pNextInCell = NULL;
+	m_bGridDirty = false;
 	SetNetworkQuantizeOriginAngAngles( false );
 
 	m_flCreateTime = 0.0f;
@@ -3486,6 +3491,17 @@ bool CBaseEntity::PassesDamageFilter( const CTakeDamageInfo &info )
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: Sets the targetname, events already targeting the new name must
+//			look it up again to find this entity.
+//-----------------------------------------------------------------------------
+void CBaseEntity::SetName( string_t newName )
+{
+	m_iName = newName;
+	gEntList.UpdateEntityName( this );
+	g_EventQueue.InvalidateTarget( newName );
+}
+
 bool CBaseEntity::NameMatchesComplex( const char *pszNameOrWildcard )
 {
 	if ( !Q_stricmp( "!player", pszNameOrWildcard) )
@@ -3659,6 +3675,9 @@ int CBaseEntity::Restore( IRestore &restore )
 	// loops through the data description list, restoring each data desc block in order
 	int status = RestoreDataDescBlock( restore, GetDataDescMap() );
 
+	// the name was restored directly, file it in the targetname index
+	gEntList.UpdateEntityName( this );
+
 	// ---------------------------------------------------------------
 	// HACKHACK: We don't know the space of these vectors until now
 	// if they are worldspace, fix them up.
@@ -524,6 +524,7 @@ public:
 	int			GetParentAttachment();
 
 	string_t	GetEntityName();
+	unsigned int GetEntityListSerial() const { return m_iListSerial; }
 	const char *GetEntityNameAsCStr();	// This method is temporary for VSCRIPT functionality until we figure out what to do with string_t (sjb)
 	const char *GetPreTemplateName(); // Not threadsafe. Get the name stripped of template unique decoration
 
@@ -1757,6 +1758,13 @@ private:
 	UtlHashHandle_t		m_ListByClass;
 	CBaseEntity	*		m_pPrevByClass;
 	CBaseEntity	*		m_pNextByClass;
+
+	unsigned int		m_iListSerial;		// position in the global entity list, older entities come first
+	string_t			m_iIndexedName;		// key used by the targetname index, NULL_STRING if not indexed
+	int					m_iGridCell;		// cell of the entity list grid, -1 if not in the grid
+	CBaseEntity	*		m_pPrevInCell;
+	CBaseEntity	*		m_pNextInCell;
+	bool				m_bGridDirty;		// waiting in the grid dirty list
 	// So it can get at the physics methods
 	friend class CCollisionEvent;
 
@@ -2024,11 +2032,6 @@ inline const char *CBaseEntity::GetPreTemplateName()
 	return szStrippedName;
 }
 
-inline void CBaseEntity::SetName( string_t newName )
-{
-	m_iName = newName;
-}
-
 
 inline bool CBaseEntity::NameMatches( const char *pszNameOrWildcard )
 {
@@ -663,10 +663,15 @@ DEFINE_FIXEDSIZE_ALLOCATOR( EventQueuePrioritizedEvent_t, 128, CUtlMemoryPool::G
 
 CEventQueue g_EventQueue;
 
-CEventQueue::CEventQueue()
+static bool TargetCacheLessFunc( const string_t &lhs, const string_t &rhs )
 {
-	m_Events.m_flFireTime = -FLT_MAX;
-	m_Events.m_pNext = NULL;
+	// keys are pooled, comparing the pointers is enough
+	return STRING(lhs) < STRING(rhs);
+}
+
+CEventQueue::CEventQueue() : m_Events( 0, 0, EventLessFunc ), m_TargetCache( 0, 0, TargetCacheLessFunc )
+{
+	m_iNextSerial = 0;
 
 	Init();
 }
@@ -780,27 +785,66 @@ void CEventQueue::Init( void )
 void CEventQueue::Clear( void )
 {
 	// delete all the events in the queue
-	EventQueuePrioritizedEvent_t *pe = m_Events.m_pNext;
-	
-	while ( pe != NULL )
+	for ( int i = 0; i < m_Events.Count(); i++ )
 	{
-		EventQueuePrioritizedEvent_t *next = pe->m_pNext;
-		delete pe;
-		pe = next;
+		delete m_Events.Element( i );
+	}
+
+	m_Events.Purge();
+	m_iNextSerial = 0;
+
+	// the string pool doesn't survive a level change
+	m_TargetCache.Purge();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: the head of the heap is the event that fires first. Events with the
+//			same fire time are kept in the order they were added.
+//-----------------------------------------------------------------------------
+bool CEventQueue::EventLessFunc( EventQueuePrioritizedEvent_t * const &lhs, EventQueuePrioritizedEvent_t * const &rhs )
+{
+	if ( lhs->m_flFireTime != rhs->m_flFireTime )
+		return lhs->m_flFireTime > rhs->m_flFireTime;
+
+	return lhs->m_iSerial > rhs->m_iSerial;
+}
+
+static int __cdecl EventFireOrderCompare( EventQueuePrioritizedEvent_t * const *lhs, EventQueuePrioritizedEvent_t * const *rhs )
+{
+	if ( (*lhs)->m_flFireTime != (*rhs)->m_flFireTime )
+		return ( (*lhs)->m_flFireTime < (*rhs)->m_flFireTime ) ? -1 : 1;
+
+	if ( (*lhs)->m_iSerial != (*rhs)->m_iSerial )
+		return ( (*lhs)->m_iSerial < (*rhs)->m_iSerial ) ? -1 : 1;
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: copies the pending events in the order they will be fired
+//-----------------------------------------------------------------------------
+void CEventQueue::GetSortedEvents( CUtlVector< EventQueuePrioritizedEvent_t * > &events )
+{
+	events.SetCount( m_Events.Count() );
+
+	for ( int i = 0; i < m_Events.Count(); i++ )
+	{
+		events[i] = m_Events.Element( i );
 	}
 
-	m_Events.m_pNext = NULL;
+	events.Sort( EventFireOrderCompare );
 }
 
 void CEventQueue::Dump( void )
 {
-	EventQueuePrioritizedEvent_t *pe = m_Events.m_pNext;
+	CUtlVector< EventQueuePrioritizedEvent_t * > events;
+	GetSortedEvents( events );
 
 	Msg("Dumping event queue. Current time is: %.2f\n", gpGlobals->curtime );
 
-	while ( pe != NULL )
+	FOR_EACH_VEC( events, i )
 	{
-		EventQueuePrioritizedEvent_t *next = pe->m_pNext;
+		EventQueuePrioritizedEvent_t *pe = events[i];
 
 		Msg("   (%.2f) Target: '%s', Input: '%s', Parameter '%s'. Activator: '%s', Caller '%s'.  \n", 
 			pe->m_flFireTime, 
@@ -809,8 +853,6 @@ void CEventQueue::Dump( void )
 			pe->m_VariantValue.String(),
 			pe->m_pActivator ? pe->m_pActivator->GetDebugName() : "None", 
 			pe->m_pCaller ? pe->m_pCaller->GetDebugName() : "None"  );
-
-		pe = next;
 	}
 
 	Msg("Finished dump.\n");
@@ -869,36 +911,85 @@ void CEventQueue::AddEvent( CBaseEntity *target, const char *action, float fireD
 //-----------------------------------------------------------------------------
 void CEventQueue::AddEvent( EventQueuePrioritizedEvent_t *newEvent )
 {
-	// loop through the actions looking for a place to insert
-	EventQueuePrioritizedEvent_t *pe;
-	for ( pe = &m_Events; pe->m_pNext != NULL; pe = pe->m_pNext )
+	newEvent->m_iSerial = m_iNextSerial++;
+	m_Events.Insert( newEvent );
+}
+
+void CEventQueue::RemoveEvent( EventQueuePrioritizedEvent_t *pe )
+{
+	for ( int i = 0; i < m_Events.Count(); i++ )
 	{
-		if ( pe->m_pNext->m_flFireTime > newEvent->m_flFireTime )
+		if ( m_Events.Element( i ) == pe )
 		{
-			break;
+			m_Events.RemoveAt( i );
+			return;
 		}
 	}
 
-	Assert( pe );
+	Assert( 0 );
+}
 
-	// insert
-	newEvent->m_pNext = pe->m_pNext;
-	newEvent->m_pPrev = pe;
-	pe->m_pNext = newEvent;
-	if ( newEvent->m_pNext )
-	{
-		newEvent->m_pNext->m_pPrev = newEvent;
-	}
+//-----------------------------------------------------------------------------
+// Purpose: the key used by the target cache. Names are matched without case,
+//			so "Relay" and "relay" share the same entry.
+//-----------------------------------------------------------------------------
+string_t CEventQueue::GetTargetKey( const char *pszName, bool bAllocate )
+{
+	char szKey[256];
+	Q_strncpy( szKey, pszName, sizeof(szKey) );
+	Q_strlower( szKey );
+
+	return bAllocate ? AllocPooledString( szKey ) : FindPooledString( szKey );
 }
 
-void CEventQueue::RemoveEvent( EventQueuePrioritizedEvent_t *pe )
+//-----------------------------------------------------------------------------
+// Purpose: returns the entities named iszName, in entity list order. Wildcards
+//			and procedural names ("!activator") depend on the context of the
+//			event and are never cached.
+//-----------------------------------------------------------------------------
+const CCopyableUtlVector< EHANDLE > *CEventQueue::GetTargets( string_t iszName )
 {
-	Assert( pe->m_pPrev );
-	pe->m_pPrev->m_pNext = pe->m_pNext;
-	if ( pe->m_pNext )
+	const char *pszName = STRING(iszName);
+
+	if ( pszName[0] == '!' || strchr( pszName, '*' ) != NULL || Q_strlen( pszName ) >= 256 )
+		return NULL;
+
+	string_t iszKey = GetTargetKey( pszName, true );
+
+	unsigned short index = m_TargetCache.Find( iszKey );
+	if ( index != m_TargetCache.InvalidIndex() )
+		return &m_TargetCache[index];
+
+	index = m_TargetCache.Insert( iszKey );
+	CCopyableUtlVector< EHANDLE > &targets = m_TargetCache[index];
+
+	CBaseEntity *target = NULL;
+	while ( ( target = gEntList.FindEntityByName( target, pszName ) ) != NULL )
 	{
-		pe->m_pNext->m_pPrev = pe->m_pPrev;
+		targets.AddToTail( target );
 	}
+
+	return &targets;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: an entity has taken this name (spawn, KeyValue or SetName)
+//-----------------------------------------------------------------------------
+void CEventQueue::InvalidateTarget( string_t iszName )
+{
+	if ( iszName == NULL_STRING || m_TargetCache.Count() == 0 )
+		return;
+
+	const char *pszName = STRING(iszName);
+	if ( !pszName[0] || Q_strlen( pszName ) >= 256 )
+		return;
+
+	// never looked up, nothing to drop
+	string_t iszKey = GetTargetKey( pszName, false );
+	if ( iszKey == NULL_STRING )
+		return;
+
+	m_TargetCache.Remove( iszKey );
 }
 
 
@@ -912,29 +1003,55 @@ void CEventQueue::ServiceEvents( void )
 		return;
 	}
 
-	EventQueuePrioritizedEvent_t *pe = m_Events.m_pNext;
-
-	while ( pe != NULL && pe->m_flFireTime <= gpGlobals->curtime )
+	while ( m_Events.Count() > 0 && m_Events.ElementAtHead()->m_flFireTime <= gpGlobals->curtime )
 	{
 		MDLCACHE_CRITICAL_SECTION();
 
+		// take the event out first, the inputs may add or cancel events
+		EventQueuePrioritizedEvent_t *pe = m_Events.ElementAtHead();
+		m_Events.RemoveAtHead();
+
 		bool targetFound = false;
 
 		// find the targets
 		if ( pe->m_iTarget != NULL_STRING )
 		{
-			// In the context the event, the searching entity is also the caller
-			CBaseEntity *pSearchingEntity = pe->m_pCaller;
-			CBaseEntity *target = NULL;
-			while ( 1 )
+			const CCopyableUtlVector< EHANDLE > *pCached = GetTargets( pe->m_iTarget );
+
+			if ( pCached )
 			{
-				target = gEntList.FindEntityByName( target, pe->m_iTarget, pSearchingEntity, pe->m_pActivator, pe->m_pCaller );
-				if ( !target )
-					break;
+				// the inputs may rename or spawn entities and drop the cache entry
+				CUtlVectorFixedGrowable< EHANDLE, 16 > targets;
+				targets.CopyArray( pCached->Base(), pCached->Count() );
+
+				FOR_EACH_VEC( targets, i )
+				{
+					CBaseEntity *target = targets[i];
+
+					// deleted or renamed since it was cached
+					if ( !target || !target->NameMatches( pe->m_iTarget ) )
+						continue;
+
+					// pump the action into the target
+					target->AcceptInput( STRING(pe->m_iTargetInput), pe->m_pActivator, pe->m_pCaller, pe->m_VariantValue, pe->m_iOutputID );
+					targetFound = true;
+				}
+			}
+			else
+			{
+				// In the context the event, the searching entity is also the caller
+				CBaseEntity *pSearchingEntity = pe->m_pCaller;
+				CBaseEntity *target = NULL;
+				while ( 1 )
+				{
+					target = gEntList.FindEntityByName( target, pe->m_iTarget, pSearchingEntity, pe->m_pActivator, pe->m_pCaller );
+					if ( !target )
+						break;
 
-				// pump the action into the target
-				target->AcceptInput( STRING(pe->m_iTargetInput), pe->m_pActivator, pe->m_pCaller, pe->m_VariantValue, pe->m_iOutputID );
-				targetFound = true;
+					// pump the action into the target
+					target->AcceptInput( STRING(pe->m_iTargetInput), pe->m_pActivator, pe->m_pCaller, pe->m_VariantValue, pe->m_iOutputID );
+					targetFound = true;
+				}
 			}
 		}
 
@@ -981,8 +1098,6 @@ void CEventQueue::ServiceEvents( void )
 			ADD_DEBUG_HISTORY( HISTORY_ENTITY_IO, szBuffer );
 		}
 
-		// remove the event from the list (remembering that the queue may have been added to)
-		RemoveEvent( pe );
 		delete pe;
 
 		//
@@ -995,9 +1110,6 @@ void CEventQueue::ServiceEvents( void )
 				break;
 			}
 		}
-
-		// restart the list (to catch any new items have probably been added to the queue)
-		pe = m_Events.m_pNext;	
 	}
 }
 
@@ -1022,11 +1134,11 @@ void CEventQueue::CancelEvents( CBaseEntity *pCaller )
 	if (!pCaller)
 		return;
 
-	EventQueuePrioritizedEvent_t *pCur = m_Events.m_pNext;
+	CUtlVector< EventQueuePrioritizedEvent_t * > deleteList;
 
-	while (pCur != NULL)
+	for ( int i = 0; i < m_Events.Count(); i++ )
 	{
-		bool bDelete = false;
+		EventQueuePrioritizedEvent_t *pCur = m_Events.Element( i );
 		if (pCur->m_pCaller == pCaller)
 		{
 			// Pointers match; make sure everything else matches.
@@ -1034,18 +1146,15 @@ void CEventQueue::CancelEvents( CBaseEntity *pCaller )
 				!stricmp(pCur->m_pCaller->GetClassname(), pCaller->GetClassname()))
 			{
 				// Found a matching event; delete it from the queue.
-				bDelete = true;
+				deleteList.AddToTail( pCur );
 			}
 		}
+	}
 
-		EventQueuePrioritizedEvent_t *pCurSave = pCur;
-		pCur = pCur->m_pNext;
-
-		if (bDelete)
-		{
-			RemoveEvent( pCurSave );
-			delete pCurSave;
-		}
+	FOR_EACH_VEC( deleteList, i )
+	{
+		RemoveEvent( deleteList[i] );
+		delete deleteList[i];
 	}
 }
 
@@ -1060,28 +1169,25 @@ void CEventQueue::CancelEventOn( CBaseEntity *pTarget, const char *sInputName )
 	if (!pTarget)
 		return;
 
-	EventQueuePrioritizedEvent_t *pCur = m_Events.m_pNext;
+	CUtlVector< EventQueuePrioritizedEvent_t * > deleteList;
 
-	while (pCur != NULL)
+	for ( int i = 0; i < m_Events.Count(); i++ )
 	{
-		bool bDelete = false;
+		EventQueuePrioritizedEvent_t *pCur = m_Events.Element( i );
 		if (pCur->m_pEntTarget == pTarget)
 		{
 			if ( !Q_strncmp( STRING(pCur->m_iTargetInput), sInputName, strlen(sInputName) ) )
 			{
 				// Found a matching event; delete it from the queue.
-				bDelete = true;
+				deleteList.AddToTail( pCur );
 			}
 		}
+	}
 
-		EventQueuePrioritizedEvent_t *pCurSave = pCur;
-		pCur = pCur->m_pNext;
-
-		if (bDelete)
-		{
-			RemoveEvent( pCurSave );
-			delete pCurSave;
-		}
+	FOR_EACH_VEC( deleteList, i )
+	{
+		RemoveEvent( deleteList[i] );
+		delete deleteList[i];
 	}
 }
 
@@ -1095,10 +1201,9 @@ bool CEventQueue::HasEventPending( CBaseEntity *pTarget, const char *sInputName
 	if (!pTarget)
 		return false;
 
-	EventQueuePrioritizedEvent_t *pCur = m_Events.m_pNext;
-
-	while (pCur != NULL)
+	for ( int i = 0; i < m_Events.Count(); i++ )
 	{
+		EventQueuePrioritizedEvent_t *pCur = m_Events.Element( i );
 		if (pCur->m_pEntTarget == pTarget)
 		{
 			if ( !sInputName )
@@ -1107,8 +1212,6 @@ bool CEventQueue::HasEventPending( CBaseEntity *pTarget, const char *sInputName
 			if ( !Q_strncmp( STRING(pCur->m_iTargetInput), sInputName, strlen(sInputName) ) )
 				return true;
 		}
-
-		pCur = pCur->m_pNext;
 	}
 
 	return false;
@@ -1143,29 +1246,27 @@ BEGIN_SIMPLE_DATADESC( EventQueuePrioritizedEvent_t )
 	DEFINE_FIELD( m_iOutputID, FIELD_INTEGER ),
 	DEFINE_CUSTOM_FIELD( m_VariantValue, variantFuncs ),
 
-//	DEFINE_FIELD( m_pNext, FIELD_??? ),
-//	DEFINE_FIELD( m_pPrev, FIELD_??? ),
+//	DEFINE_FIELD( m_iSerial, FIELD_INTEGER ),	// rebuilt from the save order on restore
 END_DATADESC()
 
 
 int CEventQueue::Save( ISave &save )
 {
-	// count the number of items in the queue
-	EventQueuePrioritizedEvent_t *pe;
+	// save them in fire order, so restoring keeps the order of simultaneous events
+	CUtlVector< EventQueuePrioritizedEvent_t * > events;
+	GetSortedEvents( events );
 
-	m_iListCount = 0;
-	for ( pe = m_Events.m_pNext; pe != NULL; pe = pe->m_pNext )
-	{
-		m_iListCount++;
-	}
+	// count the number of items in the queue
+	m_iListCount = events.Count();
 
 	// save that value out to disk, so we know how many to restore
 	if ( !save.WriteFields( "EventQueue", this, NULL, m_DataMap.dataDesc, m_DataMap.dataNumFields ) )
 		return 0;
 	
 	// cycle through all the events, saving them all
-	for ( pe = m_Events.m_pNext; pe != NULL; pe = pe->m_pNext )
+	FOR_EACH_VEC( events, i )
 	{
+		EventQueuePrioritizedEvent_t *pe = events[i];
 		if ( !save.WriteFields( "PEvent", pe, NULL, pe->m_DataMap.dataDesc, pe->m_DataMap.dataNumFields ) )
 			return 0;
 	}
@@ -11,6 +11,7 @@
 #include "igamesystem.h"
 #include "collisionutils.h"
 #include "UtlSortVector.h"
+#include "utlmap.h"
 #include "tier0/vprof.h"
 #include "mapentities.h"
 #include "client.h"
@@ -375,10 +376,197 @@ typedef CUtlHash<EntsByStringList_t	, CEntsByStringHashFuncs, CEntsByStringHashF
 
 CEntsByStringTable g_EntsByClassname( 512 );
 
+//-------------------------------------
+// Entities by targetname. The key is the lowercase pooled name (names are
+// matched without case), the keys are sorted so a trailing wildcard
+// ("director_*") is a range of the map. Each list is sorted by position in
+// the entity list, so iterating gives the same order as walking the list.
+
+static bool EntsByNameLessFunc( const string_t &lhs, const string_t &rhs )
+{
+	return Q_strcmp( STRING(lhs), STRING(rhs) ) < 0;
+}
+
+typedef CCopyableUtlVector< CBaseEntity * > CEntsByNameList;
+typedef CUtlMap< string_t, CEntsByNameList > CEntsByNameTable;
+
+CEntsByNameTable g_EntsByName( 0, 512, EntsByNameLessFunc );
+
+// returns the first entity of the list found after the given list position
+static int EntsByNameLowerBound( const CEntsByNameList &list, unsigned int serial )
+{
+	int lo = 0;
+	int hi = list.Count();
+
+	while ( lo < hi )
+	{
+		int mid = ( lo + hi ) >> 1;
+		if ( list[mid]->GetEntityListSerial() < serial )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static CBaseEntity *EntsByNameFirst( const CEntsByNameList &list, unsigned int serial, IEntityFindFilter *pFilter )
+{
+	for ( int i = EntsByNameLowerBound( list, serial ); i < list.Count(); i++ )
+	{
+		if ( pFilter && !pFilter->ShouldFindEntity( list[i] ) )
+			continue;
+
+		return list[i];
+	}
+
+	return NULL;
+}
+
+//-------------------------------------
+// Loose grid of the entities on the XY plane, used by the spatial queries.
+// An entity lives in the cell of its collision origin when its bounds reach
+// less than half a cell from it (whatever the angles), bigger entities go
+// to an extra list that every query checks. The collision property tells us
+// when an entity moves or changes its bounds, it is placed again before the
+// next query.
+
+#define ENTITY_GRID_CELL_SIZE	512
+#define ENTITY_GRID_SIZE		( ( 2 * MAX_COORD_INTEGER ) / ENTITY_GRID_CELL_SIZE )
+#define ENTITY_GRID_OVERSIZED	( ENTITY_GRID_SIZE * ENTITY_GRID_SIZE )
+
+abstract_class IEntityGridTest
+{
+public:
+	virtual bool TestEntity( CBaseEntity *pEntity ) = 0;
+};
+
+static CBaseEntity *g_EntityGrid[ ENTITY_GRID_OVERSIZED + 1 ];
+static CUtlVector< EHANDLE > g_EntityGridDirty;
+
+// The iterators call FindEntityInGrid once per result. A query gathers the
+// entities of its cells sorted by list order once, the following calls of the
+// same tick over the same cells continue from that list and only test the
+// entities after pStartEntity.
+#define ENTITY_GRID_QUERY_CACHE	4
+
+struct EntityGridCandidate_t
+{
+	EHANDLE m_hEntity;
+	unsigned int m_nSerial;
+};
+
+struct EntityGridQuery_t
+{
+	EntityGridQuery_t() : m_nTick( -1 ), m_nLastUsed( 0 ) {}
+
+	int m_iMinX, m_iMaxX, m_iMinY, m_iMaxY;
+	int m_nTick;
+	int m_nLastUsed;
+	CUtlVector< EntityGridCandidate_t > m_Candidates;
+};
+
+static EntityGridQuery_t g_EntityGridQueries[ ENTITY_GRID_QUERY_CACHE ];
+static int g_nEntityGridQueryCount;
+
+static int EntityGridCoord( float flCoord )
+{
+	int iCoord = (int)floorf( ( flCoord + MAX_COORD_INTEGER ) / ENTITY_GRID_CELL_SIZE );
+	return clamp( iCoord, 0, ENTITY_GRID_SIZE - 1 );
+}
+
+static int EntityGridCell( CBaseEntity *pEntity )
+{
+	CCollisionProperty *pCollision = pEntity->CollisionProp();
+	const Vector &vecMins = pCollision->OBBMins();
+	const Vector &vecMaxs = pCollision->OBBMaxs();
+
+	// how far the bounds can get from the origin in any rotation
+	Vector vecReach( MAX( fabs( vecMins.x ), fabs( vecMaxs.x ) ),
+		MAX( fabs( vecMins.y ), fabs( vecMaxs.y ) ),
+		MAX( fabs( vecMins.z ), fabs( vecMaxs.z ) ) );
+
+	const float flHalfCell = ENTITY_GRID_CELL_SIZE * 0.5f;
+	if ( vecReach.LengthSqr() > flHalfCell * flHalfCell )
+		return ENTITY_GRID_OVERSIZED;
+
+	const Vector &vecOrigin = pCollision->GetCollisionOrigin();
+	return EntityGridCoord( vecOrigin.x ) + EntityGridCoord( vecOrigin.y ) * ENTITY_GRID_SIZE;
+}
+
+// entities with an edict whose obb touches the sphere (FindEntityInSphere)
+class CEntityGridSphereTest : public IEntityGridTest
+{
+public:
+	CEntityGridSphereTest( const Vector &vecCenter, float flRadius, const char *pszClassname = NULL )
+		: m_vecCenter( vecCenter ), m_flRadius( flRadius ), m_pszClassname( pszClassname )
+	{
+	}
+
+	virtual bool TestEntity( CBaseEntity *pEntity )
+	{
+		if ( m_pszClassname )
+		{
+			if ( !pEntity->edict() && !pEntity->IsEFlagSet( EFL_SERVER_ONLY ) )
+				return false;
+
+			if ( !pEntity->ClassMatches( m_pszClassname ) )
+				return false;
+		}
+		else if ( !pEntity->edict() )
+		{
+			return false;
+		}
+
+		Vector vecRelativeCenter;
+		pEntity->CollisionProp()->WorldToCollisionSpace( m_vecCenter, &vecRelativeCenter );
+		return IsBoxIntersectingSphere( pEntity->CollisionProp()->OBBMins(), pEntity->CollisionProp()->OBBMaxs(), vecRelativeCenter, m_flRadius );
+	}
+
+	Vector m_vecCenter;
+	float m_flRadius;
+	const char *m_pszClassname;
+};
+
+// entities with an edict whose aabb touches the box (FindEntityInBox)
+class CEntityGridBoxTest : public IEntityGridTest
+{
+public:
+	CEntityGridBoxTest( const Vector &vecMins, const Vector &vecMaxs, const char *pszClassname = NULL )
+		: m_vecMins( vecMins ), m_vecMaxs( vecMaxs ), m_pszClassname( pszClassname )
+	{
+	}
+
+	virtual bool TestEntity( CBaseEntity *pEntity )
+	{
+		if ( m_pszClassname )
+		{
+			if ( !pEntity->edict() && !pEntity->IsEFlagSet( EFL_SERVER_ONLY ) )
+				return false;
+
+			if ( !pEntity->ClassMatches( m_pszClassname ) )
+				return false;
+		}
+		else if ( !pEntity->edict() )
+		{
+			return false;
+		}
+
+		Vector entMins, entMaxs;
+		pEntity->CollisionProp()->WorldSpaceAABB( &entMins, &entMaxs );
+		return IsBoxIntersectingBox( m_vecMins, m_vecMaxs, entMins, entMaxs );
+	}
+
+	Vector m_vecMins;
+	Vector m_vecMaxs;
+	const char *m_pszClassname;
+};
+
 //-----------------------------------------------------------------------------
 CGlobalEntityList::CGlobalEntityList()
 {
 	m_iHighestEnt = m_iNumEnts = m_iNumEdicts = 0;
+	m_iNextListSerial = 1;
 	m_bClearingEntities = false;
 }
 
@@ -473,6 +661,13 @@ void CGlobalEntityList::Clear( void )
 
 	g_EntsByClassname.RemoveAll();
 
+	// the keys are pooled strings, they don't survive the level
+	g_EntsByName.Purge();
+	m_iNextListSerial = 1;
+
+	// every entity left the grid on removal
+	g_EntityGridDirty.Purge();
+
 	CBaseEntity::m_nDebugPlayer = -1;
 	CBaseEntity::m_bInDebugSelect = false; 
 	m_iHighestEnt = 0;
@@ -713,31 +908,125 @@ CBaseEntity *CGlobalEntityList::FindEntityByName( CBaseEntity *pStartEntity, con
 
 		return NULL;
 	}
-	
-	const CEntInfo *pInfo = pStartEntity ? GetEntInfoPtr( pStartEntity->GetRefEHandle() )->m_pNext : FirstEntInfo();
 
-	for ( ;pInfo; pInfo = pInfo->m_pNext )
+	return FindEntityByNameIndexed( pStartEntity, szName, pFilter );
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Same results and order as walking the entity list, but only looks
+//			at the entities whose name can match.
+//-----------------------------------------------------------------------------
+CBaseEntity *CGlobalEntityList::FindEntityByNameIndexed( CBaseEntity *pStartEntity, const char *szName, IEntityFindFilter *pFilter )
+{
+	// everything after the first wildcard is ignored (see EntityNamesMatch)
+	const char *pszWildcard = strchr( szName, '*' );
+	int len = pszWildcard ? ( pszWildcard - szName ) : Q_strlen( szName );
+
+	char *pszKey = (char *)stackalloc( len + 1 );
+	Q_strncpy( pszKey, szName, len + 1 );
+	Q_strlower( pszKey );
+
+	unsigned int serial = pStartEntity ? pStartEntity->m_iListSerial + 1 : 0;
+
+	if ( !pszWildcard )
 	{
-		CBaseEntity *ent = (CBaseEntity *)pInfo->m_pEntity;
-		if ( !ent )
+		unsigned short index = g_EntsByName.Find( MAKE_STRING( pszKey ) );
+		if ( index == g_EntsByName.InvalidIndex() )
+			return NULL;
+
+		return EntsByNameFirst( g_EntsByName[index], serial, pFilter );
+	}
+
+	// find the first key that is not below the prefix
+	CEntsByNameTable::CTree *pTree = g_EntsByName.AccessTree();
+	unsigned short index = pTree->Root();
+	unsigned short first = pTree->InvalidIndex();
+
+	while ( index != pTree->InvalidIndex() )
+	{
+		if ( Q_strcmp( STRING(g_EntsByName.Key( index )), pszKey ) >= 0 )
 		{
-			DevWarning( "NULL entity in global entity list!\n" );
-			continue;
+			first = index;
+			index = pTree->LeftChild( index );
+		}
+		else
+		{
+			index = pTree->RightChild( index );
 		}
+	}
 
-		if ( !ent->m_iName.Get() )
-			continue;
+	// every name with the prefix, keep the one that comes first in the entity list
+	CBaseEntity *pBest = NULL;
 
-		if ( ent->NameMatches( szName ) )
-		{
-			if ( pFilter && !pFilter->ShouldFindEntity(ent) )
-				continue;
+	for ( index = first; index != g_EntsByName.InvalidIndex(); index = g_EntsByName.NextInorder( index ) )
+	{
+		if ( Q_strncmp( STRING(g_EntsByName.Key( index )), pszKey, len ) != 0 )
+			break;
 
-			return ent;
-		}
+		CBaseEntity *pEntity = EntsByNameFirst( g_EntsByName[index], serial, pFilter );
+
+		if ( pEntity && ( !pBest || pEntity->m_iListSerial < pBest->m_iListSerial ) )
+			pBest = pEntity;
 	}
 
-	return NULL;
+	return pBest;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Files the entity under its current targetname
+//-----------------------------------------------------------------------------
+void CGlobalEntityList::UpdateEntityName( CBaseEntity *pEnt )
+{
+	if ( !pEnt )
+		return;
+
+	RemoveEntityName( pEnt );
+
+	string_t iszName = pEnt->GetEntityName();
+	if ( iszName == NULL_STRING || STRING(iszName)[0] == 0 || pEnt->IsMarkedForDeletion() )
+		return;
+
+	// not in the list yet, OnAddEntity will give it a position
+	if ( pEnt->m_iListSerial == 0 )
+		return;
+
+	int len = Q_strlen( STRING(iszName) ) + 1;
+	char *pszKey = (char *)stackalloc( len );
+	Q_strncpy( pszKey, STRING(iszName), len );
+	Q_strlower( pszKey );
+
+	string_t iszKey = AllocPooledString( pszKey );
+
+	unsigned short index = g_EntsByName.Find( iszKey );
+	if ( index == g_EntsByName.InvalidIndex() )
+		index = g_EntsByName.Insert( iszKey );
+
+	CEntsByNameList &list = g_EntsByName[index];
+	list.InsertBefore( EntsByNameLowerBound( list, pEnt->m_iListSerial ), pEnt );
+
+	pEnt->m_iIndexedName = iszKey;
+}
+
+void CGlobalEntityList::RemoveEntityName( CBaseEntity *pEnt )
+{
+	if ( pEnt->m_iIndexedName == NULL_STRING )
+		return;
+
+	unsigned short index = g_EntsByName.Find( pEnt->m_iIndexedName );
+	pEnt->m_iIndexedName = NULL_STRING;
+
+	Assert( index != g_EntsByName.InvalidIndex() );
+	if ( index == g_EntsByName.InvalidIndex() )
+		return;
+
+	CEntsByNameList &list = g_EntsByName[index];
+	int i = EntsByNameLowerBound( list, pEnt->m_iListSerial );
+
+	Assert( i < list.Count() && list[i] == pEnt );
+	if ( i < list.Count() && list[i] == pEnt )
+		list.Remove( i );
+
+	// Don't remove empty lists, names are usually reused (respawns, templates)
 }
 
 CBaseEntity *CGlobalEntityList::FindEntityByNameFast( CBaseEntity *pStartEntity, string_t iszName )
@@ -745,24 +1034,23 @@ CBaseEntity *CGlobalEntityList::FindEntityByNameFast( CBaseEntity *pStartEntity,
 	if ( iszName == NULL_STRING || STRING(iszName)[0] == 0 )
 		return NULL;
 
-	const CEntInfo *pInfo = pStartEntity ? GetEntInfoPtr( pStartEntity->GetRefEHandle() )->m_pNext : FirstEntInfo();
+	int len = Q_strlen( STRING(iszName) ) + 1;
+	char *pszKey = (char *)stackalloc( len );
+	Q_strncpy( pszKey, STRING(iszName), len );
+	Q_strlower( pszKey );
 
-	for ( ;pInfo; pInfo = pInfo->m_pNext )
-	{
-		CBaseEntity *ent = (CBaseEntity *)pInfo->m_pEntity;
-		if ( !ent )
-		{
-			DevWarning( "NULL entity in global entity list!\n" );
-			continue;
-		}
+	unsigned short index = g_EntsByName.Find( MAKE_STRING( pszKey ) );
+	if ( index == g_EntsByName.InvalidIndex() )
+		return NULL;
 
-		if ( !ent->m_iName.Get() )
-			continue;
+	// the index ignores case, this one wants the exact same string
+	const CEntsByNameList &list = g_EntsByName[index];
+	unsigned int serial = pStartEntity ? pStartEntity->m_iListSerial + 1 : 0;
 
-		if ( ent->m_iName.Get() == iszName )
-		{
-			return ent;
-		}
+	for ( int i = EntsByNameLowerBound( list, serial ); i < list.Count(); i++ )
+	{
+		if ( list[i]->m_iName.Get() == iszName )
+			return list[i];
 	}
 
 	return NULL;
@@ -870,37 +1158,227 @@ CBaseEntity	*CGlobalEntityList::FindEntityByOutputTarget( CBaseEntity *pStartEnt
 
 
 //-----------------------------------------------------------------------------
-// Purpose: Used to iterate all the entities within a sphere.
-// Input  : pStartEntity - 
-//			vecCenter - 
-//			flRadius - 
+// Purpose: The entity moved or changed its bounds, it will be placed again in
+//			the grid before the next spatial query.
 //-----------------------------------------------------------------------------
-CBaseEntity *CGlobalEntityList::FindEntityInSphere( CBaseEntity *pStartEntity, const Vector &vecCenter, float flRadius )
+void CGlobalEntityList::MarkEntityGridDirty( CBaseEntity *pEnt )
 {
-	const CEntInfo *pInfo = pStartEntity ? GetEntInfoPtr( pStartEntity->GetRefEHandle() )->m_pNext : FirstEntInfo();
+	if ( pEnt->m_bGridDirty )
+		return;
 
-	for ( ;pInfo; pInfo = pInfo->m_pNext )
+	pEnt->m_bGridDirty = true;
+	g_EntityGridDirty.AddToTail( pEnt );
+}
+
+
+void CGlobalEntityList::UpdateEntityGrid()
+{
+	// NOTE: Placing an entity can compute its abs origin, don't cache the count
+	for ( int i = 0; i < g_EntityGridDirty.Count(); i++ )
 	{
-		CBaseEntity *ent = (CBaseEntity *)pInfo->m_pEntity;
-		if ( !ent )
-		{
-			DevWarning( "NULL entity in global entity list!\n" );
+		// removed, or not in the list yet (OnAddEntity marks it again)
+		CBaseEntity *pEntity = g_EntityGridDirty[i];
+		if ( !pEntity )
 			continue;
-		}
 
-		if ( !ent->edict() )
+		pEntity->m_bGridDirty = false;
+
+		int iCell = EntityGridCell( pEntity );
+		if ( iCell == pEntity->m_iGridCell )
 			continue;
 
-		Vector vecRelativeCenter;
-		ent->CollisionProp()->WorldToCollisionSpace( vecCenter, &vecRelativeCenter );
-		if ( !IsBoxIntersectingSphere( ent->CollisionProp()->OBBMins(),	ent->CollisionProp()->OBBMaxs(), vecRelativeCenter, flRadius ) )
+		RemoveFromEntityGrid( pEntity );
+
+		pEntity->m_iGridCell = iCell;
+		pEntity->m_pNextInCell = g_EntityGrid[iCell];
+		if ( g_EntityGrid[iCell] )
+		{
+			g_EntityGrid[iCell]->m_pPrevInCell = pEntity;
+		}
+		g_EntityGrid[iCell] = pEntity;
+	}
+
+	g_EntityGridDirty.RemoveAll();
+}
+
+
+void CGlobalEntityList::RemoveFromEntityGrid( CBaseEntity *pEnt )
+{
+	if ( pEnt->m_iGridCell < 0 )
+		return;
+
+	if ( pEnt->m_pPrevInCell )
+	{
+		pEnt->m_pPrevInCell->m_pNextInCell = pEnt->m_pNextInCell;
+	}
+	else
+	{
+		Assert( g_EntityGrid[pEnt->m_iGridCell] == pEnt );
+		g_EntityGrid[pEnt->m_iGridCell] = pEnt->m_pNextInCell;
+	}
+
+	if ( pEnt->m_pNextInCell )
+	{
+		pEnt->m_pNextInCell->m_pPrevInCell = pEnt->m_pPrevInCell;
+	}
+
+	pEnt->m_pPrevInCell = pEnt->m_pNextInCell = NULL;
+	pEnt->m_iGridCell = -1;
+}
+
+
+static int EntityGridCandidateCompare( const EntityGridCandidate_t *pLeft, const EntityGridCandidate_t *pRight )
+{
+	if ( pLeft->m_nSerial == pRight->m_nSerial )
+		return 0;
+
+	return ( pLeft->m_nSerial < pRight->m_nSerial ) ? -1 : 1;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Gathers the entities of the cells (and the oversized ones) in list order
+//-----------------------------------------------------------------------------
+static void GatherEntityGridCandidates( EntityGridQuery_t *pQuery )
+{
+	pQuery->m_Candidates.RemoveAll();
+
+	int nWidth = pQuery->m_iMaxX - pQuery->m_iMinX + 1;
+	int nCells = ( pQuery->m_iMaxX >= pQuery->m_iMinX && pQuery->m_iMaxY >= pQuery->m_iMinY ) ? nWidth * ( pQuery->m_iMaxY - pQuery->m_iMinY + 1 ) : 0;
+
+	// the last one is the list of the oversized entities
+	for ( int i = 0; i <= nCells; i++ )
+	{
+		int iCell = ENTITY_GRID_OVERSIZED;
+		if ( i < nCells )
+		{
+			iCell = ( pQuery->m_iMinX + i % nWidth ) + ( pQuery->m_iMinY + i / nWidth ) * ENTITY_GRID_SIZE;
+		}
+
+		for ( CBaseEntity *pEntity = g_EntityGrid[iCell]; pEntity; pEntity = pEntity->m_pNextInCell )
+		{
+			EntityGridCandidate_t &candidate = pQuery->m_Candidates[ pQuery->m_Candidates.AddToTail() ];
+			candidate.m_hEntity = pEntity;
+			candidate.m_nSerial = pEntity->GetEntityListSerial();
+		}
+	}
+
+	pQuery->m_Candidates.Sort( EntityGridCandidateCompare );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Returns the first entity after pStartEntity (in list order) that
+//			passes the test, looking only at the cells the box can touch.
+//			A new query (pStartEntity == NULL) gathers the candidates, the
+//			iteration continues from them so every entity is tested once.
+//-----------------------------------------------------------------------------
+CBaseEntity *CGlobalEntityList::FindEntityInGrid( CBaseEntity *pStartEntity, const Vector &vecMins, const Vector &vecMaxs, IEntityGridTest *pTest )
+{
+	UpdateEntityGrid();
+
+	// entities are stored by origin, grow the box by as far as they can reach
+	const float flHalfCell = ENTITY_GRID_CELL_SIZE * 0.5f;
+	int iMinX = EntityGridCoord( vecMins.x - flHalfCell );
+	int iMaxX = EntityGridCoord( vecMaxs.x + flHalfCell );
+	int iMinY = EntityGridCoord( vecMins.y - flHalfCell );
+	int iMaxY = EntityGridCoord( vecMaxs.y + flHalfCell );
+
+	EntityGridQuery_t *pQuery = NULL;
+	if ( pStartEntity )
+	{
+		for ( int i = 0; i < ENTITY_GRID_QUERY_CACHE; i++ )
+		{
+			EntityGridQuery_t &query = g_EntityGridQueries[i];
+			if ( query.m_nTick == gpGlobals->tickcount &&
+				query.m_iMinX == iMinX && query.m_iMaxX == iMaxX &&
+				query.m_iMinY == iMinY && query.m_iMaxY == iMaxY )
+			{
+				pQuery = &query;
+				break;
+			}
+		}
+	}
+
+	if ( !pQuery )
+	{
+		pQuery = &g_EntityGridQueries[0];
+		for ( int i = 1; i < ENTITY_GRID_QUERY_CACHE; i++ )
+		{
+			if ( g_EntityGridQueries[i].m_nLastUsed < pQuery->m_nLastUsed )
+			{
+				pQuery = &g_EntityGridQueries[i];
+			}
+		}
+
+		pQuery->m_iMinX = iMinX;
+		pQuery->m_iMaxX = iMaxX;
+		pQuery->m_iMinY = iMinY;
+		pQuery->m_iMaxY = iMaxY;
+		pQuery->m_nTick = gpGlobals->tickcount;
+		GatherEntityGridCandidates( pQuery );
+	}
+
+	pQuery->m_nLastUsed = ++g_nEntityGridQueryCount;
+
+	// the first candidate after pStartEntity
+	unsigned int serial = pStartEntity ? pStartEntity->GetEntityListSerial() : 0;
+	const CUtlVector< EntityGridCandidate_t > &candidates = pQuery->m_Candidates;
+
+	int iLow = 0;
+	int iHigh = candidates.Count();
+	while ( iLow < iHigh )
+	{
+		int iMid = ( iLow + iHigh ) / 2;
+		if ( candidates[iMid].m_nSerial <= serial )
+		{
+			iLow = iMid + 1;
+		}
+		else
+		{
+			iHigh = iMid;
+		}
+	}
+
+	for ( int i = iLow; i < candidates.Count(); i++ )
+	{
+		// removed while iterating
+		CBaseEntity *pEntity = candidates[i].m_hEntity;
+		if ( !pEntity )
 			continue;
 
-		return ent;
+		if ( pTest->TestEntity( pEntity ) )
+			return pEntity;
 	}
 
-	// nothing found
-	return NULL; 
+	return NULL;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Used to iterate all the entities within a sphere.
+// Input  : pStartEntity - 
+//			vecCenter - 
+//			flRadius - 
+//-----------------------------------------------------------------------------
+CBaseEntity *CGlobalEntityList::FindEntityInSphere( CBaseEntity *pStartEntity, const Vector &vecCenter, float flRadius )
+{
+	CEntityGridSphereTest test( vecCenter, flRadius );
+	Vector vecRadius( flRadius, flRadius, flRadius );
+	return FindEntityInGrid( pStartEntity, vecCenter - vecRadius, vecCenter + vecRadius, &test );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Used to iterate all the entities within a box.
+// Input  : pStartEntity - 
+//			vecMins - 
+//			vecMaxs - 
+//-----------------------------------------------------------------------------
+CBaseEntity *CGlobalEntityList::FindEntityInBox( CBaseEntity *pStartEntity, const Vector &vecMins, const Vector &vecMaxs )
+{
+	CEntityGridBoxTest test( vecMins, vecMaxs );
+	return FindEntityInGrid( pStartEntity, vecMins, vecMaxs, &test );
 }
 
 
@@ -1120,21 +1598,10 @@ CBaseEntity *CGlobalEntityList::FindEntityByClassnameWithin( CBaseEntity *pStart
 		return gEntList.FindEntityByClassname( pEntity, szName );
 	}
 
-	while ((pEntity = gEntList.FindEntityByClassname( pEntity, szName )) != NULL)
-	{
-		if ( !pEntity->edict() && !pEntity->IsEFlagSet( EFL_SERVER_ONLY ) )
-			continue;
-
-		// Instead of checking absorigin vs sphere, check if the obb intersects the sphere.
-		Vector vecRelativeCenter;
-		pEntity->CollisionProp()->WorldToCollisionSpace( vecSrc, &vecRelativeCenter );
-		if ( IsBoxIntersectingSphere( pEntity->CollisionProp()->OBBMins(),	pEntity->CollisionProp()->OBBMaxs(), vecRelativeCenter, flRadius ) )
-		{
-			return pEntity;
-		}
-	}
-
-	return NULL;
+	// Instead of checking absorigin vs sphere, check if the obb intersects the sphere.
+	CEntityGridSphereTest test( vecSrc, flRadius, szName );
+	Vector vecRadius( flRadius, flRadius, flRadius );
+	return FindEntityInGrid( pStartEntity, vecSrc - vecRadius, vecSrc + vecRadius, &test );
 }
 
 
@@ -1148,26 +1615,9 @@ CBaseEntity *CGlobalEntityList::FindEntityByClassnameWithin( CBaseEntity *pStart
 //-----------------------------------------------------------------------------
 CBaseEntity *CGlobalEntityList::FindEntityByClassnameWithin( CBaseEntity *pStartEntity, const char *szName, const Vector &vecMins, const Vector &vecMaxs )
 {
-	//
-	// Check for matching class names within the search radius.
-	//
-	CBaseEntity *pEntity = pStartEntity;
-
-	while ((pEntity = gEntList.FindEntityByClassname( pEntity, szName )) != NULL)
-	{
-		if ( !pEntity->edict() && !pEntity->IsEFlagSet( EFL_SERVER_ONLY ) )
-			continue;
-
-		// check if the aabb intersects the search aabb.
-		Vector entMins, entMaxs;
-		pEntity->CollisionProp()->WorldSpaceAABB( &entMins, &entMaxs );
-		if ( IsBoxIntersectingBox( vecMins, vecMaxs, entMins, entMaxs ) )
-		{
-			return pEntity;
-		}
-	}
-
-	return NULL;
+	// check if the aabb intersects the search aabb.
+	CEntityGridBoxTest test( vecMins, vecMaxs, szName );
+	return FindEntityInGrid( pStartEntity, vecMins, vecMaxs, &test );
 }
 
 
@@ -1361,6 +1811,14 @@ void CGlobalEntityList::OnAddEntity( IHandleEntity *pEnt, CBaseHandle handle )
 	
 	// NOTE: Must be a CBaseEntity on server
 	Assert( pBaseEnt );
+
+	// new entries always go to the tail of the list
+	pBaseEnt->m_iListSerial = m_iNextListSerial++;
+	UpdateEntityName( pBaseEnt );
+
+	// it could have been marked before it had a handle
+	pBaseEnt->m_bGridDirty = false;
+	MarkEntityGridDirty( pBaseEnt );
 	//DevMsg(2,"Created %s\n", pBaseEnt->GetClassname() );
 	for ( i = m_entityListeners.Count()-1; i >= 0; i-- )
 	{
@@ -1391,6 +1849,12 @@ void CGlobalEntityList::OnRemoveEntity( IHandleEntity *pEnt, CBaseHandle handle
 	if ( pBaseEnt->edict() )
 		m_iNumEdicts--;
 
+	// should be gone already (NotifyRemoveEntity), unless it was deleted directly
+	RemoveEntityName( pBaseEnt );
+
+	// the spatial queries find it until it is gone from the list, like the list walk did
+	RemoveFromEntityGrid( pBaseEnt );
+
 	m_iNumEnts--;
 }
 
@@ -1451,6 +1915,8 @@ void CGlobalEntityList::NotifyRemoveEntity( CBaseEntity *pBaseEnt )
 		m_entityListeners[i]->OnEntityDeleted( pBaseEnt );
 	}
 
+	RemoveEntityName( pBaseEnt );
+
 	if ( pBaseEnt->m_ListByClass != g_EntsByClassname.InvalidHandle() )
 	{
 		EntsByStringList_t *pEntry = &g_EntsByClassname[pBaseEnt->m_ListByClass];
@@ -1935,3 +2401,59 @@ CON_COMMAND(report_simthinklist, "Lists all simulating/thinking entities")
 	list.ReportEntityList();
 }
 
+
+//-----------------------------------------------------------------------------
+// Purpose: Checks the grid spatial queries against a walk of the whole list
+//-----------------------------------------------------------------------------
+static bool VerifyEntityGridQuery( const Vector &vecCenter, float flRadius, bool bBox )
+{
+	Vector vecRadius( flRadius, flRadius, flRadius );
+	CEntityGridSphereTest sphere( vecCenter, flRadius );
+	CEntityGridBoxTest box( vecCenter - vecRadius, vecCenter + vecRadius );
+	IEntityGridTest *pTest = bBox ? (IEntityGridTest *)&box : (IEntityGridTest *)&sphere;
+
+	CUtlVector< CBaseEntity * > walk;
+	for ( CBaseEntity *pEntity = gEntList.FirstEnt(); pEntity; pEntity = gEntList.NextEnt( pEntity ) )
+	{
+		if ( pTest->TestEntity( pEntity ) )
+			walk.AddToTail( pEntity );
+	}
+
+	CUtlVector< CBaseEntity * > grid;
+	CBaseEntity *pEntity = NULL;
+	while ( ( pEntity = bBox ? gEntList.FindEntityInBox( pEntity, box.m_vecMins, box.m_vecMaxs ) : gEntList.FindEntityInSphere( pEntity, vecCenter, flRadius ) ) != NULL )
+	{
+		grid.AddToTail( pEntity );
+	}
+
+	if ( walk.Count() == grid.Count() && !V_memcmp( walk.Base(), grid.Base(), walk.Count() * sizeof( CBaseEntity * ) ) )
+		return true;
+
+	Warning( "%s of %.0f at (%.0f %.0f %.0f): the list walk found %d entities, the grid %d\n", bBox ? "Box" : "Sphere", flRadius,
+		vecCenter.x, vecCenter.y, vecCenter.z, walk.Count(), grid.Count() );
+	return false;
+}
+
+
+CON_COMMAND_F( ent_grid_verify, "Compares the spatial queries of the entity list with a walk of the whole list, around every entity. Arguments: [radius]", FCVAR_CHEAT )
+{
+	float flRadius = ( args.ArgC() > 1 ) ? atof( args[1] ) : 256.0f;
+
+	int nQueries = 0;
+	int nErrors = 0;
+	for ( CBaseEntity *pCenter = gEntList.FirstEnt(); pCenter; pCenter = gEntList.NextEnt( pCenter ) )
+	{
+		if ( !pCenter->edict() )
+			continue;
+
+		for ( int i = 0; i < 2; i++ )
+		{
+			++nQueries;
+			if ( !VerifyEntityGridQuery( pCenter->WorldSpaceCenter(), flRadius, ( i == 1 ) ) )
+				++nErrors;
+		}
+	}
+
+	Msg( "%d queries, %d with different results.\n", nQueries, nErrors );
+}
+
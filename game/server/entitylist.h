@@ -16,6 +16,7 @@
 #include "baseentity.h"
 
 class IEntityListener;
+class IEntityGridTest;
 
 abstract_class CBaseEntityClassList
 {
@@ -115,6 +116,12 @@ public:
 	void NotifyCreateEntity( CBaseEntity *pEnt );
 	void NotifySpawn( CBaseEntity *pEnt );
 	void NotifyRemoveEntity( CBaseEntity *pEnt );
+
+	// the targetname of the entity changed, update the name index
+	void UpdateEntityName( CBaseEntity *pEnt );
+	// the entity moved or changed its bounds, the grid will place it again before the next query
+	void MarkEntityGridDirty( CBaseEntity *pEnt );
+
 	// iteration functions
 
 	// returns the next entity after pCurrentEnt;  if pCurrentEnt is NULL, return the first entity
@@ -143,6 +150,7 @@ public:
 		return FindEntityByName( pStartEntity, STRING(iszName), pSearchingEntity, pActivator, pCaller, pFilter );
 	}
 	CBaseEntity *FindEntityInSphere( CBaseEntity *pStartEntity, const Vector &vecCenter, float flRadius );
+	CBaseEntity *FindEntityInBox( CBaseEntity *pStartEntity, const Vector &vecMins, const Vector &vecMaxs );
 	CBaseEntity *FindEntityByTarget( CBaseEntity *pStartEntity, const char *szName );
 	CBaseEntity *FindEntityByModel( CBaseEntity *pStartEntity, const char *szModelName );
 	CBaseEntity	*FindEntityByOutputTarget( CBaseEntity *pStartEntity, string_t iTarget );
@@ -177,6 +185,15 @@ protected:
 	virtual void OnAddEntity( IHandleEntity *pEnt, CBaseHandle handle );
 	virtual void OnRemoveEntity( IHandleEntity *pEnt, CBaseHandle handle );
 
+private:
+	void RemoveEntityName( CBaseEntity *pEnt );
+	CBaseEntity *FindEntityByNameIndexed( CBaseEntity *pStartEntity, const char *szName, IEntityFindFilter *pFilter );
+
+	void UpdateEntityGrid();
+	void RemoveFromEntityGrid( CBaseEntity *pEnt );
+	CBaseEntity *FindEntityInGrid( CBaseEntity *pStartEntity, const Vector &vecMins, const Vector &vecMaxs, IEntityGridTest *pTest );
+
+	unsigned int m_iNextListSerial;
 };
 
 extern CGlobalEntityList gEntList;
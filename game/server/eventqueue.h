@@ -15,6 +15,8 @@
 #endif
 
 #include "mempool.h"
+#include "utlpriorityqueue.h"
+#include "utlmap.h"
 
 struct EventQueuePrioritizedEvent_t
 {
@@ -28,8 +30,7 @@ struct EventQueuePrioritizedEvent_t
 
 	variant_t m_VariantValue;	// variable-type parameter
 
-	EventQueuePrioritizedEvent_t *m_pNext;
-	EventQueuePrioritizedEvent_t *m_pPrev;
+	unsigned int m_iSerial;		// insertion order, keeps events with the same fire time FIFO
 
 	DECLARE_SIMPLE_DATADESC();
 
@@ -66,14 +67,27 @@ public:
 
 	void Dump( void );
 
+	// drops the cached targets for this name, called when an entity takes the name
+	void InvalidateTarget( string_t iszName );
+
 private:
 
 	void AddEvent( EventQueuePrioritizedEvent_t *event );
 	void RemoveEvent( EventQueuePrioritizedEvent_t *pe );
+	void GetSortedEvents( CUtlVector< EventQueuePrioritizedEvent_t * > &events );
+
+	string_t GetTargetKey( const char *pszName, bool bAllocate );
+	const CCopyableUtlVector< EHANDLE > *GetTargets( string_t iszName );
+
+	static bool EventLessFunc( EventQueuePrioritizedEvent_t * const &lhs, EventQueuePrioritizedEvent_t * const &rhs );
 
 	DECLARE_SIMPLE_DATADESC();
-	EventQueuePrioritizedEvent_t m_Events;
+	CUtlPriorityQueue< EventQueuePrioritizedEvent_t * > m_Events;
+	unsigned int m_iNextSerial;
 	int m_iListCount;
+
+	// name targets already resolved, keyed by the lowercase pooled name
+	CUtlMap< string_t, CCopyableUtlVector< EHANDLE > > m_TargetCache;
 };
 
 extern CEventQueue g_EventQueue;
@@ -49,6 +49,68 @@ int g_ClimbHeights[] =
 
 #define CLIMB_ACTIVITY( height ) ACT_TERROR_CLIMB_##height##_FROM_STAND
 
+//================================================================================
+// Cach de las alturas que se pueden escalar desde una posicin contra el mundo.
+// El mundo no cambia: el primer NPC que choca con una pared llena la entrada
+// (una traza por altura) y los dems solo confirman la altura elegida
+// contra las entidades.
+//================================================================================
+
+#define CLIMB_LEDGE_GRID 8.0f
+#define CLIMB_LEDGE_YAWS 32
+#define CLIMB_LEDGE_MAX 16384
+
+// La entrada ya se recalcul una vez, no lo volvemos a hacer
+#define CLIMB_LEDGE_RETRACED (1u << 31)
+
+class CClimbLedgeCache : public CAutoGameSystem
+{
+public:
+	CClimbLedgeCache() : CAutoGameSystem("ClimbLedgeCache")
+	{
+		m_Ledges.SetLessFunc( DefLessFunc(uint64) );
+	}
+
+	virtual void LevelInitPreEntity() { m_Ledges.Purge(); }
+	virtual void LevelShutdownPostEntity() { m_Ledges.Purge(); }
+
+	// Posicin (en celdas de 8 unidades), direccin y tamao del NPC
+	static uint64 GetKey( const Vector &vecOrigin, float flYaw, int hull )
+	{
+		uint64 x = (int)floorf( vecOrigin.x / CLIMB_LEDGE_GRID ) & 0xFFF;
+		uint64 y = (int)floorf( vecOrigin.y / CLIMB_LEDGE_GRID ) & 0xFFF;
+		uint64 z = (int)floorf( vecOrigin.z / CLIMB_LEDGE_GRID ) & 0xFFF;
+		uint64 yaw = (int)( AngleNormalizePositive( flYaw ) * CLIMB_LEDGE_YAWS / 360.0f + 0.5f ) & (CLIMB_LEDGE_YAWS - 1);
+
+		return x | (y << 12) | (z << 24) | (yaw << 36) | ((uint64)hull << 41);
+	}
+
+	bool Lookup( uint64 key, unsigned int *clear ) const
+	{
+		unsigned short index = m_Ledges.Find( key );
+
+		if ( index == m_Ledges.InvalidIndex() )
+			return false;
+
+		*clear = m_Ledges[index];
+		return true;
+	}
+
+	void Store( uint64 key, unsigned int clear )
+	{
+		// Los NPC no deberan visitar tantos lugares, pero por si acaso
+		if ( m_Ledges.Count() >= CLIMB_LEDGE_MAX )
+			m_Ledges.RemoveAll();
+
+		m_Ledges.InsertOrReplace( key, clear );
+	}
+
+protected:
+	CUtlMap<uint64, unsigned int> m_Ledges;
+};
+
+static CClimbLedgeCache g_ClimbLedgeCache;
+
 //================================================================================
 // Animaciones
 //================================================================================
@@ -212,42 +274,19 @@ void CAI_ClimbBehavior::Update()
                 NDebugOverlay::Box( hitting_trace.m_pEnt->GetAbsOrigin(), hitting_trace.m_pEnt->WorldAlignMins(), hitting_trace.m_pEnt->WorldAlignMaxs(), 255, 0, 0, 1.0f, 4.0f );
         }
 
-		// Verificamos de que altura es la pared
-		for ( int i = 0; i < ARRAYSIZE(g_ClimbHeights); ++i )
-		{
-			// Probamos con esta altura
-			int height	= g_ClimbHeights[i];
-			int check	= height + 3;
+		// Las alturas despejadas contra el mundo salen de la cach, si es
+		// otra cosa (o algo estorba la altura elegida) lo hacemos con trazas
+		bool fallback = !hitting_trace.DidHitWorld();
+		int height = -1;
 
-			//Vector vecSrc = GetAbsOrigin() + Vector( 0, 0, check );
-			//NDebugOverlay::Text( vecSrc, UTIL_VarArgs("%i (%i)", height, check), false, 0.5f );
+		if ( !fallback )
+			height = SelectCachedClimbHeight( &fallback );
 
-            trace_t check_tr;
-
-			// La pared es ms grande que esta altura (o algo esta bloqueandolo)
-            if ( IsHittingWall(180.0f, check, &check_tr) )
-            {
-                // Es un objeto que se mueve, terminamos todo.
-                if ( Utils::IsMoveableObject( check_tr.m_pEnt ) )
-                {
-                    if ( ai_climb_behavior_debug.GetBool() )
-                        NDebugOverlay::Text( GetOuter()->EyePosition(), UTIL_VarArgs( "Utils::IsMoveableObject!!!!!" ), false, 3.0f );
-
-                    break;
-                }
-
-
-                continue;
-            }
-
-			// Obtenemos la animacin que corresponde para escalar esta pared
-			Activity iActivity = GetClimbActivity( height );
-
-			// Algunas animaciones son especiales para diferentes tipos
-			// de NPC
-			if ( GetOuter()->SelectWeightedSequence(iActivity) == ACTIVITY_NOT_AVAILABLE )
-				continue;
+		if ( fallback )
+			height = SelectClimbHeight();
 
+		if ( height != -1 )
+		{
 			// Obtenemos un trace cuya posicin termine en una parte de la pared
 			// La usaremos para poder obtener los angulos donde debemos mirar para empezar a escalar
 			trace_t tr;
@@ -282,6 +321,162 @@ void CAI_ClimbBehavior::Update()
 	m_flClimbYaw = -1.0f;
 }
 
+//================================================================================
+// Devuelve la primera altura que podemos escalar, con una traza por altura.
+// -1 si no hay ninguna o si un objeto que se mueve lo bloquea.
+//================================================================================
+int CAI_ClimbBehavior::SelectClimbHeight()
+{
+	// Verificamos de que altura es la pared
+	for ( int i = 0; i < ARRAYSIZE(g_ClimbHeights); ++i )
+	{
+		// Probamos con esta altura
+		int height	= g_ClimbHeights[i];
+		int check	= height + 3;
+
+        trace_t check_tr;
+
+		// La pared es ms grande que esta altura (o algo esta bloqueandolo)
+        if ( IsHittingWall(180.0f, check, &check_tr) )
+        {
+            // Es un objeto que se mueve, terminamos todo.
+            if ( Utils::IsMoveableObject( check_tr.m_pEnt ) )
+            {
+                if ( ai_climb_behavior_debug.GetBool() )
+                    NDebugOverlay::Text( GetOuter()->EyePosition(), UTIL_VarArgs( "Utils::IsMoveableObject!!!!!" ), false, 3.0f );
+
+                return -1;
+            }
+
+            continue;
+        }
+
+		// Algunas animaciones son especiales para diferentes tipos
+		// de NPC
+		if ( GetOuter()->SelectWeightedSequence( GetClimbActivity(height) ) == ACTIVITY_NOT_AVAILABLE )
+			continue;
+
+		return height;
+	}
+
+	return -1;
+}
+
+//================================================================================
+// Igual que SelectClimbHeight pero con las alturas despejadas de la cach,
+// solo la altura elegida se confirma con una traza contra todo.
+// La clave es aproximada, si la entrada no coincide con lo que hay desde
+// nuestra posicin se vuelve a calcular (solo una vez por entrada), despues
+// de eso confiamos en ella aunque diga que todo esta bloqueado.
+// [fallback] indica que hay que usar SelectClimbHeight
+//================================================================================
+int CAI_ClimbBehavior::SelectCachedClimbHeight( bool *fallback )
+{
+	*fallback = false;
+
+	bool traced = false;
+	unsigned int clear = GetWorldClearHeights( false, &traced );
+
+	for ( int attempt = 0; attempt < 2; ++attempt )
+	{
+		bool stale = false;
+
+		for ( int i = 0; i < ARRAYSIZE(g_ClimbHeights); ++i )
+		{
+			if ( !(clear & (1 << i)) )
+				continue;
+
+			int height = g_ClimbHeights[i];
+
+			if ( GetOuter()->SelectWeightedSequence( GetClimbActivity(height) ) == ACTIVITY_NOT_AVAILABLE )
+				continue;
+
+			// Confirmamos contra las entidades
+			trace_t check_tr;
+
+			if ( IsHittingWall(180.0f, height + 3, &check_tr) )
+			{
+				// Es un objeto que se mueve, terminamos todo.
+				if ( Utils::IsMoveableObject( check_tr.m_pEnt ) )
+				{
+					if ( ai_climb_behavior_debug.GetBool() )
+						NDebugOverlay::Text( GetOuter()->EyePosition(), UTIL_VarArgs( "Utils::IsMoveableObject!!!!!" ), false, 3.0f );
+
+					return -1;
+				}
+
+				// Algo que no es el mundo estorba
+				if ( !check_tr.DidHitWorld() )
+				{
+					*fallback = true;
+					return -1;
+				}
+
+				// La cach dice que el mundo esta despejado pero no es as
+				stale = true;
+				break;
+			}
+
+			return height;
+		}
+
+		// Las alturas ya se calcularon desde nuestra posicin
+		if ( traced )
+		{
+			*fallback = stale;
+			return -1;
+		}
+
+		// Ninguna altura de la cach nos sirve, puede que la entrada sea de una
+		// posicin cercana y no de la nuestra: la recalculamos
+		clear = GetWorldClearHeights( true, &traced );
+
+		// La entrada ya se haba recalculado antes, confiamos en ella
+		if ( !traced )
+		{
+			*fallback = stale;
+			return -1;
+		}
+	}
+
+	return -1;
+}
+
+//================================================================================
+// Devuelve las alturas (bits de g_ClimbHeights) que no estan bloqueadas
+// por el mundo desde nuestra posicin y direccin.
+// [refresh] vuelve a calcular la entrada si no se ha hecho antes
+// [traced] indica si se hicieron las trazas en lugar de usar la cach
+//================================================================================
+unsigned int CAI_ClimbBehavior::GetWorldClearHeights( bool refresh, bool *traced )
+{
+	uint64 key = CClimbLedgeCache::GetKey( GetAbsOrigin(), GetOuter()->GetAbsAngles().y, GetOuter()->GetHullType() );
+	unsigned int clear = 0;
+
+	if ( g_ClimbLedgeCache.Lookup( key, &clear ) )
+	{
+		if ( !refresh || (clear & CLIMB_LEDGE_RETRACED) )
+			return (clear & ~CLIMB_LEDGE_RETRACED);
+
+		clear = 0;
+	}
+
+	for ( int i = 0; i < ARRAYSIZE(g_ClimbHeights); ++i )
+	{
+		trace_t tr;
+
+		if ( !IsHittingWorld( 180.0f, g_ClimbHeights[i] + 3, &tr ) )
+			clear |= (1 << i);
+	}
+
+	g_ClimbLedgeCache.Store( key, (refresh) ? (clear | CLIMB_LEDGE_RETRACED) : clear );
+
+	if ( traced )
+		*traced = true;
+
+	return clear;
+}
+
 //================================================================================
 // Devuelve si podemos escalar una pared
 //================================================================================
@@ -312,6 +507,22 @@ bool CAI_ClimbBehavior::IsHittingWall( float flDistance, int height, trace_t *tr
 	return ( !tr->startsolid && tr->fraction < 1.0f );
 }
 
+//================================================================================
+// Igual que IsHittingWall pero solo contra el mundo
+//================================================================================
+bool CAI_ClimbBehavior::IsHittingWorld( float flDistance, int height, trace_t *tr )
+{
+	Vector vecForward, vecSrc, vecEnd;
+	GetOuter()->GetVectors( &vecForward, NULL, NULL );
+
+	vecSrc = GetAbsOrigin() + Vector( 0, 0, height );
+	vecEnd = vecSrc + flDistance * vecForward;
+
+	CTraceFilterWorldOnly filter;
+	UTIL_TraceHull( vecSrc, vecEnd, GetOuter()->GetHullMins(), GetOuter()->GetHullMaxs(), MASK_NPCSOLID, &filter, tr );
+	return ( !tr->startsolid && tr->fraction < 1.0f );
+}
+
 //================================================================================
 //================================================================================
 void CAI_ClimbBehavior::GetTraceWall( int height, trace_t *tr ) 
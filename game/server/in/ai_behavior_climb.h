@@ -44,7 +44,12 @@ public:
 	virtual void Update();
 	virtual bool ShouldClimb();
 
+	virtual int SelectClimbHeight();
+	virtual int SelectCachedClimbHeight( bool *fallback );
+	virtual unsigned int GetWorldClearHeights( bool refresh = false, bool *traced = NULL );
+
 	virtual bool IsHittingWall( float flDistance, int iHeight, trace_t *tr );
+	virtual bool IsHittingWorld( float flDistance, int iHeight, trace_t *tr );
 	virtual void GetTraceWall( int height, trace_t *tr );
 	
 	// Escalamos!
@@ -74,6 +74,7 @@ DECLARE_DEBUG_CMD(bot_debug_data_memory, "0", "")
 
 DECLARE_DEBUG_CMD(bot_optimize, "0", "");
 DECLARE_SERVER_CMD(bot_far_distance, "2500", "")
+DECLARE_SERVER_CMD(bot_desire_max_age, "0.3", "Max time in seconds that the desire of a schedule is kept without computing it again")
 
 //================================================================================
 // Macros
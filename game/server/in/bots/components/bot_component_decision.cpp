@@ -91,6 +91,14 @@ void CBotDecision::PerformSensing()
 	VPROF_BUDGET("CBotDecision::PerformSensing", VPROF_BUDGETGROUP_BOTS_EXPENSIVE);
 
 	if (ShouldOnlyFeelPlayers()) {
+		CSquad *pSquad = GetBot()->GetSquad();
+
+		// Our squad splits the work between its members
+		if (pSquad && pSquad->ShouldSharePerception()) {
+			pSquad->PerformSensing(GetHost());
+			return;
+		}
+
 		// We can only verify if we are seeing the players.
 		// Light load for the engine
 		for (int i = 1; i <= gpGlobals->maxClients; ++i) {
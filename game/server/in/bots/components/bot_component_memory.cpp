@@ -148,6 +148,21 @@ void CBotMemory::UpdateIdealThreat()
 		}
 	}
 
+	// Our squad has assigned us a target to spread the fire,
+	// unless we have an enemy very close.
+	CSquad *pSquad = GetBot()->GetSquad();
+
+	if (pSquad && pSquad->ShouldSharePerception()) {
+		CBaseEntity *pAssigned = pSquad->GetAssignedTarget(GetHost());
+		CEntityMemory *memory = (pAssigned) ? GetEntityMemory(pAssigned) : NULL;
+
+		if (memory && !memory->IsLost() && memory->IsEnemy()) {
+			if (!pIdeal || pIdeal->GetDistance() > 200.0f) {
+				pIdeal = memory;
+			}
+		}
+	}
+
 	m_pIdealThreat = pIdeal;
 }
 
@@ -37,12 +37,18 @@ static int g_ScheduleID = 0;
 #define ADD_TASK( task, value ) m_Tasks.AddToTail( new BotTaskInfo_t(task, value) )
 #define ADD_INTERRUPT( condition ) m_Interrupts.AddToTail( condition )
 
+// What the level of desire depends on, it is only computed again when one of them changes
+#define ADD_DESIRE_CONDITION( condition ) m_DesireConditions.AddToTail( condition )
+#define ADD_DESIRE_MEMORY( name ) m_DesireMemory.AddToTail( AllocPooledString(name) )
+#define ADD_DESIRE_SQUAD() m_bDesireSquad = true
+
 #define DECLARE_SCHEDULE( id ) virtual int GetID() const { return id; } \
     virtual void Install_Tasks(); \
     virtual void Install_Interruptions();
 
 #define SET_SCHEDULE_TASKS( classname ) void classname::Install_Tasks()
 #define SET_SCHEDULE_INTERRUPTS( classname ) void classname::Install_Interruptions()
+#define SET_SCHEDULE_DESIRE_INPUTS( classname ) void classname::Install_DesireInputs()
 
 //================================================================================
 // Base Schedule
@@ -59,6 +65,10 @@ public:
 
 		m_flComputedDesire = BOT_DESIRE_NONE;
 		m_iComputedDesireFrame = -1;
+
+		m_flLastDesire = BOT_DESIRE_NONE;
+		m_bDesireInputsInstalled = false;
+		m_bDesireSquad = false;
 	}
 
 	// Yep, its a schedule
@@ -77,6 +87,10 @@ public:
 	virtual void Install_Interruptions() = 0;
 	virtual float GetDesire() const = 0;
 
+	// Conditions, memory and squad that GetDesire() depends on.
+	// If nothing is declared the desire is computed every 3 ticks.
+	virtual void Install_DesireInputs() { }
+
 public:
 	virtual bool HasFinished() const
 	{
@@ -143,6 +157,11 @@ public:
 	virtual float GetInternalDesire();
 	virtual void ComputeDesire();
 
+	virtual bool HasDesireInputs() const;
+	virtual bool HasDesireInputsChanged() const;
+	virtual void SaveDesireInputs();
+	virtual void InvalidateDesire();
+
 	virtual void Update();
 
 	virtual void Wait(float seconds);
@@ -170,6 +189,27 @@ protected:
 	float m_flComputedDesire;
 	int m_iComputedDesireFrame;
 
+	// Inputs of the desire when it was last computed
+	float m_flLastDesire;
+	bool m_bDesireInputsInstalled;
+	bool m_bDesireSquad;
+
+	CUtlVector<BCOND> m_DesireConditions;
+	CUtlVector<string_t> m_DesireMemory;
+
+	int m_iDesireConditionBits;
+	CUtlVector<float> m_DesireMemoryTime;
+	BotState m_iDesireState;
+	int m_iDesireTacticalMode;
+
+	CSquad *m_pDesireSquad;
+	CPlayer *m_pDesireSquadLeader;
+	int m_iDesireSquadCount;
+	int m_iDesireSquadStrategie;
+	int m_iDesireSquadTacticalMode;
+
+	CountdownTimer m_DesireTimer;
+
 	CUtlVector<BotTaskInfo_t *> m_Tasks;
 	CUtlVector<BCOND> m_Interrupts;
 
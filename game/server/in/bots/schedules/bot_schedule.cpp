@@ -26,6 +26,8 @@
 #define Msg(...) Log_Msg(LOG_BOTS, __VA_ARGS__)
 #define Warning(...) Log_Warning(LOG_BOTS, __VA_ARGS__)
 
+extern ConVar bot_desire_max_age;
+
 //================================================================================
 //================================================================================
 void IBotSchedule::Reset()
@@ -76,6 +78,7 @@ void IBotSchedule::Finish()
 
 	m_flComputedDesire = BOT_DESIRE_NONE;
 	m_iComputedDesireFrame = -1;
+	InvalidateDesire();
 
 	if (ItsImportant() && !HasFailed()) {
 		Assert(m_Tasks.Count() == 0);
@@ -101,6 +104,7 @@ void IBotSchedule::Fail(const char *pWhy)
 {
 	m_bFailed = true;
 	m_FailTimer.Start();
+	InvalidateDesire();
 
 	if (m_iScheduleOnFail != SCHEDULE_NONE) {
 		GetMemory()->UpdateDataMemory("NextSchedule", m_iScheduleOnFail);
@@ -162,12 +166,129 @@ bool IBotSchedule::ShouldCalculateDesire()
 {
 	Assert(id() > 0);
 
+	// We know what the desire depends on, only when something changes
+	if (HasDesireInputs())
+		return HasDesireInputsChanged();
+
 	if ((gpGlobals->tickcount % 3) == (id() % 3))
 		return true;
 
 	return false;
 }
 
+//================================================================================
+// Returns if the Schedule has declared what its desire depends on
+//================================================================================
+bool IBotSchedule::HasDesireInputs() const
+{
+	return (m_DesireConditions.Count() > 0 || m_DesireMemory.Count() > 0 || m_bDesireSquad);
+}
+
+//================================================================================
+// Returns if any of the inputs of the desire has changed since it was computed,
+// the desire also depends on things we can not track (decision, timers, distances)
+// so it is computed again after [bot_desire_max_age] seconds.
+//================================================================================
+bool IBotSchedule::HasDesireInputsChanged() const
+{
+	if (!m_DesireTimer.HasStarted() || m_DesireTimer.IsElapsed())
+		return true;
+
+	if (GetBot()->GetState() != m_iDesireState)
+		return true;
+
+	if (GetBot()->GetTacticalMode() != m_iDesireTacticalMode)
+		return true;
+
+	int conditions = 0;
+
+	FOR_EACH_VEC(m_DesireConditions, it)
+	{
+		if (HasCondition(m_DesireConditions[it]))
+			conditions |= (1 << it);
+	}
+
+	if (conditions != m_iDesireConditionBits)
+		return true;
+
+	FOR_EACH_VEC(m_DesireMemory, it)
+	{
+		CDataMemory *memory = (GetMemory()) ? GetMemory()->GetDataMemory(STRING(m_DesireMemory[it])) : NULL;
+		float updated = (memory) ? memory->GetTimeLastUpdate() : -1.0f;
+
+		if (updated != m_DesireMemoryTime[it])
+			return true;
+	}
+
+	if (m_bDesireSquad) {
+		CSquad *pSquad = GetBot()->GetSquad();
+
+		if (pSquad != m_pDesireSquad)
+			return true;
+
+		if (pSquad) {
+			if (pSquad->GetLeader() != m_pDesireSquadLeader || pSquad->GetCount() != m_iDesireSquadCount)
+				return true;
+
+			if (pSquad->GetStrategie() != m_iDesireSquadStrategie || pSquad->GetTacticalMode() != m_iDesireSquadTacticalMode)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+//================================================================================
+// Saves the current inputs of the desire, before computing it
+//================================================================================
+void IBotSchedule::SaveDesireInputs()
+{
+	m_DesireTimer.Start(bot_desire_max_age.GetFloat());
+
+	m_iDesireState = GetBot()->GetState();
+	m_iDesireTacticalMode = GetBot()->GetTacticalMode();
+
+	Assert(m_DesireConditions.Count() <= 32);
+	m_iDesireConditionBits = 0;
+
+	FOR_EACH_VEC(m_DesireConditions, it)
+	{
+		if (HasCondition(m_DesireConditions[it]))
+			m_iDesireConditionBits |= (1 << it);
+	}
+
+	m_DesireMemoryTime.SetCount(m_DesireMemory.Count());
+
+	FOR_EACH_VEC(m_DesireMemory, it)
+	{
+		CDataMemory *memory = (GetMemory()) ? GetMemory()->GetDataMemory(STRING(m_DesireMemory[it])) : NULL;
+		m_DesireMemoryTime[it] = (memory) ? memory->GetTimeLastUpdate() : -1.0f;
+	}
+
+	if (m_bDesireSquad) {
+		m_pDesireSquad = GetBot()->GetSquad();
+		m_pDesireSquadLeader = NULL;
+		m_iDesireSquadCount = 0;
+		m_iDesireSquadStrategie = 0;
+		m_iDesireSquadTacticalMode = 0;
+
+		if (m_pDesireSquad) {
+			m_pDesireSquadLeader = m_pDesireSquad->GetLeader();
+			m_iDesireSquadCount = m_pDesireSquad->GetCount();
+			m_iDesireSquadStrategie = m_pDesireSquad->GetStrategie();
+			m_iDesireSquadTacticalMode = m_pDesireSquad->GetTacticalMode();
+		}
+	}
+}
+
+//================================================================================
+// Forces the desire to be computed again in the next tick
+//================================================================================
+void IBotSchedule::InvalidateDesire()
+{
+	m_DesireTimer.Invalidate();
+}
+
 //================================================================================
 // Returns the desire level in the current tick
 // Do not call this function directly, it can be very expensive.
@@ -195,7 +316,7 @@ float IBotSchedule::GetInternalDesire()
 			return BOT_DESIRE_NONE;
 
 		if (!ShouldCalculateDesire())
-			return BOT_DESIRE_NONE;
+			return (HasDesireInputs()) ? m_flLastDesire : BOT_DESIRE_NONE;
 
 		// TODO: Slow!
 		/*if ( GetMemory() ) {
@@ -215,7 +336,12 @@ float IBotSchedule::GetInternalDesire()
 	// Note: this function can be very expensive!
 	{
 		VPROF_BUDGET("GetDesire", VPROF_BUDGETGROUP_BOTS);
-		return GetDesire();
+
+		if (HasDesireInputs())
+			SaveDesireInputs();
+
+		m_flLastDesire = GetDesire();
+		return m_flLastDesire;
 	}
 }
 
@@ -234,6 +360,11 @@ void IBotSchedule::ComputeDesire()
 		return;
 	}
 
+	if (!m_bDesireInputsInstalled) {
+		Install_DesireInputs();
+		m_bDesireInputsInstalled = true;
+	}
+
 	m_flComputedDesire = GetInternalDesire();
 	m_iComputedDesireFrame = gpGlobals->tickcount;
 }
@@ -48,6 +48,12 @@ SET_SCHEDULE_INTERRUPTS(CChangeWeaponSchedule)
 	ADD_INTERRUPT(BCOND_HEAR_MOVE_AWAY);
 }
 
+SET_SCHEDULE_DESIRE_INPUTS(CChangeWeaponSchedule)
+{
+	ADD_DESIRE_CONDITION(BCOND_BETTER_WEAPON_AVAILABLE);
+	ADD_DESIRE_MEMORY("BestWeapon");
+}
+
 //================================================================================
 //================================================================================
 float CChangeWeaponSchedule::GetDesire() const
@@ -40,6 +40,13 @@ SET_SCHEDULE_INTERRUPTS(CCoverSchedule)
 	ADD_INTERRUPT(BCOND_GOAL_UNREACHABLE);
 }
 
+SET_SCHEDULE_DESIRE_INPUTS(CCoverSchedule)
+{
+	ADD_DESIRE_CONDITION(BCOND_LIGHT_DAMAGE);
+	ADD_DESIRE_CONDITION(BCOND_REPEATED_DAMAGE);
+	ADD_DESIRE_CONDITION(BCOND_HEAVY_DAMAGE);
+}
+
 //================================================================================
 //================================================================================
 float CCoverSchedule::GetDesire() const
@@ -92,6 +99,11 @@ SET_SCHEDULE_INTERRUPTS(CHideSchedule)
 	ADD_INTERRUPT(BCOND_GOAL_UNREACHABLE);
 }
 
+SET_SCHEDULE_DESIRE_INPUTS(CHideSchedule)
+{
+	ADD_DESIRE_CONDITION(BCOND_HELPLESS);
+}
+
 //================================================================================
 //================================================================================
 float CHideSchedule::GetDesire() const
@@ -48,6 +48,12 @@ SET_SCHEDULE_INTERRUPTS(CDefendSpawnSchedule)
 	ADD_INTERRUPT(BCOND_SEE_DEJECTED_FRIEND);
 }
 
+SET_SCHEDULE_DESIRE_INPUTS(CDefendSpawnSchedule)
+{
+	ADD_DESIRE_MEMORY("SpawnPosition");
+	ADD_DESIRE_SQUAD();
+}
+
 //================================================================================
 //================================================================================
 float CDefendSpawnSchedule::GetDesire() const
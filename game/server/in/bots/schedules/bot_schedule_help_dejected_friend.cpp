@@ -74,6 +74,12 @@ bool CHelpDejectedFriendSchedule::ShouldHelp()
 	return true;
 }
 
+SET_SCHEDULE_DESIRE_INPUTS(CHelpDejectedFriendSchedule)
+{
+	ADD_DESIRE_CONDITION(BCOND_SEE_DEJECTED_FRIEND);
+	ADD_DESIRE_MEMORY("DejectedFriend");
+}
+
 //================================================================================
 //================================================================================
 float CHelpDejectedFriendSchedule::GetDesire() const
@@ -38,6 +38,11 @@ SET_SCHEDULE_INTERRUPTS(CHideAndHealSchedule)
 	ADD_INTERRUPT(BCOND_GOAL_UNREACHABLE);
 }
 
+SET_SCHEDULE_DESIRE_INPUTS(CHideAndHealSchedule)
+{
+	ADD_DESIRE_CONDITION(BCOND_LOW_HEALTH);
+}
+
 //================================================================================
 //================================================================================
 float CHideAndHealSchedule::GetDesire() const
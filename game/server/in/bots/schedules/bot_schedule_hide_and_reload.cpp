@@ -43,6 +43,11 @@ SET_SCHEDULE_INTERRUPTS(CHideAndReloadSchedule)
 	ADD_INTERRUPT(BCOND_HEAR_MOVE_AWAY);
 }
 
+SET_SCHEDULE_DESIRE_INPUTS(CHideAndReloadSchedule)
+{
+	ADD_DESIRE_CONDITION(BCOND_EMPTY_CLIP1_AMMO);
+}
+
 //================================================================================
 //================================================================================
 float CHideAndReloadSchedule::GetDesire() const
@@ -61,6 +61,18 @@ SET_SCHEDULE_INTERRUPTS(CHuntEnemySchedule)
 	ADD_INTERRUPT(BCOND_HEAR_MOVE_AWAY);
 }
 
+SET_SCHEDULE_DESIRE_INPUTS(CHuntEnemySchedule)
+{
+	ADD_DESIRE_CONDITION(BCOND_WITHOUT_ENEMY);
+	ADD_DESIRE_CONDITION(BCOND_NEW_ENEMY);
+	ADD_DESIRE_CONDITION(BCOND_ENEMY_LOST);
+	ADD_DESIRE_CONDITION(BCOND_ENEMY_OCCLUDED);
+	ADD_DESIRE_CONDITION(BCOND_ENEMY_LAST_POSITION_VISIBLE);
+	ADD_DESIRE_CONDITION(BCOND_ENEMY_TOO_NEAR);
+	ADD_DESIRE_CONDITION(BCOND_ENEMY_NEAR);
+	ADD_DESIRE_CONDITION(BCOND_TOO_FAR_TO_ATTACK);
+}
+
 //================================================================================
 //================================================================================
 float CHuntEnemySchedule::GetDesire() const
@@ -32,6 +32,15 @@ SET_SCHEDULE_INTERRUPTS(CMoveAsideSchedule)
 	ADD_INTERRUPT(BCOND_GOAL_UNREACHABLE);
 }
 
+SET_SCHEDULE_DESIRE_INPUTS(CMoveAsideSchedule)
+{
+	ADD_DESIRE_CONDITION(BCOND_WITHOUT_ENEMY);
+	ADD_DESIRE_CONDITION(BCOND_ENEMY_LOST);
+	ADD_DESIRE_CONDITION(BCOND_HEAR_COMBAT);
+	ADD_DESIRE_CONDITION(BCOND_LIGHT_DAMAGE);
+	ADD_DESIRE_CONDITION(BCOND_REPEATED_DAMAGE);
+}
+
 //================================================================================
 //================================================================================
 float CMoveAsideSchedule::GetDesire() const
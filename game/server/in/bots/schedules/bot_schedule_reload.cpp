@@ -29,6 +29,12 @@ SET_SCHEDULE_INTERRUPTS(CReloadSchedule)
 	ADD_INTERRUPT(BCOND_EMPTY_PRIMARY_AMMO);
 }
 
+SET_SCHEDULE_DESIRE_INPUTS(CReloadSchedule)
+{
+	ADD_DESIRE_CONDITION(BCOND_EMPTY_CLIP1_AMMO);
+	ADD_DESIRE_CONDITION(BCOND_LOW_CLIP1_AMMO);
+}
+
 //================================================================================
 //================================================================================
 float CReloadSchedule::GetDesire() const
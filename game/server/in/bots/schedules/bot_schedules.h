@@ -62,6 +62,7 @@ public:
 
 public:
 	virtual float GetDesire() const;
+	virtual void Install_DesireInputs();
 };
 
 //================================================================================
@@ -84,6 +85,7 @@ public:
 
 public:
 	virtual float GetDesire() const;
+	virtual void Install_DesireInputs();
 };
 
 //================================================================================
@@ -101,6 +103,7 @@ public:
 
 public:
 	virtual float GetDesire() const;
+	virtual void Install_DesireInputs();
 };
 
 //================================================================================
@@ -118,6 +121,7 @@ public:
 
 public:
 	virtual float GetDesire() const;
+	virtual void Install_DesireInputs();
 };
 
 //================================================================================
@@ -145,6 +149,7 @@ public:
 
 public:
 	virtual float GetDesire() const;
+	virtual void Install_DesireInputs();
 
 	virtual void TaskStart();
 	virtual void TaskRun();
@@ -165,6 +170,7 @@ public:
 
 public:
 	virtual float GetDesire() const;
+	virtual void Install_DesireInputs();
 };
 
 //================================================================================
@@ -182,6 +188,7 @@ public:
 
 public:
 	virtual float GetDesire() const;
+	virtual void Install_DesireInputs();
 	virtual void TaskRun();
 };
 
@@ -213,6 +220,7 @@ public:
 	virtual bool ShouldHelp();
 
 	virtual float GetDesire() const;
+	virtual void Install_DesireInputs();
 	virtual void TaskRun();
 };
 #endif
@@ -237,6 +245,7 @@ public:
 
 public:
 	virtual float GetDesire() const;
+	virtual void Install_DesireInputs();
 	virtual void Start();
 
 
@@ -288,6 +297,7 @@ public:
 
 public:
 	virtual float GetDesire() const;
+	virtual void Install_DesireInputs();
 };
 
 #endif // BOT_SCHEDULES_H
\ No newline at end of file
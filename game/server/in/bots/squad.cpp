@@ -24,6 +24,9 @@
 //================================================================================
 
 DECLARE_SERVER_CMD(sv_squad_replace_leader, "1", "");
+DECLARE_SERVER_CMD(sv_squad_shared_perception, "1", "Los miembros del escuadron reparten el trabajo de percepcin y comparten una lista de contactos");
+DECLARE_SERVER_CMD(sv_squad_contact_memory, "3", "Segundos que el escuadron recuerda un contacto que ya nadie ve");
+DECLARE_SERVER_CMD(sv_squad_perception_period, "4", "Ticks mximos para que cada miembro vuelva a revisar a un jugador, sin importar el tamao del escuadron");
 
 //================================================================================
 // Constructor
@@ -40,6 +43,7 @@ CSquad::CSquad()
 	SetLeader(NULL);
 
 	m_nController = NULL;
+	m_iPerceptionTick = -1;
 
 	// Nos agregamos a la lista
 	TheSquads->AddSquad(this);
@@ -480,3 +484,270 @@ void CSquad::ReportEnemy(CPlayer *member, CBaseEntity *pEnemy)
 		}
 	}
 }
+
+//================================================================================
+// Devuelve si el escuadron debe encargarse de la percepcin de sus miembros
+//================================================================================
+bool CSquad::ShouldSharePerception()
+{
+	if (!sv_squad_shared_perception.GetBool())
+		return false;
+
+	return (GetCount() > 1);
+}
+
+//================================================================================
+// Devuelve si el miembro puede revisar la visin por el escuadron
+//================================================================================
+bool CSquad::IsSensor(CPlayer *pMember)
+{
+	if (!pMember || !pMember->IsAlive())
+		return false;
+
+	IBot *pBot = pMember->GetBotController();
+
+	if (!pBot || !pBot->GetDecision())
+		return false;
+
+	// Solo los Bots que unicamente sienten a los jugadores,
+	// los dems usan CAI_Senses
+	return pBot->GetDecision()->ShouldOnlyFeelPlayers();
+}
+
+//================================================================================
+// Construye la lista de contactos del escuadron, una vez por tick.
+// Cada miembro revisa la visin hacia su objetivo asignado y el resto de
+// jugadores se reparte entre los miembros (rotando cada tick), asi cada
+// jugador se verifica unas pocas veces en lugar de una vez por miembro.
+// Con escuadrones grandes cada jugador se revisa por varios miembros en el mismo
+// tick para que la rotacin nunca tarde ms de sv_squad_perception_period ticks.
+//================================================================================
+void CSquad::UpdatePerception()
+{
+	VPROF_BUDGET("CSquad::UpdatePerception", VPROF_BUDGETGROUP_BOTS_EXPENSIVE);
+
+	if (m_iPerceptionTick == gpGlobals->tickcount)
+		return;
+
+	m_iPerceptionTick = gpGlobals->tickcount;
+
+	// Olvidamos los contactos que ya no existen o que nadie ha visto recientemente
+	for (int it = m_Contacts.Count() - 1; it >= 0; --it) {
+		SquadContact_t &contact = m_Contacts[it];
+		CBaseEntity *pEntity = contact.entity.Get();
+
+		if (!pEntity || !pEntity->IsAlive() || (gpGlobals->curtime - contact.lastSeen) > sv_squad_contact_memory.GetFloat()) {
+			m_Contacts.FastRemove(it);
+		}
+	}
+
+	CUtlVector<CPlayer *> sensors;
+
+	FOR_EACH_MEMBER(
+		{
+			if (IsSensor(pMember))
+				sensors.AddToTail(pMember);
+		});
+
+	if (sensors.Count() == 0)
+		return;
+
+	CUtlVector<CBaseEntity *> checked;
+
+	// Cada miembro sigue verificando a su objetivo
+	FOR_EACH_VEC(m_Assignments, it)
+	{
+		CPlayer *pMember = ToInPlayer(m_Assignments[it].member.Get());
+		CBaseEntity *pTarget = m_Assignments[it].target.Get();
+
+		if (!pTarget || !pTarget->IsAlive() || !sensors.HasElement(pMember))
+			continue;
+
+		if (pMember->GetBotController()->GetDecision()->IsAbleToSee(pTarget)) {
+			Spot(pMember, pTarget);
+			checked.AddToTail(pTarget);
+		}
+	}
+
+	// Repartimos el resto de jugadores entre los miembros
+	int period = MAX(1, sv_squad_perception_period.GetInt());
+	int passes = (sensors.Count() + period - 1) / period;
+	int slice = gpGlobals->tickcount * passes;
+
+	for (int i = 1; i <= gpGlobals->maxClients; ++i) {
+		CPlayer *pPlayer = ToInPlayer(i);
+
+		if (!pPlayer || !pPlayer->IsAlive())
+			continue;
+
+		if (checked.HasElement(pPlayer))
+			continue;
+
+		int first = slice;
+		slice += passes;
+
+		// Si el jugador es uno de los miembros usamos al siguiente en su lugar
+		for (int pass = 0, checks = 0; pass < sensors.Count() && checks < passes; ++pass) {
+			CPlayer *pSensor = sensors[(first + pass) % sensors.Count()];
+
+			if (pPlayer == pSensor)
+				continue;
+
+			++checks;
+
+			if (!pSensor->GetBotController()->GetDecision()->IsAbleToSee(pPlayer))
+				continue;
+
+			Spot(pSensor, pPlayer);
+			break;
+		}
+	}
+
+	AssignTargets();
+}
+
+//================================================================================
+// Un miembro ha visto a la entidad
+//================================================================================
+void CSquad::Spot(CPlayer *pMember, CBaseEntity *pEntity)
+{
+	SquadContact_t *pContact = GetContact(pEntity);
+
+	if (!pContact) {
+		int index = m_Contacts.AddToTail();
+		pContact = &m_Contacts[index];
+		pContact->entity = pEntity;
+		pContact->assigned = 0;
+	}
+
+	pContact->spotter = pMember;
+	pContact->position = pEntity->WorldSpaceCenter();
+	pContact->enemy = pMember->GetBotController()->GetDecision()->IsEnemy(pEntity);
+	pContact->spottedTick = gpGlobals->tickcount;
+	pContact->lastSeen = gpGlobals->curtime;
+}
+
+//================================================================================
+// Entrega al miembro lo que ha visto por el escuadron, los contactos que
+// vio otro miembro se confirman con su propia lnea de visin
+//================================================================================
+void CSquad::PerformSensing(CPlayer *pMember)
+{
+	UpdatePerception();
+
+	IBot *pBot = pMember->GetBotController();
+
+	if (!pBot)
+		return;
+
+	int period = MAX(1, sv_squad_perception_period.GetInt());
+
+	FOR_EACH_VEC(m_Contacts, it)
+	{
+		SquadContact_t &contact = m_Contacts[it];
+		CBaseEntity *pEntity = contact.entity.Get();
+
+		if (!pEntity || pEntity == pMember)
+			continue;
+
+		if (contact.spotter.Get() == pMember) {
+			// Los Bots piensan cada 2 ticks
+			if (contact.spottedTick < gpGlobals->tickcount - 1)
+				continue;
+		}
+		else {
+			// Alguien mas lo ha visto durante la rotacin, solo revisamos
+			// los contactos activos y no a todos los jugadores
+			if (contact.spottedTick < gpGlobals->tickcount - period)
+				continue;
+
+			if (!pBot->GetDecision() || !pBot->GetDecision()->IsAbleToSee(pEntity))
+				continue;
+		}
+
+		// Lo hemos visto con nuestros propios ojos, 
+		// el resto del escuadron se entera con ReportEnemy
+		pBot->OnLooked(pEntity);
+	}
+}
+
+//================================================================================
+// Asigna un objetivo a cada miembro para repartir el fuego:
+// cada enemigo que ya tiene tiradores se vuelve menos atractivo
+//================================================================================
+void CSquad::AssignTargets()
+{
+	VPROF_BUDGET("CSquad::AssignTargets", VPROF_BUDGETGROUP_BOTS);
+
+	m_Assignments.RemoveAll();
+
+	FOR_EACH_VEC(m_Contacts, it)
+	{
+		m_Contacts[it].assigned = 0;
+	}
+
+	FOR_EACH_MEMBER(
+		{
+			if (!IsSensor(pMember))
+				continue;
+
+			SquadContact_t *pBest = NULL;
+			float bestScore = FLT_MAX;
+
+			FOR_EACH_VEC(m_Contacts, i)
+			{
+				SquadContact_t &contact = m_Contacts[i];
+
+				if (!contact.enemy || !contact.entity.Get())
+					continue;
+
+				float distance = pMember->GetAbsOrigin().DistTo(contact.position);
+				float score = distance * (1.0f + contact.assigned);
+
+				// Muy cerca, todos pueden dispararle
+				if (distance <= 200.0f)
+					score = distance;
+
+				if (score < bestScore) {
+					bestScore = score;
+					pBest = &contact;
+				}
+			}
+
+			if (!pBest)
+				continue;
+
+			++pBest->assigned;
+
+			int index = m_Assignments.AddToTail();
+			m_Assignments[index].member = pMember;
+			m_Assignments[index].target = pBest->entity;
+		});
+}
+
+//================================================================================
+//================================================================================
+SquadContact_t *CSquad::GetContact(CBaseEntity *pEntity)
+{
+	FOR_EACH_VEC(m_Contacts, it)
+	{
+		if (m_Contacts[it].entity.Get() == pEntity)
+			return &m_Contacts[it];
+	}
+
+	return NULL;
+}
+
+//================================================================================
+// Devuelve el objetivo que el escuadron le ha asignado al miembro
+//================================================================================
+CBaseEntity *CSquad::GetAssignedTarget(CPlayer *pMember)
+{
+	FOR_EACH_VEC(m_Assignments, it)
+	{
+		if (m_Assignments[it].member.Get() == pMember)
+			return m_Assignments[it].target.Get();
+	}
+
+	return NULL;
+}
@@ -23,6 +23,29 @@ struct SquadOptions_t
 
 };
 
+//================================================================================
+// Entidad detectada por el escuadron (percepcin compartida)
+//================================================================================
+struct SquadContact_t
+{
+	EHANDLE entity;
+	EHANDLE spotter;
+	Vector position;
+	bool enemy;
+	int spottedTick;
+	float lastSeen;
+	int assigned;
+};
+
+//================================================================================
+// Objetivo asignado a un miembro del escuadron
+//================================================================================
+struct SquadAssignment_t
+{
+	EHANDLE member;
+	EHANDLE target;
+};
+
 //================================================================================
 // Define un escuadron, el enlace para comunicarse entre miembros
 //================================================================================
@@ -110,6 +133,23 @@ public:
 public:
 	virtual bool IsSquadEnemy(CBaseEntity *pEntity, CPlayer *pIgnore = NULL);
 
+public:
+	virtual bool ShouldSharePerception();
+	virtual bool IsSensor(CPlayer *pMember);
+
+	virtual void UpdatePerception();
+	virtual void PerformSensing(CPlayer *pMember);
+	virtual void AssignTargets();
+
+	virtual int GetContactCount() {
+		return m_Contacts.Count();
+	}
+	virtual SquadContact_t *GetContact(CBaseEntity *pEntity);
+	virtual CBaseEntity *GetAssignedTarget(CPlayer *pMember);
+
+protected:
+	virtual void Spot(CPlayer *pMember, CBaseEntity *pEntity);
+
 public:
 	virtual void ReportTakeDamage(CPlayer *pMember, const CTakeDamageInfo &info);
 	virtual void ReportDeath(CPlayer *pMember, const CTakeDamageInfo &info);
@@ -130,6 +170,11 @@ protected:
 	int m_iSkill;
 	bool m_bFollowLeader;
 
+	// Percepcin compartida
+	CUtlVector<SquadContact_t> m_Contacts;
+	CUtlVector<SquadAssignment_t> m_Assignments;
+	int m_iPerceptionTick;
+
 };
 
 #endif // SQUAD_H
\ No newline at end of file
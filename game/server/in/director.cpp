@@ -87,44 +87,46 @@ DEFINE_SCRIPTFUNC_NAMED(ScriptSetPhase, "SetPhase", "")
 
 DEFINE_SCRIPTFUNC_NAMED(ScriptGetAngry, "GetAngry", "")
 DEFINE_SCRIPTFUNC_NAMED(ScriptSetAngry, "SetAngry", "")
+
+DEFINE_SCRIPTFUNC_NAMED(ResolveScriptHooks, "RefreshHooks", "Vuelve a buscar las funciones del Director despues de definirlas o cambiarlas.")
 END_SCRIPTDESC();
 
 #undef VSCRIPT_CALL
 #undef VSCRIPT_RESULT
 
-#define VSCRIPT_CALL( methodname ) ScriptVariant_t _retVal; CallScriptFunction( #methodname, &_retVal )
+#define VSCRIPT_CALL( hook ) ScriptVariant_t _retVal; CallScriptFunction( hook, &_retVal )
 #define VSCRIPT_RESULT( type, value ) _retVal.Get<type>() == value
 
-#define HANDLED_BY_VSCRIPT( methodname ) ScriptVariant_t _retVal; \
-	if ( CallScriptFunction(#methodname, &_retVal) ) { \
+#define HANDLED_BY_VSCRIPT( hook ) ScriptVariant_t _retVal; \
+	if ( CallScriptFunction(hook, &_retVal) ) { \
 		if ( VSCRIPT_RESULT(bool, true) ) \
 			return; \
 	}
 
-#define IF_NOT_HANDLED_BY_VSCRIPT(methodname) ScriptVariant_t _retVal; \
-	if ( CallScriptFunction(#methodname, &_retVal) && VSCRIPT_RESULT(bool, true) ) {\
+#define IF_NOT_HANDLED_BY_VSCRIPT(hook) ScriptVariant_t _retVal; \
+	if ( CallScriptFunction(hook, &_retVal) && VSCRIPT_RESULT(bool, true) ) {\
 		return; \
     } else \
 
-#define HANDLED_BY_VSCRIPT_VALUE( type, methodname, condition, value ) ScriptVariant_t _retVal; \
-	if ( CallScriptFunction(#methodname, &_retVal) ) { \
+#define HANDLED_BY_VSCRIPT_VALUE( type, hook, condition, value ) ScriptVariant_t _retVal; \
+	if ( CallScriptFunction(hook, &_retVal) ) { \
 		if ( !_retVal.IsNull() && _retVal.Get<type>() condition value ) \
 			return _retVal.Get<type>(); \
 	}
 
-#define HANDLED_BY_VSCRIPT_VALUE_ARG1( type, methodname, arg1type, arg1value, condition, value ) ScriptVariant_t _retVal; \
-	if ( CallScriptFunction<arg1type>(#methodname, &_retVal, arg1value) ) { \
+#define HANDLED_BY_VSCRIPT_VALUE_ARG1( type, hook, arg1type, arg1value, condition, value ) ScriptVariant_t _retVal; \
+	if ( CallScriptFunction<arg1type>(hook, &_retVal, arg1value) ) { \
 		if ( !_retVal.IsNull() && _retVal.Get<type>() condition value ) \
 			return _retVal.Get<type>(); \
 	}
 
-#define HANDLED_BY_VSCRIPT_RETURN( type, methodname ) ScriptVariant_t _retVal; \
-	if ( CallScriptFunction(#methodname, &_retVal) ) { \
+#define HANDLED_BY_VSCRIPT_RETURN( type, hook ) ScriptVariant_t _retVal; \
+	if ( CallScriptFunction(hook, &_retVal) ) { \
 		return _retVal.Get<type>(); \
 	}
 
-#define HANDLED_BY_VSCRIPT_RETURN_ARG1( type, methodname, arg1type, arg1value ) ScriptVariant_t _retVal; \
-	if ( CallScriptFunction<arg1type>(#methodname, &_retVal, arg1value) ) { \
+#define HANDLED_BY_VSCRIPT_RETURN_ARG1( type, hook, arg1type, arg1value ) ScriptVariant_t _retVal; \
+	if ( CallScriptFunction<arg1type>(hook, &_retVal, arg1value) ) { \
 		return _retVal.Get<type>(); \
 	}
 
@@ -132,7 +134,11 @@ END_SCRIPTDESC();
 //================================================================================
 Director::Director() : CAutoGameSystemPerFrame("Director")
 {
+    COMPILE_TIME_ASSERT(ARRAYSIZE(g_DirectorScriptHooks) == LAST_SCRIPT_HOOK);
+    COMPILE_TIME_ASSERT(ARRAYSIZE(g_DirectorMusicCues) == LAST_MUSIC_CUE);
 
+    memset(m_ScriptHooks, 0, sizeof(m_ScriptHooks));
+    m_iStateChanges = 0;
 }
 
 //================================================================================
@@ -173,6 +179,9 @@ void Director::LevelInitPostEntity()
 //================================================================================
 void Director::LevelShutdownPreEntity()
 {
+    // La maquina virtual se destruye con el mapa
+    ReleaseScriptHooks();
+
     if ( !TheGameRules )
         return;
 
@@ -207,6 +216,7 @@ void Director::FrameUpdatePostEntityThink()
 void Director::SetPopulation(const char *type)
 {
     TheDirectorManager->SetPopulation(type);
+    m_iStateChanges |= STATE_CHANGED_POPULATION;
 }
 
 //================================================================================
@@ -215,7 +225,7 @@ void Director::SetPopulation(const char *type)
 void Director::Resume()
 {
     m_bDisabled = false;
-    VSCRIPT_CALL(Resume);
+    VSCRIPT_CALL(SCRIPT_HOOK_RESUME);
 }
 
 //================================================================================
@@ -247,6 +257,9 @@ void Director::StartVirtualMachine()
     CScriptKeyValues *pConfig = new CScriptKeyValues(config);
     g_pScriptVM->RegisterInstance(pConfig, "DirectorConfig");
 
+    // Estado de los jugadores, solo lectura
+    ThePlayersSystem->RegisterScriptInstance();
+
     //if ( m_ScriptScope.IsInitialized() )
     //return;
 
@@ -267,25 +280,109 @@ void Director::StartVirtualMachine()
 
     VScriptRunScript("director_base.nut", m_ScriptScope, true);
     VScriptRunScript(UTIL_VarArgs("director/%s.nut", gpGlobals->mapname), m_ScriptScope);
+
+    ResolveScriptHooks();
 }
 
 //================================================================================
+// Busca una sola vez las funciones que los scripts han definido.
+// Las que no existen se quedan en NULL y nunca se vuelven a buscar,
+// si el script las define ms tarde debe llamar a TheDirector.RefreshHooks()
 //================================================================================
-bool Director::CallScriptFunction(const char * pFunctionName, ScriptVariant_t *pFunctionReturn)
+void Director::ResolveScriptHooks()
 {
-    if ( !m_ScriptScope.IsInitialized() )
-        return false;
+    ReleaseScriptHooks();
 
-    HSCRIPT hFunc = m_ScriptScope.LookupFunction(pFunctionName);
+    if ( !g_pScriptVM || !m_ScriptScope.IsInitialized() )
+        return;
 
-    if ( hFunc ) {
-        m_ScriptScope.Call(hFunc, pFunctionReturn);
-        m_ScriptScope.ReleaseFunction(hFunc);
+    for ( int it = 0; it < LAST_SCRIPT_HOOK; ++it ) {
+        m_ScriptHooks[it].function = m_ScriptScope.LookupFunction(g_DirectorScriptHooks[it]);
+    }
+}
 
-        return true;
+//================================================================================
+//================================================================================
+void Director::ReleaseScriptHooks()
+{
+    for ( int it = 0; it < LAST_SCRIPT_HOOK; ++it ) {
+        DirectorScriptHook_t &info = m_ScriptHooks[it];
+
+        if ( info.function && g_pScriptVM ) {
+            g_pScriptVM->ReleaseFunction(info.function);
+        }
+
+        memset(&info, 0, sizeof(info));
     }
+}
 
-    return false;
+//================================================================================
+// Guarda el tiempo que tomaron los scripts en este Think y empieza de nuevo
+//================================================================================
+void Director::SnapshotScriptHooks()
+{
+    for ( int it = 0; it < LAST_SCRIPT_HOOK; ++it ) {
+        DirectorScriptHook_t &info = m_ScriptHooks[it];
+
+        info.lastTime = info.time;
+        info.lastCalls = info.calls;
+
+        info.time = 0.0f;
+        info.calls = 0;
+    }
+}
+
+//================================================================================
+// Entrega a los scripts todos los cambios de estado del Think en una sola llamada:
+// OnStateChanged( { status = 1, phase = 2, angry = 1, population = "default" } )
+// Solo se incluyen los valores que han cambiado.
+//================================================================================
+void Director::DispatchStateChanges()
+{
+    int changes = m_iStateChanges;
+    m_iStateChanges = 0;
+
+    if ( changes == 0 || !m_ScriptHooks[SCRIPT_HOOK_ON_STATE_CHANGED].function )
+        return;
+
+    ScriptVariant_t table;
+    g_pScriptVM->CreateTable(table);
+
+    if ( (changes & STATE_CHANGED_STATUS) )
+        g_pScriptVM->SetValue(table, "status", (int)m_iStatus);
+
+    if ( (changes & STATE_CHANGED_PHASE) )
+        g_pScriptVM->SetValue(table, "phase", (int)m_iPhase);
+
+    if ( (changes & STATE_CHANGED_ANGRY) )
+        g_pScriptVM->SetValue(table, "angry", (int)m_iAngry);
+
+    if ( (changes & STATE_CHANGED_POPULATION) )
+        g_pScriptVM->SetValue(table, "population", TheDirectorManager->m_nPopulation);
+
+    ScriptVariant_t _retVal;
+    CallScriptFunction<HSCRIPT>(SCRIPT_HOOK_ON_STATE_CHANGED, &_retVal, table);
+
+    g_pScriptVM->ReleaseValue(table);
+}
+
+//================================================================================
+//================================================================================
+bool Director::CallScriptFunction(DirectorScriptHook hook, ScriptVariant_t *pFunctionReturn)
+{
+    DirectorScriptHook_t &info = m_ScriptHooks[hook];
+
+    // El script no la tiene
+    if ( !info.function )
+        return false;
+
+    double start = Plat_FloatTime();
+    m_ScriptScope.Call(info.function, pFunctionReturn);
+
+    info.time += (float)(Plat_FloatTime() - start);
+    ++info.calls;
+
+    return true;
 }
 
 //================================================================================
@@ -334,7 +431,7 @@ void Director::StartMap()
     m_iPanicEventHordesLeft = 0;
 
     TheDirectorManager->ResetMap();
-    VSCRIPT_CALL(StartMap);
+    VSCRIPT_CALL(SCRIPT_HOOK_START_MAP);
 
     // TODO
     m_BackgroundMusicTimer.Start(RandomInt(10, 20));
@@ -390,6 +487,9 @@ void Director::Think()
     Update();
     PostUpdate();
 
+    DispatchStateChanges();
+    SnapshotScriptHooks();
+
     m_ThinkTimer.Start(0.3f);
 }
 
@@ -397,7 +497,7 @@ void Director::Think()
 //================================================================================
 void Director::PreUpdate()
 {
-    VSCRIPT_CALL(PreUpdate);
+    VSCRIPT_CALL(SCRIPT_HOOK_PRE_UPDATE);
 
     TheDirectorManager->Scan();
     TheGameRules->Director_PreUpdate();
@@ -408,13 +508,13 @@ void Director::PreUpdate()
 //================================================================================
 void Director::Update()
 {
-    VSCRIPT_CALL(Update);
+    VSCRIPT_CALL(SCRIPT_HOOK_UPDATE);
 
     UpdateAngry();
     UpdatePhase();
     UpdatePanicEvent();
 
-    m_MusicManager->Update();
+    UpdateMusic();
 
     TheDirectorManager->Spawn();
 
@@ -426,7 +526,7 @@ void Director::Update()
 //================================================================================
 void Director::PostUpdate()
 {
-    VSCRIPT_CALL(PostUpdate);
+    VSCRIPT_CALL(SCRIPT_HOOK_POST_UPDATE);
 
     // Attack!
     if ( IsOnPanicEvent() ) {
@@ -439,7 +539,7 @@ void Director::PostUpdate()
 //================================================================================
 void Director::UpdatePhase()
 {
-    HANDLED_BY_VSCRIPT(UpdatePhase);
+    HANDLED_BY_VSCRIPT(SCRIPT_HOOK_UPDATE_PHASE);
 
     DirectorPhase phase = GetPhase();
 
@@ -455,7 +555,7 @@ void Director::UpdatePhase()
 //================================================================================
 void Director::UpdateAngry()
 {
-    HANDLED_BY_VSCRIPT(UpdateAngry);
+    HANDLED_BY_VSCRIPT(SCRIPT_HOOK_UPDATE_ANGRY);
 
     // ANGRY_LOW = 1
     int angry = ANGRY_LOW;
@@ -488,7 +588,7 @@ void Director::UpdateAngry()
 //================================================================================
 void Director::UpdatePanicEvent()
 {
-    HANDLED_BY_VSCRIPT(UpdatePanicEvent);
+    HANDLED_BY_VSCRIPT(SCRIPT_HOOK_UPDATE_PANIC_EVENT);
 
     if ( !ShouldStartPanicEvent() )
         return;
@@ -502,7 +602,7 @@ void Director::UpdatePanicEvent()
 //================================================================================
 bool Director::ShouldPhaseEnd(DirectorPhase phase)
 {
-    HANDLED_BY_VSCRIPT_RETURN_ARG1(bool, ShouldPhaseEnd, int, phase);
+    HANDLED_BY_VSCRIPT_RETURN_ARG1(bool, SCRIPT_HOOK_SHOULD_PHASE_END, int, phase);
 
     switch ( phase ) {
         // Give players a break
@@ -634,7 +734,7 @@ void Director::OnPhaseEnd(DirectorPhase phase)
 //================================================================================
 float Director::GetPanicEventDelay()
 {
-    HANDLED_BY_VSCRIPT_VALUE(float, GetPanicEventDelay, >, 0.0f);
+    HANDLED_BY_VSCRIPT_VALUE(float, SCRIPT_HOOK_GET_PANIC_EVENT_DELAY, >, 0.0f);
 
     // De 5 a 7 minutos
     float delay = (60.0f * RandomFloat(5.0f, 7.0f));
@@ -657,7 +757,7 @@ float Director::GetPanicEventDelay()
 //================================================================================
 int Director::GetPanicEventHordes()
 {
-    HANDLED_BY_VSCRIPT_VALUE(int, GetPanicEventHordes, >, 0);
+    HANDLED_BY_VSCRIPT_VALUE(int, SCRIPT_HOOK_GET_PANIC_EVENT_HORDES, >, 0);
 
     // Nmero de hordas
     int hordes = 1;
@@ -679,7 +779,7 @@ int Director::GetPanicEventHordes()
 //================================================================================
 bool Director::ShouldStartPanicEvent()
 {
-    HANDLED_BY_VSCRIPT_RETURN(bool, ShouldStartPanicEvent);
+    HANDLED_BY_VSCRIPT_RETURN(bool, SCRIPT_HOOK_SHOULD_START_PANIC_EVENT);
 
     if ( !IsStatus(STATUS_NORMAL) )
         return false;
@@ -732,7 +832,7 @@ void Director::EndPanicHorde()
 //================================================================================
 void Director::OnPanicStart()
 {
-    VSCRIPT_CALL(OnPanicStart);
+    VSCRIPT_CALL(SCRIPT_HOOK_ON_PANIC_START);
 
     if ( director_debug.GetBool() )
         Msg("Un evento de panico ha comenzado.\n");
@@ -754,7 +854,7 @@ void Director::OnPanicHordeEnd(int hordeNumber, int hordesLeft)
 //================================================================================
 void Director::OnPanicEnd()
 {
-    HANDLED_BY_VSCRIPT(OnPanicEnd);
+    HANDLED_BY_VSCRIPT(SCRIPT_HOOK_ON_PANIC_END);
 
     // Estado normal
     SetStatus(STATUS_NORMAL);
@@ -891,8 +991,28 @@ void Director::DebugDisplay()
     DebugScreenText("Health: %i", ThePlayersSystem->GetHealth());
     DebugScreenText("Stress: %.2f", ThePlayersSystem->GetStress());
     DebugScreenText("Dejected: %i", ThePlayersSystem->GetDejected());
-    DebugScreenText("Weapon Stats: %s", g_StatsNames[ThePlayersSystem->m_WeaponsStats]);
-    DebugScreenText("Stats: %s", g_StatsNames[ThePlayersSystem->m_PlayerStats]);
+    DebugScreenText("Weapon Stats: %s", g_StatsNames[ThePlayersSystem->GetWeaponsStats()]);
+    DebugScreenText("Stats: %s", g_StatsNames[ThePlayersSystem->GetStats()]);
+
+    // Tiempo que tomaron los scripts en el ltimo Think
+    DebugScreenText("");
+    DebugScreenText("Scripts");
+    DebugScreenText("------------------------------------------");
+    DebugScreenText("");
+
+    float scriptTime = 0.0f;
+
+    for ( int it = 0; it < LAST_SCRIPT_HOOK; ++it ) {
+        const DirectorScriptHook_t &info = m_ScriptHooks[it];
+
+        if ( !info.function )
+            continue;
+
+        DebugScreenText("%s: %.3f ms (%i)", g_DirectorScriptHooks[it], info.lastTime * 1000.0f, info.lastCalls);
+        scriptTime += info.lastTime;
+    }
+
+    DebugScreenText("Total: %.3f ms", scriptTime * 1000.0f);
 
     // Informacin
     /*DebugScreenText( "" );
@@ -936,109 +1056,165 @@ void Director::CreateMusic()
 
     m_MusicManager = new CSoundManager();
     TheGameRules->Director_CreateMusic(m_MusicManager);
+
+    // Resolvemos la pista de cada sonido, as el deseo no depende del nombre
+    FOR_EACH_VEC( m_MusicManager->m_nSounds, it )
+    {
+        CSoundInstance *pSound = m_MusicManager->m_nSounds[it];
+        pSound->SetCue( GetMusicCue(pSound->GetSoundName()) );
+    }
+
+    // Solo volvemos a decidir la msica cuando algo cambia (UpdateMusic)
+    m_MusicManager->SetEventDriven( true );
+    memset( &m_MusicState, -1, sizeof(m_MusicState) );
 }
 
 //================================================================================
+// Revisa si algo que afecta el deseo de la msica ha cambiado
 //================================================================================
-float Director::SoundDesire(const char *soundname, int channel)
+void Director::UpdateMusic()
 {
-    if ( director_disable_music.GetBool() )
-        return 0.0f;
+    if ( !m_MusicManager )
+        return;
 
-    // CHANNEL_1
-    if ( FStrEq(soundname, "Music.Director.Boss") ) {
-        if ( GetStatus() == STATUS_BOSS )
-            return 1.0f;
+    DirectorMusicState_t state;
+    memset( &state, 0, sizeof(state) );
+
+    state.status = GetStatus();
+    state.angry = GetAngry();
+    state.hordesLeft = m_iPanicEventHordesLeft;
+    state.commons = clamp( TheDirectorManager->m_Minions[CHILD_TYPE_COMMON].alive, 0, 5 );
+    state.hordeCue = (m_HordeMusic) ? m_HordeMusic->GetCue() : SOUND_CUE_NONE;
+    state.tooClose = (TheDirectorManager->m_Minions[CHILD_TYPE_COMMON].tooClose > 6);
+    state.backgroundElapsed = m_BackgroundMusicTimer.IsElapsed();
+    state.choirElapsed = m_ChoirTimer.IsElapsed();
+    state.disabled = director_disable_music.GetBool();
+
+    if ( memcmp(&state, &m_MusicState, sizeof(state)) != 0 ) {
+        memcpy( &m_MusicState, &state, sizeof(state) );
+        m_MusicManager->Invalidate();
     }
 
-    if ( FStrEq(soundname, "Music.Director.BigBoss") ) {
-    }
+    m_MusicManager->Update();
+}
 
-    // CHANNEL_2
-    if ( FStrEq(soundname, "Music.Director.MiniFinale") ) {
+//================================================================================
+// Devuelve la pista de msica con el nombre especificado
+//================================================================================
+int Director::GetMusicCue(const char *soundname)
+{
+    for ( int cue = 0; cue < LAST_MUSIC_CUE; ++cue ) {
+        if ( FStrEq(soundname, g_DirectorMusicCues[cue]) )
+            return cue;
     }
 
-    if ( FStrEq(soundname, "Music.Director.Finale") ) {
-        if ( GetStatus() == STATUS_FINALE )
-            return 1.0f;
-    }
+    return SOUND_CUE_NONE;
+}
+
+//================================================================================
+//================================================================================
+float Director::MusicDesire(int cue, int channel)
+{
+    if ( director_disable_music.GetBool() )
+        return 0.0f;
 
-    // CHANNEL_3
-    if ( GetStatus() == STATUS_NORMAL && m_BackgroundMusicTimer.IsElapsed() ) {
-        if ( FStrEq(soundname, "Music.Director.Background.LowAngry") ) {
-            if ( GetAngry() == ANGRY_LOW ) {
+    switch ( cue ) {
+        // CHANNEL_1
+        case MUSIC_CUE_BOSS:
+            if ( GetStatus() == STATUS_BOSS )
                 return 1.0f;
-            }
-        }
+            break;
+
+        case MUSIC_CUE_BIG_BOSS:
+            break;
 
-        if ( FStrEq(soundname, "Music.Director.Background.MediumAngry") ) {
-            if ( GetAngry() == ANGRY_MEDIUM ) {
+        // CHANNEL_2
+        case MUSIC_CUE_MINI_FINALE:
+            break;
+
+        case MUSIC_CUE_FINALE:
+            if ( GetStatus() == STATUS_FINALE )
                 return 1.0f;
-            }
-        }
+            break;
 
-        if ( FStrEq(soundname, "Music.Director.Background.HighAngry") ) {
-            if ( GetAngry() == ANGRY_HIGH ) {
+        // CHANNEL_3
+        case MUSIC_CUE_BACKGROUND_LOW:
+        case MUSIC_CUE_BACKGROUND_MEDIUM:
+        case MUSIC_CUE_BACKGROUND_HIGH:
+        case MUSIC_CUE_BACKGROUND_CRAZY:
+        {
+            if ( GetStatus() != STATUS_NORMAL || !m_BackgroundMusicTimer.IsElapsed() )
+                break;
+
+            if ( cue == MUSIC_CUE_BACKGROUND_LOW && GetAngry() == ANGRY_LOW )
                 return 1.0f;
-            }
-        }
 
-        if ( FStrEq(soundname, "Music.Director.Background.CrazyAngry") ) {
-            if ( GetAngry() == ANGRY_CRAZY ) {
+            if ( cue == MUSIC_CUE_BACKGROUND_MEDIUM && GetAngry() == ANGRY_MEDIUM )
                 return 1.0f;
-            }
-        }
-    }
 
-    // CHANNEL_ANY
-    if ( FStrEq(soundname, "Music.Director.Horde") ) {
-        if ( GetStatus() == STATUS_PANIC )
-            return 2.0f;
-    }
-    if ( FStrEq(soundname, "Music.Director.HordeSlayer") ) {
-        if ( GetStatus() == STATUS_PANIC ) {
-            int childs = TheDirectorManager->m_Minions[CHILD_TYPE_COMMON].alive;
-            float volume = (0.2f * childs);
+            if ( cue == MUSIC_CUE_BACKGROUND_HIGH && GetAngry() == ANGRY_HIGH )
+                return 1.0f;
 
-            return clamp(volume, 0.1f, 1.0f);
-        }
-    }
-    if ( m_HordeMusic ) {
-        if ( FStrEq(soundname, m_HordeMusic->GetSoundName()) ) {
-            if ( GetStatus() == STATUS_PANIC ) {
-                if ( m_iPanicEventHordesLeft == INFINITE && TheDirectorManager->m_Minions[CHILD_TYPE_COMMON].alive < 3 )
-                    return 0.1f;
-                else
-                    return 2.0f;
-            }
+            if ( cue == MUSIC_CUE_BACKGROUND_CRAZY && GetAngry() == ANGRY_CRAZY )
+                return 1.0f;
+
+            break;
         }
-    }
 
-    if ( FStrEq(soundname, "Music.Director.MobRules") ) {
+        // CHANNEL_ANY
+        case MUSIC_CUE_HORDE:
+            if ( GetStatus() == STATUS_PANIC )
+                return 2.0f;
+            break;
 
-    }
+        case MUSIC_CUE_HORDE_SLAYER:
+        {
+            if ( GetStatus() == STATUS_PANIC ) {
+                int childs = TheDirectorManager->m_Minions[CHILD_TYPE_COMMON].alive;
+                float volume = (0.2f * childs);
 
-    if ( FStrEq(soundname, "Music.Director.FinalNail") ) {
+                return clamp(volume, 0.1f, 1.0f);
+            }
 
-    }
+            break;
+        }
 
-    if ( FStrEq(soundname, "Music.Director.Preparation") ) {
+        case MUSIC_CUE_MOB_RULES:
+        case MUSIC_CUE_FINAL_NAIL:
+        case MUSIC_CUE_PREPARATION:
+            break;
 
-    }
+        case MUSIC_CUE_GAMEOVER:
+            if ( GetStatus() == STATUS_GAMEOVER )
+                return 2.0f;
+            break;
 
-    if ( FStrEq(soundname, "Music.Director.Gameover") ) {
-        if ( GetStatus() == STATUS_GAMEOVER )
-            return 2.0f;
+        case MUSIC_CUE_CHOIR:
+            if ( GetStatus() == STATUS_NORMAL && m_ChoirTimer.IsElapsed() && TheDirectorManager->m_Minions[CHILD_TYPE_COMMON].tooClose > 6 )
+                return 2.0f;
+            break;
     }
 
-    if ( FStrEq(soundname, "Music.Director.InfectedChoir") ) {
-        if ( GetStatus() == STATUS_NORMAL && m_ChoirTimer.IsElapsed() && TheDirectorManager->m_Minions[CHILD_TYPE_COMMON].tooClose > 6 )
-            return 2.0f;
+    // Msica de la horda actual
+    if ( m_HordeMusic && m_HordeMusic->GetCue() == cue && cue != SOUND_CUE_NONE ) {
+        if ( GetStatus() == STATUS_PANIC ) {
+            if ( m_iPanicEventHordesLeft == INFINITE && TheDirectorManager->m_Minions[CHILD_TYPE_COMMON].alive < 3 )
+                return 0.1f;
+            else
+                return 2.0f;
+        }
     }
 
     return 0.0f;
 }
 
+//================================================================================
+//================================================================================
+float Director::SoundDesire(const char *soundname, int channel)
+{
+    return MusicDesire( GetMusicCue(soundname), channel );
+}
+
 //================================================================================
 //================================================================================
 void Director::OnSoundPlay(const char *soundname)
@@ -1064,7 +1240,7 @@ bool Director::CanSpawnMinions()
         return false;
     }
 
-    HANDLED_BY_VSCRIPT_RETURN(bool, CanSpawnMinions);
+    HANDLED_BY_VSCRIPT_RETURN(bool, SCRIPT_HOOK_CAN_SPAWN_MINIONS);
 
     if ( IsPhase(PHASE_RELAX) || IsPhase(PHASE_FADE) )
         return false;
@@ -1097,7 +1273,7 @@ bool Director::CanSpawnMinions(MinionType type)
     if ( alive >= max )
         return false;
 
-    HANDLED_BY_VSCRIPT_RETURN_ARG1(bool, CanSpawnMinionsByType, int, (int)type);
+    HANDLED_BY_VSCRIPT_RETURN_ARG1(bool, SCRIPT_HOOK_CAN_SPAWN_MINIONS_BY_TYPE, int, (int)type);
     return true;
 }
 
@@ -1161,7 +1337,7 @@ int Director::GetDifficulty()
 //================================================================================
 float Director::GetMaxDistance()
 {
-    HANDLED_BY_VSCRIPT_VALUE(float, GetMaxDistance, >, 300.0f);
+    HANDLED_BY_VSCRIPT_VALUE(float, SCRIPT_HOOK_GET_MAX_DISTANCE, >, 300.0f);
 
     float distance = director_max_distance.GetFloat();
 
@@ -1177,7 +1353,7 @@ float Director::GetMaxDistance()
 //================================================================================
 float Director::GetMinDistance()
 {
-    HANDLED_BY_VSCRIPT_VALUE(float, GetMinDistance, >, 0.0f);
+    HANDLED_BY_VSCRIPT_VALUE(float, SCRIPT_HOOK_GET_MIN_DISTANCE, >, 0.0f);
 
     float distance = director_min_distance.GetFloat();
     return MAX(distance, 0.0f);
@@ -1270,7 +1446,7 @@ float Director::GetStress()
 //================================================================================
 int Director::GetMaxUnits()
 {
-    HANDLED_BY_VSCRIPT_VALUE(int, GetMaxUnits, >= , 0);
+    HANDLED_BY_VSCRIPT_VALUE(int, SCRIPT_HOOK_GET_MAX_UNITS, >= , 0);
     return director_max_childs.GetInt();
 }
 
@@ -1278,7 +1454,7 @@ int Director::GetMaxUnits()
 //================================================================================
 int Director::GetMaxUnits(MinionType type)
 {
-    HANDLED_BY_VSCRIPT_VALUE_ARG1(int, GetMaxUnitsByType, int, (int)type, >= , 0);
+    HANDLED_BY_VSCRIPT_VALUE_ARG1(int, SCRIPT_HOOK_GET_MAX_UNITS_BY_TYPE, int, (int)type, >= , 0);
     return GetMaxUnits();
 }
 
@@ -1287,17 +1463,14 @@ int Director::GetMaxUnits(MinionType type)
 //================================================================================
 void Director::Disclose()
 {
-    CBaseEntity *pMinion = NULL;
-
-    do {
-        pMinion = gEntList.FindEntityByName(pMinion, "director_*");
+    for ( int it = TheDirectorManager->GetMinionCount() - 1; it >= 0; --it ) {
+        CBaseEntity *pMinion = TheDirectorManager->GetMinion(it);
 
         if ( !pMinion || !pMinion->IsAlive() )
             continue;
 
         TheDirectorManager->ReportEnemy(pMinion);
     }
-    while ( pMinion );
 }
 
 //================================================================================
@@ -1305,10 +1478,11 @@ void Director::Disclose()
 //================================================================================
 void Director::KillAll(bool onlyNoVisible)
 {
-    CBaseEntity *pMinion = NULL;
+    for ( int it = TheDirectorManager->GetMinionCount() - 1; it >= 0; --it ) {
+        if ( it >= TheDirectorManager->GetMinionCount() )
+            continue;
 
-    do {
-        pMinion = gEntList.FindEntityByName(pMinion, "director_*");
+        CBaseEntity *pMinion = TheDirectorManager->GetMinion(it);
 
         if ( !pMinion || !pMinion->IsAlive() )
             continue;
@@ -1318,7 +1492,6 @@ void Director::KillAll(bool onlyNoVisible)
 
         TheDirectorManager->Kill(pMinion, "Kill All");
     }
-    while ( pMinion );
 }
 
 //================================================================================
@@ -1342,6 +1515,10 @@ void Director::ScriptSet(int status, int phase, float duration)
 //================================================================================
 void Director::SetStatus(DirectorStatus status)
 {
+    if ( m_iStatus != status ) {
+        m_iStateChanges |= STATE_CHANGED_STATUS;
+    }
+
     m_iStatus = status;
 }
 
@@ -1349,6 +1526,10 @@ void Director::SetStatus(DirectorStatus status)
 //================================================================================
 void Director::SetPhase(DirectorPhase phase, float duration)
 {
+    if ( m_iPhase != phase ) {
+        m_iStateChanges |= STATE_CHANGED_PHASE;
+    }
+
     m_iPhase = phase;
 
     if ( duration > 0.0f ) {
@@ -1365,6 +1546,10 @@ void Director::SetPhase(DirectorPhase phase, float duration)
 //================================================================================
 void Director::SetAngry(DirectorAngry angry)
 {
+    if ( m_iAngry != angry ) {
+        m_iStateChanges |= STATE_CHANGED_ANGRY;
+    }
+
     m_iAngry = angry;
 
     // Establecemos la dificultad del juego
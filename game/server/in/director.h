@@ -33,6 +33,157 @@ static const char *g_hordeMusic[] = {
 	"Music.Director.Violin"
 };
 
+//================================================================================
+// Pistas de msica del Director, se resuelven una sola vez al crear la msica
+//================================================================================
+enum DirectorMusicCue
+{
+	MUSIC_CUE_BOSS = 0,
+	MUSIC_CUE_BIG_BOSS,
+	MUSIC_CUE_MINI_FINALE,
+	MUSIC_CUE_FINALE,
+	MUSIC_CUE_BACKGROUND_LOW,
+	MUSIC_CUE_BACKGROUND_MEDIUM,
+	MUSIC_CUE_BACKGROUND_HIGH,
+	MUSIC_CUE_BACKGROUND_CRAZY,
+	MUSIC_CUE_MOB_RULES,
+	MUSIC_CUE_FINAL_NAIL,
+	MUSIC_CUE_PREPARATION,
+	MUSIC_CUE_GAMEOVER,
+	MUSIC_CUE_CHOIR,
+	MUSIC_CUE_HORDE,
+	MUSIC_CUE_HORDE_SLAYER,
+	MUSIC_CUE_HORDE_DEVIDDLE,
+	MUSIC_CUE_HORDE_DOBRO,
+	MUSIC_CUE_HORDE_DRUMS,
+	MUSIC_CUE_HORDE_ORGANS,
+	MUSIC_CUE_HORDE_VIOLIN,
+
+	LAST_MUSIC_CUE
+};
+
+static const char *g_DirectorMusicCues[] = {
+	"Music.Director.Boss",
+	"Music.Director.BigBoss",
+	"Music.Director.MiniFinale",
+	"Music.Director.Finale",
+	"Music.Director.Background.LowAngry",
+	"Music.Director.Background.MediumAngry",
+	"Music.Director.Background.HighAngry",
+	"Music.Director.Background.CrazyAngry",
+	"Music.Director.MobRules",
+	"Music.Director.FinalNail",
+	"Music.Director.Preparation",
+	"Music.Director.Gameover",
+	"Music.Director.InfectedChoir",
+	"Music.Director.Horde",
+	"Music.Director.HordeSlayer",
+	"Music.Director.Deviddle",
+	"Music.Director.Dobro",
+	"Music.Director.Drums",
+	"Music.Director.Organs",
+	"Music.Director.Violin"
+};
+
+//================================================================================
+// Todo lo que puede cambiar el deseo de la msica, si nada cambia
+// no hace falta volver a decidir que pista reproducir.
+//================================================================================
+struct DirectorMusicState_t
+{
+	int status;
+	int angry;
+	int hordesLeft;
+	int commons;
+	int hordeCue;
+	bool tooClose;
+	bool backgroundElapsed;
+	bool choirElapsed;
+	bool disabled;
+};
+
+//================================================================================
+// Funciones que el Director puede llamar en los scripts
+//================================================================================
+enum DirectorScriptHook
+{
+	SCRIPT_HOOK_RESUME = 0,
+	SCRIPT_HOOK_START_MAP,
+	SCRIPT_HOOK_PRE_UPDATE,
+	SCRIPT_HOOK_UPDATE,
+	SCRIPT_HOOK_POST_UPDATE,
+	SCRIPT_HOOK_UPDATE_PHASE,
+	SCRIPT_HOOK_UPDATE_ANGRY,
+	SCRIPT_HOOK_UPDATE_PANIC_EVENT,
+	SCRIPT_HOOK_SHOULD_PHASE_END,
+	SCRIPT_HOOK_GET_PANIC_EVENT_DELAY,
+	SCRIPT_HOOK_GET_PANIC_EVENT_HORDES,
+	SCRIPT_HOOK_SHOULD_START_PANIC_EVENT,
+	SCRIPT_HOOK_ON_PANIC_START,
+	SCRIPT_HOOK_ON_PANIC_END,
+	SCRIPT_HOOK_CAN_SPAWN_MINIONS,
+	SCRIPT_HOOK_CAN_SPAWN_MINIONS_BY_TYPE,
+	SCRIPT_HOOK_GET_MAX_DISTANCE,
+	SCRIPT_HOOK_GET_MIN_DISTANCE,
+	SCRIPT_HOOK_GET_MAX_UNITS,
+	SCRIPT_HOOK_GET_MAX_UNITS_BY_TYPE,
+	SCRIPT_HOOK_ON_STATE_CHANGED,
+
+	LAST_SCRIPT_HOOK
+};
+
+static const char *g_DirectorScriptHooks[] = {
+	"Resume",
+	"StartMap",
+	"PreUpdate",
+	"Update",
+	"PostUpdate",
+	"UpdatePhase",
+	"UpdateAngry",
+	"UpdatePanicEvent",
+	"ShouldPhaseEnd",
+	"GetPanicEventDelay",
+	"GetPanicEventHordes",
+	"ShouldStartPanicEvent",
+	"OnPanicStart",
+	"OnPanicEnd",
+	"CanSpawnMinions",
+	"CanSpawnMinionsByType",
+	"GetMaxDistance",
+	"GetMinDistance",
+	"GetMaxUnits",
+	"GetMaxUnitsByType",
+	"OnStateChanged"
+};
+
+//================================================================================
+// Cambios en el estado del Director que se entregan a los scripts
+// en una sola llamada a OnStateChanged al final de cada Think
+//================================================================================
+enum
+{
+	STATE_CHANGED_STATUS = (1 << 0),
+	STATE_CHANGED_PHASE = (1 << 1),
+	STATE_CHANGED_ANGRY = (1 << 2),
+	STATE_CHANGED_POPULATION = (1 << 3),
+};
+
+//================================================================================
+// Funcin de un script y el tiempo que ha tomado ejecutarla
+//================================================================================
+struct DirectorScriptHook_t
+{
+	HSCRIPT function;
+
+	// Think actual
+	float time;
+	int calls;
+
+	// Think anterior (director_debug)
+	float lastTime;
+	int lastCalls;
+};
+
 //================================================================================
 // El Director
 //================================================================================
@@ -104,6 +255,10 @@ public:
 
 	// Msica
 	virtual void CreateMusic();
+	virtual void UpdateMusic();
+
+	virtual int GetMusicCue( const char *soundname );
+	virtual float MusicDesire( int cue, int channel );
 	virtual float SoundDesire( const char *soundname, int channel );
 
 	virtual void OnSoundPlay( const char *soundname );
@@ -170,10 +325,16 @@ public:
     // Virtual Machine
     virtual void StartVirtualMachine();
 
-    virtual bool CallScriptFunction( const char *pFunctionName, ScriptVariant_t *pFunctionReturn );
+    virtual void ResolveScriptHooks();
+    virtual void ReleaseScriptHooks();
+    virtual void SnapshotScriptHooks();
+
+    virtual void DispatchStateChanges();
+
+    virtual bool CallScriptFunction( DirectorScriptHook hook, ScriptVariant_t *pFunctionReturn );
 
     template <typename ARG_TYPE_1>
-    bool CallScriptFunction( const char *pFunctionName, ScriptVariant_t *pFunctionReturn, ARG_TYPE_1 arg1 );
+    bool CallScriptFunction( DirectorScriptHook hook, ScriptVariant_t *pFunctionReturn, ARG_TYPE_1 arg1 );
 
 protected:
     DirectorStatus m_iStatus;
@@ -203,11 +364,16 @@ protected:
     CSoundInstance *m_HordeMusicList[LAST_HORDE_MUSIC];
     CSoundInstance *m_HordeMusic = NULL;
 
+    DirectorMusicState_t m_MusicState;
+
 protected:
     CScriptScope m_ScriptScope;
     HSCRIPT m_hScriptInstance;
     string_t m_szScriptID;
 
+    DirectorScriptHook_t m_ScriptHooks[LAST_SCRIPT_HOOK];
+    int m_iStateChanges;
+
     friend class DirectorManager;
 	friend class CInfoDirector;
 };
@@ -215,22 +381,21 @@ protected:
 extern Director *TheDirector;
 
 template<typename ARG_TYPE_1>
-inline bool Director::CallScriptFunction( const char * pFunctionName, ScriptVariant_t * pFunctionReturn, ARG_TYPE_1 arg1 ) 
+inline bool Director::CallScriptFunction( DirectorScriptHook hook, ScriptVariant_t * pFunctionReturn, ARG_TYPE_1 arg1 ) 
 {
-	if ( !m_ScriptScope.IsInitialized() )
-		return false;
+	DirectorScriptHook_t &info = m_ScriptHooks[hook];
 
-	HSCRIPT hFunc = m_ScriptScope.LookupFunction( pFunctionName );
+	// El script no la tiene
+	if ( !info.function )
+		return false;
 
-	if( hFunc )
-	{
-		m_ScriptScope.Call<ARG_TYPE_1>( hFunc, pFunctionReturn, arg1 );
-		m_ScriptScope.ReleaseFunction( hFunc );
+	double start = Plat_FloatTime();
+	m_ScriptScope.Call<ARG_TYPE_1>( info.function, pFunctionReturn, arg1 );
 
-		return true;
-	}
+	info.time += (float)(Plat_FloatTime() - start);
+	++info.calls;
 
-	return false;
+	return true;
 }
 
 
@@ -52,6 +52,7 @@ DECLARE_SERVER_CMD( director_spawn_mode, "2", "" )
 DECLARE_CHEAT_CMD( director_manager_use_navmesh, "1", "" )
 DECLARE_CHEAT_CMD( director_manager_spawn_novisible_spots, "1", "" )
 DECLARE_DEBUG_CMD( director_manager_check_unreachable, "1", "" );
+DECLARE_CHEAT_CMD( director_manager_minion_checks, "15", "Cantidad de minions que verifican su distancia y si pueden llegar a los jugadores en cada Think" )
 
 //================================================================================
 // Constructor 
@@ -59,12 +60,23 @@ DECLARE_DEBUG_CMD( director_manager_check_unreachable, "1", "" );
 DirectorManager::DirectorManager()
 {
     m_PopulationList.EnsureCapacity( 32 );
+    m_iMinionsCreated = 0;
+    m_iNextMinionCheck = 0;
+
+    FOR_EACH_MINION_TYPE( it )
+    {
+        m_iPopulation[it] = 0;
+    }
 }
 
 //================================================================================
 //================================================================================
 void DirectorManager::Init()
 {
+    // Nos enteramos cuando un minion es eliminado
+    gEntList.RemoveListenerEntity( this );
+    gEntList.AddListenerEntity( this );
+
     SetPopulation("default");
 }
 
@@ -84,10 +96,32 @@ void DirectorManager::ResetMap()
 
     FOR_EACH_VEC( m_PopulationList, pt )
     {
+        m_PopulationList[pt]->alive = 0;
         m_PopulationList[pt]->lastSpawn = 0;
         m_PopulationList[pt]->nextSpawn.Start( m_PopulationList[pt]->spawnInterval );
     }
 
+    m_iMinionsCreated = 0;
+    m_iNextMinionCheck = 0;
+
+    // Volvemos a contar los minions que siguen vivos
+    for ( int it = m_MinionList.Count() - 1; it >= 0; --it )
+    {
+        MinionEntry_t &entry = m_MinionList[it];
+        CBaseEntity *pMinion = entry.entity.Get();
+
+        if ( !pMinion || !pMinion->IsAlive() ) {
+            m_MinionList.FastRemove( it );
+            continue;
+        }
+
+        entry.tooClose = false;
+        m_Minions[entry.type].alive++;
+
+        if ( entry.info )
+            entry.info->alive++;
+    }
+
     m_ScanTimer.Start( 1.0f );
 }
 
@@ -130,6 +164,17 @@ void DirectorManager::LoadPopulation()
 {
     m_PopulationList.PurgeAndDeleteElements();
 
+    // Los minions vivos ya no pertenecen a ninguna poblacin
+    FOR_EACH_VEC( m_MinionList, it )
+    {
+        m_MinionList[it].info = NULL;
+    }
+
+    FOR_EACH_MINION_TYPE( it )
+    {
+        m_iPopulation[it] = 0;
+    }
+
     dbReadResult *results = TheGameDatabase->ReadMultiple( "SELECT unit,spawn_chance,spawn_interval,type,is_template,max_units FROM director_population WHERE population = '%s'", m_nPopulation );
 
     FOR_EACH_RESULT( it, results, 6 )
@@ -150,6 +195,9 @@ void DirectorManager::LoadPopulation()
 
         Msg( "Minion: %s (spawnChance: %i) (spawnInterval: %i) (type: %i)  (population: %s) (maxUnits: %i)\n", info->unit, info->spawnChance, info->spawnInterval, info->type, info->population, info->maxUnits );
         m_PopulationList.AddToTail( info );
+
+        if ( info->type >= 0 && info->type < LAST_CHILD_TYPE )
+            m_iPopulation[info->type]++;
     }
 
     results->Purge();
@@ -326,14 +374,7 @@ int DirectorManager::GetSpawnsLeft( MinionType type )
 //================================================================================
 int DirectorManager::GetMinionsCreated()
 {
-    int count = 0;
-
-    FOR_EACH_MINION_TYPE( it )
-    {
-        count += m_Minions[it].created;
-    }
-
-    return count;
+    return m_iMinionsCreated;
 }
 
 //================================================================================
@@ -342,18 +383,7 @@ int DirectorManager::GetMinionsCreated()
 //================================================================================
 int DirectorManager::GetPopulation( MinionType type )
 {
-    int count = 0;
-
-    FOR_EACH_VEC( m_PopulationList, it )
-    {
-        CMinionInfo *info = m_PopulationList[it];
-        Assert( info );
-
-        if ( info->type == type )
-            count++;
-    }
-
-    return count;
+    return m_iPopulation[type];
 }
 
 //================================================================================
@@ -383,9 +413,9 @@ void DirectorManager::Spawn( MinionType type )
     AssertMsg( left > 0, "Minion Spawns satisfied but Spawn() is called!" );
 
     while ( left > 0 ) {
+        // El minion se registra al crearse, no hace falta volver a escanear
         if ( CreateMinion( type ) ) {
             left--;
-            TheDirectorManager->Scan();
             continue;
         }
 
@@ -469,6 +499,7 @@ bool DirectorManager::CreateMinion( CMinionInfo *minion, Vector *vecPosition )
 
     m_Minions[minion->type].created++;
     m_Minions[minion->type].lastSpawn = gpGlobals->curtime;
+    m_iMinionsCreated++;
     return true;
 }
 
@@ -491,6 +522,7 @@ bool DirectorManager::SetupMinion( CAI_BaseNPC * pMinion, CMinionInfo * minion,
         NDebugOverlay::VertArrow( *vecPosition + Vector( 0, 0, 25.0f ), *vecPosition, 25.0f / 4.0f, 255, 0, 255, 0, true, 1.0f );
 
     lagcompensation->AddAdditionalEntity( pMinion );
+    AddMinion( pMinion, minion );
     return true;
 }
 
@@ -519,6 +551,7 @@ bool DirectorManager::SetupMinion( CBotSpawn * pSpawner, CMinionInfo * minion, V
     //pPlayer->GetAI()->m_vecSpawnSpot = *vecPosition;
 
     pPlayer->Teleport( vecPosition, &angles, NULL );
+    AddMinion( pPlayer, minion );
     return true;
 }
 
@@ -621,6 +654,9 @@ void DirectorManager::ScanNavMesh()
     if ( count == 0 )
         return;
 
+    CUtlVector<CNavArea *> areas( 0, count );
+    CUtlVector<Vector> positions( 0, count );
+
     FOR_EACH_VEC( TheNavAreas, it )
     {
         CNavArea *pArea = TheNavAreas[it];
@@ -628,20 +664,32 @@ void DirectorManager::ScanNavMesh()
         if ( !CanUseNavArea( pArea ) )
             continue;
 
-        Vector vecPosition = pArea->GetCenter();
-        float distance = 0;
+        areas.AddToTail( pArea );
+        positions.AddToTail( pArea->GetCenter() );
+    }
+
+    if ( areas.Count() == 0 )
+        return;
 
-        // Obtenemos al jugador ms cercano
-        CPlayer *pPlayer = ThePlayersSystem->GetNear( vecPosition, distance );
+    // Obtenemos al jugador ms cercano de todas las areas en una sola pasada,
+    // las que estan muy lejos se quedan sin jugador.
+    CUtlVector<CPlayer *> players;
+    CUtlVector<float> distances;
+    players.SetCount( areas.Count() );
+    distances.SetCount( areas.Count() );
 
-        if ( !pPlayer )
-            continue;
+    float minDistance = TheDirector->GetMinDistance();
+    ThePlayersSystem->GetNear( positions.Base(), positions.Count(), players.Base(), distances.Base(), TheDirector->GetMaxDistance() );
+
+    FOR_EACH_VEC( areas, it )
+    {
+        CNavArea *pArea = areas[it];
 
         // Esta muy lejos o muy cerca
-        if ( distance > TheDirector->GetMaxDistance() || distance < TheDirector->GetMinDistance() )
+        if ( !players[it] || distances[it] < minDistance )
             continue;
 
-        Vector vecTemporal = vecPosition;
+        Vector vecTemporal = positions[it];
         vecTemporal.z += HalfHumanHeight;
 
         // No podemos usar este punto
@@ -669,6 +717,9 @@ void DirectorManager::ScanNodes()
     if ( count == 0 )
         return;
 
+    CUtlVector<CAI_Node *> nodes( 0, count );
+    CUtlVector<Vector> positions( 0, count );
+
     for ( int i = 0; i < count; ++i ) {
         // Obtenemos el nodo
         CAI_Node *pNode = g_pBigAINet->GetNode( i );
@@ -677,23 +728,36 @@ void DirectorManager::ScanNodes()
         if ( !CanUseNode( pNode ) )
             continue;
 
-        Vector vecPosition = pNode->GetPosition( HULL_HUMAN );
-        CNavArea *pArea = TheNavMesh->GetNearestNavArea( vecPosition );
+        nodes.AddToTail( pNode );
+        positions.AddToTail( pNode->GetPosition( HULL_HUMAN ) );
+    }
 
-        // Invlido
-        if ( !CanUseNavArea( pArea ) )
-            continue;
+    if ( nodes.Count() == 0 )
+        return;
+
+    // Obtenemos al jugador ms cercano de todos los nodos en una sola pasada
+    CUtlVector<CPlayer *> players;
+    CUtlVector<float> distances;
+    players.SetCount( nodes.Count() );
+    distances.SetCount( nodes.Count() );
 
-        float distance = 0;
+    float minDistance = TheDirector->GetMinDistance();
+    ThePlayersSystem->GetNear( positions.Base(), positions.Count(), players.Base(), distances.Base(), TheDirector->GetMaxDistance() );
 
-        // Obtenemos al jugador ms cercano
-        CPlayer *pPlayer = ThePlayersSystem->GetNear( vecPosition, distance );
+    FOR_EACH_VEC( nodes, i ) {
+        CAI_Node *pNode = nodes[i];
 
-        if ( !pPlayer )
+        // Esta muy lejos o muy cerca
+        if ( !players[i] || distances[i] < minDistance )
             continue;
 
-        // Esta muy lejos o muy cerca
-        if ( distance > TheDirector->GetMaxDistance() || distance < TheDirector->GetMinDistance() )
+        Vector vecPosition = positions[i];
+
+        // Buscamos el area solo para los nodos que estan a buena distancia
+        CNavArea *pArea = TheNavMesh->GetNearestNavArea( vecPosition );
+
+        // Invlido
+        if ( !CanUseNavArea( pArea ) )
             continue;
 
         Vector vecTemporal = vecPosition;
@@ -713,81 +777,124 @@ void DirectorManager::ScanNodes()
 }
 
 //================================================================================
-// Escanea los minions vivos en el mapa
+// Registra un minion creado por el Director
 //================================================================================
-void DirectorManager::Scan()
+void DirectorManager::AddMinion( CBaseEntity *pEntity, CMinionInfo *minion )
 {
-    ScanSpawnableSpots();
+    Assert( pEntity && minion );
+
+    if ( FindMinion( pEntity ) != m_MinionList.InvalidIndex() )
+        return;
 
-    CBaseEntity *pMinion = NULL;
+    MinionEntry_t entry;
+    entry.entity = pEntity;
+    entry.type = minion->type;
+    entry.info = minion;
+    entry.tooClose = false;
 
-    // Reiniciamos variables
-    FOR_EACH_MINION_TYPE(it)
-    {
-        m_Minions[it].alive = 0;
-        m_Minions[it].tooClose = 0;
-    }
+    m_MinionList.AddToTail( entry );
 
-    FOR_EACH_VEC( m_PopulationList, pt )
-    {
-        m_PopulationList[pt]->alive = 0;
-    }
+    m_Minions[entry.type].alive++;
+    minion->alive++;
+}
 
-    do {
-        pMinion = gEntList.FindEntityByName( pMinion, "director_*" );
+//================================================================================
+// Quita un minion del registro (ha muerto o ha sido eliminado)
+//================================================================================
+void DirectorManager::RemoveMinion( int index )
+{
+    MinionEntry_t &entry = m_MinionList[index];
 
-        if ( !pMinion )
-            continue;
+    m_Minions[entry.type].alive--;
 
-        if ( !pMinion->IsAlive() )
-            continue;
+    if ( entry.tooClose )
+        m_Minions[entry.type].tooClose--;
 
-        ScanMinion( pMinion );
-    }
-    while ( pMinion );
+    if ( entry.info )
+        entry.info->alive--;
+
+    m_MinionList.FastRemove( index );
 }
 
 //================================================================================
-// Escanea un minion
 //================================================================================
-void DirectorManager::ScanMinion( CBaseEntity *pMinion )
+int DirectorManager::FindMinion( CBaseEntity *pEntity )
 {
-    if ( ShouldKill( pMinion ) ) {
-        Kill( pMinion, "ShouldKill()" );
-        return;
+    FOR_EACH_VEC( m_MinionList, it )
+    {
+        if ( m_MinionList[it].entity.Get() == pEntity )
+            return it;
     }
 
-    FOR_EACH_MINION_TYPE( it )
-    {
-        const char *pName = UTIL_VarArgs( "director_%s", g_MinionTypes[it] );
+    return m_MinionList.InvalidIndex();
+}
 
-        if ( !pMinion->NameMatches( pName ) )
-            continue;
+//================================================================================
+//================================================================================
+void DirectorManager::OnEntityDeleted( CBaseEntity *pEntity )
+{
+    int index = FindMinion( pEntity );
 
-        m_Minions[it].alive++;
+    if ( index != m_MinionList.InvalidIndex() )
+        RemoveMinion( index );
+}
 
-        if ( IsTooClose( pMinion ) )
-            m_Minions[it].tooClose++;
+//================================================================================
+// Escanea los minions vivos en el mapa
+//================================================================================
+void DirectorManager::Scan()
+{
+    ScanSpawnableSpots();
+
+    // Quitamos a los minions que han muerto y les reportamos
+    // la ubicacin de los jugadores
+    for ( int it = m_MinionList.Count() - 1; it >= 0; --it )
+    {
+        CBaseEntity *pMinion = m_MinionList[it].entity.Get();
+
+        if ( !pMinion || !pMinion->IsAlive() ) {
+            RemoveMinion( it );
+            continue;
+        }
 
         // Necesitas un nuevo enemigo
         if ( ShouldReportEnemy( pMinion ) )
             ReportEnemy( pMinion );
     }
 
-    FOR_EACH_VEC( m_PopulationList, pt )
+    // Las verificaciones de distancia y de si puede llegar a los jugadores
+    // son costosas, las repartimos entre varios Think
+    int count = MIN( m_MinionList.Count(), MAX( director_manager_minion_checks.GetInt(), 1 ) );
+
+    for ( int it = 0; it < count; ++it )
     {
-        if ( m_PopulationList[pt]->isTemplate ) {
-            if ( pMinion->GetOwnerEntity() ) {
-                if ( pMinion->GetOwnerEntity()->NameMatches( m_PopulationList[pt]->unit ) ) {
-                    m_PopulationList[pt]->alive++;
-                }
-            }
-        }
-        else {
-            if ( pMinion->ClassMatches( m_PopulationList[pt]->unit ) ) {
-                m_PopulationList[pt]->alive++;
-            }
-        }
+        if ( m_iNextMinionCheck >= m_MinionList.Count() )
+            m_iNextMinionCheck = 0;
+
+        ScanMinion( m_MinionList[m_iNextMinionCheck] );
+        ++m_iNextMinionCheck;
+    }
+}
+
+//================================================================================
+// Escanea un minion
+//================================================================================
+void DirectorManager::ScanMinion( MinionEntry_t &entry )
+{
+    CBaseEntity *pMinion = entry.entity.Get();
+    Assert( pMinion );
+
+    // Se quitar del registro cuando sea eliminado
+    if ( ShouldKill( pMinion ) ) {
+        Kill( pMinion, "ShouldKill()" );
+        return;
+    }
+
+    bool tooClose = IsTooClose( pMinion );
+
+    if ( tooClose != entry.tooClose ) {
+        entry.tooClose = tooClose;
+        m_Minions[entry.type].tooClose += (tooClose) ? 1 : -1;
     }
 }
 
@@ -13,7 +13,7 @@
 //================================================================================
 // El ayudante del Director
 //================================================================================
-class DirectorManager
+class DirectorManager : public IEntityListener
 {
 public:
     DirectorManager();
@@ -56,9 +56,19 @@ public:
     virtual void ScanNodes();
     virtual void ScanNavMesh();
 
+    // Registro de hijos
+    virtual void AddMinion( CBaseEntity *pEntity, CMinionInfo *minion );
+    virtual void RemoveMinion( int index );
+    virtual int FindMinion( CBaseEntity *pEntity );
+    virtual int GetMinionCount() { return m_MinionList.Count(); }
+    virtual CBaseEntity *GetMinion( int index ) { return m_MinionList[index].entity.Get(); }
+
+    // IEntityListener
+    virtual void OnEntityDeleted( CBaseEntity *pEntity );
+
     // Escaneo de hijos
     virtual void Scan();
-    virtual void ScanMinion( CBaseEntity *pEntity );
+    virtual void ScanMinion( MinionEntry_t &entry );
 
     virtual bool ShouldKill( CBaseEntity *pEntity );
     virtual void Kill( CBaseEntity *pEntity, const char *reason = "Unknown" );
@@ -77,6 +87,11 @@ public:
 
 protected:
     char m_nPopulation[32];
+    int m_iPopulation[LAST_CHILD_TYPE];
+    int m_iMinionsCreated;
+
+    CUtlVector<MinionEntry_t> m_MinionList;
+    int m_iNextMinionCheck;
 
     CUtlVector<CNavArea *>m_CandidateAreas;
     CUtlVector<CAI_Node *>m_CandidateNodes;
@@ -61,6 +61,17 @@ public:
 
 typedef CUtlVector<CMinionInfo *> PopulationList;
 
+//================================================================================
+// Un minion vivo creado por el Director
+//================================================================================
+struct MinionEntry_t
+{
+    EHANDLE entity;
+    MinionType type;
+    CMinionInfo *info;
+    bool tooClose;
+};
+
 //================================================================================
 // Estados del Director
 //================================================================================
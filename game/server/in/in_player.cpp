@@ -22,6 +22,7 @@
 #include "in_attribute_system.h"
 
 #include "director.h"
+#include "players_system.h"
 
 #include "obstacle_pushaway.h"
 #include "predicted_viewmodel.h"
@@ -252,6 +253,7 @@ void CPlayer::InitialSpawn()
 void CPlayer::Spawn()
 {
     BaseClass::Spawn();
+    ThePlayersSystem->Invalidate();
 
     m_nButtons = 0;
     m_iRespawnFrames = 0;
@@ -737,6 +739,34 @@ CBaseWeapon *CPlayer::GetActiveBaseWeapon()
     return ToBaseWeapon(GetActiveWeapon());
 }
 
+//================================================================================
+// Los cambios de arma afectan al estado de los jugadores
+//================================================================================
+void CPlayer::Weapon_Equip(CBaseCombatWeapon *pWeapon)
+{
+    BaseClass::Weapon_Equip(pWeapon);
+    ThePlayersSystem->Invalidate();
+}
+
+//================================================================================
+//================================================================================
+void CPlayer::Weapon_Drop(CBaseCombatWeapon *pWeapon, const Vector *pvecTarget, const Vector *pVelocity)
+{
+    BaseClass::Weapon_Drop(pWeapon, pvecTarget, pVelocity);
+    ThePlayersSystem->Invalidate();
+}
+
+//================================================================================
+//================================================================================
+bool CPlayer::Weapon_Switch(CBaseCombatWeapon *pWeapon, int viewmodelindex)
+{
+    if ( !BaseClass::Weapon_Switch(pWeapon, viewmodelindex) )
+        return false;
+
+    ThePlayersSystem->Invalidate();
+    return true;
+}
+
 //================================================================================
 // Otorga el objeto especificado al jugador
 //================================================================================
@@ -1439,6 +1469,8 @@ int CPlayer::OnTakeDamage_Alive(CTakeDamageInfo &info)
     m_UnderAttackTimer.Start();
     m_CombatTimer.Start();
 
+    ThePlayersSystem->Invalidate();
+
     // This type of damage slows us down
     if ( TheGameRules->Damage_CausesSlowness(info) ) {
         m_SlowDamageTimer.Start();
@@ -1638,6 +1670,8 @@ void CPlayer::DropResources()
 //================================================================================
 void CPlayer::Event_Killed(const CTakeDamageInfo &info)
 {
+    ThePlayersSystem->Invalidate();
+
     CSound *pSound = CSoundEnt::SoundPointerForIndex(CSoundEnt::ClientSoundIndex(edict()));
     IPhysicsObject *pPhysics = VPhysicsGetObject();
 
@@ -1877,6 +1911,8 @@ void CPlayer::SetPlayerStatus(int status)
 
     OnPlayerStatus(m_iPlayerStatus, status);
     m_iPlayerStatus = status;
+
+    ThePlayersSystem->Invalidate();
 }
 
 //================================================================================
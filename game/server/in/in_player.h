@@ -165,6 +165,10 @@ public:
     // Armas
     CBaseWeapon *GetActiveBaseWeapon();
 
+    virtual void Weapon_Equip( CBaseCombatWeapon *pWeapon );
+    virtual void Weapon_Drop( CBaseCombatWeapon *pWeapon, const Vector *pvecTarget = NULL, const Vector *pVelocity = NULL );
+    virtual bool Weapon_Switch( CBaseCombatWeapon *pWeapon, int viewmodelindex = 0 );
+
 	virtual CBaseEntity	*GiveNamedItem( const char *szName, int iSubType = 0, bool removeIfNotCarried = true );
 
 	//virtual bool Weapon_HasWeapon();
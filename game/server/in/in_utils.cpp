@@ -637,35 +637,31 @@ bool Utils::IsIntersecting2D(const Vector &startA, const Vector &endA, const Vec
 //================================================================================
 CPlayer *Utils::GetClosestPlayer(const Vector &vecPosition, float *distance, CPlayer *pIgnore, int team)
 {
-    CPlayer *pClosest = NULL;
-    float closeDist = 999999999999.9f;
-
-    for ( int i = 1; i <= gpGlobals->maxClients; ++i ) {
-        CPlayer *pPlayer = ToInPlayer(UTIL_PlayerByIndex(i));
+    const CUtlVector<PlayerSpot_t> &spots = ThePlayersSystem->GetSpots();
 
-        if ( !pPlayer )
-            continue;
+    CPlayer *pClosest = NULL;
+    float closeDist = Square(999999999999.9f);
 
-        if ( !pPlayer->IsAlive() )
-            continue;
+    FOR_EACH_VEC(spots, it)
+    {
+        const PlayerSpot_t &spot = spots[it];
 
-        if ( pPlayer == pIgnore )
+        if ( spot.player == pIgnore )
             continue;
 
-        if ( team && pPlayer->GetTeamNumber() != team )
+        if ( team && spot.team != team )
             continue;
 
-        Vector position = pPlayer->GetAbsOrigin();
-        float dist = vecPosition.DistTo(position);
+        float dist = vecPosition.DistToSqr(spot.position);
 
         if ( dist < closeDist ) {
             closeDist = dist;
-            pClosest = pPlayer;
+            pClosest = spot.player;
         }
     }
 
     if ( distance )
-        *distance = closeDist;
+        *distance = (pClosest) ? FastSqrt(closeDist) : 999999999999.9f;
 
     return pClosest;
 }
@@ -676,57 +672,76 @@ CPlayer *Utils::GetClosestPlayer(const Vector &vecPosition, float *distance, CPl
 //================================================================================
 bool Utils::IsSpotOccupied(const Vector &vecPosition, CPlayer *pIgnore, float closeRange, int avoidTeam)
 {
-    float distance;
-    CPlayer *pPlayer = Utils::GetClosestPlayer(vecPosition, &distance, pIgnore, avoidTeam);
+    const CUtlVector<PlayerSpot_t> &spots = ThePlayersSystem->GetSpots();
+    float closeRangeSqr = Square(closeRange);
 
-    if ( pPlayer && distance < closeRange )
-        return true;
+    // No necesitamos al ms cercano, basta con uno
+    FOR_EACH_VEC(spots, it)
+    {
+        const PlayerSpot_t &spot = spots[it];
+
+        if ( spot.player == pIgnore )
+            continue;
+
+        if ( avoidTeam && spot.team != avoidTeam )
+            continue;
+
+        if ( vecPosition.DistToSqr(spot.position) < closeRangeSqr )
+            return true;
+    }
 
     return false;
 }
 
 CPlayer * Utils::GetClosestPlayerByClass(const Vector & vecPosition, Class_T classify, float *distance, CPlayer *pIgnore)
 {
-    CPlayer *pClosest = NULL;
-    float closeDist = 999999999999.9f;
-
-    for ( int i = 1; i <= gpGlobals->maxClients; ++i ) {
-        CPlayer *pPlayer = ToInPlayer(UTIL_PlayerByIndex(i));
+    const CUtlVector<PlayerSpot_t> &spots = ThePlayersSystem->GetSpots();
 
-        if ( !pPlayer )
-            continue;
+    CPlayer *pClosest = NULL;
+    float closeDist = Square(999999999999.9f);
 
-        if ( !pPlayer->IsAlive() )
-            continue;
+    FOR_EACH_VEC(spots, it)
+    {
+        const PlayerSpot_t &spot = spots[it];
 
-        if ( pPlayer == pIgnore )
+        if ( spot.player == pIgnore )
             continue;
 
-        if ( pPlayer->Classify() != classify )
+        if ( spot.classify != classify )
             continue;
 
-        Vector position = pPlayer->GetAbsOrigin();
-        float dist = vecPosition.DistTo(position);
+        float dist = vecPosition.DistToSqr(spot.position);
 
         if ( dist < closeDist ) {
             closeDist = dist;
-            pClosest = pPlayer;
+            pClosest = spot.player;
         }
     }
 
     if ( distance )
-        *distance = closeDist;
+        *distance = (pClosest) ? FastSqrt(closeDist) : 999999999999.9f;
 
     return pClosest;
 }
 
 bool Utils::IsSpotOccupiedByClass(const Vector &vecPosition, Class_T classify, CPlayer * pIgnore, float closeRange)
 {
-    float distance;
-    CPlayer *pPlayer = Utils::GetClosestPlayerByClass(vecPosition, classify, &distance, pIgnore);
+    const CUtlVector<PlayerSpot_t> &spots = ThePlayersSystem->GetSpots();
+    float closeRangeSqr = Square(closeRange);
 
-    if ( pPlayer && distance < closeRange )
-        return true;
+    FOR_EACH_VEC(spots, it)
+    {
+        const PlayerSpot_t &spot = spots[it];
+
+        if ( spot.player == pIgnore )
+            continue;
+
+        if ( spot.classify != classify )
+            continue;
+
+        if ( vecPosition.DistToSqr(spot.position) < closeRangeSqr )
+            return true;
+    }
 
     return false;
 }
@@ -737,28 +752,22 @@ bool Utils::IsSpotOccupiedByClass(const Vector &vecPosition, Class_T classify, C
 //================================================================================
 bool Utils::IsCrossingLineOfFire(const Vector &vecStart, const Vector &vecFinish, CPlayer *pIgnore, int ignoreTeam)
 {
-    for ( int i = 1; i <= gpGlobals->maxClients; ++i ) {
-        CPlayer *pPlayer = ToInPlayer(UTIL_PlayerByIndex(i));
+    const CUtlVector<PlayerSpot_t> &spots = ThePlayersSystem->GetSpots();
 
-        if ( !pPlayer )
-            continue;
-
-        if ( !pPlayer->IsAlive() )
-            continue;
+    FOR_EACH_VEC(spots, it)
+    {
+        const PlayerSpot_t &spot = spots[it];
 
-        if ( pPlayer == pIgnore )
+        if ( spot.player == pIgnore )
             continue;
 
-        if ( ignoreTeam && pPlayer->GetTeamNumber() == ignoreTeam )
+        if ( ignoreTeam && spot.team == ignoreTeam )
             continue;
 
-        // compute player's unit aiming vector 
-        Vector viewForward;
-        AngleVectors(pPlayer->EyeAngles() + pPlayer->GetPunchAngle(), &viewForward);
-
+        // player's unit aiming vector, computed once per tick
         const float longRange = 5000.0f;
-        Vector playerOrigin = pPlayer->GetAbsOrigin();
-        Vector playerTarget = playerOrigin + longRange * viewForward;
+        Vector playerOrigin = spot.position;
+        Vector playerTarget = playerOrigin + longRange * spot.forward;
 
         Vector result(0, 0, 0);
 
@@ -12,6 +12,7 @@
 #include "nav.h"
 #include "nav_area.h"
 #include "nav_mesh.h"
+#include "nav_resources.h"
 
 #include "eventqueue.h"
 #include "dbhandler.h"
@@ -74,6 +75,15 @@ CWeaponSpawn::~CWeaponSpawn()
 		delete g_WeaponDatabase;
 }
 
+//================================================================================
+// Eliminado del mundo
+//================================================================================
+void CWeaponSpawn::UpdateOnRemove()
+{
+	TheNavResources->Unregister( this );
+	BaseClass::UpdateOnRemove();
+}
+
 //================================================================================
 //================================================================================
 int CWeaponSpawn::ObjectCaps() 
@@ -97,6 +107,10 @@ void CWeaponSpawn::Spawn()
 	// No somos solidos
     SetSolid( SOLID_NONE );
 
+	// Nos registramos una sola vez en el indice de recursos,
+	// el area se marca con NAV_MESH_RESOURCES al construirlo
+	TheNavResources->Register( this, (IsStatic()) ? NAV_RESOURCE_WEAPON_STATIC : NAV_RESOURCE_WEAPON );
+
 	// Estatico
 	if ( IsStatic() )
 	{
@@ -138,18 +152,6 @@ void CWeaponSpawn::Think()
 	// Volvemos a pensar en 2s
 	SetNextThink( gpGlobals->curtime + sv_weapon_spawn_think.GetFloat() );
 
-    if ( !engine->IsInEditMode()  )
-    {
-	    CNavArea *pArea = TheNavMesh->GetNavArea( GetAbsOrigin() );
-
-	    // Marcamos esta area como la que tiene recursos
-	    if ( pArea && !pArea->HasAttributes(NAV_MESH_RESOURCES) )
-	    {
-		    NavAttributeSetter setter( (NavAttributeType)NAV_MESH_RESOURCES );
-		    setter( pArea );
-	    }
-    }
-
 	// A veces no aparecera nada :P
 	// Esto tiene sentido si sv_weapon_spawn_think es muy grande
 	if ( IsDistanceHandled() )
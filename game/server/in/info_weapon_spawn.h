@@ -34,6 +34,7 @@ public:
 
     virtual void Spawn();
 	virtual void Think();
+	virtual void UpdateOnRemove();
 
 	virtual bool IsStatic();
 	virtual bool IsAdaptative();
@@ -0,0 +1,359 @@
+//==== Woots 2017. http://creativecommons.org/licenses/by/2.5/mx/ ===========//
+
+#include "cbase.h"
+#include "nav_resources.h"
+
+#include "nav.h"
+#include "nav_area.h"
+#include "nav_mesh.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+CNavResourceIndex g_NavResourceIndex;
+CNavResourceIndex *TheNavResources = &g_NavResourceIndex;
+
+static bool NavResourceNodeLessFunc( const NavResourceNode_t &lhs, const NavResourceNode_t &rhs )
+{
+    // The head of the queue is the cheapest node
+    return lhs.cost > rhs.cost;
+}
+
+//================================================================================
+//================================================================================
+void CNavResourceIndex::LevelInitPreEntity()
+{
+    m_Sources.Purge();
+    Clear();
+}
+
+//================================================================================
+//================================================================================
+void CNavResourceIndex::LevelShutdownPostEntity()
+{
+    m_Sources.Purge();
+    Clear();
+}
+
+//================================================================================
+// The navigation mesh is loaded after the entities, we build the index
+// as soon as it is available and every time it changes (nav_edit)
+//================================================================================
+void CNavResourceIndex::FrameUpdatePostEntityThink()
+{
+    if ( !TheNavMesh || !TheNavMesh->IsLoaded() )
+        return;
+
+    if ( m_iAreaCount != TheNavMesh->GetNavAreaCount() )
+        m_bDirty = true;
+
+    if ( !m_bDirty )
+        return;
+
+    Build();
+}
+
+//================================================================================
+// Registers an entity as a source of resources.
+// It only needs to be called once (on spawn), the area is resolved when
+// the index is built.
+//================================================================================
+void CNavResourceIndex::Register( CBaseEntity *pEntity, NavResourceType type )
+{
+    Assert( pEntity );
+    Assert( type > NAV_RESOURCE_ANY && type < LAST_NAV_RESOURCE );
+
+    if ( !pEntity )
+        return;
+
+    FOR_EACH_VEC( m_Sources, it )
+    {
+        if ( m_Sources[it].entity == pEntity && m_Sources[it].type == type )
+            return;
+    }
+
+    NavResourceSource_t source;
+    source.entity = pEntity;
+    source.position = pEntity->GetAbsOrigin();
+    source.type = type;
+    source.area = NULL;
+    source.markedID = 0;
+
+    m_Sources.AddToTail( source );
+    Invalidate();
+}
+
+//================================================================================
+//================================================================================
+void CNavResourceIndex::Unregister( CBaseEntity *pEntity )
+{
+    for ( int it = m_Sources.Count() - 1; it >= 0; --it )
+    {
+        if ( m_Sources[it].entity != pEntity )
+            continue;
+
+        unsigned int markedID = m_Sources[it].markedID;
+        m_Sources.FastRemove( it );
+
+        // We remove the mark we put on the area, only when no other source is there.
+        // The area is resolved by its ID since the mesh may have changed.
+        if ( markedID != 0 && !engine->IsInEditMode() && TheNavMesh )
+        {
+            CNavArea *pArea = TheNavMesh->GetNavAreaByID( markedID );
+            bool remaining = false;
+
+            FOR_EACH_VEC( m_Sources, other )
+            {
+                if ( pArea && m_Sources[other].area == pArea )
+                {
+                    // It now owns the mark
+                    m_Sources[other].markedID = markedID;
+                    remaining = true;
+                    break;
+                }
+            }
+
+            if ( pArea && !remaining )
+            {
+                NavAttributeClearer clearer( (NavAttributeType)NAV_MESH_RESOURCES );
+                clearer( pArea );
+            }
+        }
+
+        Invalidate();
+    }
+}
+
+//================================================================================
+//================================================================================
+void CNavResourceIndex::Clear()
+{
+    for ( int type = 0; type < LAST_NAV_RESOURCE; ++type )
+        m_Areas[type].Purge();
+
+    m_Links.Purge();
+    m_iAreaCount = 0;
+    m_bDirty = true;
+}
+
+//================================================================================
+// Builds the index, called once per level (or after editing the mesh)
+//================================================================================
+void CNavResourceIndex::Build()
+{
+    VPROF_BUDGET( "CNavResourceIndex::Build", VPROF_BUDGETGROUP_NPCS );
+
+    Clear();
+
+    if ( !TheNavMesh || !TheNavMesh->IsLoaded() )
+        return;
+
+    m_iAreaCount = TheNavMesh->GetNavAreaCount();
+    m_bDirty = false;
+
+    // The table is indexed by area ID, IDs are compacted when the mesh is saved
+    unsigned int maxID = 0;
+
+    FOR_EACH_VEC( TheNavAreas, it )
+    {
+        maxID = MAX( maxID, TheNavAreas[it]->GetID() );
+    }
+
+    m_Links.SetCount( maxID + 1 );
+
+    FOR_EACH_VEC( m_Links, it )
+    {
+        NavResourceLink_t &link = m_Links[it];
+        link.types = 0;
+
+        for ( int type = 0; type < LAST_NAV_RESOURCE; ++type )
+        {
+            link.nearest[type] = NULL;
+            link.distance[type] = FLT_MAX;
+        }
+    }
+
+    // Spawners
+    FOR_EACH_VEC( m_Sources, it )
+    {
+        NavResourceSource_t &source = m_Sources[it];
+        source.area = TheNavMesh->GetNearestNavArea( source.position, true, 300.0f );
+
+        if ( !source.area )
+            continue;
+
+        // We mark this area as the one with resources (only once)
+        if ( !engine->IsInEditMode() && !source.area->HasAttributes(NAV_MESH_RESOURCES) )
+        {
+            NavAttributeSetter setter( (NavAttributeType)NAV_MESH_RESOURCES );
+            setter( source.area );
+            source.markedID = source.area->GetID();
+        }
+
+        NavResourceLink_t &link = m_Links[source.area->GetID()];
+
+        if ( !(link.types & (1 << source.type)) )
+        {
+            link.types |= (1 << source.type);
+            m_Areas[source.type].AddToTail( source.area );
+        }
+    }
+
+    // Areas marked in the editor or by the spawners
+    FOR_EACH_VEC( TheNavAreas, it )
+    {
+        CNavArea *pArea = TheNavAreas[it];
+
+        if ( !pArea->HasAttributes(NAV_MESH_RESOURCES) )
+            continue;
+
+        m_Links[pArea->GetID()].types |= (1 << NAV_RESOURCE_ANY);
+        m_Areas[NAV_RESOURCE_ANY].AddToTail( pArea );
+    }
+
+    for ( int type = 0; type < LAST_NAV_RESOURCE; ++type )
+        Propagate( (NavResourceType)type );
+
+    DevMsg( 2, "[NavResourceIndex] %i areas, %i sources, %i resource areas.\n", m_iAreaCount, m_Sources.Count(), m_Areas[NAV_RESOURCE_ANY].Count() );
+}
+
+//================================================================================
+// Multi-source Dijkstra from every area with this type of resource,
+// each area ends up pointing to the nearest (by travel distance) one.
+//================================================================================
+void CNavResourceIndex::Propagate( NavResourceType type )
+{
+    CUtlVector<CNavArea *> &sources = m_Areas[type];
+
+    if ( sources.Count() == 0 )
+        return;
+
+    CUtlPriorityQueue<NavResourceNode_t> queue( 0, TheNavAreas.Count(), NavResourceNodeLessFunc );
+
+    FOR_EACH_VEC( sources, it )
+    {
+        NavResourceNode_t node;
+        node.area = sources[it];
+        node.source = sources[it];
+        node.cost = 0.0f;
+
+        m_Links[node.area->GetID()].nearest[type] = node.source;
+        m_Links[node.area->GetID()].distance[type] = 0.0f;
+
+        queue.Insert( node );
+    }
+
+    while ( queue.Count() > 0 )
+    {
+        NavResourceNode_t node = queue.ElementAtHead();
+        queue.RemoveAtHead();
+
+        // Stale entry, we already found a shorter way
+        if ( node.cost > m_Links[node.area->GetID()].distance[type] )
+            continue;
+
+        // We walk the links backwards: the areas that can reach this one
+        for ( int dir = 0; dir < NUM_DIRECTIONS; ++dir )
+        {
+            int count = node.area->GetAdjacentCount( (NavDirType)dir );
+
+            for ( int i = 0; i < count; ++i )
+            {
+                CNavArea *pAdjacent = node.area->GetAdjacentArea( (NavDirType)dir, i );
+
+                // One-way link, they can not come back to us
+                if ( !pAdjacent || !pAdjacent->IsConnected(node.area, NUM_DIRECTIONS) )
+                    continue;
+
+                Relax( queue, node, pAdjacent, type );
+            }
+
+            const NavConnectVector *pIncoming = node.area->GetIncomingConnections( (NavDirType)dir );
+
+            FOR_EACH_VEC( (*pIncoming), i )
+            {
+                Relax( queue, node, (*pIncoming)[i].area, type );
+            }
+        }
+    }
+}
+
+//================================================================================
+//================================================================================
+void CNavResourceIndex::Relax( CUtlPriorityQueue<NavResourceNode_t> &queue, const NavResourceNode_t &node, CNavArea *pArea, NavResourceType type )
+{
+    if ( !pArea )
+        return;
+
+    float cost = node.cost + (pArea->GetCenter() - node.area->GetCenter()).Length();
+    NavResourceLink_t &link = m_Links[pArea->GetID()];
+
+    if ( cost >= link.distance[type] )
+        return;
+
+    link.distance[type] = cost;
+    link.nearest[type] = node.source;
+
+    NavResourceNode_t next;
+    next.area = pArea;
+    next.source = node.source;
+    next.cost = cost;
+
+    queue.Insert( next );
+}
+
+//================================================================================
+//================================================================================
+const NavResourceLink_t *CNavResourceIndex::GetLink( const CNavArea *pArea ) const
+{
+    if ( !pArea || m_bDirty )
+        return NULL;
+
+    unsigned int id = pArea->GetID();
+
+    if ( !m_Links.IsValidIndex(id) )
+        return NULL;
+
+    return &m_Links[id];
+}
+
+//================================================================================
+// Returns if the area has resources of the specified type
+//================================================================================
+bool CNavResourceIndex::HasResource( const CNavArea *pArea, NavResourceType type ) const
+{
+    const NavResourceLink_t *link = GetLink( pArea );
+
+    if ( !link )
+        return false;
+
+    return (link->types & (1 << type)) != 0;
+}
+
+//================================================================================
+// Returns the nearest area with resources of the specified type.
+// NULL if there is none reachable from this area.
+//================================================================================
+CNavArea *CNavResourceIndex::GetNearest( const CNavArea *pArea, NavResourceType type, float *distance ) const
+{
+    const NavResourceLink_t *link = GetLink( pArea );
+
+    if ( !link || !link->nearest[type] )
+        return NULL;
+
+    if ( distance )
+        *distance = link->distance[type];
+
+    return link->nearest[type];
+}
+
+//================================================================================
+//================================================================================
+CNavArea *CNavResourceIndex::GetNearest( const Vector &vecPosition, NavResourceType type, float *distance ) const
+{
+    if ( m_bDirty )
+        return NULL;
+
+    CNavArea *pArea = TheNavMesh->GetNearestNavArea( vecPosition );
+    return GetNearest( pArea, type, distance );
+}
@@ -0,0 +1,114 @@
+//==== Woots 2017. http://creativecommons.org/licenses/by/2.5/mx/ ===========//
+
+#ifndef NAV_RESOURCES_H
+#define NAV_RESOURCES_H
+
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "utlpriorityqueue.h"
+
+class CNavArea;
+
+//================================================================================
+// Resource types
+//================================================================================
+enum NavResourceType
+{
+    // Any area flagged with NAV_MESH_RESOURCES (nav editor or spawners)
+    NAV_RESOURCE_ANY = 0,
+
+    NAV_RESOURCE_WEAPON,
+    NAV_RESOURCE_WEAPON_STATIC,
+
+    LAST_NAV_RESOURCE
+};
+
+//================================================================================
+// Entity registered as a source of resources
+//================================================================================
+struct NavResourceSource_t
+{
+    EHANDLE entity;
+    Vector position;
+    NavResourceType type;
+    CNavArea *area;
+
+    // ID of the area we marked with NAV_MESH_RESOURCES (0 if it was already marked)
+    unsigned int markedID;
+};
+
+//================================================================================
+// Nearest resource of each type from an area
+//================================================================================
+struct NavResourceLink_t
+{
+    CNavArea *nearest[LAST_NAV_RESOURCE];
+    float distance[LAST_NAV_RESOURCE];
+    int types;
+};
+
+//================================================================================
+// Open list entry for the multi-source search
+//================================================================================
+struct NavResourceNode_t
+{
+    CNavArea *area;
+    CNavArea *source;
+    float cost;
+};
+
+//================================================================================
+// Level-wide index of navigation areas with resources.
+// Spawners register once, the index is built as soon as the navigation mesh
+// is loaded and every area stores the nearest resource area of each type
+// (multi-source Dijkstra over the area graph), so Bots can ask for
+// "the nearest resource of type X" in O(1).
+//================================================================================
+class CNavResourceIndex : public CAutoGameSystemPerFrame
+{
+public:
+    CNavResourceIndex() : CAutoGameSystemPerFrame("NavResourceIndex")
+    {
+    }
+
+    virtual void LevelInitPreEntity();
+    virtual void LevelShutdownPostEntity();
+    virtual void FrameUpdatePostEntityThink();
+
+public:
+    virtual void Register( CBaseEntity *pEntity, NavResourceType type );
+    virtual void Unregister( CBaseEntity *pEntity );
+
+    virtual void Invalidate() { m_bDirty = true; }
+    virtual bool IsBuilt() const { return !m_bDirty; }
+    virtual void Build();
+
+    virtual const CUtlVector<CNavArea *> &GetAreas( NavResourceType type ) const { return m_Areas[type]; }
+
+    virtual bool HasResource( const CNavArea *pArea, NavResourceType type ) const;
+    virtual CNavArea *GetNearest( const CNavArea *pArea, NavResourceType type, float *distance = NULL ) const;
+    virtual CNavArea *GetNearest( const Vector &vecPosition, NavResourceType type, float *distance = NULL ) const;
+
+protected:
+    virtual void Clear();
+    virtual void Propagate( NavResourceType type );
+    virtual void Relax( CUtlPriorityQueue<NavResourceNode_t> &queue, const NavResourceNode_t &node, CNavArea *pArea, NavResourceType type );
+
+    const NavResourceLink_t *GetLink( const CNavArea *pArea ) const;
+
+protected:
+    bool m_bDirty;
+    unsigned int m_iAreaCount;
+
+    CUtlVector<NavResourceSource_t> m_Sources;
+    CUtlVector<CNavArea *> m_Areas[LAST_NAV_RESOURCE];
+
+    // Indexed by area ID
+    CUtlVector<NavResourceLink_t> m_Links;
+};
+
+extern CNavResourceIndex *TheNavResources;
+
+#endif // NAV_RESOURCES_H
@@ -11,6 +11,9 @@
 #include "in_player.h"
 #include "in_utils.h"
 
+#include "collisionutils.h"
+#include "vscript_shared.h"
+
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
@@ -18,6 +21,19 @@
 CPlayersSystem g_PlayersSystem;
 CPlayersSystem *ThePlayersSystem = &g_PlayersSystem;
 
+//================================================================================
+//================================================================================
+static inline bool IsSpotOfTeam( const PlayerSpot_t &spot, int team, bool ignoreBots )
+{
+    if ( team != TEAM_ANY && spot.team != team )
+        return false;
+
+    if ( ignoreBots && spot.bot )
+        return false;
+
+    return true;
+}
+
 // Puntero al acceso de la base de datos players.db
 dbHandler *ThePlayersDatabase = NULL;
 dbHandler *TheGameDatabase = NULL;
@@ -49,19 +65,38 @@ void CPlayersSystem::Shutdown()
         delete ThePlayersDatabase;
 }
 
+//================================================================================
+// Informacin para la maquina virtual
+//================================================================================
+
+BEGIN_SCRIPTDESC_ROOT_NAMED( CPlayersSystem, "CPlayersSystem", SCRIPT_SINGLETON "Estado de los jugadores" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetTotal, "GetTotal", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetAlive, "GetAlive", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetDejected, "GetDejected", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetHealth, "GetHealth", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetStress, "GetStress", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetInCombat, "GetInCombat", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetUnderAttack, "GetUnderAttack", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetWithFireWeapons, "GetWithFireWeapons", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetWeaponStats, "GetWeaponStats", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetAmmoStats, "GetAmmoStats", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetStats, "GetStats", "" )
+    DEFINE_SCRIPTFUNC_NAMED( ScriptGetSnapshotTick, "GetSnapshotTick", "" )
+END_SCRIPTDESC();
+
 //================================================================================
 // Reinicia la informacin del sistema
 //================================================================================
 void CPlayersSystem::Restart()
 {
-    m_iTotal        = 0;
-    m_iAlive        = 0;
-    m_iConnected    = 0;
+    memset( m_Snapshots, 0, sizeof(m_Snapshots) );
+
+    for ( int it = 0; it < ARRAYSIZE(m_Snapshots); ++it )
+        m_Snapshots[it].tick = -1;
 
-    m_iHealth            = 0;
-    m_iInCombat            = 0;
-    m_iUnderAttack        = 0;
-    m_iWithFireWeapons    = 0;
+    m_bDirty = true;
+    m_Spots.Purge();
+    m_iSpotsTick = -1;
 
     m_ThinkTimer.Start( 1.0f );
 
@@ -88,61 +123,313 @@ void CPlayersSystem::FrameUpdatePostEntityThink()
 }
 
 //================================================================================
+// El estrs y los temporizadores de combate cambian sin que haya un evento,
+// de vez en cuando volvemos a calcular todo.
 //================================================================================
 void CPlayersSystem::Update()
 {
-    m_iTotal        = 0;
-    m_iConnected    = 0;
-    m_iInCombat        = 0;
-    m_iUnderAttack    = 0;
+    Invalidate();
+    GetSnapshot();
+}
 
-    FOR_EACH_PLAYER(
+//================================================================================
+// Devuelve el estado de los jugadores del equipo
+// Los eventos de los jugadores (dao, muerte, armas) lo invalidan y se vuelve
+// a calcular en la siguiente consulta, como mucho una vez por tick.
+//================================================================================
+const PlayersSnapshot_t &CPlayersSystem::GetSnapshot( int team )
+{
+    if ( m_bDirty && m_Snapshots[0].tick != gpGlobals->tickcount )
+        BuildSnapshots();
+
+    int index = team + 1;
+
+    if ( index < 0 || index >= ARRAYSIZE(m_Snapshots) )
+        index = 0;
+
+    return m_Snapshots[index];
+}
+
+//================================================================================
+// Devuelve el estado de la municin de un jugador
+//================================================================================
+static int GetPlayerAmmoStats( CPlayer *pPlayer, CBaseWeapon *pWeapon )
+{
+    // Municin actual
+    int ammo        = pPlayer->GetAmmoCount( pWeapon->GetPrimaryAmmoType() );
+    int max            = pWeapon->GetMaxClip1();
+    int individual    = STATS_MEDIOCRE;
+
+    // Ms de 0.2 - STATS_POOR
+    if ( ammo >= roundup(max*0.2) )
+        ++individual;
+
+    // Ms de la mitad - STATS_NORMAL
+    if ( ammo >= roundup(max*0.4) )
+        ++individual;
+
+    // Ms de la mitad - STATS_GOOD
+    if ( ammo >= roundup(max*0.6) )
+        ++individual;
+
+    // Mucha - STATS_EXCELENT
+    if ( ammo >= roundup(max*0.8) )
+        ++individual;
+
+    return individual;
+}
+
+//================================================================================
+// Devuelve el estado de la municin del equipo
+// TODO: Algo mejor
+//================================================================================
+static StatType ComputeAmmoStats( int total, const int *ammoCount )
+{
+    // STATS_MEDIOCRE
+    int type = STATS_MEDIOCRE;
+
+    // STATS_POOR
+    if ( ammoCount[STATS_MEDIOCRE] <= roundup(total*0.3) )
+        ++type;
+
+    // STATS_NORMAL
+    if ( ammoCount[STATS_POOR] <= roundup(total*0.3) )
+        ++type;
+
+    // STATS_GOOD
+    if ( ammoCount[STATS_NORMAL] >= roundup(total*0.3) )
+        ++type;
+
+    // STATS_EXCELENT
+    if ( ammoCount[STATS_GOOD] >= roundup(total*0.3) )
+        ++type;
+
+    // clamp
+    type = clamp( type, STATS_MEDIOCRE, STATS_EXCELENT );
+    return (StatType)type;
+}
+
+//================================================================================
+// Devuelve el estado de las armas del equipo
+//================================================================================
+static StatType ComputeWeaponStats( const PlayersSnapshot_t &snapshot )
+{
+    // STATS_MEDIOCRE
+    int type = STATS_MEDIOCRE;
+
+    int total = snapshot.total;
+    int count = snapshot.withFireWeapons;
+
+    // La mitad de jugadores tiene un arma - STATS_POOR
+    if ( count >= roundup(total*0.5) )
+        ++type;
+
+    // Todos tienen un arma - STATS_NORMAL
+    if ( count == total )
+        ++type;
+
+    // Buen estado de municin - STATS_GOOD
+    if ( snapshot.ammoStats >= STATS_NORMAL )
+        ++type;
+
+    // Excelente estado de municin - STATS_EXCELENT
+    if ( snapshot.ammoStats >= STATS_EXCELENT )
+        ++type;
+
+    // clamp
+    type = clamp( type, STATS_MEDIOCRE, STATS_EXCELENT );
+
+    return (StatType)type;
+}
+
+//================================================================================
+// Devuelve el estado de todos los jugadores del equipo
+//================================================================================
+static StatType ComputePlayersStats( const PlayersSnapshot_t &snapshot )
+{
+    // STATS_EXCELENT
+    int type = STATS_EXCELENT;
+
+    // Stats
+    float total = (float)snapshot.total;
+
+    // La mayora de jugadores estan muertos
+    if ( snapshot.alive < roundup(total * 0.8f) )
+        --type;
+
+    // Baja salud
+    if ( snapshot.health <= 60 )
+        --type;
+
+    // Baja salud
+    if ( snapshot.health <= 30 )
+        --type;
+
+    // Buen estado de armas y municin
+    if ( snapshot.weaponStats < STATS_NORMAL )
+        --type;
+
+    // Jugadores incapacitados!
+    if ( snapshot.dejected >= roundup(total * 0.3f) )
+        --type;
+
+    // Jugadores incapacitados!
+    if ( snapshot.dejected >= roundup(total * 0.6f) )
+        --type;
+
+    // Alto estrs
+    if ( snapshot.stress >= 50 )
+        --type;
+
+    // clamp
+    type = clamp( type, STATS_MEDIOCRE, STATS_EXCELENT );
+    return (StatType)type;
+}
+
+//================================================================================
+// Calcula el estado de todos los equipos en una sola pasada por los jugadores
+//================================================================================
+void CPlayersSystem::BuildSnapshots()
+{
+    VPROF_BUDGET( "CPlayersSystem::BuildSnapshots", VPROF_BUDGETGROUP_GAME );
+
+    int ammoCount[ARRAYSIZE(m_Snapshots)][LAST_STATS];
+
+    memset( m_Snapshots, 0, sizeof(m_Snapshots) );
+    memset( ammoCount, 0, sizeof(ammoCount) );
+
+    for ( int it = 1; it <= gpGlobals->maxClients; ++it )
     {
-        // Conectado
-        ++m_iConnected;
+        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex(it) );
 
-        // No es del equipo que queremos
-        if ( GetTeam() != TEAM_ANY && pPlayer->GetTeamNumber() != GetTeam() )
+        if ( !pPlayer )
             continue;
 
-        // Total del equipo
-        ++m_iTotal;
+        // El jugador cuenta para TEAM_ANY y para su equipo
+        int slots[2] = { 0, pPlayer->GetTeamNumber() + 1 };
+        int slotCount = ( slots[1] > 0 && slots[1] < ARRAYSIZE(m_Snapshots) ) ? 2 : 1;
+
+        bool alive = pPlayer->IsAlive();
+        bool active = alive && !pPlayer->IsObserver();
+        bool dejected = alive && pPlayer->IsDejected();
+
+        // Los jugadores incapacitados tienen una penalizacin
+        int health = 0;
+
+        if ( alive )
+            health = ( dejected ) ? (int)round( (float)pPlayer->GetHealth() / 2.0f ) : pPlayer->GetHealth();
+
+        // Armas de fuego
+        int ammo = -1;
+
+        if ( alive )
+        {
+            CBaseWeapon *pWeapon = pPlayer->GetActiveBaseWeapon();
+
+            if ( pWeapon && !pWeapon->IsMeleeWeapon() )
+                ammo = GetPlayerAmmoStats( pPlayer, pWeapon );
+        }
+
+        for ( int slot = 0; slot < slotCount; ++slot )
+        {
+            PlayersSnapshot_t &snapshot = m_Snapshots[slots[slot]];
+
+            ++snapshot.total;
+            snapshot.stress += pPlayer->GetStress();
+
+            if ( !alive )
+                continue;
+
+            ++snapshot.alive;
+            snapshot.health += health;
+
+            if ( dejected )
+                ++snapshot.dejected;
+
+            if ( active && pPlayer->IsOnCombat() )
+                ++snapshot.inCombat;
+
+            if ( active && pPlayer->IsUnderAttack() )
+                ++snapshot.underAttack;
+
+            if ( ammo >= 0 )
+            {
+                ++snapshot.withFireWeapons;
+                ++ammoCount[slots[slot]][ammo];
+            }
+        }
+    }
+
+    for ( int it = 0; it < ARRAYSIZE(m_Snapshots); ++it )
+    {
+        PlayersSnapshot_t &snapshot = m_Snapshots[it];
+        snapshot.tick = gpGlobals->tickcount;
+
+        // Dividimos la salud entre todos
+        if ( snapshot.health > 0 )
+            snapshot.health = (int)round( (float)snapshot.health / (float)snapshot.alive );
+
+        // Dividimos entre todos
+        if ( snapshot.stress > 0.0f )
+            snapshot.stress = snapshot.stress / (float)snapshot.total;
+
+        snapshot.ammoStats = ComputeAmmoStats( snapshot.total, ammoCount[it] );
+        snapshot.weaponStats = ComputeWeaponStats( snapshot );
+        snapshot.playerStats = ComputePlayersStats( snapshot );
+    }
+
+    m_bDirty = false;
+}
+
+//================================================================================
+// Devuelve la posicin de los jugadores vivos en este tick
+//================================================================================
+const CUtlVector<PlayerSpot_t> &CPlayersSystem::GetSpots()
+{
+    if ( m_iSpotsTick != gpGlobals->tickcount )
+        BuildSpots();
+
+    return m_Spots;
+}
+
+//================================================================================
+//================================================================================
+void CPlayersSystem::BuildSpots()
+{
+    m_Spots.RemoveAll();
+    m_iSpotsTick = gpGlobals->tickcount;
+
+    for ( int it = 1; it <= gpGlobals->maxClients; ++it )
+    {
+        CPlayer *pPlayer = ToInPlayer( UTIL_PlayerByIndex(it) );
+
+        if ( !pPlayer )
+            continue;
 
         // No esta vivo
-        if ( !pPlayer->IsAlive() || pPlayer->IsObserver() )
+        if ( !pPlayer->IsAlive() )
             continue;
 
-        // En combate
-        if ( pPlayer->IsOnCombat() )
-            ++m_iInCombat;
+        PlayerSpot_t &spot = m_Spots[m_Spots.AddToTail()];
+        spot.player = pPlayer;
+        spot.position = pPlayer->GetAbsOrigin();
+        spot.team = pPlayer->GetTeamNumber();
+        spot.classify = pPlayer->Classify();
+        spot.bot = pPlayer->IsBot();
 
-        // Bajo ataque
-        if ( pPlayer->IsUnderAttack() )
-            ++m_iUnderAttack;
-    });
+        AngleVectors( pPlayer->EyeAngles() + pPlayer->GetPunchAngle(), &spot.forward );
+    }
+}
+
+//================================================================================
+// Registra el sistema en la maquina virtual como "ThePlayers"
+//================================================================================
+void CPlayersSystem::RegisterScriptInstance()
+{
+    if ( !g_pScriptVM )
+        return;
 
-    // Basic Stats
-    m_iHealth           = GetHealthTotal( GetTeam() );
-    m_flStress          = GetStressTotal( GetTeam() );
-    m_iAlive            = GetAliveCount( GetTeam() );
-    m_iWithFireWeapons  = GetFireWeaponsCount( GetTeam() );
-    m_iDejected         = GetDejectedCount( GetTeam() );
-    m_WeaponsStats      = GetWeaponStats( GetTeam() );
-    m_PlayerStats       = GetPlayersStats();
-
-    // Debug
-    /*
-    DevMsg("STATS \n");
-    DevMsg("    m_iHealth = %i \n", m_iHealth);
-    DevMsg("    m_iAlive = %i / %i \n", m_iAlive, m_iTotal);
-    DevMsg("    m_iInCombat = %i \n", m_iInCombat);
-    DevMsg("    m_iUnderAttack = %i \n", m_iUnderAttack);
-    DevMsg("    m_iWithFireWeapons = %i \n", m_iWithFireWeapons);
-    DevMsg("    m_iDejected = %i \n", m_iDejected);
-    DevMsg("    m_WeaponsStats = %s \n", g_StatsNames[m_WeaponsStats]);
-    DevMsg("    m_PlayerStats = %s \n", g_StatsNames[m_PlayerStats]);
-    DevMsg("=============================================================\n");
-    */
+    g_pScriptVM->RegisterInstance( this, "ThePlayers" );
 }
 
 //================================================================================
@@ -206,20 +493,7 @@ void CPlayersSystem::RespawnAll( int team )
 //================================================================================
 int CPlayersSystem::GetDejectedCount( int team )
 {
-    int count = 0;
-
-    FOR_EACH_PLAYER_TEAM(
-    {
-        // No esta vivo
-        if ( !pPlayer->IsAlive() )
-            continue;
-        
-        // Incapacitado
-        if ( pPlayer->IsDejected() )
-            ++count;
-    }, team);
-
-    return count;
+    return GetSnapshot( team ).dejected;
 }
 
 //================================================================================
@@ -227,10 +501,7 @@ int CPlayersSystem::GetDejectedCount( int team )
 //================================================================================
 int CPlayersSystem::GetTotalCount( int team )
 {
-    int count = 0;
-    FOR_EACH_PLAYER_TEAM( ++count;, team );
-
-    return count;
+    return GetSnapshot( team ).total;
 }
 
 //================================================================================
@@ -238,18 +509,7 @@ int CPlayersSystem::GetTotalCount( int team )
 //================================================================================
 int CPlayersSystem::GetAliveCount( int team )
 {
-    int count = 0;
-
-    FOR_EACH_PLAYER_TEAM(
-    {
-        // No esta vivo
-        if ( !pPlayer->IsAlive() )
-            continue;
-
-        ++count;
-    }, team);
-
-    return count;
+    return GetSnapshot( team ).alive;
 }
 
 //================================================================================
@@ -257,28 +517,7 @@ int CPlayersSystem::GetAliveCount( int team )
 //================================================================================
 int CPlayersSystem::GetFireWeaponsCount( int team )
 {
-    int count = 0;
-
-    FOR_EACH_PLAYER_TEAM(
-    {
-        // No esta vivo
-        if ( !pPlayer->IsAlive() )
-            continue;
-
-        CBaseWeapon *pWeapon = pPlayer->GetActiveBaseWeapon();
-
-        // No tiene arma
-        if ( !pWeapon )
-            continue;
-
-        // Es de cuerpo a cuerpo
-        if ( pWeapon->IsMeleeWeapon() )
-            continue;
-
-        ++count;
-    }, team);
-
-    return count;
+    return GetSnapshot( team ).withFireWeapons;
 }
 
 //================================================================================
@@ -286,29 +525,7 @@ int CPlayersSystem::GetFireWeaponsCount( int team )
 //================================================================================
 int CPlayersSystem::GetHealthTotal( int team )
 {
-    int health = 0;
-    int players = 0;
-
-    FOR_EACH_PLAYER_TEAM(
-    {
-        // No esta vivo
-        if ( !pPlayer->IsAlive() )
-            continue;
-
-        // Los jugadores incapacitados tienen una penalizacin
-        if ( pPlayer->IsDejected() )
-            health += (int)round( (float)pPlayer->GetHealth() / 2.0f );
-        else
-            health += pPlayer->GetHealth();
-        
-        ++players;
-    }, team);
-
-    // Dividimos la salud entre todos
-    if ( health > 0 )
-        health = (int)round( (float)health / (float)players );
-
-    return health;
+    return GetSnapshot( team ).health;
 }
 
 //================================================================================
@@ -316,20 +533,7 @@ int CPlayersSystem::GetHealthTotal( int team )
 //================================================================================
 float CPlayersSystem::GetStressTotal( int team )
 {
-    float stress = 0;
-    int players = 0;
-
-    FOR_EACH_PLAYER_TEAM(
-    {
-        stress += pPlayer->GetStress();
-        ++players;
-    }, team);
-
-    // Dividimos entre todos
-    if ( stress > 0.0f )
-        stress = stress / (float)players;
-
-    return stress;
+    return GetSnapshot( team ).stress;
 }
 
 //================================================================================
@@ -337,17 +541,7 @@ float CPlayersSystem::GetStressTotal( int team )
 //================================================================================
 bool CPlayersSystem::IsAnyPlayerInCombat( int team )
 {
-    FOR_EACH_PLAYER_TEAM(
-    {
-        // No esta vivo
-        if ( !pPlayer->IsAlive() )
-            continue;
-
-        if ( pPlayer->IsOnCombat() )
-            return true;
-    }, team);
-
-    return false;
+    return GetSnapshot( team ).inCombat > 0;
 }
 
 //================================================================================
@@ -355,17 +549,7 @@ bool CPlayersSystem::IsAnyPlayerInCombat( int team )
 //================================================================================
 bool CPlayersSystem::IsAnyPlayerUnderAttack( int team )
 {
-    FOR_EACH_PLAYER_TEAM(
-    {
-        // No esta vivo
-        if ( !pPlayer->IsAlive() )
-            continue;
-
-        if ( pPlayer->IsUnderAttack() )
-            return true;
-    }, team);
-
-    return false;
+    return GetSnapshot( team ).underAttack > 0;
 }
 
 //================================================================================
@@ -373,185 +557,23 @@ bool CPlayersSystem::IsAnyPlayerUnderAttack( int team )
 //================================================================================
 StatType CPlayersSystem::GetWeaponStats( int team )
 {
-    // STATS_MEDIOCRE
-    int type = STATS_MEDIOCRE;
-
-    // Stats
-    int total        = GetTotalCount( team );
-    int count        = GetFireWeaponsCount( team );
-    StatType ammo    = GetAmmoStats( team );
-
-    // La mitad de jugadores tiene un arma - STATS_POOR
-    if ( count >= roundup(total*0.5) )
-        ++type;
-
-    // Todos tienen un arma - STATS_NORMAL
-    if ( count == total )
-        ++type;
-
-    // Buen estado de municin - STATS_GOOD
-    if ( ammo >= STATS_NORMAL )
-        ++type;
-
-    // Excelente estado de municin - STATS_EXCELENT
-    if ( ammo >= STATS_EXCELENT )
-        ++type;
-
-    // clamp
-    type = clamp( type, STATS_MEDIOCRE, STATS_EXCELENT );
-
-    return (StatType)type;
+    return GetSnapshot( team ).weaponStats;
 }
 
 //================================================================================
 // Devuelve el estado actual de la municin de los jugadores
-// TODO: Algo mejor
 //================================================================================
 StatType CPlayersSystem::GetAmmoStats( int team )
 {
-    // STATS_MEDIOCRE
-    int total        = GetTotalCount( team );
-    int type        = STATS_MEDIOCRE;
-
-    int mediocreCount = 0;
-    int poorCount = 0;
-    int normalCount = 0;
-    int goodCount = 0;
-    int excelentCount = 0;
-
-    FOR_EACH_PLAYER_TEAM(
-    {
-        // No esta vivo
-        if ( !pPlayer->IsAlive() )
-            continue;
-
-        CBaseWeapon *pWeapon = pPlayer->GetActiveBaseWeapon();
-
-        // No tiene arma
-        if ( !pWeapon )
-            continue;
-
-        // Es de cuerpo a cuerpo
-        if ( pWeapon->IsMeleeWeapon() )
-            continue;
-
-        // Municin actual
-        int ammo        = pPlayer->GetAmmoCount( pWeapon->GetPrimaryAmmoType() );
-        int max            = pWeapon->GetMaxClip1();
-        int individual    = STATS_MEDIOCRE;
-
-        // Ms de 0.2 - STATS_POOR
-        if ( ammo >= roundup(max*0.2) )
-            ++individual;
-
-        // Ms de la mitad - STATS_NORMAL
-        if ( ammo >= roundup(max*0.4) )
-            ++individual;
-
-        // Ms de la mitad - STATS_GOOD
-        if ( ammo >= roundup(max*0.6) )
-            ++individual;
-
-        // Mucha - STATS_EXCELENT
-        if ( ammo >= roundup(max*0.8) )
-            ++individual;
-        
-        switch( individual )
-        {
-            case STATS_MEDIOCRE:
-                ++mediocreCount;
-            break;
-
-            case STATS_POOR:
-                ++poorCount;
-            break;
-
-            case STATS_NORMAL:
-                ++normalCount;
-            break;
-
-            case STATS_GOOD:
-                ++goodCount;
-            break;
-
-            case STATS_EXCELENT:
-                ++excelentCount;
-            break;
-        }
-    }, team);
-
-    // STATS_POOR
-    if ( mediocreCount <= roundup(total*0.3) )
-        ++type;
-
-    // STATS_NORMAL
-    if ( poorCount <= roundup(total*0.3) )
-        ++type;
-
-    // STATS_GOOD
-    if ( normalCount >= roundup(total*0.3) )
-        ++type;
-
-    // STATS_EXCELENT
-    if ( goodCount >= roundup(total*0.3) )
-        ++type;
-
-    // clamp
-    type = clamp( type, STATS_MEDIOCRE, STATS_EXCELENT );
-    return (StatType)type;
+    return GetSnapshot( team ).ammoStats;
 }
 
-
-
 //================================================================================
 // Devuelve el estado de todos los jugadores
 //================================================================================
 StatType CPlayersSystem::GetPlayersStats()
 {
-    // STATS_EXCELENT
-    int type = STATS_EXCELENT;
-
-    // Stats
-    float total     = (float)( GetTotal() );
-    int alive       = GetAlive();
-    int dejected    = GetDejected();
-    int health      = GetHealth();
-    float stress    = GetStress();
-    int weapons     = m_WeaponsStats;
-    //int combat      = GetInCombat();
-    //int attacked    = GetUnderAttack();
-
-    // La mayora de jugadores estan muertos
-    if ( alive < roundup(total * 0.8f) )
-        --type;
-
-    // Baja salud
-    if ( health <= 60 )
-        --type;
-
-    // Baja salud
-    if ( health <= 30 )
-        --type;
-
-    // Buen estado de armas y municin
-    if ( weapons < STATS_NORMAL )
-        --type;
-
-    // Jugadores incapacitados!
-    if ( dejected >= roundup(total * 0.3f) )
-        --type;
-
-    // Jugadores incapacitados!
-    if ( dejected >= roundup(total * 0.6f) )
-        --type;
-
-    // Alto estrs
-    if ( stress >= 50 )
-        --type;
-
-    // clamp
-    type = clamp( type, STATS_MEDIOCRE, STATS_EXCELENT );
-    return (StatType)type;
+    return GetSnapshot( GetTeam() ).playerStats;
 }
 
 //================================================================================
@@ -559,32 +581,33 @@ StatType CPlayersSystem::GetPlayersStats()
 //================================================================================
 CPlayer *CPlayersSystem::GetNear( const Vector &vecPosition, float &distance, CBasePlayer *pExcept, int team, bool ignoreBots )
 {
+    const CUtlVector<PlayerSpot_t> &spots = GetSpots();
+
     CPlayer *pNear = NULL;
-    distance = 999999.0f;
+    float nearDistance = Square( 999999.0f );
 
-    FOR_EACH_PLAYER_TEAM(
+    FOR_EACH_VEC( spots, it )
     {
-        // No esta vivo
-        if ( !pPlayer->IsAlive() )
-            continue;
+        const PlayerSpot_t &spot = spots[it];
 
         // No queremos este
-        if ( pExcept && pPlayer == pExcept )
+        if ( pExcept && spot.player == pExcept )
             continue;
 
-        if ( ignoreBots && pPlayer->IsBot() )
+        if ( !IsSpotOfTeam(spot, team, ignoreBots) )
             continue;
 
-        float flDistance = pPlayer->GetAbsOrigin().DistTo( vecPosition );
+        float flDistance = spot.position.DistToSqr( vecPosition );
 
         // Esta ms lejos
-        if ( flDistance > distance )
+        if ( flDistance > nearDistance )
             continue;
 
-        pNear        = pPlayer;
-        distance    = flDistance;
-    }, team);
+        pNear           = spot.player;
+        nearDistance    = flDistance;
+    }
 
+    distance = ( pNear ) ? FastSqrt( nearDistance ) : 999999.0f;
     return pNear;
 }
 
@@ -597,6 +620,79 @@ CPlayer *CPlayersSystem::GetNear( const Vector &vecPosition, CBasePlayer *pExcep
     return GetNear( vecPosition, distance, pExcept, team, ignoreBots );
 }
 
+//================================================================================
+// Devuelve el Jugador ms cercano a cada una de las posiciones indicadas
+// Las posiciones que estan a ms de [maxDistance] de todos los jugadores se
+// descartan con una sola comprobacin contra la caja que los envuelve.
+// Devuelve el nmero de posiciones que tienen un jugador cerca.
+//================================================================================
+int CPlayersSystem::GetNear( const Vector *positions, int count, CPlayer **results, float *distances, float maxDistance, int team, bool ignoreBots )
+{
+    const CUtlVector<PlayerSpot_t> &spots = GetSpots();
+
+    // Solo los jugadores que pasan el filtro
+    const PlayerSpot_t *candidates[MAX_PLAYERS];
+    int candidateCount = 0;
+
+    Vector vecMins( FLT_MAX, FLT_MAX, FLT_MAX );
+    Vector vecMaxs( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+
+    FOR_EACH_VEC( spots, it )
+    {
+        if ( !IsSpotOfTeam(spots[it], team, ignoreBots) || candidateCount >= MAX_PLAYERS )
+            continue;
+
+        candidates[candidateCount++] = &spots[it];
+        VectorMin( vecMins, spots[it].position, vecMins );
+        VectorMax( vecMaxs, spots[it].position, vecMaxs );
+    }
+
+    bool bounded = ( maxDistance < FLT_MAX );
+    float maxDistanceSqr = ( bounded ) ? Square( maxDistance ) : FLT_MAX;
+
+    if ( bounded ) {
+        vecMins -= Vector( maxDistance, maxDistance, maxDistance );
+        vecMaxs += Vector( maxDistance, maxDistance, maxDistance );
+    }
+
+    int found = 0;
+
+    for ( int i = 0; i < count; ++i )
+    {
+        const Vector &vecPosition = positions[i];
+
+        results[i] = NULL;
+        distances[i] = FLT_MAX;
+
+        if ( candidateCount == 0 )
+            continue;
+
+        // Esta muy lejos de todos
+        if ( bounded && !IsPointInBox(vecPosition, vecMins, vecMaxs) )
+            continue;
+
+        float nearDistance = maxDistanceSqr;
+
+        for ( int c = 0; c < candidateCount; ++c )
+        {
+            float flDistance = candidates[c]->position.DistToSqr( vecPosition );
+
+            if ( flDistance > nearDistance )
+                continue;
+
+            results[i] = candidates[c]->player;
+            nearDistance = flDistance;
+        }
+
+        if ( results[i] ) {
+            distances[i] = FastSqrt( nearDistance );
+            ++found;
+        }
+    }
+
+    return found;
+}
+
 //================================================================================
 // Devuelve si el NPC tiene una ruta segura hacia el Jugador
 //================================================================================
@@ -52,6 +52,46 @@ static const char *g_StatsNames[LAST_STATS] =
     "EXCELENT"
 };
 
+//================================================================================
+// Estado de los jugadores de un equipo
+// Se calcula para todos los equipos en una sola pasada, como mucho una vez por tick
+//================================================================================
+struct PlayersSnapshot_t
+{
+    // Tick en el que se calculo
+    int tick;
+
+    int total;
+    int alive;
+    int dejected;
+    int health;
+    float stress;
+
+    int inCombat;
+    int underAttack;
+    int withFireWeapons;
+
+    StatType weaponStats;
+    StatType ammoStats;
+    StatType playerStats;
+};
+
+//================================================================================
+// Posicin de un jugador vivo
+// Se calcula una vez por tick para no recorrer a todos los clientes en cada bsqueda
+//================================================================================
+struct PlayerSpot_t
+{
+    CPlayer *player;
+
+    Vector position;
+    Vector forward;
+
+    int team;
+    Class_T classify;
+    bool bot;
+};
+
 //================================================================================
 // Clase para administrar y escanear el estado de los Jugadores
 //================================================================================
@@ -60,6 +100,8 @@ class CPlayersSystem : public CAutoGameSystemPerFrame
 public:
     CPlayersSystem() : CAutoGameSystemPerFrame("PlayersManager")
     {
+        m_bDirty = true;
+        m_iSpotsTick = -1;
     }
 
     virtual bool Init();
@@ -75,23 +117,45 @@ public:
 
     virtual void Update();
 
-    virtual int GetTotal() { return m_iTotal; }
-    virtual int GetConnected() { return m_iConnected; }
-    virtual int GetAlive() { return m_iAlive; }
-    virtual int GetDejected() { return m_iDejected; }
-    virtual int GetHealth() { return m_iHealth; }
-    virtual float GetStress() { return m_flStress; }
+    virtual const PlayersSnapshot_t &GetSnapshot( int team = TEAM_ANY );
+    virtual void Invalidate() { m_bDirty = true; m_iSpotsTick = -1; }
+
+    virtual const CUtlVector<PlayerSpot_t> &GetSpots();
+
+    virtual void RegisterScriptInstance();
+
+    virtual int GetTotal() { return GetSnapshot( GetTeam() ).total; }
+    virtual int GetConnected() { return GetSnapshot().total; }
+    virtual int GetAlive() { return GetSnapshot( GetTeam() ).alive; }
+    virtual int GetDejected() { return GetSnapshot( GetTeam() ).dejected; }
+    virtual int GetHealth() { return GetSnapshot( GetTeam() ).health; }
+    virtual float GetStress() { return GetSnapshot( GetTeam() ).stress; }
 
-    virtual int GetWithFireWeapons() { return m_iWithFireWeapons; }
+    virtual int GetWithFireWeapons() { return GetSnapshot( GetTeam() ).withFireWeapons; }
     virtual bool HasFireWeapons() { return (GetWithFireWeapons() > 0); }
 
-    virtual int GetInCombat() { return m_iInCombat; }
+    virtual int GetInCombat() { return GetSnapshot( GetTeam() ).inCombat; }
     virtual bool IsOnCombat() { return (GetInCombat() > 0); }
 
-    virtual int GetUnderAttack() { return m_iUnderAttack; }
+    virtual int GetUnderAttack() { return GetSnapshot( GetTeam() ).underAttack; }
     virtual bool IsUnderAttack() { return (GetUnderAttack() > 0); }
 
-    virtual StatType GetStats() { return m_PlayerStats; }
+    virtual StatType GetStats() { return GetSnapshot( GetTeam() ).playerStats; }
+    virtual StatType GetWeaponsStats() { return GetSnapshot( GetTeam() ).weaponStats; }
+
+    // VScript
+    int ScriptGetTotal( int team ) { return GetSnapshot( team ).total; }
+    int ScriptGetAlive( int team ) { return GetSnapshot( team ).alive; }
+    int ScriptGetDejected( int team ) { return GetSnapshot( team ).dejected; }
+    int ScriptGetHealth( int team ) { return GetSnapshot( team ).health; }
+    float ScriptGetStress( int team ) { return GetSnapshot( team ).stress; }
+    int ScriptGetInCombat( int team ) { return GetSnapshot( team ).inCombat; }
+    int ScriptGetUnderAttack( int team ) { return GetSnapshot( team ).underAttack; }
+    int ScriptGetWithFireWeapons( int team ) { return GetSnapshot( team ).withFireWeapons; }
+    int ScriptGetWeaponStats( int team ) { return GetSnapshot( team ).weaponStats; }
+    int ScriptGetAmmoStats( int team ) { return GetSnapshot( team ).ammoStats; }
+    int ScriptGetStats( int team ) { return GetSnapshot( team ).playerStats; }
+    int ScriptGetSnapshotTick( int team ) { return GetSnapshot( team ).tick; }
 
 public:
     virtual void ExecuteCommand( const char *command, int team = TEAM_ANY );
@@ -116,6 +180,8 @@ public:
     virtual CPlayer *GetNear( const Vector &vecPosition, float &distance, CBasePlayer *pExcept = NULL, int team = TEAM_ANY, bool ignoreBots = false );
     virtual CPlayer *GetNear( const Vector &vecPosition, CBasePlayer *pExcept = NULL, int team = TEAM_ANY, bool ignoreBots = false );
 
+    virtual int GetNear( const Vector *positions, int count, CPlayer **results, float *distances, float maxDistance = FLT_MAX, int team = TEAM_ANY, bool ignoreBots = false );
+
     virtual bool HasRouteToPlayer( CPlayer *pPlayer, CAI_BaseNPC *pNPC, float tolerance = 100, Navigation_t type = NAV_GROUND );
     virtual bool HasRouteToAnyPlayer( CAI_BaseNPC *pNPC, float tolerance = 100, int team = TEAM_ANY, Navigation_t type = NAV_GROUND );
 
@@ -135,21 +201,18 @@ public:
     virtual void SendLesson2All( const char *pLesson, int team = TEAM_ANY, bool once = false, CBaseEntity *pSubject = NULL );
 
 protected:
-    int m_iTotal;
-    int m_iAlive;
-    int m_iConnected;
-    int m_iDejected;
-
-    int m_iHealth;
-    float m_flStress;
-    int m_iInCombat;
-    int m_iUnderAttack;
-    int m_iWithFireWeapons;
+    virtual void BuildSnapshots();
+    virtual void BuildSpots();
 
+protected:
     int m_iTeam;
 
-    StatType m_WeaponsStats;
-    StatType m_PlayerStats;
+    // [0] = TEAM_ANY, [team + 1] = team
+    PlayersSnapshot_t m_Snapshots[MAX_TEAMS + 1];
+    bool m_bDirty;
+
+    CUtlVector<PlayerSpot_t> m_Spots;
+    int m_iSpotsTick;
 
     CountdownTimer m_ThinkTimer;
     //CUtlVector<CPlayer *> m_DejectedPlayers;
@@ -8474,7 +8474,7 @@ void CBasePlayer::SetDefaultFOV( int FOV )
 void CBasePlayer::ModifyOrAppendPlayerCriteria( AI_CriteriaSet& set )
 {
 	// Append our health
-	set.AppendCriteria( "playerhealth", UTIL_VarArgs( "%i", GetHealth() ) );
+	set.AppendCriteriaInt( "playerhealth", GetHealth() );
 	float healthfrac = 0.0f;
 	if ( GetMaxHealth() > 0 )
 	{
@@ -59,6 +59,9 @@ void CSound::Clear ( void )
 	m_bNoExpirationTime = false;
 	m_iNext				= SOUNDLIST_EMPTY;
 	m_iNextAudible		= SOUNDLIST_EMPTY;
+	m_iBucket			= SOUNDBUCKET_NONE;
+	m_iNextInBucket		= SOUNDLIST_EMPTY;
+	m_iPrevInBucket		= SOUNDLIST_EMPTY;
 }
 
 //=========================================================
@@ -70,7 +73,6 @@ void CSound::Reset ( void )
 	m_vecOrigin		= vec3_origin;
 	m_iType			= 0;
 	m_iVolume		= 0;
-	m_iNext			= SOUNDLIST_EMPTY;
 }
 
 //=========================================================
@@ -191,10 +193,13 @@ void CSoundEnt::ShutdownSoundEnt()
 //-----------------------------------------------------------------------------
 CSoundEnt::CSoundEnt()
 {
+	m_nExtraBlocks = 0;
+	m_nDroppedSounds = 0;
 }
 
 CSoundEnt::~CSoundEnt()
 {
+	FreeExtraBlocks();
 }
 
 
@@ -220,6 +225,9 @@ void CSoundEnt::OnRestore()
 		UTIL_Remove( g_pSoundEnt );
 	}
 	g_pSoundEnt = this;
+
+	// Buckets are not saved
+	RebuildBuckets();
 }
 
 
@@ -240,17 +248,17 @@ void CSoundEnt::Think ( void )
 
 	while ( iSound != SOUNDLIST_EMPTY )
 	{
-		if ( (m_SoundPool[ iSound ].m_flExpireTime <= gpGlobals->curtime && (!m_SoundPool[ iSound ].m_bNoExpirationTime)) || !m_SoundPool[iSound].ValidateOwner() )
+		if ( (Sound( iSound ).m_flExpireTime <= gpGlobals->curtime && (!Sound( iSound ).m_bNoExpirationTime)) || !Sound( iSound ).ValidateOwner() )
 		{
-			int iNext = m_SoundPool[ iSound ].m_iNext;
+			int iNext = Sound( iSound ).m_iNext;
 
 			if( displaysoundlist.GetInt() == 1 )
 			{
-				Msg("  Removed Sound: %d (Time:%f)\n", m_SoundPool[ iSound ].SoundType(), gpGlobals->curtime );
+				Msg("  Removed Sound: %d (Time:%f)\n", Sound( iSound ).SoundType(), gpGlobals->curtime );
 			}
-			if( displaysoundlist.GetInt() == 2 && m_SoundPool[ iSound ].IsSoundType( SOUND_DANGER ) )
+			if( displaysoundlist.GetInt() == 2 && Sound( iSound ).IsSoundType( SOUND_DANGER ) )
 			{
-				Msg("  Removed Danger Sound: %d (time:%f)\n", m_SoundPool[ iSound ].SoundType(), gpGlobals->curtime );
+				Msg("  Removed Danger Sound: %d (time:%f)\n", Sound( iSound ).SoundType(), gpGlobals->curtime );
 			}
 
 			// move this sound back into the free list
@@ -271,7 +279,7 @@ void CSoundEnt::Think ( void )
 				g = 255;
 				b = 0;
 
-				CSound *pSound = &m_SoundPool[ iSound ];
+				CSound *pSound = &Sound( iSound );
 
 				if( pSound->IsSoundType( SOUND_DANGER ) )
 				{
@@ -311,7 +319,7 @@ void CSoundEnt::Think ( void )
 			}
 
 			iPreviousSound = iSound;
-			iSound = m_SoundPool[ iSound ].m_iNext;
+			iSound = Sound( iSound ).m_iNext;
 		}
 	}
 
@@ -337,20 +345,22 @@ void CSoundEnt::FreeSound ( int iSound, int iPrevious )
 		return;
 	}
 
+	g_pSoundEnt->UnlinkSound( iSound );
+
 	if ( iPrevious != SOUNDLIST_EMPTY )
 	{
 		// iSound is not the head of the active list, so
 		// must fix the index for the Previous sound
-		g_pSoundEnt->m_SoundPool[ iPrevious ].m_iNext = g_pSoundEnt->m_SoundPool[ iSound ].m_iNext;
+		g_pSoundEnt->Sound( iPrevious ).m_iNext = g_pSoundEnt->Sound( iSound ).m_iNext;
 	}
 	else 
 	{
 		// the sound we're freeing IS the head of the active list.
-		g_pSoundEnt->m_iActiveSound = g_pSoundEnt->m_SoundPool [ iSound ].m_iNext;
+		g_pSoundEnt->m_iActiveSound = g_pSoundEnt->Sound( iSound ).m_iNext;
 	}
 
 	// make iSound the head of the Free list.
-	g_pSoundEnt->m_SoundPool[ iSound ].m_iNext = g_pSoundEnt->m_iFreeSound;
+	g_pSoundEnt->Sound( iSound ).m_iNext = g_pSoundEnt->m_iFreeSound;
 	g_pSoundEnt->m_iFreeSound = iSound;
 }
 
@@ -362,7 +372,7 @@ void CSoundEnt::FreeSound( int iSound )
 		return;
 
 	int iPrevious = SOUNDLIST_EMPTY;
-	for ( int i = g_pSoundEnt->m_iActiveSound; i != SOUNDLIST_EMPTY; iPrevious = i, i = g_pSoundEnt->m_SoundPool[ i ].m_iNext )
+	for ( int i = g_pSoundEnt->m_iActiveSound; i != SOUNDLIST_EMPTY; iPrevious = i, i = g_pSoundEnt->Sound( i ).m_iNext )
 	{
 		if ( i == iSound )
 		{
@@ -383,12 +393,13 @@ int CSoundEnt::IAllocSound( void )
 {
 	int iNewSound;
 
-	if ( m_iFreeSound == SOUNDLIST_EMPTY )
+	if ( m_iFreeSound == SOUNDLIST_EMPTY && !GrowPool() )
 	{
 		// no free sound!
 		if ( developer.GetInt() >= 2 )
 			Msg( "Free Sound List is full!\n" );
 
+		++m_nDroppedSounds;
 		return SOUNDLIST_EMPTY;
 	}
 
@@ -397,14 +408,14 @@ int CSoundEnt::IAllocSound( void )
 	
 	iNewSound = m_iFreeSound;// copy the index of the next free sound
 
-	m_iFreeSound = m_SoundPool[ m_iFreeSound ].m_iNext;// move the index down into the free list. 
+	m_iFreeSound = Sound( m_iFreeSound ).m_iNext;// move the index down into the free list. 
 
-	m_SoundPool[ iNewSound ].m_iNext = m_iActiveSound;// point the new sound at the top of the active list.
+	Sound( iNewSound ).m_iNext = m_iActiveSound;// point the new sound at the top of the active list.
 
 	m_iActiveSound = iNewSound;// now make the new sound the top of the active list. You're done.
 
 #ifdef DEBUG
-	m_SoundPool[ iNewSound ].m_iMyIndex = iNewSound;
+	Sound( iNewSound ).m_iMyIndex = iNewSound;
 #endif // DEBUG
 
 	return iNewSound;
@@ -441,7 +452,7 @@ int CSoundEnt::InsertSound ( int iType, const Vector &vecOrigin, int iVolume, fl
 
 	CSound *pSound;
 
-	pSound = &g_pSoundEnt->m_SoundPool[ iThisSound ];
+	pSound = &g_pSoundEnt->Sound( iThisSound );
 
 	pSound->SetSoundOrigin( vecOrigin );
 	pSound->m_iType = iType;
@@ -473,6 +484,9 @@ int CSoundEnt::InsertSound ( int iType, const Vector &vecOrigin, int iVolume, fl
 		pSound->m_bHasOwner = false;
 	}
 
+	// the origin, volume or type may have changed if we are reusing the sound of a channel
+	g_pSoundEnt->LinkSound( iThisSound );
+
 	if( displaysoundlist.GetInt() == 1 )
 	{
 		Msg("  Added Sound! Type:%d  Duration:%f (Time:%f)\n", pSound->SoundType(), flDuration, gpGlobals->curtime );
@@ -494,7 +508,7 @@ int CSoundEnt::FindOrAllocateSound( CBaseEntity *pOwner, int soundChannelIndex )
 
 	while ( iSound != SOUNDLIST_EMPTY )
 	{
-		CSound &sound = m_SoundPool[iSound];
+		CSound &sound = Sound( iSound );
 		
 		if ( sound.m_ownerChannelIndex == soundChannelIndex && sound.m_hOwner == pOwner )
 		{
@@ -519,6 +533,10 @@ void CSoundEnt::Initialize ( void )
 	m_cLastActiveSounds;
 	m_iFreeSound = 0;
 	m_iActiveSound = SOUNDLIST_EMPTY;
+	m_nDroppedSounds = 0;
+
+	FreeExtraBlocks();
+	RebuildBuckets();
 
 	// In SP, we should only use the first 64 slots so save/load works right.
 	// In MP, have one for each player and 32 extras.
@@ -534,11 +552,11 @@ void CSoundEnt::Initialize ( void )
 	for ( i = 0 ; i < nTotalSoundsInPool ; i++ )
 	{
 		// clear all sounds, and link them into the free sound list.
-		m_SoundPool[ i ].Clear();
-		m_SoundPool[ i ].m_iNext = i + 1;
+		Sound( i ).Clear();
+		Sound( i ).m_iNext = i + 1;
 	}
 
-	m_SoundPool[ i - 1 ].m_iNext = SOUNDLIST_EMPTY;// terminate the list here.
+	Sound( i - 1 ).m_iNext = SOUNDLIST_EMPTY;// terminate the list here.
 
 	
 	// now reserve enough sounds for each client
@@ -552,7 +570,8 @@ void CSoundEnt::Initialize ( void )
 			return;
 		}
 
-		m_SoundPool[ iSound ].m_bNoExpirationTime = true;
+		Sound( iSound ).m_bNoExpirationTime = true;
+		LinkSound( iSound );
 	}
 }
 
@@ -589,7 +608,7 @@ int CSoundEnt::ISoundsInList ( int iListType )
 	{
 		i++;
 
-		iThisSound = m_SoundPool[ iThisSound ].m_iNext;
+		iThisSound = Sound( iThisSound ).m_iNext;
 	}
 
 	return i;
@@ -632,7 +651,7 @@ CSound*	CSoundEnt::SoundPointerForIndex( int iIndex )
 		return NULL;
 	}
 
-	if ( iIndex > ( MAX_WORLD_SOUNDS_MP - 1 ) )
+	if ( iIndex >= g_pSoundEnt->GetPoolSize() )
 	{
 		Msg( "SoundPointerForIndex() - Index too large!\n" );
 		return NULL;
@@ -644,7 +663,7 @@ CSound*	CSoundEnt::SoundPointerForIndex( int iIndex )
 		return NULL;
 	}
 
-	return &g_pSoundEnt->m_SoundPool[ iIndex ];
+	return &g_pSoundEnt->Sound( iIndex );
 }
 
 //=========================================================
@@ -709,6 +728,394 @@ CSound*	CSoundEnt::GetLoudestSoundOfType( int iType, const Vector &vecEarPositio
 }
 
 
+//-----------------------------------------------------------------------------
+// Sound pool growth
+//-----------------------------------------------------------------------------
+bool CSoundEnt::GrowPool( void )
+{
+	// In SP only the first sounds of the pool are saved
+	if ( gpGlobals->maxClients <= 1 || m_nExtraBlocks >= MAX_WORLD_SOUND_BLOCKS - 1 )
+		return false;
+
+	int iFirst = GetPoolSize();
+	CSound *pBlock = new CSound[ MAX_WORLD_SOUNDS_MP ];
+	m_pExtraBlocks[ m_nExtraBlocks++ ] = pBlock;
+
+	// link the new sounds into the free sound list.
+	for ( int i = 0; i < MAX_WORLD_SOUNDS_MP; i++ )
+	{
+		pBlock[ i ].Clear();
+		pBlock[ i ].m_iNext = ( i < MAX_WORLD_SOUNDS_MP - 1 ) ? iFirst + i + 1 : m_iFreeSound;
+	}
+
+	m_iFreeSound = iFirst;
+
+	DevMsg( 2, "CSoundEnt pool grown to %d sounds.\n", GetPoolSize() );
+	return true;
+}
+
+void CSoundEnt::FreeExtraBlocks( void )
+{
+	for ( int i = 0; i < m_nExtraBlocks; i++ )
+	{
+		delete [] m_pExtraBlocks[ i ];
+		m_pExtraBlocks[ i ] = NULL;
+	}
+
+	m_nExtraBlocks = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Sound buckets
+//-----------------------------------------------------------------------------
+static const float g_flSoundTierVolume[ SOUNDENT_TIERS ] =
+{
+	1024.0f,	// footsteps, impacts, physics...
+	4096.0f,	// gunfire
+};
+
+static int SoundTypeClass( int iType )
+{
+	int iBaseType = iType & ~ALL_CONTEXTS;
+
+	// none or more than one type
+	if ( iBaseType == 0 || ( iBaseType & ( iBaseType - 1 ) ) != 0 )
+		return 0;
+
+	int iClass = 1;
+	while ( !( iBaseType & 1 ) )
+	{
+		iBaseType >>= 1;
+		++iClass;
+	}
+
+	return ( iClass < SOUNDENT_TYPE_CLASSES ) ? iClass : 0;
+}
+
+static int SoundCellHash( int x, int y )
+{
+	return ( ( (unsigned int)x * 73856093u ) ^ ( (unsigned int)y * 19349663u ) ) & ( SOUNDENT_CELL_HASH - 1 );
+}
+
+static int SoundCell( float flCoord, float flCellSize )
+{
+	return (int)floor( flCoord / flCellSize );
+}
+
+int CSoundEnt::GetSoundBucket( int iSound )
+{
+	CSound &sound = Sound( iSound );
+
+	// The reserved client sounds are moved every frame by their players
+	if ( iSound < gpGlobals->maxClients || sound.IsSoundType( SOUND_CONTEXT_FORCE_FROM_OWNER ) )
+		return SOUNDENT_BUCKET_GLOBAL;
+
+	for ( int iTier = 0; iTier < SOUNDENT_TIERS; iTier++ )
+	{
+		float flCellSize = g_flSoundTierVolume[ iTier ];
+
+		if ( sound.m_iVolume > flCellSize )
+			continue;
+
+		int iHash = SoundCellHash( SoundCell( sound.m_vecOrigin.x, flCellSize ), SoundCell( sound.m_vecOrigin.y, flCellSize ) );
+		return ( ( iTier * SOUNDENT_TYPE_CLASSES ) + SoundTypeClass( sound.m_iType ) ) * SOUNDENT_CELL_HASH + iHash;
+	}
+
+	return SOUNDENT_BUCKET_GLOBAL;
+}
+
+void CSoundEnt::LinkSound( int iSound )
+{
+	int iBucket = GetSoundBucket( iSound );
+	CSound &sound = Sound( iSound );
+
+	if ( sound.m_iBucket == iBucket )
+		return;
+
+	UnlinkSound( iSound );
+
+	sound.m_iBucket = iBucket;
+	sound.m_iPrevInBucket = SOUNDLIST_EMPTY;
+	sound.m_iNextInBucket = m_iBucketHead[ iBucket ];
+
+	if ( m_iBucketHead[ iBucket ] != SOUNDLIST_EMPTY )
+	{
+		Sound( m_iBucketHead[ iBucket ] ).m_iPrevInBucket = iSound;
+	}
+
+	m_iBucketHead[ iBucket ] = iSound;
+
+	if ( iBucket != SOUNDENT_BUCKET_GLOBAL )
+	{
+		++m_nBucketedSounds[ iBucket / ( SOUNDENT_TYPE_CLASSES * SOUNDENT_CELL_HASH ) ][ ( iBucket / SOUNDENT_CELL_HASH ) % SOUNDENT_TYPE_CLASSES ];
+	}
+}
+
+void CSoundEnt::UnlinkSound( int iSound )
+{
+	CSound &sound = Sound( iSound );
+	int iBucket = sound.m_iBucket;
+
+	if ( iBucket == SOUNDBUCKET_NONE )
+		return;
+
+	if ( sound.m_iPrevInBucket != SOUNDLIST_EMPTY )
+	{
+		Sound( sound.m_iPrevInBucket ).m_iNextInBucket = sound.m_iNextInBucket;
+	}
+	else
+	{
+		m_iBucketHead[ iBucket ] = sound.m_iNextInBucket;
+	}
+
+	if ( sound.m_iNextInBucket != SOUNDLIST_EMPTY )
+	{
+		Sound( sound.m_iNextInBucket ).m_iPrevInBucket = sound.m_iPrevInBucket;
+	}
+
+	if ( iBucket != SOUNDENT_BUCKET_GLOBAL )
+	{
+		--m_nBucketedSounds[ iBucket / ( SOUNDENT_TYPE_CLASSES * SOUNDENT_CELL_HASH ) ][ ( iBucket / SOUNDENT_CELL_HASH ) % SOUNDENT_TYPE_CLASSES ];
+	}
+
+	sound.m_iBucket = SOUNDBUCKET_NONE;
+	sound.m_iNextInBucket = SOUNDLIST_EMPTY;
+	sound.m_iPrevInBucket = SOUNDLIST_EMPTY;
+}
+
+void CSoundEnt::RebuildBuckets( void )
+{
+	for ( int i = 0; i < SOUNDENT_NUM_BUCKETS; i++ )
+	{
+		m_iBucketHead[ i ] = SOUNDLIST_EMPTY;
+	}
+
+	memset( m_nBucketedSounds, 0, sizeof( m_nBucketedSounds ) );
+
+	for ( int i = 0; i < GetPoolSize(); i++ )
+	{
+		Sound( i ).m_iBucket = SOUNDBUCKET_NONE;
+		Sound( i ).m_iNextInBucket = SOUNDLIST_EMPTY;
+		Sound( i ).m_iPrevInBucket = SOUNDLIST_EMPTY;
+	}
+
+	for ( int iSound = m_iActiveSound; iSound != SOUNDLIST_EMPTY; iSound = Sound( iSound ).m_iNext )
+	{
+		LinkSound( iSound );
+	}
+}
+
+void CSoundEnt::AddBucketSounds( int iBucket, int iTypeMask, CUtlVector<int> &sounds )
+{
+	for ( int iSound = m_iBucketHead[ iBucket ]; iSound != SOUNDLIST_EMPTY; iSound = Sound( iSound ).m_iNextInBucket )
+	{
+		if ( Sound( iSound ).m_iType & iTypeMask )
+		{
+			sounds.AddToTail( iSound );
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Adds the active sounds of these types that may be heard from
+//			"earposition". A sound is never farther than its volume (times
+//			the sensitivity) so only the cells of each tier within that
+//			reach are visited.
+//-----------------------------------------------------------------------------
+void CSoundEnt::GetSoundsInRange( const Vector &vecEarPosition, float flHearingSensitivity, int iTypeMask, CUtlVector<int> &sounds )
+{
+	if ( !g_pSoundEnt )
+		return;
+
+	// Contexts can be added to sounds of any type
+	bool bAllClasses = ( iTypeMask & ALL_CONTEXTS ) != 0;
+
+	for ( int iTier = 0; iTier < SOUNDENT_TIERS; iTier++ )
+	{
+		float flCellSize = g_flSoundTierVolume[ iTier ];
+		float flReach = flCellSize * MAX( flHearingSensitivity, 0.0f );
+
+		int x0 = SoundCell( vecEarPosition.x - flReach, flCellSize );
+		int x1 = SoundCell( vecEarPosition.x + flReach, flCellSize );
+		int y0 = SoundCell( vecEarPosition.y - flReach, flCellSize );
+		int y1 = SoundCell( vecEarPosition.y + flReach, flCellSize );
+
+		// Very sensitive listeners just visit every cell
+		bool bAllCells = ( ( x1 - x0 + 1 ) * ( y1 - y0 + 1 ) ) >= SOUNDENT_CELL_HASH;
+
+		for ( int iClass = 0; iClass < SOUNDENT_TYPE_CLASSES; iClass++ )
+		{
+			if ( g_pSoundEnt->m_nBucketedSounds[ iTier ][ iClass ] == 0 )
+				continue;
+
+			if ( iClass > 0 && !bAllClasses && !( iTypeMask & ( 1 << ( iClass - 1 ) ) ) )
+				continue;
+
+			int iFirstBucket = ( ( iTier * SOUNDENT_TYPE_CLASSES ) + iClass ) * SOUNDENT_CELL_HASH;
+
+			if ( bAllCells )
+			{
+				for ( int iHash = 0; iHash < SOUNDENT_CELL_HASH; iHash++ )
+				{
+					g_pSoundEnt->AddBucketSounds( iFirstBucket + iHash, iTypeMask, sounds );
+				}
+
+				continue;
+			}
+
+			// different cells can share a bucket, visit it only once
+			uint64 visited = 0;
+
+			for ( int x = x0; x <= x1; x++ )
+			{
+				for ( int y = y0; y <= y1; y++ )
+				{
+					int iHash = SoundCellHash( x, y );
+
+					if ( visited & ( 1ull << iHash ) )
+						continue;
+
+					visited |= ( 1ull << iHash );
+					g_pSoundEnt->AddBucketSounds( iFirstBucket + iHash, iTypeMask, sounds );
+				}
+			}
+		}
+	}
+
+	g_pSoundEnt->AddBucketSounds( SOUNDENT_BUCKET_GLOBAL, iTypeMask, sounds );
+}
+
+//-----------------------------------------------------------------------------
+// Stress test of the sound list
+//-----------------------------------------------------------------------------
+static bool IsSoundInRange( CSound *pSound, const Vector &vecEarPosition, float flHearingSensitivity )
+{
+	float flHearDistanceSq = pSound->Volume() * flHearingSensitivity;
+	flHearDistanceSq *= flHearDistanceSq;
+
+	return ( pSound->GetSoundOrigin().DistToSqr( vecEarPosition ) <= flHearDistanceSq );
+}
+
+static int __cdecl SoundIndexCompare( const int *a, const int *b )
+{
+	return *a - *b;
+}
+
+CON_COMMAND_F( ai_sound_stress, "Inserts random sounds around the player and compares the bucketed sound queries with a walk of the active list. Arguments: [count] [radius] [duration]", FCVAR_CHEAT )
+{
+	if ( !g_pSoundEnt )
+		return;
+
+	int nCount = ( args.ArgC() > 1 ) ? atoi( args[1] ) : 2000;
+	float flRadius = ( args.ArgC() > 2 ) ? atof( args[2] ) : 8192.0f;
+	float flDuration = ( args.ArgC() > 3 ) ? atof( args[3] ) : 1.0f;
+
+	Vector vecCenter = vec3_origin;
+	CBasePlayer *pPlayer = UTIL_GetCommandClient();
+
+	if ( pPlayer )
+	{
+		vecCenter = pPlayer->GetAbsOrigin();
+	}
+
+	static const int soundTypes[] =
+	{
+		SOUND_COMBAT | SOUND_CONTEXT_GUNFIRE,
+		SOUND_DANGER | SOUND_CONTEXT_BULLET_IMPACT,
+		SOUND_PLAYER | SOUND_CONTEXT_FOOTSTEP,
+		SOUND_COMBAT,
+		SOUND_WORLD,
+		SOUND_DANGER,
+		SOUND_PHYSICS_DANGER,
+		SOUND_CARCASS,
+	};
+
+	static const int soundVolumes[] =
+	{
+		256,
+		512,
+		1024,
+		(int)SOUNDENT_VOLUME_PISTOL,
+		(int)SOUNDENT_VOLUME_MACHINEGUN,
+		(int)SOUNDENT_VOLUME_SHOTGUN,
+		8192,
+	};
+
+	int nDropped = g_pSoundEnt->GetDroppedSounds();
+
+	for ( int i = 0; i < nCount; i++ )
+	{
+		Vector vecOrigin = vecCenter + Vector( RandomFloat( -flRadius, flRadius ), RandomFloat( -flRadius, flRadius ), RandomFloat( -256.0f, 256.0f ) );
+		int iType = soundTypes[ RandomInt( 0, ARRAYSIZE( soundTypes ) - 1 ) ];
+		int iVolume = soundVolumes[ RandomInt( 0, ARRAYSIZE( soundVolumes ) - 1 ) ];
+
+		CSoundEnt::InsertSound( iType, vecOrigin, iVolume, flDuration * RandomFloat( 0.5f, 1.0f ) );
+	}
+
+	Msg( "Inserted %d sounds, %d dropped. Pool: %d sounds, %d active.\n", nCount, g_pSoundEnt->GetDroppedSounds() - nDropped, g_pSoundEnt->GetPoolSize(), g_pSoundEnt->ISoundsInList( SOUNDLISTTYPE_ACTIVE ) );
+
+	const int nQueries = 256;
+	int nErrors = 0;
+	int nHeard = 0;
+	double flBucketedTime = 0.0;
+	double flWalkTime = 0.0;
+
+	CUtlVector<int> bucketed;
+	CUtlVector<int> walked;
+
+	for ( int i = 0; i < nQueries; i++ )
+	{
+		Vector vecEar = vecCenter + Vector( RandomFloat( -flRadius, flRadius ), RandomFloat( -flRadius, flRadius ), 64.0f );
+		float flSensitivity = RandomFloat( 0.5f, 2.0f );
+		int iTypeMask = ( i & 1 ) ? ALL_SOUNDS : ( SOUND_COMBAT | SOUND_DANGER );
+
+		double flStart = Plat_FloatTime();
+
+		bucketed.RemoveAll();
+		CSoundEnt::GetSoundsInRange( vecEar, flSensitivity, iTypeMask, bucketed );
+
+		for ( int j = bucketed.Count() - 1; j >= 0; j-- )
+		{
+			if ( !IsSoundInRange( CSoundEnt::SoundPointerForIndex( bucketed[j] ), vecEar, flSensitivity ) )
+				bucketed.FastRemove( j );
+		}
+
+		flBucketedTime += Plat_FloatTime() - flStart;
+		flStart = Plat_FloatTime();
+
+		walked.RemoveAll();
+
+		for ( int iSound = CSoundEnt::ActiveList(); iSound != SOUNDLIST_EMPTY; iSound = CSoundEnt::SoundPointerForIndex( iSound )->NextSound() )
+		{
+			CSound *pSound = CSoundEnt::SoundPointerForIndex( iSound );
+
+			if ( ( pSound->SoundType() & iTypeMask ) && IsSoundInRange( pSound, vecEar, flSensitivity ) )
+				walked.AddToTail( iSound );
+		}
+
+		flWalkTime += Plat_FloatTime() - flStart;
+
+		bucketed.Sort( SoundIndexCompare );
+		walked.Sort( SoundIndexCompare );
+
+		bool bSame = ( bucketed.Count() == walked.Count() );
+
+		for ( int j = 0; bSame && j < walked.Count(); j++ )
+		{
+			bSame = ( bucketed[j] == walked[j] );
+		}
+
+		if ( !bSame )
+			++nErrors;
+
+		nHeard += walked.Count();
+	}
+
+	Msg( "%d queries (%d sounds heard), %d with different results. Buckets: %.3f ms, active list: %.3f ms.\n", nQueries, nHeard, nErrors, flBucketedTime * 1000.0, flWalkTime * 1000.0 );
+}
+
+
 //-----------------------------------------------------------------------------
 // Purpose: Inserts an AI sound into the world sound list.
 //-----------------------------------------------------------------------------
@@ -21,7 +21,32 @@ enum
 	MAX_WORLD_SOUNDS_SP	= 64,	// Maximum number of sounds handled by the world at one time in single player.
 	// This is also the number of entries saved in a savegame file (for b/w compatibility).
 
-	MAX_WORLD_SOUNDS_MP	= 128	// The sound array size is set this large but we'll only use gpGlobals->maxPlayers+32 entries in mp.
+	MAX_WORLD_SOUNDS_MP	= 128,	// The sound array size is set this large but we'll only use gpGlobals->maxPlayers+32 entries in mp.
+
+	// In mp the pool grows in blocks of MAX_WORLD_SOUNDS_MP when it is full (never in sp, see MAX_WORLD_SOUNDS_SP)
+	MAX_WORLD_SOUND_BLOCKS = 64,
+	MAX_WORLD_SOUNDS_GROWN = MAX_WORLD_SOUNDS_MP * MAX_WORLD_SOUND_BLOCKS
+};
+
+//-----------------------------------------------------------------------------
+// Active sounds are also bucketed so listeners only visit the ones that may
+// reach them: by volume tier (the cell size of the tier is its max volume),
+// by XY cell and by sound type. Louder sounds, sounds that follow their owner
+// and the reserved client sounds are kept in a single global bucket.
+//-----------------------------------------------------------------------------
+enum
+{
+	SOUNDENT_TIERS			= 2,
+	SOUNDENT_TYPE_CLASSES	= 10,	// one for each sound type bit, 0 for sounds with none or more than one
+	SOUNDENT_CELL_HASH		= 64,	// must be <= 64, a query tracks the visited cells in a 64 bit mask
+
+	SOUNDENT_BUCKET_GLOBAL	= SOUNDENT_TIERS * SOUNDENT_TYPE_CLASSES * SOUNDENT_CELL_HASH,
+	SOUNDENT_NUM_BUCKETS
+};
+
+enum
+{
+	SOUNDBUCKET_NONE = -1
 };
 
 enum
@@ -129,6 +154,9 @@ private:
 
 	float	m_flExpireTime;	// when the sound should be purged from the list
 	short	m_iNext;		// index of next sound in this list ( Active or Free )
+	short	m_iBucket;		// bucket of the active sound (not saved, rebuilt on restore)
+	short	m_iNextInBucket;
+	short	m_iPrevInBucket;
 	bool	m_bNoExpirationTime;
 	int		m_ownerChannelIndex;
 
@@ -229,19 +257,43 @@ public:
 	static int		ClientSoundIndex ( edict_t *pClient );
 	static void		FreeSound( int iSound );
 
+	// Adds the active sounds of these types that may be heard from this position,
+	// the caller still has to check the distance against the volume of each one.
+	static void		GetSoundsInRange( const Vector &vecEarPosition, float flHearingSensitivity, int iTypeMask, CUtlVector<int> &sounds );
+
 	bool	IsEmpty( void );
 	int		ISoundsInList ( int iListType );
 	int		IAllocSound ( void );
 	int		FindOrAllocateSound( CBaseEntity *pOwner, int soundChannelIndex );
+
+	int		GetPoolSize( void ) const { return MAX_WORLD_SOUNDS_MP * ( m_nExtraBlocks + 1 ); }
+	int		GetDroppedSounds( void ) const { return m_nDroppedSounds; }
 	
 private:
 	static void		FreeSound ( int iSound, int iPrevious );
 	static int		FreeList( void );// return the head of the free list
 
+	CSound	&Sound( int iSound );
+	bool	GrowPool( void );
+	void	FreeExtraBlocks( void );
+
+	int		GetSoundBucket( int iSound );
+	void	LinkSound( int iSound );
+	void	UnlinkSound( int iSound );
+	void	RebuildBuckets( void );
+	void	AddBucketSounds( int iBucket, int iTypeMask, CUtlVector<int> &sounds );
+
 	int		m_iFreeSound;	// index of the first sound in the free sound list
 	int		m_iActiveSound; // indes of the first sound in the active sound list
 	int		m_cLastActiveSounds; // keeps track of the number of active sounds at the last update. (for diagnostic work)
 	CSound	m_SoundPool[ MAX_WORLD_SOUNDS_MP ];
+
+	CSound	*m_pExtraBlocks[ MAX_WORLD_SOUND_BLOCKS - 1 ];
+	int		m_nExtraBlocks;
+	int		m_nDroppedSounds;
+
+	short	m_iBucketHead[ SOUNDENT_NUM_BUCKETS ];
+	int		m_nBucketedSounds[ SOUNDENT_TIERS ][ SOUNDENT_TYPE_CLASSES ];
 };
 
 
@@ -253,5 +305,13 @@ inline bool CSoundEnt::IsEmpty( void )
 	return m_iActiveSound == SOUNDLIST_EMPTY; 
 }
 
+inline CSound &CSoundEnt::Sound( int iSound )
+{
+	if ( iSound < MAX_WORLD_SOUNDS_MP )
+		return m_SoundPool[ iSound ];
+
+	return m_pExtraBlocks[ ( iSound / MAX_WORLD_SOUNDS_MP ) - 1 ][ iSound % MAX_WORLD_SOUNDS_MP ];
+}
+
 
 #endif //SOUNDENT_H
@@ -647,6 +647,16 @@ CON_COMMAND( rr_reloadresponsesystems, "Reload all response system scripts." )
 	defaultresponsesytem.ReloadAllResponseSystems();
 }
 
+CON_COMMAND( rr_benchmark, "Replay the criteria sets recorded with rr_benchmark_record against the default response system. Usage: rr_benchmark [iterations]" )
+{
+#ifdef GAME_DLL
+	if ( !UTIL_IsCommandIssuedByServerAdmin() )
+		return;
+#endif
+
+	defaultresponsesytem.Benchmark( args.ArgC() > 1 ? atoi( args[1] ) : 100 );
+}
+
 static short RESPONSESYSTEM_SAVE_RESTORE_VERSION = 1;
 
 // note:  this won't save/restore settings from instanced response systems.  Could add that with a CDefSaveRestoreOps implementation if needed
@@ -16,6 +16,8 @@
 #include "npcevent.h"
 #include "eventlist.h"
 #include "tier0/vprof.h"
+#include "tier1/generichash.h"
+#include "utlmap.h"
 
 #if !defined( CLIENT_DLL ) && !defined( MAKEXVCD )
 #include "util.h"
@@ -468,6 +470,171 @@ void GetEyePosition ( CStudioHdr *pstudiohdr, Vector &vecEyePosition )
 }
 
 
+//-----------------------------------------------------------------------------
+// Name lookup tables. Every CStudioHdr of the same model shares them (they are
+// keyed by the studiohdr_t), they are all built under the lock the first time
+// a name is looked up in the model and the CStudioHdr keeps a pointer to them,
+// after that the lookups don't lock. Open addressing on the caseless hash of
+// the names, a slot holds the index of the first entry with that name, like
+// the linear searches.
+//-----------------------------------------------------------------------------
+enum
+{
+	STUDIO_NAMES_SEQUENCE = 0,
+	STUDIO_NAMES_ACTIVITY,
+	STUDIO_NAMES_ATTACHMENT,
+	STUDIO_NAMES_POSE_PARAMETER,
+
+	STUDIO_NAMES_COUNT
+};
+
+struct StudioNameIndex_t
+{
+	long checksum;
+	char name[64];
+	virtualmodel_t *pVModel;
+	CUtlVector<short> slots[STUDIO_NAMES_COUNT];
+};
+
+static CUtlMap<const studiohdr_t *, StudioNameIndex_t *> g_StudioNameIndices( DefLessFunc( const studiohdr_t * ) );
+static CThreadFastMutex g_StudioNameIndicesLock;
+
+// replaced indices are never freed, a CStudioHdr (or another thread) may still point to them
+static CUtlVector<StudioNameIndex_t *> g_RetiredStudioNameIndices;
+
+static int GetStudioNameCount( CStudioHdr *pstudiohdr, int nTable )
+{
+	switch ( nTable )
+	{
+	case STUDIO_NAMES_SEQUENCE:
+	case STUDIO_NAMES_ACTIVITY:
+		return pstudiohdr->GetNumSeq();
+
+	case STUDIO_NAMES_ATTACHMENT:
+		return pstudiohdr->GetNumAttachments();
+
+	default:
+		return pstudiohdr->GetNumPoseParameters();
+	}
+}
+
+static const char *GetStudioName( CStudioHdr *pstudiohdr, int nTable, int i )
+{
+	switch ( nTable )
+	{
+	case STUDIO_NAMES_SEQUENCE:
+		return pstudiohdr->pSeqdesc( i ).pszLabel();
+
+	case STUDIO_NAMES_ACTIVITY:
+		return pstudiohdr->pSeqdesc( i ).pszActivityName();
+
+	case STUDIO_NAMES_ATTACHMENT:
+		return pstudiohdr->pAttachment( i ).pszName();
+
+	default:
+		return pstudiohdr->pPoseParameter( i ).pszName();
+	}
+}
+
+static void BuildStudioNameTable( CStudioHdr *pstudiohdr, int nTable, CUtlVector<short> &slots )
+{
+	int nCount = GetStudioNameCount( pstudiohdr, nTable );
+
+	// at most half full
+	int nSlots = 4;
+	while ( nSlots < nCount * 2 )
+	{
+		nSlots <<= 1;
+	}
+
+	slots.SetCount( nSlots );
+	for ( int i = 0; i < nSlots; i++ )
+	{
+		slots[i] = -1;
+	}
+
+	unsigned int mask = nSlots - 1;
+	for ( int i = 0; i < nCount; i++ )
+	{
+		const char *pszName = GetStudioName( pstudiohdr, nTable, i );
+
+		unsigned int slot = HashStringCaseless( pszName ) & mask;
+		while ( slots[slot] != -1 && stricmp( GetStudioName( pstudiohdr, nTable, slots[slot] ), pszName ) != 0 )
+		{
+			slot = ( slot + 1 ) & mask;
+		}
+
+		// keep the first one with this name
+		if ( slots[slot] == -1 )
+		{
+			slots[slot] = i;
+		}
+	}
+}
+
+static bool IsStudioNameIndexValid( const StudioNameIndex_t *pIndex, CStudioHdr *pstudiohdr )
+{
+	const studiohdr_t *pRealHdr = pstudiohdr->GetRenderHdr();
+	return ( pIndex->checksum == pRealHdr->checksum && pIndex->pVModel == pstudiohdr->GetVirtualModel() && Q_strcmp( pIndex->name, pRealHdr->name ) == 0 );
+}
+
+static StudioNameIndex_t *GetStudioNameIndex( CStudioHdr *pstudiohdr )
+{
+	// the common case, no lock. Init() clears the pointer, only the includes can change
+	StudioNameIndex_t *pIndex = pstudiohdr->m_pNameIndex;
+	if ( pIndex && pIndex->pVModel == pstudiohdr->GetVirtualModel() )
+		return pIndex;
+
+	AUTO_LOCK( g_StudioNameIndicesLock );
+
+	const studiohdr_t *pRealHdr = pstudiohdr->GetRenderHdr();
+
+	unsigned short i = g_StudioNameIndices.Find( pRealHdr );
+	if ( i != g_StudioNameIndices.InvalidIndex() )
+	{
+		pIndex = g_StudioNameIndices[i];
+		if ( IsStudioNameIndexValid( pIndex, pstudiohdr ) )
+		{
+			pstudiohdr->m_pNameIndex = pIndex;
+			return pIndex;
+		}
+
+		// the model was unloaded and something else took its place, or the includes changed
+		g_RetiredStudioNameIndices.AddToTail( pIndex );
+		g_StudioNameIndices.RemoveAt( i );
+	}
+
+	pIndex = new StudioNameIndex_t;
+	pIndex->checksum = pRealHdr->checksum;
+	Q_strncpy( pIndex->name, pRealHdr->name, sizeof( pIndex->name ) );
+	pIndex->pVModel = pstudiohdr->GetVirtualModel();
+
+	// every table is built before anyone else can see the index, it is read only after that
+	for ( int nTable = 0; nTable < STUDIO_NAMES_COUNT; nTable++ )
+	{
+		BuildStudioNameTable( pstudiohdr, nTable, pIndex->slots[nTable] );
+	}
+
+	g_StudioNameIndices.Insert( pRealHdr, pIndex );
+	pstudiohdr->m_pNameIndex = pIndex;
+	return pIndex;
+}
+
+static int FindStudioName( CStudioHdr *pstudiohdr, int nTable, const char *pszName )
+{
+	const CUtlVector<short> &slots = GetStudioNameIndex( pstudiohdr )->slots[nTable];
+
+	unsigned int mask = slots.Count() - 1;
+	for ( unsigned int slot = HashStringCaseless( pszName ) & mask; slots[slot] != -1; slot = ( slot + 1 ) & mask )
+	{
+		if ( stricmp( GetStudioName( pstudiohdr, nTable, slots[slot] ), pszName ) == 0 )
+			return slots[slot];
+	}
+
+	return -1;
+}
+
+
 //-----------------------------------------------------------------------------
 // Purpose: Looks up an activity by name.
 // Input  : label - Name of the activity to look up, ie "ACT_IDLE"
@@ -482,13 +649,10 @@ int LookupActivity( CStudioHdr *pstudiohdr, const char *label )
 		return 0;
 	}
 
-	for ( int i = 0; i < pstudiohdr->GetNumSeq(); i++ )
+	int iSequence = FindStudioName( pstudiohdr, STUDIO_NAMES_ACTIVITY, label );
+	if ( iSequence != -1 )
 	{
-		mstudioseqdesc_t &seqdesc = pstudiohdr->pSeqdesc( i );
-		if ( stricmp( seqdesc.pszActivityName(), label ) == 0 )
-		{
-			return seqdesc.activity;
-		}
+		return pstudiohdr->pSeqdesc( iSequence ).activity;
 	}
 
 	return ACT_INVALID;
@@ -513,12 +677,9 @@ int LookupSequence( CStudioHdr *pstudiohdr, const char *label )
 	//
 	// Look up by sequence name.
 	//
-	for (int i = 0; i < pstudiohdr->GetNumSeq(); i++)
-	{
-		mstudioseqdesc_t	&seqdesc = pstudiohdr->pSeqdesc( i );
-		if (stricmp( seqdesc.pszLabel(), label ) == 0)
-			return i;
-	}
+	int iSequence = FindStudioName( pstudiohdr, STUDIO_NAMES_SEQUENCE, label );
+	if ( iSequence != -1 )
+		return iSequence;
 
 	//
 	// Not found, look up by activity name.
@@ -532,6 +693,30 @@ int LookupSequence( CStudioHdr *pstudiohdr, const char *label )
 	return ACT_INVALID;
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: Looks up an attachment by name, same as Studio_FindAttachment.
+// Output : Returns the attachment index (0 based), or -1 if not found.
+//-----------------------------------------------------------------------------
+int LookupAttachment( CStudioHdr *pstudiohdr, const char *pAttachmentName )
+{
+	if ( !pstudiohdr || !pstudiohdr->SequencesAvailable() )
+		return -1;
+
+	return FindStudioName( pstudiohdr, STUDIO_NAMES_ATTACHMENT, pAttachmentName );
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Looks up a pose parameter by name.
+// Output : Returns the pose parameter index, or -1 if not found.
+//-----------------------------------------------------------------------------
+int LookupPoseParameter( CStudioHdr *pstudiohdr, const char *szName )
+{
+	if ( !pstudiohdr )
+		return -1;
+
+	return FindStudioName( pstudiohdr, STUDIO_NAMES_POSE_PARAMETER, szName );
+}
+
 void GetSequenceLinearMotion( CStudioHdr *pstudiohdr, int iSequence, const float poseParameter[], Vector *pVec )
 {
 	if (! pstudiohdr)
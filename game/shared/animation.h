@@ -36,6 +36,8 @@ void GetEyePosition( CStudioHdr *pstudiohdr, Vector &vecEyePosition );
 
 int LookupActivity( CStudioHdr *pstudiohdr, const char *label );
 int LookupSequence( CStudioHdr *pstudiohdr, const char *label );
+int LookupAttachment( CStudioHdr *pstudiohdr, const char *pAttachmentName );
+int LookupPoseParameter( CStudioHdr *pstudiohdr, const char *szName );
 
 #define NOMOTION 99999
 void GetSequenceLinearMotion( CStudioHdr *pstudiohdr, int iSequence, const float poseParameter[], Vector *pVec );
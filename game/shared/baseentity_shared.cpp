@@ -433,7 +433,7 @@ bool CBaseEntity::KeyValue( const char *szKeyName, const char *szValue )
 	
 	if ( FStrEq( szKeyName, "targetname" ) )
 	{
-		m_iName = AllocPooledString( szValue );
+		SetName( AllocPooledString( szValue ) );
 		return true;
 	}
 
@@ -2520,7 +2520,7 @@ void CBaseEntity::ModifyOrAppendCriteria( AI_CriteriaSet& set )
 	// TODO
 	// Append chapter/day?
 
-	set.AppendCriteria( "randomnum", UTIL_VarArgs("%d", RandomInt(0,100)) );
+	set.AppendCriteriaInt( "randomnum", RandomInt(0,100) );
 	
 	// Append our classname and game name
 	set.AppendCriteria( "classname", GetClassname() );
@@ -2536,7 +2536,7 @@ void CBaseEntity::ModifyOrAppendCriteria( AI_CriteriaSet& set )
 	set.AppendCriteria( "name", pEntityName );
 
 	// Append our health
-	set.AppendCriteria( "health", UTIL_VarArgs( "%i", GetHealth() ) );
+	set.AppendCriteriaInt( "health", GetHealth() );
 
 	float healthfrac = 0.0f;
 	if ( GetMaxHealth() > 0 )
@@ -2553,7 +2553,7 @@ void CBaseEntity::ModifyOrAppendCriteria( AI_CriteriaSet& set )
 	{
 		const char *szGlobalName = GlobalEntity_GetName(i);
 		int iGlobalState = (int)GlobalEntity_GetStateByIndex(i);
-		set.AppendCriteria( szGlobalName, UTIL_VarArgs( "%i", iGlobalState ) );
+		set.AppendCriteriaInt( szGlobalName, iGlobalState );
 	}
 
 	// Append map name
@@ -1388,6 +1388,12 @@ void CCollisionProperty::UpdateServerPartitionMask( )
 //-----------------------------------------------------------------------------
 void CCollisionProperty::MarkPartitionHandleDirty()
 {
+#ifndef CLIENT_DLL
+	// the entity list grid keeps its own dirty list, the engine partition
+	// flag is only cleared when the partition gets updated
+	gEntList.MarkEntityGridDirty( m_pOuter );
+#endif
+
 	if ( !m_pOuter->IsEFlagSet( EFL_DIRTY_SPATIAL_PARTITION ) )
 	{
 		s_DirtyKDTree.AddEntity( m_pOuter );
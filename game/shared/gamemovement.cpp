@@ -708,6 +708,8 @@ CGameMovement::CGameMovement( void )
 
 	memset( m_flStuckCheckTime, 0, sizeof(m_flStuckCheckTime) );
 	m_pTraceListData = NULL;
+	m_nTraceCount = 0;
+	m_nTraceListMisses = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -905,11 +907,10 @@ inline void CGameMovement::TracePlayerBBox( const Vector& start, const Vector& e
 
 CBaseHandle CGameMovement::TestPlayerPosition( const Vector& pos, int collisionGroup, trace_t& pm )
 {
-	++m_nTraceCount;
 	Ray_t ray;
 	ray.Init( pos, pos, GetPlayerMins(), GetPlayerMaxs() );
 	ITraceFilter *filter = LockTraceFilter( collisionGroup );
-	UTIL_TraceRay( ray, PlayerSolidMask(), filter, &pm );
+	TraceMovementRay( ray, PlayerSolidMask(), filter, &pm );
 	UnlockTraceFilter( filter );
 	if ( (pm.contents & PlayerSolidMask()) && pm.m_pEnt )
 		return pm.m_pEnt->GetRefEHandle();
@@ -1270,15 +1271,21 @@ void CGameMovement::SetupMovementBounds( CMoveData *move )
 	Vector moveMins, moveMaxs;
 	ClearBounds( moveMins, moveMaxs );
 	Vector start = move->GetAbsOrigin();
-	float radius = ((move->m_vecVelocity.Length() + move->m_flMaxSpeed) * gpGlobals->frametime) + 1.0f;
+	float speed = move->m_vecVelocity.Length() + move->m_flMaxSpeed + pPlayer->GetBaseVelocity().Length();
+	float radius = (speed * gpGlobals->frametime) + 1.0f;
 	// NOTE: assumes the unducked bbox encloses the ducked bbox
 	Vector boxMins = GetPlayerMins(false);
 	Vector boxMaxs = GetPlayerMaxs(false);
 
-	// bloat by traveling the max velocity in all directions, plus the stepsize up/down
+	// bloat by traveling the max velocity in all directions, plus the stepsize up/down.
+	// A jump this command and the origin shift of ducking/unducking in the air
+	// would otherwise push the traces out of the list every time.
+	float jumpSpeed = sqrt( 2.0f * sv_gravity.GetFloat() * GAMEMOVEMENT_JUMP_HEIGHT );
+	float duckShift = GetPlayerMaxs(false).z - GetPlayerMaxs(true).z;
+
 	Vector bloat;
 	bloat.Init(radius, radius, radius);
-	bloat.z += pPlayer->m_Local.m_flStepSize;
+	bloat.z += pPlayer->m_Local.m_flStepSize + (jumpSpeed * gpGlobals->frametime) + duckShift;
 	AddPointToBounds( start + boxMaxs + bloat, moveMins, moveMaxs );
 	AddPointToBounds( start + boxMins - bloat, moveMins, moveMaxs );
 	// now build an optimized trace within these bounds
@@ -1292,6 +1299,7 @@ void CGameMovement::SetupMovementBounds( CMoveData *move )
 void CGameMovement::ProcessMovement( CBasePlayer *pPlayer, CMoveData *pMove )
 {
 	m_nTraceCount = 0;
+	m_nTraceListMisses = 0;
 
 	Assert( pMove && pPlayer );
 
@@ -1339,6 +1347,7 @@ void CGameMovement::ProcessMovement( CBasePlayer *pPlayer, CMoveData *pMove )
 	if ( !player->IsBot() )
 	{
 		VPROF_INCREMENT_COUNTER( "PlayerMovementTraces", m_nTraceCount );
+		VPROF_INCREMENT_COUNTER( "PlayerMovementTraceListMisses", m_nTraceListMisses );
 	}
 #endif
 }
@@ -57,6 +57,10 @@ public:
 	// wrapper around tracehull to allow tracelistdata optimizations
 	void			GameMovementTraceHull( const Vector& start, const Vector& end, const Vector &mins, const Vector &maxs, unsigned int fMask, ITraceFilter *pFilter, trace_t *pTrace );
 
+	// every movement trace goes through here, against the list built in SetupMovementBounds
+	// when the ray fits in it and against the whole world otherwise
+	void			TraceMovementRay( const Ray_t &ray, unsigned int fMask, ITraceFilter *pFilter, trace_t *pTrace );
+
 #define BRUSH_ONLY true
 	virtual unsigned int PlayerSolidMask( bool brushOnly = false, CBasePlayer *testPlayer = NULL ) const;	///< returns the solid mask for the given player, so bots can have a more-restrictive set
 	CBasePlayer		*player;
@@ -278,6 +282,7 @@ public:
 	ITraceListData	*m_pTraceListData;
 
 	int				m_nTraceCount;
+	int				m_nTraceListMisses;
 };
 
 
@@ -286,34 +291,33 @@ public:
 //-----------------------------------------------------------------------------
 inline void CGameMovement::TracePlayerBBox( const Vector& start, const Vector& end, unsigned int fMask, int collisionGroup, trace_t& pm )
 {
-	++m_nTraceCount;
 	VPROF( "CGameMovement::TracePlayerBBox" );
 
 	Ray_t ray;
 	ray.Init( start, end, GetPlayerMins(), GetPlayerMaxs() );
 	ITraceFilter *pFilter = LockTraceFilter( collisionGroup );
-	if ( m_pTraceListData && m_pTraceListData->CanTraceRay(ray) )
-	{
-		enginetrace->TraceRayAgainstLeafAndEntityList( ray, m_pTraceListData, fMask, pFilter, &pm );
-	}
-	else
-	{
-		enginetrace->TraceRay( ray, fMask, pFilter, &pm );
-	}
+	TraceMovementRay( ray, fMask, pFilter, &pm );
 	UnlockTraceFilter( pFilter );
 }
 
 inline void CGameMovement::GameMovementTraceHull( const Vector& start, const Vector& end, const Vector &mins, const Vector &maxs, unsigned int fMask, ITraceFilter *pFilter, trace_t *pTrace )
 {
-	++m_nTraceCount;
 	Ray_t ray;
 	ray.Init( start, end, mins, maxs );
+	TraceMovementRay( ray, fMask, pFilter, pTrace );
+}
+
+inline void CGameMovement::TraceMovementRay( const Ray_t &ray, unsigned int fMask, ITraceFilter *pFilter, trace_t *pTrace )
+{
+	++m_nTraceCount;
 	if ( m_pTraceListData && m_pTraceListData->CanTraceRay(ray) )
 	{
 		enginetrace->TraceRayAgainstLeafAndEntityList( ray, m_pTraceListData, fMask, pFilter, pTrace );
 	}
 	else
 	{
+		// left the gathered bounds (teleports, water jumps, unsticking...)
+		++m_nTraceListMisses;
 		enginetrace->TraceRay( ray, fMask, pFilter, pTrace );
 	}
 }
@@ -80,7 +80,9 @@ extern ConVar aimcrosshair;
 extern ConVar footsteps;
 extern ConVar flashlight;
 extern ConVar allowNPCs;
-//extern ConVar sv_alltalk;
+#ifndef CLIENT_DLL
+extern ConVar sv_alltalk;
+#endif
 extern ConVar friendlyfire;
 
 #ifndef CLIENT_DLL
@@ -90,26 +92,185 @@ extern ConVar sk_player_stomach;
 extern ConVar sk_player_arm;
 extern ConVar sk_player_leg;
 
+#define VOICE_PROXIMITY_BUCKETS 64
+
+//====================================================================
+//====================================================================
+CVoiceGameMgrHelper::CVoiceGameMgrHelper()
+{
+    m_iUpdateTick = -1;
+    m_bAllTalk = false;
+    m_bDeathToDeath = false;
+    m_bProximity = false;
+
+    // Lo forzamos a construir las rutas la primera vez
+    for ( int it = 0; it < ABSOLUTE_PLAYER_LIMIT; ++it )
+        m_iPlayerState[it] = -1;
+}
+
 //====================================================================
+// El administrador de voz pregunta por cada par de jugadores,
+// la respuesta sale de la matriz que se reconstruye solo cuando
+// algn jugador cambia de equipo, muere/revive o cambian los comandos
 //====================================================================
 bool CVoiceGameMgrHelper::CanPlayerHearPlayer( CBasePlayer *pListener, CBasePlayer *pTalker, bool &bProximity )
 {
-    ConVarRef sv_alltalk("sv_alltalk");
+    Update();
 
-    // El chat no es global y no son del mismo equipo
-    if ( !sv_alltalk.GetBool() && !pTalker->InSameTeam(pListener) )
+    int listener = pListener->entindex() - 1;
+    int talker = pTalker->entindex() - 1;
+
+    bProximity = false;
+
+    if ( !m_Routes[listener].IsBitSet(talker) )
         return false;
 
-    // El hablante esta muerto
-    if ( !pTalker->IsAlive() ) {
-        // Solo podemos hablar a los muertos y el escucha esta vivo
-        if ( sv_voice_death_to_death.GetBool() && pListener->IsAlive() )
+    // Por distancia, solo entre los vivos
+    if ( m_bProximity && pListener->IsAlive() && pTalker->IsAlive() ) {
+        if ( !m_InRange[listener].IsBitSet(talker) )
             return false;
+
+        bProximity = true;
     }
 
     return true;
 }
 
+//====================================================================
+// Una vez por tick: verifica si las rutas siguen siendo validas
+//====================================================================
+void CVoiceGameMgrHelper::Update()
+{
+    if ( m_iUpdateTick == gpGlobals->tickcount )
+        return;
+
+    m_iUpdateTick = gpGlobals->tickcount;
+
+    bool bChanged = ( m_bAllTalk != sv_alltalk.GetBool() || m_bDeathToDeath != sv_voice_death_to_death.GetBool() );
+
+    for ( int it = 1; it <= gpGlobals->maxClients; ++it ) {
+        CBasePlayer *pPlayer = UTIL_PlayerByIndex( it );
+        int state = 0;
+
+        if ( pPlayer )
+            state = 1 | (pPlayer->IsAlive() << 1) | (pPlayer->GetTeamNumber() << 2);
+
+        if ( m_iPlayerState[it - 1] != state ) {
+            m_iPlayerState[it - 1] = state;
+            bChanged = true;
+        }
+    }
+
+    if ( bChanged )
+        BuildRoutes();
+
+    // Las posiciones cambian todo el tiempo
+    m_bProximity = ( sv_voice_proximity.GetFloat() > 0.0f );
+
+    if ( m_bProximity )
+        BuildProximity( sv_voice_proximity.GetFloat() );
+}
+
+//====================================================================
+// Construye la matriz de quien puede escuchar a quien
+//====================================================================
+void CVoiceGameMgrHelper::BuildRoutes()
+{
+    m_bAllTalk = sv_alltalk.GetBool();
+    m_bDeathToDeath = sv_voice_death_to_death.GetBool();
+
+    for ( int listener = 1; listener <= gpGlobals->maxClients; ++listener ) {
+        CPlayerBitVec &routes = m_Routes[listener - 1];
+        routes.ClearAll();
+
+        CBasePlayer *pListener = UTIL_PlayerByIndex( listener );
+
+        if ( !pListener )
+            continue;
+
+        for ( int talker = 1; talker <= gpGlobals->maxClients; ++talker ) {
+            CBasePlayer *pTalker = UTIL_PlayerByIndex( talker );
+
+            if ( !pTalker )
+                continue;
+
+            // El chat no es global y no son del mismo equipo
+            if ( !m_bAllTalk && !pTalker->InSameTeam(pListener) )
+                continue;
+
+            // El hablante esta muerto
+            if ( !pTalker->IsAlive() ) {
+                // Solo podemos hablar a los muertos y el escucha esta vivo
+                if ( m_bDeathToDeath && pListener->IsAlive() )
+                    continue;
+            }
+
+            routes.Set( talker - 1 );
+        }
+    }
+}
+
+//====================================================================
+// Chat de voz por distancia: los jugadores vivos se reparten en
+// una rejilla con celdas del tamao de la distancia, cada escucha
+// solo revisa su celda y las 8 vecinas
+//====================================================================
+void CVoiceGameMgrHelper::BuildProximity( float flDistance )
+{
+    int head[VOICE_PROXIMITY_BUCKETS];
+    int next[ABSOLUTE_PLAYER_LIMIT];
+    int cellX[ABSOLUTE_PLAYER_LIMIT];
+    int cellY[ABSOLUTE_PLAYER_LIMIT];
+
+    for ( int it = 0; it < VOICE_PROXIMITY_BUCKETS; ++it )
+        head[it] = -1;
+
+    for ( int it = 1; it <= gpGlobals->maxClients; ++it ) {
+        m_InRange[it - 1].ClearAll();
+
+        CBasePlayer *pPlayer = UTIL_PlayerByIndex( it );
+
+        if ( !pPlayer || !pPlayer->IsAlive() )
+            continue;
+
+        int index = it - 1;
+        cellX[index] = (int)floorf( pPlayer->GetAbsOrigin().x / flDistance );
+        cellY[index] = (int)floorf( pPlayer->GetAbsOrigin().y / flDistance );
+
+        int bucket = ((cellX[index] * 73856093) ^ (cellY[index] * 19349663)) & (VOICE_PROXIMITY_BUCKETS - 1);
+        next[index] = head[bucket];
+        head[bucket] = index;
+    }
+
+    float flDistanceSqr = flDistance * flDistance;
+
+    for ( int it = 1; it <= gpGlobals->maxClients; ++it ) {
+        CBasePlayer *pListener = UTIL_PlayerByIndex( it );
+
+        if ( !pListener || !pListener->IsAlive() )
+            continue;
+
+        int listener = it - 1;
+
+        for ( int x = cellX[listener] - 1; x <= cellX[listener] + 1; ++x ) {
+            for ( int y = cellY[listener] - 1; y <= cellY[listener] + 1; ++y ) {
+                int bucket = ((x * 73856093) ^ (y * 19349663)) & (VOICE_PROXIMITY_BUCKETS - 1);
+
+                for ( int talker = head[bucket]; talker != -1; talker = next[talker] ) {
+                    // Otra celda en la misma cubeta
+                    if ( cellX[talker] != x || cellY[talker] != y )
+                        continue;
+
+                    CBasePlayer *pTalker = UTIL_PlayerByIndex( talker + 1 );
+
+                    if ( pListener->GetAbsOrigin().DistToSqr(pTalker->GetAbsOrigin()) <= flDistanceSqr )
+                        m_InRange[listener].Set( talker );
+                }
+            }
+        }
+    }
+}
+
 // Ayudante de voz
 CVoiceGameMgrHelper g_VoiceGameMgrHelper;
 IVoiceGameMgrHelper *g_pVoiceGameMgrHelper = &g_VoiceGameMgrHelper;
@@ -43,7 +43,29 @@ class CVoiceGameMgrHelper : public IVoiceGameMgrHelper
     //DECLARE_CLASS( CVoiceGameMgrHelper, IVoiceGameMgrHelper );
 
 public:
+    CVoiceGameMgrHelper();
+
     virtual bool CanPlayerHearPlayer( CBasePlayer *, CBasePlayer *, bool & );
+
+protected:
+    virtual void Update();
+    virtual void BuildRoutes();
+    virtual void BuildProximity( float flDistance );
+
+protected:
+    int m_iUpdateTick;
+
+    // Estado de cada jugador (equipo, vida) y de los comandos al construir las rutas
+    int m_iPlayerState[ABSOLUTE_PLAYER_LIMIT];
+    bool m_bAllTalk;
+    bool m_bDeathToDeath;
+
+    // [escucha][hablante]
+    CPlayerBitVec m_Routes[ABSOLUTE_PLAYER_LIMIT];
+
+    // Chat de voz por distancia: hablantes vivos que estan cerca del escucha
+    bool m_bProximity;
+    CPlayerBitVec m_InRange[ABSOLUTE_PLAYER_LIMIT];
 };
 #endif
 
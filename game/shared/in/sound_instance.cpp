@@ -8,6 +8,7 @@
 #endif
 
 #include "sound_instance_manager.h"
+#include "sound_manager.h"
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
@@ -65,6 +66,10 @@ CSoundInstance::~CSoundInstance()
         delete m_nTagSound;
     }
 
+    if ( m_pManager ) {
+        m_pManager->Remove( this );
+    }
+
     TheSoundSystem->Remove( this );
 }
 
@@ -82,8 +87,11 @@ void CSoundInstance::Setup( SoundInfo *info, CSoundInstance *master )
     m_nTagSound = info->tag;
     m_bIsTag = false;
     m_iChannel = info->channel;
+    m_iCue = SOUND_CUE_NONE;
+    m_pManager = NULL;
     m_nOwner = info->owner.Get();
     m_bStopOnFinish = !m_bIsLoop;
+    m_iRecipientsSerial = -1;
 
     TheSoundSystem->Add( this );
     CBaseEntity::PrecacheScriptSound( m_nSoundName );
@@ -194,6 +202,10 @@ float CSoundInstance::GetDesire()
         }
 #ifndef CLIENT_DLL
         else if ( GetOwner()->IsWorld() ) {
+            // Ya sabemos que pista es, no hace falta comparar el nombre
+            if ( GetCue() != SOUND_CUE_NONE )
+                return TheDirector->MusicDesire( GetCue(), GetChannel() );
+
             return TheDirector->SoundDesire( GetSoundName(), GetChannel() );
         }
 #endif
@@ -206,71 +218,94 @@ float CSoundInstance::GetDesire()
 }
 
 //================================================================================
-// Devuelve si el jugador especificado puede escuchar el sonido
+// Calcula los jugadores que pueden escuchar el sonido
 //================================================================================
-bool CSoundInstance::ShouldListen( CPlayer *pSearch, CRecipientFilter &filter )
+void CSoundInstance::BuildRecipients()
 {
     CBaseEntity *pEntity = GetOriginEntity();
 
-    // Tiene como destino una entidad
-    /*if ( pEntity )
-    {
-    #ifdef CLIENT_DLL
-    filter.AddAllPlayers();
-    #else
-    CPASAttenuationFilter filter( pEntity, m_nParams.soundlevel );
-    #endif
-    }
-    else
-    {
-    filter.AddAllPlayers();
-    }*/
-
-    filter.AddAllPlayers();
-
-    if ( m_iTeam != TEAM_ANY ) {
-        FOR_EACH_PLAYER( {
-            if ( pPlayer->GetTeamNumber() != m_iTeam )
-            filter.RemoveRecipient( pPlayer );
-        } )
-    }
+    m_Recipients.ClearAll();
+    m_iRecipientsSerial = TheSoundSystem->GetPlayersSerial();
 
-    if ( pEntity && pEntity->IsPlayer() ) {
-        CBasePlayer *pPlayer = ToBasePlayer( pEntity );
+    // Todos los jugadores del equipo
+    for ( int i = 1; i <= gpGlobals->maxClients && i <= ABSOLUTE_PLAYER_LIMIT; ++i ) {
+        CBasePlayer *pPlayer = UTIL_PlayerByIndex( i );
+
+        if ( !pPlayer )
+            continue;
 
-        if ( m_iTarget == TARGET_ONLY ) {
 #ifndef CLIENT_DLL
-            filter.RemoveAllRecipients();
-#else
-            FOR_EACH_PLAYER( {
-                filter.RemoveRecipient( pPlayer );
-            } )
+        if ( !pPlayer->IsConnected() )
+            continue;
 #endif
 
-            filter.AddRecipient( pPlayer );
-        }
-        else if ( m_iTarget == TARGET_EXCEPT ) {
-            filter.RemoveRecipient( pPlayer );
+        if ( m_iTeam != TEAM_ANY && pPlayer->GetTeamNumber() != m_iTeam )
+            continue;
+
+        m_Recipients.Set( i - 1 );
+    }
+
+    if ( pEntity && pEntity->IsPlayer() ) {
+        int index = pEntity->entindex() - 1;
+
+        if ( index >= 0 && index < ABSOLUTE_PLAYER_LIMIT ) {
+            if ( m_iTarget == TARGET_ONLY ) {
+                m_Recipients.ClearAll();
+                m_Recipients.Set( index );
+            }
+            else if ( m_iTarget == TARGET_EXCEPT ) {
+                m_Recipients.Clear( index );
+            }
         }
     }
 
-    if ( GetExceptPlayer() )
-        filter.RemoveRecipient( GetExceptPlayer() );
+    if ( GetExceptPlayer() ) {
+        int index = GetExceptPlayer()->entindex() - 1;
 
-    if ( !pSearch )
-        return false;
+        if ( index >= 0 && index < ABSOLUTE_PLAYER_LIMIT )
+            m_Recipients.Clear( index );
+    }
+}
 
-    if ( filter.GetRecipientCount() == 0 )
-        return false;
+//================================================================================
+// Devuelve los jugadores que pueden escuchar el sonido.
+// Solo se vuelve a calcular si cambia el equipo, el objetivo, el dueo o
+// algn jugador entra, sale o cambia de equipo.
+//================================================================================
+const CPlayerBitVec &CSoundInstance::GetRecipients()
+{
+    if ( m_iRecipientsSerial != TheSoundSystem->GetPlayersSerial() )
+        BuildRecipients();
 
-    for ( int i = 0; i < filter.GetRecipientCount(); ++i ) {
-        CPlayer *pItem = ToInPlayer( UTIL_PlayerByIndex( filter.GetRecipientIndex( i ) ) );
+    return m_Recipients;
+}
 
-        if ( pItem == pSearch )
-            return true;
+//================================================================================
+// Devuelve si el jugador especificado puede escuchar el sonido
+//================================================================================
+bool CSoundInstance::ShouldListen( CPlayer *pSearch, CRecipientFilter &filter )
+{
+    const CPlayerBitVec &recipients = GetRecipients();
+
+    for ( int i = 0; i < ABSOLUTE_PLAYER_LIMIT; ++i ) {
+        if ( !recipients.IsBitSet( i ) )
+            continue;
+
+        CBasePlayer *pPlayer = UTIL_PlayerByIndex( i + 1 );
+
+        if ( pPlayer )
+            filter.AddRecipient( pPlayer );
     }
 
-    return false;
+    if ( !pSearch )
+        return false;
+
+    int index = pSearch->entindex() - 1;
+
+    if ( index < 0 || index >= ABSOLUTE_PLAYER_LIMIT )
+        return false;
+
+    return recipients.IsBitSet( index );
 }
 
 //================================================================================
@@ -289,8 +324,15 @@ bool CSoundInstance::ShouldListen( CPlayer *pPlayer )
     }
 #endif
 
-    CRecipientFilter dummy;
-    return ShouldListen( pPlayer, dummy );
+    if ( !pPlayer )
+        return false;
+
+    int index = pPlayer->entindex() - 1;
+
+    if ( index < 0 || index >= ABSOLUTE_PLAYER_LIMIT )
+        return false;
+
+    return GetRecipients().IsBitSet( index );
 }
 
 //================================================================================
@@ -346,6 +388,10 @@ void CSoundInstance::Stop()
     SOUND_CONTROLLER.SoundDestroy( m_nSound );
     m_bIsPlaying = false;
 
+    // El canal puede volver a elegir
+    if ( m_pManager )
+        m_pManager->Invalidate();
+
     if ( sv_debug_sounds.GetBool() )
         DevMsg( "[CSoundInstance] Stop / %s\n", GetSoundName() );
 }
@@ -468,6 +514,7 @@ void CSoundInstance::SetSoundName( const char *pSoundName, bool isLoop )
 void CSoundInstance::SetTeam( int team )
 {
     m_iTeam = team;
+    InvalidateRecipients();
 
     // Seguimos reproduciendo
     if ( IsPlaying() ) {
@@ -482,6 +529,7 @@ void CSoundInstance::SetTeam( int team )
 void CSoundInstance::SetOrigin( CBaseEntity * pEntity )
 {
     m_nOriginEntity = pEntity;
+    InvalidateRecipients();
 
     // Seguimos reproduciendo
     if ( IsPlaying() ) {
@@ -496,6 +544,7 @@ void CSoundInstance::SetOrigin( CBaseEntity * pEntity )
 void CSoundInstance::SetExcept( CPlayer *pEntity )
 {
     m_nExceptPlayer = pEntity;
+    InvalidateRecipients();
 
     // Seguimos reproduciendo
     if ( IsPlaying() ) {
@@ -504,11 +553,26 @@ void CSoundInstance::SetExcept( CPlayer *pEntity )
     }
 }
 
+//================================================================================
+// Establece el canal de reproduccin del sonido
+//================================================================================
+void CSoundInstance::SetChannel( int channel )
+{
+    if ( channel == m_iChannel )
+        return;
+
+    m_iChannel = channel;
+
+    if ( m_pManager )
+        m_pManager->Invalidate( true );
+}
+
 //================================================================================
 //================================================================================
 void CSoundInstance::SetOwner( CBaseEntity *pEntity )
 {
     m_nOwner = pEntity;
+    InvalidateRecipients();
 }
 
 //================================================================================
@@ -517,6 +581,7 @@ void CSoundInstance::SetOwner( CBaseEntity *pEntity )
 void CSoundInstance::SetTarget( int target )
 {
     m_iTarget = target;
+    InvalidateRecipients();
 
     // Seguimos reproduciendo
     if ( IsPlaying() ) {
@@ -45,7 +45,17 @@ enum
 	LAST_TARGET
 };
 
+//================================================================================
+// Identificador de la pista de msica, el dueo del sonido decide su significado
+// y lo usa en lugar del nombre para calcular el deseo.
+//================================================================================
+enum
+{
+	SOUND_CUE_NONE = -1
+};
+
 class CSoundInstance;
+class CSoundManager;
 
 //================================================================================
 //================================================================================
@@ -122,6 +132,9 @@ public:
 	virtual bool ShouldListen( CPlayer *pPlayer, CRecipientFilter &filter );
 	virtual bool ShouldListen( CPlayer *pPlayer = NULL );
 
+	virtual const CPlayerBitVec &GetRecipients();
+	virtual void InvalidateRecipients() { m_iRecipientsSerial = -1; }
+
 	virtual void Play( float volume = -1.0f, int pitch = -1 );
 	virtual void Stop();
 
@@ -149,7 +162,10 @@ public:
 	virtual void SetTarget( int target );
 
 	//virtual void SetLayer( int layer ) { m_iLayer = layer; }
-	virtual void SetChannel( int channel ) { m_iChannel = channel; }
+	virtual void SetChannel( int channel );
+
+	virtual void SetCue( int cue ) { m_iCue = cue; }
+	virtual void SetManager( CSoundManager *pManager ) { m_pManager = pManager; }
 
 public:
 	virtual CBaseEntity *GetOriginEntity() { return m_nOriginEntity.Get(); }
@@ -170,6 +186,12 @@ public:
 	virtual int GetChannel() { return m_iChannel; }
 	//virtual int GetLayer() { return m_iLayer; }
 
+	virtual int GetCue() { return m_iCue; }
+	virtual CSoundManager *GetManager() { return m_pManager; }
+
+protected:
+	virtual void BuildRecipients();
+
 protected:
 	float m_flSoundDuration;
 	bool m_bIsLoop;
@@ -183,6 +205,9 @@ protected:
 
 	//int m_iLayer;
 	int m_iChannel;
+	int m_iCue;
+
+	CSoundManager *m_pManager;
 
 	const char *m_nSoundName;
 	int m_iTeam;
@@ -194,6 +219,10 @@ protected:
 	CSoundPatch *m_nSound;
 	CSoundInstance *m_nTagSound;
 
+	// Jugadores que pueden escuchar el sonido (ndice de entidad - 1)
+	CPlayerBitVec m_Recipients;
+	int m_iRecipientsSerial;
+
 public:
 	EmitSound_t m_nInfo;
 	CSoundParameters m_nParams;
@@ -18,6 +18,10 @@ extern ConVar sv_debug_sound_manager;
 //================================================================================
 SoundGlobalSystem::SoundGlobalSystem() : CAutoGameSystemPerFrame("SoundGlobalSystem")
 {
+    m_iPlayersSerial = 0;
+
+    for ( int i = 0; i < ABSOLUTE_PLAYER_LIMIT; ++i )
+        m_iPlayerTeams[i] = TEAM_INVALID;
 }
 
 //================================================================================
@@ -46,6 +50,8 @@ void SoundGlobalSystem::LevelShutdownPostEntity()
 //================================================================================
 void SoundGlobalSystem::FrameUpdatePreEntityThink() 
 {
+    UpdatePlayers();
+
     FOR_EACH_VEC( m_ManagerList, it )
     {
         CSoundManager *pManager = m_ManagerList.Element( it );
@@ -69,6 +75,8 @@ void SoundGlobalSystem::FrameUpdatePreEntityThink()
 //================================================================================
 void SoundGlobalSystem::Update( float frametime ) 
 {
+    UpdatePlayers();
+
     FOR_EACH_VEC( m_ManagerList, it )
     {
         CSoundManager *pManager = m_ManagerList.Element( it );
@@ -180,6 +188,36 @@ void SoundGlobalSystem::UpdateLayer()
 }
 #endif
 
+//================================================================================
+// Revisa si algn jugador entro, salio o cambio de equipo, en ese caso
+// los sonidos deben volver a calcular quien puede escucharlos.
+//================================================================================
+void SoundGlobalSystem::UpdatePlayers()
+{
+    bool changed = false;
+
+    for ( int i = 1; i <= gpGlobals->maxClients && i <= ABSOLUTE_PLAYER_LIMIT; ++i ) {
+        CBasePlayer *pPlayer = UTIL_PlayerByIndex( i );
+        int team = TEAM_INVALID;
+
+#ifndef CLIENT_DLL
+        if ( pPlayer && pPlayer->IsConnected() )
+#else
+        if ( pPlayer )
+#endif
+            team = pPlayer->GetTeamNumber();
+
+        if ( m_iPlayerTeams[i - 1] == team )
+            continue;
+
+        m_iPlayerTeams[i - 1] = team;
+        changed = true;
+    }
+
+    if ( changed )
+        ++m_iPlayersSerial;
+}
+
 //================================================================================
 //================================================================================
 void SoundGlobalSystem::Add( CSoundInstance *pSound )
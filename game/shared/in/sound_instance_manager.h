@@ -37,6 +37,9 @@ public:
 	virtual void UpdateLayer();
 #endif
 
+	virtual void UpdatePlayers();
+	virtual int GetPlayersSerial() { return m_iPlayersSerial; }
+
 	virtual void Add( CSoundInstance *pSound );
 	virtual void Remove( CSoundInstance *pSound );
 
@@ -46,6 +49,10 @@ public:
 protected:
 	CUtlVector<CSoundInstance *> m_SoundList;
     CUtlVector<CSoundManager *> m_ManagerList;
+
+	// Cambia cada vez que un jugador entra, sale o cambia de equipo
+	int m_iPlayersSerial;
+	int m_iPlayerTeams[ABSOLUTE_PLAYER_LIMIT];
 };
 
 extern SoundGlobalSystem *TheSoundSystem;
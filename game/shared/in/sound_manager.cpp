@@ -29,6 +29,10 @@ CSoundManager::CSoundManager()
 {
     TheSoundSystem->Add( this );
     m_nSounds.EnsureCapacity( 100 );
+
+    m_bEventDriven = false;
+    m_bDirty = true;
+    m_bChannelsDirty = true;
 }
 
 //================================================================================
@@ -37,6 +41,11 @@ CSoundManager::CSoundManager()
 CSoundManager::~CSoundManager()
 {
     TheSoundSystem->Remove( this );
+
+    FOR_EACH_VEC( m_nSounds, it )
+    {
+        m_nSounds[it]->SetManager( NULL );
+    }
 }
 
 //================================================================================
@@ -44,24 +53,47 @@ CSoundManager::~CSoundManager()
 //================================================================================
 void CSoundManager::Update()
 {
+    // Nada ha cambiado desde la ltima vez
+    if ( m_bEventDriven && !m_bDirty )
+        return;
+
+    m_bDirty = false;
     UpdateChannel();
 }
 
+//================================================================================
+// Algo que afecta el deseo de los sonidos ha cambiado
+//================================================================================
+void CSoundManager::Invalidate( bool channels )
+{
+    m_bDirty = true;
+
+    if ( channels )
+        m_bChannelsDirty = true;
+}
+
 //================================================================================
 // Actualiza los sonidos por canal
 //================================================================================
 void CSoundManager::UpdateChannel()
 {
     // Lista de sonidos por canal
-    CUtlVector<CSoundInstance *> sounds[LAST_CHANNEL];
+    CUtlVector<CSoundInstance *> *sounds = m_Channels;
 
-    // Primero separamos por canal los sonidos
-    FOR_EACH_VEC( m_nSounds, it )
-    {
-        CSoundInstance *pSound = m_nSounds.Element( it );
-        if ( pSound->GetChannel() < CHANNEL_ANY ) continue;
+    // Separamos por canal los sonidos, solo cuando se agrega o cambia alguno
+    if ( m_bChannelsDirty ) {
+        for ( int channel = CHANNEL_ANY; channel < LAST_CHANNEL; ++channel )
+            sounds[channel].RemoveAll();
+
+        FOR_EACH_VEC( m_nSounds, it )
+        {
+            CSoundInstance *pSound = m_nSounds.Element( it );
+            if ( pSound->GetChannel() < CHANNEL_ANY || pSound->GetChannel() >= LAST_CHANNEL ) continue;
 
-        sounds[pSound->GetChannel()].AddToTail( pSound );
+            sounds[pSound->GetChannel()].AddToTail( pSound );
+        }
+
+        m_bChannelsDirty = false;
     }
 
     // Revisamos cada canal
@@ -238,6 +270,9 @@ void CSoundManager::Add( CSoundInstance *pSound )
         return;
 
     m_nSounds.AddToTail( pSound );
+    pSound->SetManager( this );
+
+    Invalidate( true );
 }
 
 //================================================================================
@@ -250,4 +285,9 @@ void CSoundManager::Remove( CSoundInstance *pSound )
         return;
 
     m_nSounds.Remove( index );
+
+    if ( pSound->GetManager() == this )
+        pSound->SetManager( NULL );
+
+    Invalidate( true );
 }
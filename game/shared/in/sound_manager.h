@@ -23,6 +23,13 @@ public:
 	virtual void Update();
 	virtual void UpdateChannel();
 
+	// Los administradores por eventos solo vuelven a decidir que reproducir
+	// cuando alguien llama a Invalidate() (cambio de estado, sonido terminado, etc.)
+	virtual void SetEventDriven( bool enabled ) { m_bEventDriven = enabled; }
+	virtual bool IsEventDriven() { return m_bEventDriven; }
+
+	virtual void Invalidate( bool channels = false );
+
 	virtual void OnPlay( CSoundInstance *pSound );
 	virtual void OnStop( CSoundInstance *pSound );
 
@@ -32,6 +39,13 @@ public:
 
 public:
 	CUtlVector<CSoundInstance *> m_nSounds;
+
+protected:
+	CUtlVector<CSoundInstance *> m_Channels[LAST_CHANNEL];
+
+	bool m_bEventDriven;
+	bool m_bDirty;
+	bool m_bChannelsDirty;
 };
 
 #endif
\ No newline at end of file
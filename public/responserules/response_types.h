@@ -159,10 +159,13 @@ namespace ResponseRules
 		CriteriaSet( const char *criteria, const char *value ) ;  // construct initialized with a key/value pair (convenience)
 		~CriteriaSet();
 
+		CriteriaSet& operator=( const CriteriaSet& src );
+
 		static CritSymbol_t	ComputeCriteriaSymbol( const char *criteria );
 		void		AppendCriteria( CritSymbol_t criteria, const char *value = "", float weight = 1.0f );
 		void		AppendCriteria( const char *criteria, const char *value = "", float weight = 1.0f );
 		void		AppendCriteria( const char *criteria, float value, float weight = 1.0f );
+		void		AppendCriteriaInt( const char *criteria, int value, float weight = 1.0f ); ///< distinct name so double/bool/unsigned arguments still go to the float version
 		void		RemoveCriteria( const char *criteria );
 
 		void		Describe() const;
@@ -176,6 +179,7 @@ namespace ResponseRules
 		inline static const char *SymbolToStr( const CritSymbol_t &symbol );
 		const char *GetName( int index ) const;
 		const char *GetValue( int index ) const;
+		float		GetNumericValue( int index ) const;
 		float		GetWeight( int index ) const;
 
 		/// Merge another CriteriaSet into this one.
@@ -199,6 +203,10 @@ namespace ResponseRules
 		inline int  Head() const;
 		inline int  Next( int i ) const; 	// use with IsValidIndex above
 
+		/// Number of entry blocks this thread had to get from the heap (instead of
+		/// recycling one from its arena) since it started. For rr_debugresponses.
+		static int	GetAllocationCount();
+
 		const static char kAPPLYTOWORLDPREFIX = '$';
 
 		/// A last minute l4d2 change: deferred contexts prefixed with a '$'
@@ -218,67 +226,80 @@ namespace ResponseRules
 	private:
 	void		RemoveCriteria( int idx, bool bTestForPrefix );
 
-		struct CritEntry_t
-		{
-			CritEntry_t() :
-		criterianame( UTL_INVAL_SYMBOL ),
-			weight( 0.0f )
-		{
-			value[ 0 ] = 0;
-		}
-
-		CritEntry_t( const CritEntry_t& src )
+		enum CritType_t
 		{
-			criterianame = src.criterianame;
-			value[ 0 ] = 0;
-			weight = src.weight;
-			SetValue( src.value );
-		}
-
-		CritEntry_t& operator=( const CritEntry_t& src )
-		{
-			if ( this == &src )
-				return *this;
-
-			criterianame = src.criterianame;
-			weight = src.weight;
-			SetValue( src.value );
-
-			return *this;
-		}
+			CRIT_STRING = 0,
+			CRIT_INT,
+			CRIT_FLOAT,
+		};
 
-		static bool LessFunc( const CritEntry_t& lhs, const CritEntry_t& rhs )
+		/// Entries are plain data: they are moved around with memcpy and live in
+		/// blocks recycled by a per-thread arena (see criteriaset.cpp).
+		struct CritEntry_t
 		{
-			return lhs.criterianame < rhs.criterianame;
-		}
+			void SetValue( char const *str )
+			{
+				type = CRIT_STRING;
+
+				if ( !str )
+				{
+					value[ 0 ] = 0;
+					numeric = 0.0f;
+				}
+				else
+				{
+					Q_strncpy( value, str, sizeof( value ) );
+					numeric = (float)atof( value );
+				}
+			}
 
-		void SetValue( char const *str )
-		{
-			if ( !str )
+			/// numbers are kept as such (no atof), the text is formatted here
+			/// so reading the value never writes to the entry.
+			void SetNumber( float flValue, CritType_t numType )
 			{
-				value[ 0 ] = 0;
+				type = numType;
+				numeric = flValue;
+
+				if ( numType == CRIT_INT )
+					Q_snprintf( value, sizeof( value ), "%d", (int)flValue );
+				else
+					Q_snprintf( value, sizeof( value ), "%f", flValue );
 			}
-			else
+
+			const char *GetValue() const
 			{
-				Q_strncpy( value, str, sizeof( value ) );
+				return value;
 			}
-		}
 
-		CritSymbol_t criterianame;
-		char		value[ 64 ];
-		float		weight;
+			CritSymbol_t criterianame;
+			uint8		type;
+			float		weight;
+			float		numeric; // value pre-parsed once, so matchers don't atof() it per rule
+			char		value[ 64 ];
 		};
 
+		/// binary search, returns the slot where the criterion is or should be inserted
+		int			LowerBound( CritSymbol_t criteria ) const;
+		CritEntry_t	*InsertEntry( CritSymbol_t criteria, bool *pAdded );
+		void		Grow( int num );
+
 		static CUtlSymbolTable sm_CriteriaSymbols;
-	    typedef CUtlRBTree< CritEntry_t, short > Dict_t;
-	    Dict_t m_Lookup;
+
+		// sorted by symbol
+		CritEntry_t *m_pEntries;
+		unsigned short m_nCount;
+		unsigned short m_nAllocated;
+
 	    int m_nNumPrefixedContexts; // number of contexts prefixed with kAPPLYTOWORLDPREFIX
 		bool m_bOverrideOnAppend;
 	};
 
 	inline void CriteriaSet::EnsureCapacity( int num )
 	{
-		m_Lookup.EnsureCapacity(num);
+		if ( num > m_nAllocated )
+		{
+			Grow( num );
+		}
 	}
 
 	//-----------------------------------------------------------------------------
@@ -392,17 +413,17 @@ namespace ResponseRules
 
 	inline bool CriteriaSet::IsValidIndex( int index ) const
 	{
-		return ( index >= 0 && index < ((int)(m_Lookup.Count())) );
+		return ( index >= 0 && index < ((int)m_nCount) );
 	}
 
     inline int CriteriaSet::Head() const
     {
-	    return m_Lookup.FirstInorder();
+	    return 0;
     }
     
     inline int CriteriaSet::Next( int i ) const
     {
-	    return m_Lookup.NextInorder(i);
+	    return i + 1;
     }
     
     inline const char *CriteriaSet::SymbolToStr( const CritSymbol_t &symbol )
@@ -737,6 +737,7 @@ void CStudioHdr::Init( const studiohdr_t *pStudioHdr, IMDLCache *mdlcache )
 	m_pStudioHdr = pStudioHdr;
 
 	m_pVModel = NULL;
+	m_pNameIndex = NULL;
 	m_pStudioHdrCache.RemoveAll();
 
 	if (m_pStudioHdr == NULL)
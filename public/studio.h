@@ -2475,6 +2475,8 @@ private:
 class IDataCache;
 class IMDLCache;
 
+struct StudioNameIndex_t;
+
 class CStudioHdr
 {
 public:
@@ -2829,6 +2831,10 @@ public:
 		m_pActivityToSequence = CActivityToSequenceMapping::FindMapping( this );
 	}
 
+	// Name lookup tables shared by every CStudioHdr of the model, set the
+	// first time a name is looked up (see FindStudioName in animation.cpp)
+	mutable StudioNameIndex_t *m_pNameIndex;
+
 #ifdef STUDIO_ENABLE_PERF_COUNTERS
 public:
 	inline void			ClearPerfCounters( void )
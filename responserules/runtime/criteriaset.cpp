@@ -8,6 +8,7 @@
 #include "rrbase.h"
 
 #include "utlmap.h"
+#include "tier0/threadtools.h"
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include <tier0/memdbgon.h>
@@ -85,28 +86,115 @@ const char *SplitContext( const char *raw, char *key, int keylen, char *value, i
 
 
 //-----------------------------------------------------------------------------
-// Purpose: 
+// Per-thread arena for the entry blocks. Criteria sets are built and thrown
+// away several times for every speech attempt, so instead of giving their
+// blocks back to the heap we keep them around for the next set built on the
+// same thread. Blocks hold a power of two entries.
+//-----------------------------------------------------------------------------
+class CCriteriaSetArena
+{
+public:
+	enum
+	{
+		MIN_BLOCK_SHIFT = 4,	// 16 entries
+		NUM_BLOCK_SIZES = 6,	// up to 512 entries, bigger ones always go to the heap
+		MAX_FREE_BLOCKS = 32,	// per size
+	};
+
+	CCriteriaSetArena() : m_nHeapAllocations( 0 )
+	{
+		memset( m_nFree, 0, sizeof( m_nFree ) );
+	}
+
+	void *Alloc( int &nCapacity, int nEntrySize )
+	{
+		int nSize = 0;
+		while ( nSize < NUM_BLOCK_SIZES - 1 && ( 1 << ( nSize + MIN_BLOCK_SHIFT ) ) < nCapacity )
+			++nSize;
+
+		int nBlockCapacity = 1 << ( nSize + MIN_BLOCK_SHIFT );
+		if ( nBlockCapacity < nCapacity )
+		{
+			++m_nHeapAllocations;
+			return malloc( nCapacity * nEntrySize );
+		}
+
+		nCapacity = nBlockCapacity;
+
+		if ( m_nFree[nSize] > 0 )
+			return m_pFree[nSize][ --m_nFree[nSize] ];
+
+		++m_nHeapAllocations;
+		return malloc( nCapacity * nEntrySize );
+	}
+
+	void Free( void *pBlock, int nCapacity )
+	{
+		for ( int nSize = 0; nSize < NUM_BLOCK_SIZES; ++nSize )
+		{
+			if ( ( 1 << ( nSize + MIN_BLOCK_SHIFT ) ) != nCapacity )
+				continue;
+
+			if ( m_nFree[nSize] < MAX_FREE_BLOCKS )
+			{
+				m_pFree[nSize][ m_nFree[nSize]++ ] = pBlock;
+				return;
+			}
+			break;
+		}
+
+		free( pBlock );
+	}
+
+	int m_nHeapAllocations;
+
+private:
+	void *m_pFree[NUM_BLOCK_SIZES][MAX_FREE_BLOCKS];
+	int m_nFree[NUM_BLOCK_SIZES];
+};
+
+// Never freed, a few KB per thread that ever built a criteria set
+static CTHREADLOCALPTR( CCriteriaSetArena ) s_pCriteriaSetArena;
+
+static CCriteriaSetArena *GetCriteriaSetArena()
+{
+	CCriteriaSetArena *pArena = s_pCriteriaSetArena;
+	if ( !pArena )
+	{
+		pArena = new CCriteriaSetArena;
+		s_pCriteriaSetArena = pArena;
+	}
+
+	return pArena;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose:
 //-----------------------------------------------------------------------------
-CriteriaSet::CriteriaSet() : m_Lookup( 0, 0, CritEntry_t::LessFunc ), m_bOverrideOnAppend(true), 
-	m_nNumPrefixedContexts(0)
+int CriteriaSet::GetAllocationCount()
 {
+	return GetCriteriaSetArena()->m_nHeapAllocations;
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: 
+// Purpose:
 //-----------------------------------------------------------------------------
-CriteriaSet::CriteriaSet( const CriteriaSet& src ) : m_Lookup( 0, 0, CritEntry_t::LessFunc ), m_nNumPrefixedContexts(src.m_nNumPrefixedContexts)
+CriteriaSet::CriteriaSet() : m_pEntries( NULL ), m_nCount( 0 ), m_nAllocated( 0 ),
+	m_nNumPrefixedContexts(0), m_bOverrideOnAppend(true)
 {
-	m_Lookup.EnsureCapacity( src.m_Lookup.Count() );
-	for ( short i = src.m_Lookup.FirstInorder(); 
-		i != src.m_Lookup.InvalidIndex(); 
-		i = src.m_Lookup.NextInorder( i ) )
-	{
-		m_Lookup.Insert( src.m_Lookup[ i ] );
-	}
 }
 
-CriteriaSet::CriteriaSet( const char *criteria, const char *value ) : m_Lookup( 0, 0, CritEntry_t::LessFunc ), m_bOverrideOnAppend(true)
+//-----------------------------------------------------------------------------
+// Purpose:
+//-----------------------------------------------------------------------------
+CriteriaSet::CriteriaSet( const CriteriaSet& src ) : m_pEntries( NULL ), m_nCount( 0 ), m_nAllocated( 0 ),
+	m_nNumPrefixedContexts(0), m_bOverrideOnAppend(true)
+{
+	*this = src;
+}
+
+CriteriaSet::CriteriaSet( const char *criteria, const char *value ) : m_pEntries( NULL ), m_nCount( 0 ), m_nAllocated( 0 ),
+	m_nNumPrefixedContexts(0), m_bOverrideOnAppend(true)
 {
 	AppendCriteria(criteria,value);
 }
@@ -114,10 +202,60 @@ CriteriaSet::CriteriaSet( const char *criteria, const char *value ) : m_Lookup(
 
 
 //-----------------------------------------------------------------------------
-// Purpose: 
+// Purpose:
 //-----------------------------------------------------------------------------
 CriteriaSet::~CriteriaSet()
 {
+	if ( m_pEntries )
+	{
+		GetCriteriaSetArena()->Free( m_pEntries, m_nAllocated );
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose:
+//-----------------------------------------------------------------------------
+CriteriaSet& CriteriaSet::operator=( const CriteriaSet& src )
+{
+	if ( this == &src )
+		return *this;
+
+	m_nCount = 0;
+	EnsureCapacity( src.m_nCount );
+
+	if ( src.m_nCount > 0 )
+	{
+		memcpy( m_pEntries, src.m_pEntries, src.m_nCount * sizeof( CritEntry_t ) );
+	}
+
+	m_nCount = src.m_nCount;
+	m_nNumPrefixedContexts = src.m_nNumPrefixedContexts;
+	m_bOverrideOnAppend = src.m_bOverrideOnAppend;
+	return *this;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Make room for at least num entries
+//-----------------------------------------------------------------------------
+void CriteriaSet::Grow( int num )
+{
+	Assert( num < 0xFFFF );
+
+	int nCapacity = MAX( num, m_nAllocated * 2 );
+	CritEntry_t *pEntries = (CritEntry_t *)GetCriteriaSetArena()->Alloc( nCapacity, sizeof( CritEntry_t ) );
+
+	if ( m_pEntries )
+	{
+		if ( m_nCount > 0 )
+		{
+			memcpy( pEntries, m_pEntries, m_nCount * sizeof( CritEntry_t ) );
+		}
+
+		GetCriteriaSetArena()->Free( m_pEntries, m_nAllocated );
+	}
+
+	m_pEntries = pEntries;
+	m_nAllocated = MIN( nCapacity, 0xFFFF );
 }
 
 //-----------------------------------------------------------------------------
@@ -128,42 +266,83 @@ CriteriaSet::CritSymbol_t CriteriaSet::ComputeCriteriaSymbol( const char *criter
 	return sm_CriteriaSymbols.AddString( criteria );
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: First slot whose symbol is not less than the given one
+//-----------------------------------------------------------------------------
+int CriteriaSet::LowerBound( CritSymbol_t criteria ) const
+{
+	int lo = 0;
+	int hi = m_nCount;
+
+	while ( lo < hi )
+	{
+		int mid = ( lo + hi ) >> 1;
+		if ( m_pEntries[mid].criterianame < criteria )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
 
 //-----------------------------------------------------------------------------
-// Computes a symbol for the criteria
+// Purpose: Returns the entry of the criterion, adding it if it's not there.
 //-----------------------------------------------------------------------------
-void CriteriaSet::AppendCriteria( CriteriaSet::CritSymbol_t criteria, const char *value, float weight )
+CriteriaSet::CritEntry_t *CriteriaSet::InsertEntry( CritSymbol_t criteria, bool *pAdded )
 {
-	int idx = FindCriterionIndex( criteria );
-	if ( idx == -1 )
+	int idx = LowerBound( criteria );
+	if ( idx < m_nCount && m_pEntries[idx].criterianame == criteria )
 	{
-		CritEntry_t entry;
-		entry.criterianame = criteria;
-		MEM_ALLOC_CREDIT();
-		idx = m_Lookup.Insert( entry );
-		if ( sm_CriteriaSymbols.String(criteria)[0] == kAPPLYTOWORLDPREFIX )
-		{
-			m_nNumPrefixedContexts += 1;
-		}
+		*pAdded = false;
+		return &m_pEntries[idx];
+	}
+
+	EnsureCapacity( m_nCount + 1 );
+
+	if ( idx < m_nCount )
+	{
+		memmove( &m_pEntries[idx + 1], &m_pEntries[idx], ( m_nCount - idx ) * sizeof( CritEntry_t ) );
 	}
-	else // criteria already existed
+	++m_nCount;
+
+	CritEntry_t *entry = &m_pEntries[idx];
+	entry->criterianame = criteria;
+	entry->weight = 0.0f;
+	entry->SetValue( NULL );
+
+	if ( sm_CriteriaSymbols.String(criteria)[0] == kAPPLYTOWORLDPREFIX )
 	{
-		// bail out if override existing criteria is not allowed
-		if ( !m_bOverrideOnAppend )
-			return; 
+		m_nNumPrefixedContexts += 1;
 	}
 
-	CritEntry_t *entry = &m_Lookup[ idx ];
+	*pAdded = true;
+	return entry;
+}
+
+
+//-----------------------------------------------------------------------------
+// Computes a symbol for the criteria
+//-----------------------------------------------------------------------------
+void CriteriaSet::AppendCriteria( CriteriaSet::CritSymbol_t criteria, const char *value, float weight )
+{
+	bool bAdded;
+	CritEntry_t *entry = InsertEntry( criteria, &bAdded );
+
+	// bail out if override existing criteria is not allowed
+	if ( !bAdded && !m_bOverrideOnAppend )
+		return;
+
 	entry->SetValue( value );
 	entry->weight = weight;
 }
 
 
 //-----------------------------------------------------------------------------
-// Purpose: 
-// Input  : *criteria - 
-//			"" - 
-//			1.0f - 
+// Purpose:
+// Input  : *criteria -
+//			"" -
+//			1.0f -
 //-----------------------------------------------------------------------------
 void CriteriaSet::AppendCriteria( const char *pCriteriaName, const char *value /*= ""*/, float weight /*= 1.0f*/ )
 {
@@ -173,16 +352,33 @@ void CriteriaSet::AppendCriteria( const char *pCriteriaName, const char *value /
 
 
 //-----------------------------------------------------------------------------
-// Purpose: 
-// Input  : *criteria - 
-//			"" - 
-//			1.0f - 
+// Purpose: Numbers are stored as such, no need to go through text
+// Input  : *criteria -
+//			value -
+//			1.0f -
 //-----------------------------------------------------------------------------
 void	CriteriaSet::AppendCriteria( const char *criteria, float value, float weight /*= 1.0f*/ )
 {
-	char buf[32];
-	V_snprintf( buf, 32, "%f", value );
-	AppendCriteria( criteria, buf, weight );
+	bool bAdded;
+	CritEntry_t *entry = InsertEntry( ComputeCriteriaSymbol( criteria ), &bAdded );
+
+	if ( !bAdded && !m_bOverrideOnAppend )
+		return;
+
+	entry->SetNumber( value, CRIT_FLOAT );
+	entry->weight = weight;
+}
+
+void	CriteriaSet::AppendCriteriaInt( const char *criteria, int value, float weight /*= 1.0f*/ )
+{
+	bool bAdded;
+	CritEntry_t *entry = InsertEntry( ComputeCriteriaSymbol( criteria ), &bAdded );
+
+	if ( !bAdded && !m_bOverrideOnAppend )
+		return;
+
+	entry->SetNumber( (float)value, CRIT_INT );
+	entry->weight = weight;
 }
 
 
@@ -203,44 +399,50 @@ void CriteriaSet::RemoveCriteria( const char *criteria )
 	RemoveCriteria( idx, false );
 }
 
-// bTestForIndex tells us whether the calling function has already checked for a 
-// $ prefix and decremented m_nNumPrefixedContexts appropriately (false), 
+// bTestForIndex tells us whether the calling function has already checked for a
+// $ prefix and decremented m_nNumPrefixedContexts appropriately (false),
 // or if this function should do that (true).
 void CriteriaSet::RemoveCriteria( int idx, bool bTestForPrefix )
 {
-	Assert( m_Lookup.IsValidIndex(idx) );
+	Assert( IsValidIndex(idx) );
 	if ( bTestForPrefix )
 	{
-		if ( sm_CriteriaSymbols.String( m_Lookup[idx].criterianame )[0] == kAPPLYTOWORLDPREFIX )
+		if ( sm_CriteriaSymbols.String( m_pEntries[idx].criterianame )[0] == kAPPLYTOWORLDPREFIX )
 		{
 			Assert( m_nNumPrefixedContexts > 0 );
 			m_nNumPrefixedContexts = isel( m_nNumPrefixedContexts - 1, m_nNumPrefixedContexts - 1, 0 );
 		}
 	}
-	m_Lookup.RemoveAt( idx );
+
+	--m_nCount;
+	if ( idx < m_nCount )
+	{
+		memmove( &m_pEntries[idx], &m_pEntries[idx + 1], ( m_nCount - idx ) * sizeof( CritEntry_t ) );
+	}
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: 
+// Purpose:
 // Output : int
 //-----------------------------------------------------------------------------
 int CriteriaSet::GetCount() const
 {
-	return m_Lookup.Count();
+	return m_nCount;
 }
 
 
 //-----------------------------------------------------------------------------
-// Purpose: 
-// Input  : *name - 
+// Purpose:
+// Input  : *name -
 // Output : int
 //-----------------------------------------------------------------------------
 int CriteriaSet::FindCriterionIndex( CritSymbol_t criteria ) const
 {
-	CritEntry_t search;
-	search.criterianame = criteria;
-	int idx = m_Lookup.Find( search );
-	return ( idx == m_Lookup.InvalidIndex() ) ? -1 : idx;
+	int idx = LowerBound( criteria );
+	if ( idx < m_nCount && m_pEntries[idx].criterianame == criteria )
+		return idx;
+
+	return -1;
 }
 
 int CriteriaSet::FindCriterionIndex( const char *name ) const
@@ -255,76 +457,142 @@ int CriteriaSet::FindCriterionIndex( const char *name ) const
 //-----------------------------------------------------------------------------
 CriteriaSet::CritSymbol_t CriteriaSet::GetNameSymbol( int nIndex ) const
 {
-	if ( nIndex < 0 || nIndex >= (int)m_Lookup.Count() )
+	if ( !IsValidIndex( nIndex ) )
 		return UTL_INVAL_SYMBOL;
 
-	const CritEntry_t *entry = &m_Lookup[ nIndex ];
-	return entry->criterianame;
+	return m_pEntries[ nIndex ].criterianame;
 }
 
 
 //-----------------------------------------------------------------------------
-// Purpose: 
-// Input  : index - 
+// Purpose:
+// Input  : index -
 // Output : char const
 //-----------------------------------------------------------------------------
 const char *CriteriaSet::GetName( int index ) const
 {
-	if ( index < 0 || index >= (int)m_Lookup.Count() )
+	if ( !IsValidIndex( index ) )
 		return "";
 	else
 	{
-		const char *pCriteriaName = sm_CriteriaSymbols.String( m_Lookup[ index ].criterianame );
+		const char *pCriteriaName = sm_CriteriaSymbols.String( m_pEntries[ index ].criterianame );
 		return pCriteriaName ? pCriteriaName : "";
 	}
 }
 
 
 //-----------------------------------------------------------------------------
-// Purpose: 
-// Input  : index - 
+// Purpose:
+// Input  : index -
 // Output : char const
 //-----------------------------------------------------------------------------
 const char *CriteriaSet::GetValue( int index ) const
 {
-	if ( index < 0 || index >= (int)m_Lookup.Count() )
+	if ( !IsValidIndex( index ) )
 		return "";
 
-	const CritEntry_t *entry = &m_Lookup[ index ];
-	return entry->value ? entry->value : "";
+	return m_pEntries[ index ].GetValue();
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: 
-// Input  : index - 
+// Purpose: Value as a number, parsed once when it was set
+// Input  : index -
+// Output : float
+//-----------------------------------------------------------------------------
+float CriteriaSet::GetNumericValue( int index ) const
+{
+	if ( !IsValidIndex( index ) )
+		return 0.0f;
+
+	return m_pEntries[ index ].numeric;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose:
+// Input  : index -
 // Output : float
 //-----------------------------------------------------------------------------
 float CriteriaSet::GetWeight( int index ) const
 {
-	if ( index < 0 || index >= (int)m_Lookup.Count() )
+	if ( !IsValidIndex( index ) )
 		return 1.0f;
 
-	const CritEntry_t *entry = &m_Lookup[ index ];
-	return entry->weight;
+	return m_pEntries[ index ].weight;
 }
 
 
 //-----------------------------------------------------------------------------
 // Purpose: Merge another criteria set into this one.
+//  Both are sorted, so this is a single merge pass done backwards in place.
 //-----------------------------------------------------------------------------
 void CriteriaSet::Merge( const CriteriaSet * RESTRICT otherCriteria )
 {
 	Assert(otherCriteria);
-	if (!otherCriteria)
+	if (!otherCriteria || otherCriteria == this )
 		return;
 
-	// for now, just duplicate everything.
-	int count = otherCriteria->GetCount();
-	EnsureCapacity( count + GetCount() );
-	for ( int i = 0 ; i < count ; ++i )
+	int nOther = otherCriteria->m_nCount;
+	if ( nOther == 0 )
+		return;
+
+	// count the resulting entries
+	int nTotal = m_nCount;
+	int i = 0, j = 0;
+	while ( j < nOther )
 	{
-		AppendCriteria( otherCriteria->GetNameSymbol(i), otherCriteria->GetValue(i), otherCriteria->GetWeight(i) );
+		if ( i < m_nCount && m_pEntries[i].criterianame < otherCriteria->m_pEntries[j].criterianame )
+		{
+			++i;
+		}
+		else
+		{
+			if ( i >= m_nCount || otherCriteria->m_pEntries[j].criterianame < m_pEntries[i].criterianame )
+			{
+				++nTotal;
+
+				if ( sm_CriteriaSymbols.String( otherCriteria->m_pEntries[j].criterianame )[0] == kAPPLYTOWORLDPREFIX )
+				{
+					m_nNumPrefixedContexts += 1;
+				}
+			}
+			else
+			{
+				++i;
+			}
+
+			++j;
+		}
 	}
+
+	EnsureCapacity( nTotal );
+
+	i = m_nCount - 1;
+	j = nOther - 1;
+	int k = nTotal - 1;
+
+	while ( j >= 0 )
+	{
+		const CritEntry_t &other = otherCriteria->m_pEntries[j];
+
+		if ( i >= 0 && other.criterianame < m_pEntries[i].criterianame )
+		{
+			m_pEntries[k--] = m_pEntries[i--];
+		}
+		else if ( i >= 0 && m_pEntries[i].criterianame == other.criterianame )
+		{
+			m_pEntries[k--] = m_bOverrideOnAppend ? other : m_pEntries[i];
+			--i;
+			--j;
+		}
+		else
+		{
+			m_pEntries[k--] = other;
+			--j;
+		}
+	}
+
+	Assert( k == i );
+	m_nCount = nTotal;
 }
 
 void CriteriaSet::Merge( const char *modifiers ) // add criteria parsed from a text string
@@ -359,54 +627,36 @@ void CriteriaSet::Describe() const
 {
 	// build an alphabetized representation of the set for printing
 	typedef CUtlMap<const char *, const CritEntry_t *> tMap;
-	tMap m_TempMap( 0, m_Lookup.Count(), CaselessStringLessThan );
+	tMap m_TempMap( 0, m_nCount, CaselessStringLessThan );
 
-	for ( short i = m_Lookup.FirstInorder(); i != m_Lookup.InvalidIndex(); i = m_Lookup.NextInorder( i ) )
+	for ( int i = 0; i < m_nCount; ++i )
 	{
-		const CritEntry_t *entry = &m_Lookup[ i ];
+		const CritEntry_t *entry = &m_pEntries[ i ];
 
 		m_TempMap.Insert( sm_CriteriaSymbols.String( entry->criterianame ), entry );
 	}
 
 	for ( tMap::IndexType_t i = m_TempMap.FirstInorder(); i != m_TempMap.InvalidIndex(); i = m_TempMap.NextInorder( i ) )
 	{
-		// const CritEntry_t *entry = &m_TempMap[ i ];
-		// const char *pCriteriaName = sm_CriteriaSymbols.String( entry->criterianame );
-
 		const char *name = m_TempMap.Key( i );
 		const CritEntry_t *entry  = m_TempMap.Element( i );
+		const char *value = GetValue( (int)( entry - m_pEntries ) );
 		if ( entry->weight != 1.0f )
 		{
-			DevMsg( "  %20s = '%s' (weight %f)\n", name, entry->value ? entry->value : "", entry->weight );
-		}
-		else
-		{
-			DevMsg( "  %20s = '%s'\n", name, entry->value ? entry->value : "" );
-		}
-	}
-
-	/*
-	for ( short i = m_Lookup.FirstInorder(); i != m_Lookup.InvalidIndex(); i = m_Lookup.NextInorder( i ) )
-	{
-		const CritEntry_t *entry = &m_Lookup[ i ];
-
-		const char *pCriteriaName = sm_CriteriaSymbols.String( entry->criterianame );
-		if ( entry->weight != 1.0f )
-		{
-			DevMsg( "  %20s = '%s' (weight %f)\n", pCriteriaName, entry->value ? entry->value : "", entry->weight );
+			DevMsg( "  %20s = '%s' (weight %f)\n", name, value, entry->weight );
 		}
 		else
 		{
-			DevMsg( "  %20s = '%s'\n", pCriteriaName, entry->value ? entry->value : "" );
+			DevMsg( "  %20s = '%s'\n", name, value );
 		}
 	}
-	*/
 }
 
 
 void CriteriaSet::Reset()
 {
-	m_Lookup.Purge();
+	m_nCount = 0;
+	m_nNumPrefixedContexts = 0;
 }
 
 void CriteriaSet::WriteToEntity( CBaseEntity *pEntity )
@@ -472,6 +722,8 @@ int CriteriaSet::InterceptWorldSetContexts( CriteriaSet * RESTRICT pFrom, Criter
 		pSetOnWorld->GetCount(), nPrefixedContexts	);
 
 	pFrom->m_nNumPrefixedContexts = 0;
-	pFrom->m_Lookup.Swap(rewrite.m_Lookup);
+	V_swap( pFrom->m_pEntries, rewrite.m_pEntries );
+	V_swap( pFrom->m_nCount, rewrite.m_nCount );
+	V_swap( pFrom->m_nAllocated, rewrite.m_nAllocated );
 	return pSetOnWorld->GetCount();
 }
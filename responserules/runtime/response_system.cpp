@@ -84,6 +84,9 @@ ConVar rr_debugresponses( "rr_debugresponses", "0", FCVAR_NONE, "Show verbose ma
 ConVar rr_debugrule( "rr_debugrule", "", FCVAR_NONE, "If set to the name of the rule, that rule's score will be shown whenever a concept is passed into the response rules system.");
 ConVar rr_dumpresponses( "rr_dumpresponses", "0", FCVAR_NONE, "Dump all response_rules.txt and rules (requires restart)" );
 ConVar rr_debugresponseconcept( "rr_debugresponseconcept", "", FCVAR_NONE, "If set, rr_debugresponses will print only responses testing for the specified concept" );
+ConVar rr_ruleindex( "rr_ruleindex", "1", FCVAR_NONE, "Prune the rules that can't match a criteria set using the index built at load time, before scoring them." );
+ConVar rr_debugallocations( "rr_debugallocations", "0", FCVAR_NONE, "Print how many criteria set blocks had to come from the heap (instead of being recycled) to build each query." );
+ConVar rr_benchmark_record( "rr_benchmark_record", "0", FCVAR_NONE, "Record the last criteria sets passed to the response system, to be replayed by rr_benchmark." );
 #define RR_DEBUGRESPONSES_SPECIALCASE 4
 
 
@@ -184,6 +187,7 @@ CResponseSystem::CResponseSystem() :
 	token[0] = 0;
 	m_bUnget = false;
 	m_bCustomManagable = false;
+	m_nNextRecordedCriteria = 0;
 
 	BuildDispatchTables();
 }
@@ -410,17 +414,20 @@ void CResponseSystem::ComputeMatcher( Criteria *c, Matcher& matcher )
 		in++;
 	}
 
+	// Parse it now instead of every time the criterion is compared
+	matcher.tokenval = (float)atof( token );
+
 	matcher.SetToken( token );
 	matcher.SetRaw( rawtoken );
 	matcher.valid = true;
 }
 
-bool CResponseSystem::CompareUsingMatcher( const char *setValue, Matcher& m, bool verbose /*=false*/ )
+bool CResponseSystem::CompareUsingMatcher( const char *setValue, float setNumeric, Matcher& m, bool verbose /*=false*/ )
 {
 	if ( !m.valid )
 		return false;
 
-	float v = (float)atof( setValue );
+	float v = setNumeric;
 	if ( setValue[0] == '[' )
 	{
 		bool found = false;
@@ -471,7 +478,7 @@ bool CResponseSystem::CompareUsingMatcher( const char *setValue, Matcher& m, boo
 	{
 		if ( m.isnumeric )
 		{
-			if ( v == (float)atof( m.GetToken() ) )
+			if ( v == m.tokenval )
 				return false;
 		}
 		else
@@ -490,18 +497,18 @@ bool CResponseSystem::CompareUsingMatcher( const char *setValue, Matcher& m, boo
 		if ( !setValue || !setValue[0] )
 			return false;
 
-		return v == (float)atof( m.GetToken() );
+		return v == m.tokenval;
 	}
 
 	return !Q_stricmp( setValue, m.GetToken() ) ? true : false;
 }
 
-bool CResponseSystem::Compare( const char *setValue, Criteria *c, bool verbose /*= false*/ )
+bool CResponseSystem::Compare( const char *setValue, float setNumeric, Criteria *c, bool verbose /*= false*/ )
 {
 	Assert( c );
 	Assert( setValue );
 
-	bool bret = CompareUsingMatcher( setValue, c->matcher, verbose );
+	bool bret = CompareUsingMatcher( setValue, setNumeric, c->matcher, verbose );
 
 	if ( verbose )
 	{
@@ -587,6 +594,7 @@ float CResponseSystem::ScoreCriteriaAgainstRuleCriteria( const CriteriaSet& set,
 	float score = 0.0f;
 
 	const char *actualValue = "";
+	float actualNumeric = 0.0f;
 
 	/*
 	const char * RESTRICT critname = c->name;
@@ -602,11 +610,13 @@ float CResponseSystem::ScoreCriteriaAgainstRuleCriteria( const CriteriaSet& set,
 			Assert( 0 );
 			return score;
 		}
+
+		actualNumeric = set.GetNumericValue( found );
 	}
 
 	Assert( actualValue );
 
-	if ( Compare( actualValue, c, verbose ) )
+	if ( Compare( actualValue, actualNumeric, c, verbose ) )
 	{
 		float w = set.GetWeight( found );
 		score = w * c->weight.GetFloat();
@@ -1135,21 +1145,43 @@ bool CResponseSystem::GetBestResponse( ResponseSearchResult& searchResult, Rule
 // Warning: If you change this, be sure to also change 
 //          ResponseSystemImplementationCLI::FindAllRulesMatchingCriteria().
 //-----------------------------------------------------------------------------
-ResponseRulePartition::tIndex CResponseSystem::FindBestMatchingRule( const CriteriaSet& set, bool verbose, float &scoreOfBestMatchingRule )
+ResponseRulePartition::tIndex CResponseSystem::FindBestMatchingRule( const CriteriaSet& set, bool verbose, float &scoreOfBestMatchingRule, bool bUseIndex /*= true*/ )
 {
 	CUtlVector< ResponseRulePartition::tIndex >	bestrules(16,4);
 	float bestscore = 0.001f;
 	scoreOfBestMatchingRule = 0;
 
+	// Rules pruned by the index are never scored, so don't use it if someone wants to see them.
+	const char *pszDebugRule = rr_debugrule.GetString();
+	bUseIndex = bUseIndex && rr_ruleindex.GetBool() && !verbose && !( pszDebugRule && pszDebugRule[0] );
+
+	if ( bUseIndex && !m_RulePartitions.IsCompiled() )
+	{
+		m_RulePartitions.Compile( this );
+	}
+
+	ResponseRulePartition::tCandidates candidates;
+
 	CUtlVectorFixed< ResponseRulePartition::tRuleDict *, 2 > buckets( 0, 2 );
 	m_RulePartitions.GetDictsForCriteria( &buckets, set );
 	for ( int b = 0 ; b < buckets.Count() ; ++b )
 	{
 		ResponseRulePartition::tRuleDict *prules = buckets[b];
-		int c = prules->Count();
-	int i;
-	for ( i = 0; i < c; i++ )
+		int c;
+
+		if ( bUseIndex )
+		{
+			m_RulePartitions.GetCandidatesForCriteria( &candidates, prules, set );
+			c = candidates.Count();
+		}
+		else
+		{
+			c = prules->Count();
+		}
+
+	for ( int n = 0; n < c; n++ )
 	{
+			int i = bUseIndex ? candidates[n] : n;
 			float score = ScoreCriteriaAgainstRule( set, *prules, i, verbose );
 		// Check equals so that we keep track of all matching rules
 		if ( score >= bestscore )
@@ -1197,6 +1229,20 @@ bool CResponseSystem::FindBestResponse( const CriteriaSet& set, CRR_Response& re
 {
 	bool valid = false;
 
+	if ( rr_benchmark_record.GetBool() )
+	{
+		RecordCriteria( set );
+	}
+
+	if ( rr_debugallocations.GetBool() )
+	{
+		// the sets for this query were built since the last one
+		static int s_nLastAllocationCount = 0;
+		int nAllocationCount = CriteriaSet::GetAllocationCount();
+		Msg( "FindBestResponse: %d criteria set allocations (%d criteria)\n", nAllocationCount - s_nLastAllocationCount, set.GetCount() );
+		s_nLastAllocationCount = nAllocationCount;
+	}
+
 	int iDbgResponse = rr_debugresponses.GetInt();
 	bool showRules = ( iDbgResponse >= 2 && iDbgResponse < RR_DEBUGRESPONSES_SPECIALCASE );
 	bool showResult = ( iDbgResponse >= 1 && iDbgResponse < RR_DEBUGRESPONSES_SPECIALCASE );
@@ -1410,6 +1456,8 @@ void CResponseSystem::LoadRuleSet( const char *basescript )
 
 	IEngineEmulator::Get()->FreeFile( buffer );
 
+	m_RulePartitions.Compile( this );
+
 	Assert( m_ScriptStack.Count() == 0 );
 	float flEnd = Plat_FloatTime();
 	COM_TimestampedLog( "CResponseSystem::LoadRuleSet took %f msec", 1000.0f * ( flEnd - flStart ) );
@@ -2356,6 +2404,81 @@ void CResponseSystem::DumpDictionary( const char *pszName )
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: Keep a copy of the last criteria sets for rr_benchmark
+//-----------------------------------------------------------------------------
+void CResponseSystem::RecordCriteria( const CriteriaSet &set )
+{
+	const int MAX_RECORDED_CRITERIA = 512;
+
+	if ( m_RecordedCriteria.Count() < MAX_RECORDED_CRITERIA )
+	{
+		m_RecordedCriteria.AddToTail( set );
+		return;
+	}
+
+	CriteriaSet &recorded = m_RecordedCriteria[ m_nNextRecordedCriteria ];
+	recorded.Reset();
+	recorded.Merge( &set );
+
+	m_nNextRecordedCriteria = ( m_nNextRecordedCriteria + 1 ) % MAX_RECORDED_CRITERIA;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Replay the recorded criteria sets scoring every rule of the buckets
+//  and only the candidates of the index, and make sure both agree.
+//-----------------------------------------------------------------------------
+void CResponseSystem::Benchmark( int nIterations )
+{
+	int nSets = m_RecordedCriteria.Count();
+	if ( nSets == 0 )
+	{
+		Msg( "No criteria sets recorded, set rr_benchmark_record 1 and play for a while.\n" );
+		return;
+	}
+
+	nIterations = MAX( nIterations, 1 );
+
+	if ( !m_RulePartitions.IsCompiled() )
+	{
+		m_RulePartitions.Compile( this );
+	}
+
+	int nMismatches = 0;
+	for ( int i = 0; i < nSets; ++i )
+	{
+		float flLinearScore, flIndexedScore;
+		bool bLinear = m_RulePartitions.IsValid( FindBestMatchingRule( m_RecordedCriteria[i], false, flLinearScore, false ) );
+		bool bIndexed = m_RulePartitions.IsValid( FindBestMatchingRule( m_RecordedCriteria[i], false, flIndexedScore, true ) );
+
+		if ( bLinear != bIndexed || flLinearScore != flIndexedScore )
+		{
+			++nMismatches;
+		}
+	}
+
+	double flTimes[2];
+	for ( int pass = 0; pass < 2; ++pass )
+	{
+		double flStart = Plat_FloatTime();
+		for ( int it = 0; it < nIterations; ++it )
+		{
+			for ( int i = 0; i < nSets; ++i )
+			{
+				float flScore;
+				FindBestMatchingRule( m_RecordedCriteria[i], false, flScore, pass != 0 );
+			}
+		}
+		flTimes[pass] = Plat_FloatTime() - flStart;
+	}
+
+	int nQueries = nSets * nIterations;
+	Msg( "rr_benchmark: %d criteria sets x %d iterations, %d rules\n", nSets, nIterations, m_RulePartitions.Count() );
+	Msg( "  linear:  %8.3f msec (%.2f usec/query)\n", flTimes[0] * 1000.0, flTimes[0] * 1000000.0 / nQueries );
+	Msg( "  indexed: %8.3f msec (%.2f usec/query)\n", flTimes[1] * 1000.0, flTimes[1] * 1000000.0 / nQueries );
+	Msg( "  mismatches: %d\n", nMismatches );
+}
+
 void CResponseSystem::BuildDispatchTables()
 {
 	m_RootCommandHashes.Insert( RR_HASH( "#include" ) );
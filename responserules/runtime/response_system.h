@@ -79,6 +79,10 @@ namespace ResponseRules
 		void		CopyResponsesFrom( Rule *pSrcRule, Rule *pDstRule, CResponseSystem *pCustomSystem );
 		void		CopyEnumerationsFrom( CResponseSystem *pCustomSystem );
 
+		// rr_benchmark: replay criteria sets recorded with rr_benchmark_record
+		void		RecordCriteria( const CriteriaSet &set );
+		void		Benchmark( int nIterations );
+
 		//private:
 
 		struct Enumeration
@@ -204,13 +208,13 @@ namespace ResponseRules
 public:
 		int			ParseOneCriterion( const char *criterionName );
 
-		bool		Compare( const char *setValue, Criteria *c, bool verbose = false );
-		bool		CompareUsingMatcher( const char *setValue, Matcher& m, bool verbose = false );
+		bool		Compare( const char *setValue, float setNumeric, Criteria *c, bool verbose = false );
+		bool		CompareUsingMatcher( const char *setValue, float setNumeric, Matcher& m, bool verbose = false );
 		void		ComputeMatcher( Criteria *c, Matcher& matcher );
 		void		ResolveToken( Matcher& matcher, char *token, size_t bufsize, char const *rawtoken );
 		float		LookupEnumeration( const char *name, bool& found );
 
-		ResponseRulePartition::tIndex FindBestMatchingRule( const CriteriaSet& set, bool verbose, float &scoreOfBestMatchingRule );
+		ResponseRulePartition::tIndex FindBestMatchingRule( const CriteriaSet& set, bool verbose, float &scoreOfBestMatchingRule, bool bUseIndex = true );
 		
 		float		ScoreCriteriaAgainstRule( const CriteriaSet& set, ResponseRulePartition::tRuleDict &dict, int irule, bool verbose = false );
 		float		RecursiveScoreSubcriteriaAgainstRule( const CriteriaSet& set, Criteria *parent, bool& exclude, bool verbose /*=false*/ );
@@ -253,6 +257,9 @@ public:
 
 		CUtlVector<int> m_FakedDepletes;
 
+		CUtlVector< CriteriaSet > m_RecordedCriteria;
+		int			m_nNextRecordedCriteria;
+
 		char		token[ 1204 ];
 
 		bool		m_bUnget;
@@ -36,6 +36,7 @@ Matcher::Matcher()
 	maxequals = false;
 	maxval = 0.0f;
 	minval = 0.0f;
+	tokenval = 0.0f;
 
 	token = UTL_INVAL_SYMBOL;
 	rawtoken = UTL_INVAL_SYMBOL;
@@ -15,7 +15,7 @@ using namespace ResponseRules;
 
 
 
-ResponseRulePartition::ResponseRulePartition()
+ResponseRulePartition::ResponseRulePartition() : m_bCompiled( false )
 {
 	Assert(true);
 	COMPILE_TIME_ASSERT( kIDX_ELEM_MASK < (1 << 16) );
@@ -67,7 +67,13 @@ void ResponseRulePartition::RemoveAll( void )
 			delete m_RuleParts[bukkit][ i ];
 		}
 		m_RuleParts[bukkit].RemoveAll();
+
+		m_Compiled[bukkit].keySym = UTL_INVAL_SYMBOL;
+		m_Compiled[bukkit].keyed.Purge();
+		m_Compiled[bukkit].unkeyed.Purge();
 	}
+
+	m_bCompiled = false;
 }
 
 // don't bucket "subject" criteria that prefix with operators, since stripping all that out again would
@@ -85,6 +91,9 @@ ResponseRulePartition::tRuleDict &ResponseRulePartition::GetDictForRule( CRespon
 	const static CUtlSymbol kCONCEPT = CriteriaSet::ComputeCriteriaSymbol("Concept");
 	const static CUtlSymbol kSUBJECT = CriteriaSet::ComputeCriteriaSymbol("Subject");
 
+	// the caller is about to add a rule
+	m_bCompiled = false;
+
 	const char *pszSpeaker = pRule->GetValueForRuleCriterionByName( pSystem, kWHO );
 	const char *pszConcept = pRule->GetValueForRuleCriterionByName( pSystem, kCONCEPT );
 	const Criteria *pSubjCrit = pRule->GetPointerForRuleCriterionByName( pSystem, kSUBJECT );
@@ -117,4 +126,228 @@ void ResponseRulePartition::GetDictsForCriteria( CUtlVectorFixed< ResponseRulePa
 	// also try the rules not specifying subject
 	pResult->AddToTail( &m_RuleParts[ GetBucketForSpeakerAndConcept(pszSpeaker, pszConcept, NULL) ] );
 
-}
\ No newline at end of file
+}
+
+// Criteria that can key the index: required, plain (case insensitive) string equality
+static bool CanIndexCriterion( Criteria *c )
+{
+	if ( !c->required || c->IsSubCriteriaType() || !c->matcher.valid )
+		return false;
+
+	const Matcher &m = c->matcher;
+	if ( m.isnumeric || m.notequal || m.usemin || m.usemax )
+		return false;
+
+	return c->matcher.GetToken()[0] != 0;
+}
+
+static int __cdecl HashSortCompare( const unsigned int *a, const unsigned int *b )
+{
+	if ( *a == *b )
+		return 0;
+
+	return ( *a < *b ) ? -1 : 1;
+}
+
+int __cdecl ResponseRulePartition::CompiledKey_t::SortCompare( const CompiledKey_t *a, const CompiledKey_t *b )
+{
+	if ( a->hash != b->hash )
+		return ( a->hash < b->hash ) ? -1 : 1;
+
+	return (int)a->elem - (int)b->elem;
+}
+
+// A required (criterion, value) pair of a rule, while compiling
+struct RuleKey_t
+{
+	CUtlSymbol sym;
+	unsigned int hash;
+	unsigned short elem;
+};
+
+void ResponseRulePartition::Compile( CResponseSystem *pSystem )
+{
+	CUtlVector< RuleKey_t > keys;
+	CUtlVector< CUtlSymbol > syms;
+	CUtlVector< unsigned int > hashes;
+
+	for ( int bukkit = 0 ; bukkit < N_RESPONSE_PARTITIONS ; ++bukkit )
+	{
+		tRuleDict &dict = m_RuleParts[bukkit];
+		CompiledBucket_t &compiled = m_Compiled[bukkit];
+
+		compiled.keySym = UTL_INVAL_SYMBOL;
+		compiled.keyed.Purge();
+		compiled.unkeyed.Purge();
+
+		int count = dict.Count();
+		if ( count == 0 )
+			continue;
+
+		// gather every (criterion, value) pair a rule requires
+		keys.RemoveAll();
+		syms.RemoveAll();
+		for ( int i = 0 ; i < count ; ++i )
+		{
+			Rule *pRule = dict[i];
+			int nFirstKey = keys.Count();
+
+			for ( int c = 0 ; c < pRule->m_Criteria.Count() ; ++c )
+			{
+				Criteria *pCrit = &pSystem->m_Criteria[ pRule->m_Criteria[c] ];
+				if ( !CanIndexCriterion( pCrit ) )
+					continue;
+
+				// only the first one if a rule requires the same criterion twice
+				bool bDuplicate = false;
+				for ( int k = nFirstKey ; k < keys.Count() ; ++k )
+				{
+					if ( keys[k].sym == pCrit->nameSym )
+					{
+						bDuplicate = true;
+						break;
+					}
+				}
+
+				if ( bDuplicate )
+					continue;
+
+				RuleKey_t key;
+				key.sym = pCrit->nameSym;
+				key.hash = HashStringCaseless( pCrit->matcher.GetToken() );
+				key.elem = i;
+				keys.AddToTail( key );
+
+				if ( syms.Find( key.sym ) == syms.InvalidIndex() )
+				{
+					syms.AddToTail( key.sym );
+				}
+			}
+		}
+
+		// pick the criterion that leaves the fewest rules to score on average:
+		// the rules not requiring it, plus the rules requiring any one of its values.
+		float flBestCost = (float)count;
+		for ( int s = 0 ; s < syms.Count() ; ++s )
+		{
+			hashes.RemoveAll();
+			for ( int k = 0 ; k < keys.Count() ; ++k )
+			{
+				if ( keys[k].sym == syms[s] )
+				{
+					hashes.AddToTail( keys[k].hash );
+				}
+			}
+
+			hashes.Sort( HashSortCompare );
+
+			int nDistinct = 0;
+			for ( int h = 0 ; h < hashes.Count() ; ++h )
+			{
+				if ( h == 0 || hashes[h] != hashes[h - 1] )
+					++nDistinct;
+			}
+
+			float flCost = (float)( count - hashes.Count() ) + (float)hashes.Count() / (float)nDistinct;
+			if ( flCost < flBestCost )
+			{
+				flBestCost = flCost;
+				compiled.keySym = syms[s];
+			}
+		}
+
+		if ( !compiled.keySym.IsValid() )
+			continue;
+
+		int nextElem = 0;
+		for ( int k = 0 ; k < keys.Count() ; ++k )
+		{
+			if ( keys[k].sym != compiled.keySym )
+				continue;
+
+			// keys were gathered in element order, so this keeps unkeyed sorted
+			while ( nextElem < keys[k].elem )
+			{
+				compiled.unkeyed.AddToTail( nextElem++ );
+			}
+			nextElem = keys[k].elem + 1;
+
+			CompiledKey_t &compiledKey = compiled.keyed[ compiled.keyed.AddToTail() ];
+			compiledKey.hash = keys[k].hash;
+			compiledKey.elem = keys[k].elem;
+		}
+
+		while ( nextElem < count )
+		{
+			compiled.unkeyed.AddToTail( nextElem++ );
+		}
+
+		compiled.keyed.Sort( CompiledKey_t::SortCompare );
+	}
+
+	m_bCompiled = true;
+}
+
+void ResponseRulePartition::GetCandidatesForCriteria( tCandidates *pResult, const tRuleDict *pDict, const CriteriaSet &criteria ) const
+{
+	Assert( m_bCompiled );
+	Assert( pDict >= m_RuleParts && pDict < m_RuleParts + N_RESPONSE_PARTITIONS );
+
+	pResult->RemoveAll();
+
+	const CompiledBucket_t &compiled = m_Compiled[ pDict - m_RuleParts ];
+	if ( !compiled.keySym.IsValid() )
+	{
+		int count = pDict->Count();
+		pResult->EnsureCapacity( count );
+		for ( int i = 0 ; i < count ; ++i )
+		{
+			pResult->AddToTail( i );
+		}
+		return;
+	}
+
+	// find the rules requiring the value we have. If the criterion is missing
+	// from the set none of them can match.
+	int first = compiled.keyed.Count();
+	int last = first;
+
+	int iSetIdx = criteria.FindCriterionIndex( compiled.keySym );
+	if ( iSetIdx != -1 )
+	{
+		unsigned int hash = HashStringCaseless( criteria.GetValue( iSetIdx ) );
+
+		int lo = 0;
+		int hi = compiled.keyed.Count();
+		while ( lo < hi )
+		{
+			int mid = ( lo + hi ) >> 1;
+			if ( compiled.keyed[mid].hash < hash )
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		first = last = lo;
+		while ( last < compiled.keyed.Count() && compiled.keyed[last].hash == hash )
+		{
+			++last;
+		}
+	}
+
+	// merge with the unkeyed rules, so everything is scored in the same order as the dict
+	pResult->EnsureCapacity( ( last - first ) + compiled.unkeyed.Count() );
+
+	int u = 0;
+	while ( first < last || u < compiled.unkeyed.Count() )
+	{
+		if ( u >= compiled.unkeyed.Count() || ( first < last && compiled.keyed[first].elem < compiled.unkeyed[u] ) )
+		{
+			pResult->AddToTail( compiled.keyed[first++].elem );
+		}
+		else
+		{
+			pResult->AddToTail( compiled.unkeyed[u++] );
+		}
+	}
+}
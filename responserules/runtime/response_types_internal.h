@@ -13,6 +13,7 @@
 
 #include "responserules/response_types.h"
 #include "utldict.h"
+#include "generichash.h"
 
 
 namespace ResponseRules
@@ -44,6 +45,7 @@ namespace ResponseRules
 
 		float	maxval;
 		float	minval;
+		float	tokenval;		// token pre-parsed at load time (numeric equality)
 
 		bool	valid : 1;      //1
 		bool	isnumeric : 1;  //2
@@ -418,6 +420,17 @@ namespace ResponseRules
 	    ///  criteria are in one of two dictionaries)
 	    void GetDictsForCriteria( CUtlVectorFixed< ResponseRulePartition::tRuleDict *, 2 > *pResult, const CriteriaSet &criteria );
 
+		typedef CUtlVectorFixedGrowable< unsigned short, 256 > tCandidates;
+
+		/// build the per-bucket index used by GetCandidatesForCriteria. Done after
+		/// loading the scripts, and lazily again if more rules get added.
+		void Compile( CResponseSystem *pSystem );
+		inline bool IsCompiled() const { return m_bCompiled; }
+
+		/// get the elements of a bucket that can possibly match the given criteria, in
+		/// ascending order. Rules left out are guaranteed to fail a required criterion.
+		void GetCandidatesForCriteria( tCandidates *pResult, const tRuleDict *pDict, const CriteriaSet &criteria ) const;
+
 		// dump everything.
 		void RemoveAll();
 
@@ -452,7 +465,27 @@ namespace ResponseRules
 #endif
 
 	private:
+		struct CompiledKey_t
+		{
+			unsigned int hash;		///< caseless hash of the value the rule requires
+			unsigned short elem;	///< element in the bucket
+
+			static int __cdecl SortCompare( const CompiledKey_t *a, const CompiledKey_t *b );
+		};
+
+		/// Every bucket is keyed on its most selective required criterion: 
+		/// the rules that require an exact value for it are sorted by that value,
+		/// so a query only has to score those whose value matches the set's.
+		struct CompiledBucket_t
+		{
+			CUtlSymbol keySym;
+			CUtlVector< CompiledKey_t > keyed;
+			CUtlVector< unsigned short > unkeyed;
+		};
+
 		tRuleDict m_RuleParts[N_RESPONSE_PARTITIONS];
+		CompiledBucket_t m_Compiled[N_RESPONSE_PARTITIONS];
+		bool m_bCompiled;
 	    unsigned int GetBucketForSpeakerAndConcept( const char *pszSpeaker, const char *pszConcept, const char *pszSubject );
 	};
 